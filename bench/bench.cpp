@@ -0,0 +1,252 @@
+#include "bench.hpp"
+#include "instrument/alloc_scope.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench {
+
+std::uint64_t allocations() {
+    return instrument::allocations();
+}
+
+/**
+ * @brief Quotes a string for JSON.
+ */
+std::string quote(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief Formats a number with a fixed count of decimals, so reports diff cleanly.
+ */
+std::string fixed(double value, int decimals) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return text;
+}
+
+/**
+ * @brief Opens a user-space instruction counter for the calling thread.
+ *
+ * Failure is not an error: the kernel may forbid it (perf_event_paranoid) or the machine
+ * may have no PMU. available() then returns false and read() returns 0.
+ */
+InstructionCounter::InstructionCounter() : _fd(-1) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (_fd >= 0 && read() == 0) {
+        // Some hypervisors hand out a counter that never counts
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+InstructionCounter::~InstructionCounter() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+bool InstructionCounter::available() const {
+    return _fd >= 0;
+}
+
+std::uint64_t InstructionCounter::read() const {
+    std::uint64_t value = 0;
+    if (_fd >= 0 && ::read(_fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+        return 0;
+    }
+    return value;
+}
+
+/**
+ * @brief Reads the counters of every scope entered since the last reset.
+ *
+ * Empty unless the engine was built with COUP_ALLOC_TRACKING.
+ *
+ * @return std::vector<instrument::ScopeStats> Scopes, most allocations (self) first.
+ */
+std::vector<instrument::ScopeStats> collectScopes() {
+    std::vector<instrument::ScopeStats> scopes;
+    instrument::forEachScope([&](const instrument::ScopeStats& s) {
+        if (s.calls > 0) {
+            scopes.push_back(s);
+        }
+    });
+    std::sort(scopes.begin(), scopes.end(), [](const instrument::ScopeStats& a, const instrument::ScopeStats& b) {
+        return a.self != b.self ? a.self > b.self : std::string(a.name) < std::string(b.name);
+    });
+    return scopes;
+}
+
+/**
+ * @brief Prints where the allocations of one benchmark came from, per operation.
+ *
+ * @param title Benchmark name.
+ * @param scopes Result of collectScopes().
+ * @param operations Operations the counts are divided by.
+ * @param out Stream to print to.
+ */
+void printScopes(const std::string& title, const std::vector<instrument::ScopeStats>& scopes, double operations,
+                 std::FILE* out) {
+    if (scopes.empty()) {
+        return;
+    }
+    std::fprintf(out, "\n%s\n  %-30s %12s %12s %14s %12s\n", title.c_str(), "scope", "calls/op", "self/op",
+                 "self bytes/op", "total/op");
+    for (const instrument::ScopeStats& s : scopes) {
+        std::fprintf(out, "  %-30s %12.3f %12.3f %14.1f %12.3f\n", s.name, static_cast<double>(s.calls) / operations,
+                     static_cast<double>(s.self) / operations, static_cast<double>(s.selfBytes) / operations,
+                     static_cast<double>(s.total) / operations);
+    }
+}
+
+std::string scopesJson(const std::vector<instrument::ScopeStats>& scopes, double operations) {
+    std::string out = "[";
+    for (size_t i = 0; i < scopes.size(); ++i) {
+        const instrument::ScopeStats& s = scopes[i];
+        out += std::string(i ? ", " : "") + "{\"scope\": " + quote(s.name) +
+               ", \"calls_per_op\": " + fixed(static_cast<double>(s.calls) / operations, 3) +
+               ", \"self_per_op\": " + fixed(static_cast<double>(s.self) / operations, 3) +
+               ", \"self_bytes_per_op\": " + fixed(static_cast<double>(s.selfBytes) / operations, 1) +
+               ", \"total_per_op\": " + fixed(static_cast<double>(s.total) / operations, 3) + "}";
+    }
+    return out + "]";
+}
+
+/**
+ * @brief Parses one of the options shared by all benchmark binaries.
+ *
+ * @param options Receives the value.
+ * @param argc Argument count.
+ * @param argv Arguments.
+ * @param i Index of the current argument; advanced past the value when one is consumed.
+ * @return true If argv[i] was a common option.
+ */
+bool parseOption(Options& options, int argc, char** argv, int& i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (!hasValue) {
+        return false;
+    }
+    if (arg == "--min-time") options.minSeconds = std::atof(argv[++i]);
+    else if (arg == "--repetitions") options.repetitions = static_cast<size_t>(std::max(1L, std::atol(argv[++i])));
+    else if (arg == "--filter") options.filter = argv[++i];
+    else if (arg == "--json") options.jsonPath = argv[++i];
+    else if (arg == "--label") options.label = argv[++i];
+    else return false;
+    return true;
+}
+
+bool selected(const Options& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+/**
+ * @brief Prints the results as an aligned table.
+ *
+ * @param results Results in report order.
+ * @param instructions Whether the instruction column has values.
+ * @param out Stream to print to; stderr when the JSON goes to stdout.
+ */
+void printTable(const std::vector<Result>& results, bool instructions, std::FILE* out) {
+    std::fprintf(out, "%-28s %14s %12s %12s %14s\n", "benchmark", "operations", "ns/op", "allocs/op", "instructions/op");
+    for (const Result& r : results) {
+        std::fprintf(out, "%-28s %14llu %12.2f %12.3f %14s\n", r.name.c_str(), static_cast<unsigned long long>(r.operations),
+                    r.nsPerOp, r.allocsPerOp, instructions ? fixed(r.instructionsPerOp, 1).c_str() : "n/a");
+    }
+    for (const Result& r : results) {
+        printScopes(r.name, r.scopes, static_cast<double>(r.operations), out);
+    }
+}
+
+/**
+ * @brief Writes a JSON report: a fixed header and one object per line.
+ *
+ * Keys and number formats never change between runs, so two reports can be compared
+ * with a plain diff or a small script.
+ *
+ * @param options Gives the path ("-" for stdout) and the label; nothing is written without a path.
+ * @param suite Name of the benchmark binary's suite.
+ * @param header Extra "key": value pairs for the header, each followed by ",\n".
+ * @param rows JSON objects, in report order.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void writeReport(const Options& options, const std::string& suite, const std::string& header,
+                 const std::vector<std::string>& rows) {
+    if (options.jsonPath.empty()) {
+        return;
+    }
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"schema\": 1,\n";
+    out << "  \"suite\": " << quote(suite) << ",\n";
+    out << "  \"label\": " << quote(options.label) << ",\n";
+    out << header;
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        out << "    " << rows[i] << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+
+    if (options.jsonPath == "-") {
+        std::cout << out.str();
+        return;
+    }
+    std::ofstream file(options.jsonPath);
+    if (!(file << out.str())) {
+        throw std::runtime_error("Cannot write " + options.jsonPath);
+    }
+}
+
+/**
+ * @brief Writes microbenchmark results; instructions_per_op is null without a counter.
+ */
+void writeJson(const Options& options, const std::string& suite, const std::vector<Result>& results,
+               bool instructions) {
+    std::vector<std::string> rows;
+    for (const Result& r : results) {
+        rows.push_back("{\"name\": " + quote(r.name) + ", \"operations\": " + std::to_string(r.operations) +
+                       ", \"ns_per_op\": " + fixed(r.nsPerOp, 3) + ", \"allocs_per_op\": " + fixed(r.allocsPerOp, 3) +
+                       ", \"instructions_per_op\": " + (instructions ? fixed(r.instructionsPerOp, 1) : "null") +
+                       (instrument::trackingEnabled()
+                            ? ", \"scopes\": " + scopesJson(r.scopes, static_cast<double>(r.operations))
+                            : std::string()) +
+                       "}");
+    }
+    writeReport(options, suite,
+                std::string("  \"instructions\": ") + (instructions ? "true" : "false") + ",\n" +
+                    "  \"alloc_tracking\": " + (instrument::trackingEnabled() ? "true" : "false") + ",\n",
+                rows);
+}
+
+}
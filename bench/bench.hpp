@@ -0,0 +1,116 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "instrument/alloc_scope.hpp"
+
+namespace bench {
+
+// One line of a report. Counts are per operation; instructions is negative when the
+// hardware counter is not available (no perf_event_open, a VM without a PMU, ...).
+struct Result {
+    std::string name;
+    std::uint64_t operations;
+    double nsPerOp;
+    double allocsPerOp;
+    double instructionsPerOp;
+    std::vector<instrument::ScopeStats> scopes; // entered scopes, only with COUP_ALLOC_TRACKING
+};
+
+// Scopes entered since the last instrument::resetAllocationCounters(), most allocations first
+std::vector<instrument::ScopeStats> collectScopes();
+void printScopes(const std::string& title, const std::vector<instrument::ScopeStats>& scopes, double operations,
+                 std::FILE* out);
+// JSON array of the scopes with calls, allocations and bytes divided by operations
+std::string scopesJson(const std::vector<instrument::ScopeStats>& scopes, double operations);
+
+// Global operator new calls made by this process so far (all threads), counted by
+// src/instrument/alloc_hooks.cpp which every benchmark binary links
+std::uint64_t allocations();
+
+// Retired user-space instructions of the calling thread, read through perf_event_open
+class InstructionCounter {
+public:
+    InstructionCounter();
+    ~InstructionCounter();
+    InstructionCounter(const InstructionCounter&) = delete;
+    InstructionCounter& operator=(const InstructionCounter&) = delete;
+
+    bool available() const;
+    std::uint64_t read() const;
+
+private:
+    int _fd;
+};
+
+struct Options {
+    double minSeconds = 0.2;   // measuring time per benchmark
+    size_t repetitions = 5;    // ns/op is the median over this many runs
+    std::string filter;        // only run benchmarks whose name contains this
+    std::string jsonPath;      // "-" for stdout, empty for no JSON
+    std::string label;         // free text copied into the JSON, e.g. a commit id
+};
+
+// Consumes argv[i] (and its value) if it is one of the common options below; returns false otherwise.
+//   --min-time SEC  --repetitions N  --filter TEXT  --json FILE|-  --label TEXT
+bool parseOption(Options& options, int argc, char** argv, int& i);
+bool selected(const Options& options, const std::string& name);
+void printTable(const std::vector<Result>& results, bool instructions, std::FILE* out);
+std::string quote(const std::string& text);
+std::string fixed(double value, int decimals);
+void writeReport(const Options& options, const std::string& suite, const std::string& header,
+                 const std::vector<std::string>& rows);
+void writeJson(const Options& options, const std::string& suite, const std::vector<Result>& results,
+               bool instructions);
+
+// Times a batched operation. prepare(i) puts slot i in a state where op(i) is legal and is not
+// measured; op(i) is then run for every slot in one timed sweep. Sweeps are repeated until
+// minSeconds have been spent, once per repetition, and the median ns/op is kept.
+template <class Prepare, class Op>
+Result measure(const std::string& name, size_t batch, const Options& options, const InstructionCounter& counter,
+               Prepare prepare, Op op) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> samples;
+    instrument::resetAllocationCounters();
+    std::uint64_t operations = 0;
+    std::uint64_t allocs = 0;
+    std::uint64_t instructions = 0;
+    for (size_t r = 0; r < options.repetitions; ++r) {
+        Clock::duration spent{};
+        std::uint64_t done = 0;
+        while (std::chrono::duration<double>(spent).count() < options.minSeconds / options.repetitions) {
+            instrument::pauseScopes(true);
+            for (size_t i = 0; i < batch; ++i) {
+                prepare(i);
+            }
+            instrument::pauseScopes(false);
+            std::uint64_t allocsBefore = allocations();
+            std::uint64_t instructionsBefore = counter.read();
+            Clock::time_point start = Clock::now();
+            for (size_t i = 0; i < batch; ++i) {
+                op(i);
+            }
+            spent += Clock::now() - start;
+            instructions += counter.read() - instructionsBefore;
+            allocs += allocations() - allocsBefore;
+            done += batch;
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(spent).count() / static_cast<double>(done));
+        operations += done;
+    }
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    double ops = static_cast<double>(operations);
+    return Result{name, operations, sorted[sorted.size() / 2], static_cast<double>(allocs) / ops,
+                  counter.available() ? static_cast<double>(instructions) / ops : -1.0, collectScopes()};
+}
+
+}
+
+#endif // BENCH_HPP
@@ -0,0 +1,325 @@
+// Full-game throughput: plays complete games from fixed seeds with every scripted bot
+// (src/ai/bot.hpp), a one-ply search and the lockstep batch engine (src/engine/lockstep.hpp,
+// 16 games per step, with each kernel the CPU supports) at every table size, on one thread and on all cores,
+// and reports games/sec, moves/sec and allocations/move. Games and seeds are fixed, so the
+// work done is identical from run to run and from machine to machine.
+#include "bench.hpp"
+#include "ai/bot.hpp"
+#include "game.hpp"
+#include "engine/lockstep.hpp"
+#include "engine/move.hpp"
+#include "engine/snapshot.hpp"
+#include "instrument/trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t MAX_GAME_MOVES = 1000; // a game still running after this many moves is abandoned
+
+// Every seat plays the same scripted bot, or the one-ply search; lockstep games are played
+// by the batch engine's own policy, which plays like the couper bot
+struct Policy {
+    BotKind bot;
+    bool search;
+    bool lockstep;
+    LockstepBatch::Kernel kernel;
+};
+
+const char* policyName(const Policy& policy) {
+    if (policy.lockstep) {
+        return policy.kernel == LockstepBatch::Kernel::Avx2 ? "lockstep-avx2" : "lockstep-generic";
+    }
+    return policy.search ? "search" : Bot::kindName(policy.bot);
+}
+
+struct Options {
+    bench::Options common;
+    size_t games = 1000;        // games per configuration and thread; search plays a tenth of that
+    size_t minPlayers = 2;
+    size_t maxPlayers = 6;
+    size_t threads = 0;         // 0: one per core
+    unsigned int seed = 1;
+    std::string tracePath;      // Chrome trace of the run, needs TRACING=1
+};
+
+struct Totals {
+    std::uint64_t games = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t abandoned = 0;
+};
+
+// Position value for one player: staying in, fewer opponents, and a coin lead
+int evaluate(const Game& game, const Player* self) {
+    int best = 0;
+    bool alive = false;
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        const Player& p = game.playerAt(i);
+        if (&p == self) {
+            alive = true;
+        } else {
+            best = std::max(best, p.getCoins());
+        }
+    }
+    if (!alive) {
+        return -100000;
+    }
+    return -1000 * static_cast<int>(game.playerCount()) + 10 * self->getCoins() - 5 * best;
+}
+
+class Chooser {
+public:
+    Chooser(const Policy& policy, unsigned int seed) : _search(policy.search), _bot(policy.bot, seed) {
+        _image.reserve(512);
+    }
+
+    Move choose(Game& game) {
+        if (!_search) {
+            return _bot.choose(game);
+        }
+        size_t count = moves::legalMoves(game, _legal, moves::MAX_MOVES);
+        if (count == 1) {
+            return _legal[0];
+        }
+
+        // One-ply search: play every move, score the result, then put the table back
+        const Player* self = &game.playerAt(static_cast<size_t>(game.currentPlayerIndex()));
+        _image.clear();
+        Snapshot::write(game, _image);
+        size_t best = 0;
+        int bestValue = 0;
+        for (size_t i = 0; i < count; ++i) {
+            moves::apply(game, _legal[i]);
+            int value = evaluate(game, self);
+            Snapshot::read(game, _image.data(), _image.size());
+            if (i == 0 || value > bestValue) {
+                bestValue = value;
+                best = i;
+            }
+        }
+        return _legal[best];
+    }
+
+private:
+    bool _search;
+    Bot _bot;
+    std::vector<std::uint8_t> _image;
+    Move _legal[moves::MAX_MOVES];
+};
+
+// The same deals as playGames(), LANES games at a time; a lane whose game ends is dealt the next one
+void playLockstep(const Policy& policy, size_t players, size_t games, unsigned int seed, Totals& totals) {
+    LockstepBatch batch(policy.kernel);
+    size_t dealt = 0;
+    size_t played[LockstepBatch::LANES] = {};
+    bool busy[LockstepBatch::LANES] = {};
+    auto deal = [&](size_t lane) {
+        busy[lane] = dealt < games;
+        if (busy[lane]) {
+            batch.deal(lane, seed + static_cast<unsigned int>(dealt++) * 2654435761u, players);
+            played[lane] = 0;
+        }
+    };
+    for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+        deal(lane);
+    }
+    Move moves[LockstepBatch::LANES];
+    for (bool any = true; any;) {
+        batch.choose(moves);
+        batch.apply(moves);
+        any = false;
+        for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+            if (!busy[lane]) {
+                continue;
+            }
+            ++played[lane];
+            bool abandoned = played[lane] == MAX_GAME_MOVES;
+            if (!batch.running(lane) || abandoned) {
+                totals.moves += played[lane];
+                totals.games++;
+                totals.abandoned += abandoned ? 1 : 0;
+                deal(lane);
+            }
+            any = any || busy[lane];
+        }
+    }
+}
+
+void playGames(const Policy& policy, size_t players, size_t games, unsigned int seed, Totals& totals) {
+    if (policy.lockstep) {
+        playLockstep(policy, players, games, seed, totals);
+        return;
+    }
+    static const char* const NAMES[] = {"p0", "p1", "p2", "p3", "p4", "p5", "p6", "p7",
+                                        "p8", "p9", "p10", "p11", "p12", "p13", "p14", "p15"};
+    const std::vector<std::string> names(NAMES, NAMES + players);
+    for (size_t g = 0; g < games; ++g) {
+        unsigned int gameSeed = seed + static_cast<unsigned int>(g) * 2654435761u;
+        Game game(names, gameSeed);
+        Chooser chooser(policy, gameSeed);
+        size_t played = 0;
+        while (game.isGame() && game.playerCount() > 1 && played < MAX_GAME_MOVES) {
+            moves::apply(game, chooser.choose(game));
+            ++played;
+        }
+        totals.moves += played;
+        totals.games++;
+        if (played == MAX_GAME_MOVES) {
+            totals.abandoned++;
+        }
+    }
+}
+
+struct Row {
+    Totals totals;
+    double seconds;
+    double allocsPerMove;
+    std::vector<instrument::ScopeStats> scopes;
+};
+
+Row runConfiguration(const Policy& policy, size_t players, size_t threads, const Options& opt) {
+    size_t games = policy.search ? std::max<size_t>(1, opt.games / 10) : opt.games;
+    std::vector<Totals> totals(threads);
+    instrument::resetAllocationCounters();
+    std::uint64_t allocsBefore = bench::allocations();
+    Clock::time_point start = Clock::now();
+    if (threads == 1) {
+        playGames(policy, players, games, opt.seed, totals[0]);
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            // Thread t plays the same games in every run, whatever the machine
+            unsigned int seed = opt.seed + static_cast<unsigned int>(t) * 1000003u;
+            workers.emplace_back([&, t, seed] { playGames(policy, players, games, seed, totals[t]); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::uint64_t allocs = bench::allocations() - allocsBefore;
+
+    Row row{Totals{}, seconds, 0, bench::collectScopes()};
+    for (const Totals& t : totals) {
+        row.totals.games += t.games;
+        row.totals.moves += t.moves;
+        row.totals.abandoned += t.abandoned;
+    }
+    row.allocsPerMove = row.totals.moves ? static_cast<double>(allocs) / static_cast<double>(row.totals.moves) : 0;
+    return row;
+}
+
+void usage() {
+    std::cerr << "Usage: game_bench [--games N] [--min-players N] [--max-players N] [--threads N] [--seed N]\n"
+                 "                  [--filter TEXT] [--json FILE|-] [--label TEXT] [--trace FILE]" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (bench::parseOption(opt.common, argc, argv, i)) continue;
+        if (arg == "--games" && hasValue) opt.games = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--min-players" && hasValue) opt.minPlayers = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--max-players" && hasValue) opt.maxPlayers = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--threads" && hasValue) opt.threads = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--seed" && hasValue) opt.seed = static_cast<unsigned int>(std::atol(argv[++i]));
+        else if (arg == "--trace" && hasValue) opt.tracePath = argv[++i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (opt.minPlayers < 2 || opt.maxPlayers > moves::MAX_TABLE || opt.minPlayers > opt.maxPlayers) {
+        std::cerr << "game_bench: players must be within 2.." << moves::MAX_TABLE << std::endl;
+        return 2;
+    }
+    size_t cores = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts{1};
+    if (cores > 1) {
+        threadCounts.push_back(cores);
+    }
+
+    std::FILE* out = opt.common.jsonPath == "-" ? stderr : stdout;
+    std::fprintf(out, "%-22s %8s %10s %10s %12s %14s %12s\n", "benchmark", "threads", "games", "abandoned",
+                 "games/sec", "moves/sec", "allocs/move");
+    std::vector<std::string> rows;
+    std::vector<std::pair<std::string, Row>> scopeReports; // printed below the table
+    try {
+        std::vector<Policy> policies;
+        for (size_t kind = 0; kind < static_cast<size_t>(BotKind::Count); ++kind) {
+            policies.push_back(Policy{static_cast<BotKind>(kind), false, false, LockstepBatch::Kernel::Generic});
+        }
+        policies.push_back(Policy{BotKind::Greedy, true, false, LockstepBatch::Kernel::Generic});
+        policies.push_back(Policy{BotKind::Couper, false, true, LockstepBatch::Kernel::Generic});
+        if (LockstepBatch::bestKernel() == LockstepBatch::Kernel::Avx2) {
+            policies.push_back(Policy{BotKind::Couper, false, true, LockstepBatch::Kernel::Avx2});
+        }
+        for (const Policy& policy : policies) {
+            for (size_t players = opt.minPlayers; players <= opt.maxPlayers; ++players) {
+                if (policy.lockstep && players > LockstepBatch::MAX_SEATS) {
+                    continue;
+                }
+                for (size_t threads : threadCounts) {
+                    std::string name = std::string(policyName(policy)) + "/" + std::to_string(players) + "p/" +
+                                       std::to_string(threads) + "t";
+                    if (!bench::selected(opt.common, name)) {
+                        continue;
+                    }
+                    Row row = runConfiguration(policy, players, threads, opt);
+                    double gamesPerSec = static_cast<double>(row.totals.games) / row.seconds;
+                    double movesPerSec = static_cast<double>(row.totals.moves) / row.seconds;
+                    std::fprintf(out, "%-22s %8zu %10llu %10llu %12.0f %14.0f %12.3f\n", name.c_str(), threads,
+                                 static_cast<unsigned long long>(row.totals.games),
+                                 static_cast<unsigned long long>(row.totals.abandoned), gamesPerSec, movesPerSec,
+                                 row.allocsPerMove);
+                    rows.push_back("{\"name\": " + bench::quote(name) + ", \"policy\": " +
+                                   bench::quote(policyName(policy)) + ", \"players\": " + std::to_string(players) +
+                                   ", \"threads\": " + std::to_string(threads) + ", \"games\": " +
+                                   std::to_string(row.totals.games) + ", \"moves\": " +
+                                   std::to_string(row.totals.moves) + ", \"abandoned\": " +
+                                   std::to_string(row.totals.abandoned) + ", \"games_per_sec\": " +
+                                   bench::fixed(gamesPerSec, 1) + ", \"moves_per_sec\": " +
+                                   bench::fixed(movesPerSec, 1) + ", \"allocs_per_move\": " +
+                                   bench::fixed(row.allocsPerMove, 3) +
+                                   (instrument::trackingEnabled()
+                                        ? ", \"scopes\": " + bench::scopesJson(row.scopes, double(row.totals.moves))
+                                        : std::string()) +
+                                   "}");
+                    scopeReports.emplace_back(name, std::move(row));
+                }
+            }
+        }
+        for (const auto& report : scopeReports) {
+            bench::printScopes(report.first + " (per move)", report.second.scopes,
+                               static_cast<double>(report.second.totals.moves), out);
+        }
+        bench::writeReport(opt.common, "game",
+                           "  \"seed\": " + std::to_string(opt.seed) + ",\n  \"alloc_tracking\": " +
+                               (instrument::trackingEnabled() ? "true" : "false") + ",\n",
+                           rows);
+        if (!opt.tracePath.empty()) {
+            if (!trace::enabled()) {
+                std::cerr << "game_bench: built without tracing (make TRACING=1), --trace ignored" << std::endl;
+            } else {
+                std::fprintf(out, "\n%zu trace events written to %s\n", trace::writeChromeTrace(opt.tracePath),
+                             opt.tracePath.c_str());
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "game_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
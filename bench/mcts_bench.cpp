@@ -0,0 +1,140 @@
+// Tree-parallel MCTS (src/ai/mcts.hpp): searches fixed mid-game positions with 1, 2, 4 ... threads
+// up to the core count (or --threads) sharing one tree, and reports playouts/sec, the speedup over
+// one thread and the tree size. Positions come from seeded tables played forward by the greedy
+// bot, so the work is the same on every run.
+#include "bench.hpp"
+#include "ai/bot.hpp"
+#include "ai/mcts.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    bench::Options common;
+    size_t positions = 4;            // per table size
+    size_t minPlayers = 2;
+    size_t maxPlayers = 4;
+    std::uint64_t playouts = 20000;  // per search
+    size_t maxThreads = 0;           // 0: the core count
+};
+
+void usage() {
+    std::cerr << "Usage: mcts_bench [--positions N] [--players MIN:MAX] [--playouts N] [--threads MAX]\n"
+                 "                  [--filter TEXT] [--json FILE|-] [--label TEXT]" << std::endl;
+}
+
+// Table p of a size: dealt from a seed and played 4 to 19 plies by the greedy bot
+std::vector<std::unique_ptr<Game>> positions(size_t players, size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < players; ++i) {
+        names.push_back("p" + std::to_string(i));
+    }
+    std::vector<std::unique_ptr<Game>> games;
+    for (unsigned int seed = 1; games.size() < count; ++seed) {
+        auto game = std::make_unique<Game>(names, seed);
+        Bot bot(BotKind::Greedy, seed);
+        for (size_t ply = 0; ply < 4 + seed % 16 && game->isGame(); ++ply) {
+            moves::apply(*game, bot.choose(*game));
+        }
+        if (game->isGame()) {
+            games.push_back(std::move(game));
+        }
+    }
+    return games;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (bench::parseOption(opt.common, argc, argv, i)) continue;
+        if (arg == "--positions" && hasValue) opt.positions = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--playouts" && hasValue) opt.playouts = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && hasValue) opt.maxThreads = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--players" && hasValue) {
+            std::string range = argv[++i];
+            size_t colon = range.find(':');
+            opt.minPlayers = static_cast<size_t>(std::atol(range.substr(0, colon).c_str()));
+            opt.maxPlayers = colon == std::string::npos ? opt.minPlayers
+                                                        : static_cast<size_t>(std::atol(range.substr(colon + 1).c_str()));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (opt.positions == 0 || opt.playouts == 0 || opt.minPlayers < 2 || opt.maxPlayers > moves::MAX_TABLE ||
+        opt.minPlayers > opt.maxPlayers) {
+        usage();
+        return 2;
+    }
+    size_t maxThreads = opt.maxThreads ? opt.maxThreads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::FILE* out = opt.common.jsonPath == "-" ? stderr : stdout;
+    std::vector<std::string> rows;
+    try {
+        std::fprintf(out, "%-18s %9s %12s %9s %14s %8s %10s\n", "benchmark", "positions", "playouts", "seconds",
+                     "playouts/sec", "speedup", "nodes");
+        for (size_t players = opt.minPlayers; players <= opt.maxPlayers; ++players) {
+            std::vector<std::unique_ptr<Game>> games = positions(players, opt.positions);
+            double single = 0;
+            for (size_t threads : threadCounts) {
+                std::string name = std::to_string(players) + "p/" + std::to_string(threads) + "t";
+                if (!bench::selected(opt.common, name)) {
+                    continue;
+                }
+                MctsOptions options;
+                options.playouts = opt.playouts;
+                options.threads = threads;
+                Mcts mcts(options);
+
+                std::uint64_t playouts = 0;
+                size_t nodes = 0;
+                Clock::duration spent{};
+                for (const auto& game : games) {
+                    Clock::time_point start = Clock::now();
+                    MctsResult result = mcts.search(*game);
+                    spent += Clock::now() - start;
+                    playouts += result.playouts;
+                    nodes = std::max(nodes, result.nodes);
+                }
+                double seconds = std::chrono::duration<double>(spent).count();
+                double rate = double(playouts) / seconds;
+                if (threads == 1) {
+                    single = rate;
+                }
+                double speedup = single > 0 ? rate / single : 0.0;
+                std::fprintf(out, "%-18s %9zu %12llu %9.3f %14.0f %8.2f %10zu\n", name.c_str(), games.size(),
+                             static_cast<unsigned long long>(playouts), seconds, rate, speedup, nodes);
+                rows.push_back("{\"name\": " + bench::quote(name) + ", \"threads\": " + std::to_string(threads) +
+                               ", \"playouts\": " + std::to_string(playouts) + ", \"seconds\": " +
+                               bench::fixed(seconds, 4) + ", \"playouts_per_sec\": " + bench::fixed(rate, 1) +
+                               ", \"speedup\": " + bench::fixed(speedup, 3) + ", \"max_nodes\": " +
+                               std::to_string(nodes) + "}");
+            }
+        }
+        bench::writeReport(opt.common, "mcts", "  \"playouts\": " + std::to_string(opt.playouts) + ",\n", rows);
+    } catch (const std::exception& e) {
+        std::cerr << "mcts_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
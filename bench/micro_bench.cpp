@@ -0,0 +1,173 @@
+// Microbenchmarks for the rules engine: one entry point of Player, Game, PlayerFactory
+// or Bot each.
+// Every benchmark keeps a batch of small independent tables (2-6 players, fixed seeds), puts
+// each one in a state where the operation is legal without timing it, then times one call per
+// table. Run through `make bench`; see bench/bench.hpp for the options.
+#include "bench.hpp"
+#include "ai/bot.hpp"
+#include "ai/coin_belief.hpp"
+#include "game.hpp"
+#include "roles/player_factory.hpp"
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t BATCH = 256;
+constexpr size_t PLAYERS = 4;
+
+const char* const ROLES[] = {"Spy", "Merchant", "Judge", "Governor", "General", "Baron"};
+
+// BATCH tables of PLAYERS players each, built from seeds 1..BATCH
+struct Tables {
+    std::vector<std::unique_ptr<Game>> games;
+    std::vector<Player*> actors;
+    std::vector<Player*> targets;
+    std::vector<std::string> names;
+
+    explicit Tables(size_t players = PLAYERS) : actors(BATCH), targets(BATCH) {
+        for (size_t i = 0; i < BATCH; ++i) {
+            games.push_back(std::make_unique<Game>(static_cast<unsigned int>(i + 1)));
+            for (size_t p = 0; p < players; ++p) {
+                games.back()->add_player("player" + std::to_string(p));
+            }
+        }
+        for (size_t p = 0; p <= players; ++p) {
+            names.push_back("player" + std::to_string(p));
+        }
+    }
+
+    // Picks the player to move and the next player as the target, with clean flags
+    void pick(size_t i, int actorCoins, int targetCoins) {
+        Game& game = *games[i];
+        while (game.playerCount() < names.size() - 1) {
+            game.restorePlayer();
+        }
+        game.setBribe(false);
+        Player& actor = game.playerAt(static_cast<size_t>(game.currentPlayerIndex()));
+        Player& target = game.playerAt((static_cast<size_t>(game.currentPlayerIndex()) + 1) % game.playerCount());
+        actor.setCoins(actorCoins);
+        actor.setSanctioned(false);
+        actor.setCanArrest(true);
+        target.setCoins(targetCoins);
+        target.setArrest(false);
+        actors[i] = &actor;
+        targets[i] = &target;
+    }
+};
+
+std::vector<bench::Result> run(const bench::Options& options, const bench::InstructionCounter& counter) {
+    std::vector<bench::Result> results;
+    auto add = [&](const std::string& name, auto prepare, auto op) {
+        if (bench::selected(options, name)) {
+            results.push_back(bench::measure(name, BATCH, options, counter, prepare, op));
+        }
+    };
+
+    Tables t;
+    add("Player::gather", [&](size_t i) { t.pick(i, 0, 0); }, [&](size_t i) { t.actors[i]->gather(); });
+    add("Player::tax", [&](size_t i) { t.pick(i, 0, 0); }, [&](size_t i) { t.actors[i]->tax(); });
+    add("Player::arrest", [&](size_t i) { t.pick(i, 0, 3); },
+        [&](size_t i) { t.actors[i]->arrest(*t.targets[i]); });
+    add("Player::sanction", [&](size_t i) { t.pick(i, 5, 0); },
+        [&](size_t i) { t.actors[i]->sanction(*t.targets[i]); });
+    add("Player::coup", [&](size_t i) { t.pick(i, 7, 0); }, [&](size_t i) { t.actors[i]->coup(*t.targets[i]); });
+    add("Game::next_turn", [&](size_t i) { t.pick(i, 0, 0); }, [&](size_t i) { t.games[i]->next_turn(); });
+    add("Game::gameCoup", [&](size_t i) { t.pick(i, 0, 0); },
+        [&](size_t i) { t.games[i]->gameCoup(t.names[(i % PLAYERS)]); });
+    add("Game::restorePlayer",
+        [&](size_t i) {
+            t.pick(i, 0, 0);
+            t.games[i]->gameCoup(t.names[i % PLAYERS]);
+        },
+        [&](size_t i) { t.games[i]->restorePlayer(); });
+
+    // add_player seats the last player of a table that already has PLAYERS - 1
+    std::vector<std::unique_ptr<Game>> fresh(BATCH);
+    add("Game::add_player",
+        [&](size_t i) {
+            fresh[i] = std::make_unique<Game>(static_cast<unsigned int>(i + 1));
+            for (size_t p = 0; p + 1 < PLAYERS; ++p) {
+                fresh[i]->add_player(t.names[p]);
+            }
+        },
+        [&](size_t i) { fresh[i]->add_player(t.names[PLAYERS - 1]); });
+
+    // A whole table of PLAYERS, seat by seat and as one roster
+    std::vector<std::string> roster(t.names.begin(), t.names.begin() + PLAYERS);
+    add("Game/add_player table", [&](size_t i) { fresh[i].reset(); },
+        [&](size_t i) {
+            fresh[i] = std::make_unique<Game>(static_cast<unsigned int>(i + 1));
+            for (size_t p = 0; p < PLAYERS; ++p) {
+                fresh[i]->add_player(roster[p]);
+            }
+        });
+    add("Game::fromRoster", [&](size_t i) { fresh[i].reset(); },
+        [&](size_t i) { fresh[i] = Game::fromRoster(roster, static_cast<unsigned int>(i + 1)); });
+
+    std::vector<std::shared_ptr<Player>> created(BATCH);
+    add("PlayerFactory::createPlayer", [&](size_t i) { created[i].reset(); },
+        [&](size_t i) {
+            created[i] = PlayerFactory::createPlayer(*t.games[i], ROLES[i % 6], t.names[0], static_cast<int>(i));
+        });
+
+    // One decision per table, from a spread of coin counts so every policy branch is taken
+    std::vector<Move> chosen(BATCH);
+    for (size_t kind = 0; kind < static_cast<size_t>(BotKind::Count); ++kind) {
+        Bot bot(static_cast<BotKind>(kind));
+        add(std::string("Bot::choose/") + Bot::kindName(bot.kind()), [&](size_t i) { t.pick(i, int(i % 11), 3); },
+            [&](size_t i) { chosen[i] = bot.choose(*t.games[i]); });
+    }
+
+    // The same move with and without the coin-belief update, from beliefs that know nothing
+    std::vector<CoinBelief> beliefs(BATCH);
+    auto unknown = [&](size_t i, int actorCoins, int targetCoins) {
+        t.pick(i, actorCoins, targetCoins);
+        for (size_t seat = 0; seat < PLAYERS; ++seat) {
+            beliefs[i].assume(seat, 0, 12);
+        }
+    };
+    auto next = [&](size_t i) {
+        Game& game = *t.games[i];
+        return static_cast<std::uint8_t>((static_cast<size_t>(game.currentPlayerIndex()) + 1) % game.playerCount());
+    };
+    add("moves::apply/tax", [&](size_t i) { unknown(i, 0, 0); },
+        [&](size_t i) { moves::apply(*t.games[i], Move{Action::Tax, Move::NO_TARGET}); });
+    add("CoinBelief::play/tax", [&](size_t i) { unknown(i, 0, 0); },
+        [&](size_t i) { beliefs[i].play(*t.games[i], Move{Action::Tax, Move::NO_TARGET}); });
+    add("moves::apply/arrest", [&](size_t i) { unknown(i, 0, 3); },
+        [&](size_t i) { moves::apply(*t.games[i], Move{Action::Arrest, next(i)}); });
+    add("CoinBelief::play/arrest", [&](size_t i) { unknown(i, 0, 3); },
+        [&](size_t i) { beliefs[i].play(*t.games[i], Move{Action::Arrest, next(i)}); });
+    return results;
+}
+
+void usage() {
+    std::cerr << "Usage: micro_bench [--min-time SEC] [--repetitions N] [--filter TEXT] [--json FILE|-] [--label TEXT]"
+              << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (!bench::parseOption(options, argc, argv, i)) {
+            usage();
+            return 2;
+        }
+    }
+    try {
+        bench::InstructionCounter counter;
+        std::vector<bench::Result> results = run(options, counter);
+        bench::printTable(results, counter.available(), options.jsonPath == "-" ? stderr : stdout);
+        bench::writeJson(options, "micro", results, counter.available());
+    } catch (const std::exception& e) {
+        std::cerr << "micro_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Alpha-beta search (src/ai/search.hpp): searches fixed mid-game positions at every table size in
+// both modes with a cold transposition table, and reports the depth reached, nodes/sec and the
+// effective branching factor, the node ratio of the last two completed iterations (geometric
+// mean over the positions). Positions come from seeded tables played forward by the greedy bot,
+// so the work is the same on every run.
+#include "bench.hpp"
+#include "ai/bot.hpp"
+#include "ai/search.hpp"
+#include "game.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    bench::Options common;
+    size_t positions = 16;           // per table size
+    size_t minPlayers = 2;
+    size_t maxPlayers = 4;
+    std::uint64_t budget = 200000;   // nodes per search
+    size_t depth = Searcher::MAX_PLIES;
+};
+
+void usage() {
+    std::cerr << "Usage: search_bench [--positions N] [--players MIN:MAX] [--budget NODES] [--depth N]\n"
+                 "                    [--filter TEXT] [--json FILE|-] [--label TEXT]" << std::endl;
+}
+
+// Table p of a size: dealt from a seed and played 4 to 19 plies by the greedy bot
+std::vector<std::unique_ptr<Game>> positions(size_t players, size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < players; ++i) {
+        names.push_back("p" + std::to_string(i));
+    }
+    std::vector<std::unique_ptr<Game>> games;
+    for (unsigned int seed = 1; games.size() < count; ++seed) {
+        auto game = std::make_unique<Game>(names, seed);
+        Bot bot(BotKind::Greedy, seed);
+        for (size_t ply = 0; ply < 4 + seed % 16 && game->isGame(); ++ply) {
+            moves::apply(*game, bot.choose(*game));
+        }
+        if (game->isGame()) {
+            games.push_back(std::move(game));
+        }
+    }
+    return games;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (bench::parseOption(opt.common, argc, argv, i)) continue;
+        if (arg == "--positions" && hasValue) opt.positions = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--budget" && hasValue) opt.budget = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--depth" && hasValue) opt.depth = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--players" && hasValue) {
+            std::string range = argv[++i];
+            size_t colon = range.find(':');
+            opt.minPlayers = static_cast<size_t>(std::atol(range.substr(0, colon).c_str()));
+            opt.maxPlayers = colon == std::string::npos ? opt.minPlayers
+                                                        : static_cast<size_t>(std::atol(range.substr(colon + 1).c_str()));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (opt.positions == 0 || opt.minPlayers < 2 || opt.maxPlayers > moves::MAX_TABLE ||
+        opt.minPlayers > opt.maxPlayers) {
+        usage();
+        return 2;
+    }
+
+    std::FILE* out = opt.common.jsonPath == "-" ? stderr : stdout;
+    std::vector<std::string> rows;
+    try {
+        std::fprintf(out, "%-18s %9s %7s %12s %9s %14s %7s\n", "benchmark", "positions", "depth", "nodes", "seconds",
+                     "nodes/sec", "EBF");
+        for (size_t players = opt.minPlayers; players <= opt.maxPlayers; ++players) {
+            std::vector<std::unique_ptr<Game>> games = positions(players, opt.positions);
+            for (SearchMode mode : {SearchMode::Paranoid, SearchMode::MaxN}) {
+                std::string name = std::string(mode == SearchMode::Paranoid ? "paranoid" : "maxn") + "/" +
+                                   std::to_string(players) + "p";
+                if (!bench::selected(opt.common, name)) {
+                    continue;
+                }
+                SearchOptions options;
+                options.mode = mode;
+                options.nodeBudget = opt.budget;
+                options.maxDepth = opt.depth;
+                Searcher searcher(options);
+
+                std::uint64_t nodes = 0;
+                double depths = 0;
+                double logBranching = 0;
+                size_t branchingSamples = 0;
+                Clock::duration spent{};
+                for (const auto& game : games) {
+                    searcher.clear();
+                    Clock::time_point start = Clock::now();
+                    SearchResult result = searcher.search(*game);
+                    spent += Clock::now() - start;
+                    nodes += result.nodes;
+                    depths += double(result.depth);
+                    if (result.branchingFactor() > 0) {
+                        logBranching += std::log(result.branchingFactor());
+                        ++branchingSamples;
+                    }
+                }
+                double seconds = std::chrono::duration<double>(spent).count();
+                double depth = depths / double(games.size());
+                double branching = branchingSamples ? std::exp(logBranching / double(branchingSamples)) : 0.0;
+                std::fprintf(out, "%-18s %9zu %7.2f %12llu %9.3f %14.0f %7.2f\n", name.c_str(), games.size(), depth,
+                             static_cast<unsigned long long>(nodes), seconds, double(nodes) / seconds, branching);
+                rows.push_back("{\"name\": " + bench::quote(name) + ", \"positions\": " +
+                               std::to_string(games.size()) + ", \"depth\": " + bench::fixed(depth, 2) +
+                               ", \"nodes\": " + std::to_string(nodes) + ", \"seconds\": " + bench::fixed(seconds, 4) +
+                               ", \"nodes_per_sec\": " + bench::fixed(double(nodes) / seconds, 1) +
+                               ", \"branching_factor\": " + bench::fixed(branching, 3) + "}");
+            }
+        }
+        bench::writeReport(opt.common, "search", "  \"budget\": " + std::to_string(opt.budget) + ",\n", rows);
+    } catch (const std::exception& e) {
+        std::cerr << "search_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
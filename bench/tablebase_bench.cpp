@@ -0,0 +1,156 @@
+// Endgame tablebase (src/ai/tablebase.hpp): generation speed on one thread and on all cores,
+// then the cost of a probe, of Tablebase::bestMove() and of a Bot::choose() that consults the table.
+// Generation solves the first --pairs role pairs; positions/sec counts every index of those pairs.
+#include "bench.hpp"
+#include "ai/bot.hpp"
+#include "ai/tablebase.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t BATCH = 256;
+
+struct Options {
+    bench::Options common;
+    size_t pairs = Tablebase::PAIRS; // role pairs generated per run
+    size_t threads = 0;              // 0: one per core
+};
+
+void usage() {
+    std::cerr << "Usage: tablebase_bench [--pairs N] [--threads N] [--min-time SEC] [--repetitions N]\n"
+                 "                       [--filter TEXT] [--json FILE|-] [--label TEXT]" << std::endl;
+}
+
+std::vector<std::pair<Role, Role>> firstPairs(size_t count) {
+    std::vector<std::pair<Role, Role>> pairs;
+    for (size_t pair = 0; pair < std::min(count, Tablebase::PAIRS); ++pair) {
+        pairs.emplace_back(static_cast<Role>(pair / Tablebase::ROLES + 1), static_cast<Role>(pair % Tablebase::ROLES + 1));
+    }
+    return pairs;
+}
+
+// Median wall time of a full generation, over the configured repetitions
+double generationSeconds(const std::vector<std::pair<Role, Role>>& pairs, size_t threads, const Options& opt,
+                         size_t& sweeps) {
+    std::vector<double> samples;
+    for (size_t r = 0; r < std::max<size_t>(opt.common.repetitions, 1); ++r) {
+        Tablebase table;
+        Clock::time_point start = Clock::now();
+        table.generate(threads, pairs);
+        samples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+        sweeps = table.sweeps();
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (bench::parseOption(opt.common, argc, argv, i)) continue;
+        if (arg == "--pairs" && hasValue) opt.pairs = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--threads" && hasValue) opt.threads = static_cast<size_t>(std::atol(argv[++i]));
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (opt.pairs == 0 || opt.pairs > Tablebase::PAIRS) {
+        std::cerr << "tablebase_bench: --pairs must be within 1.." << Tablebase::PAIRS << std::endl;
+        return 2;
+    }
+    size_t cores = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts{1};
+    if (cores > 1) {
+        threadCounts.push_back(cores);
+    }
+
+    std::FILE* out = opt.common.jsonPath == "-" ? stderr : stdout;
+    std::vector<std::string> rows;
+    try {
+        std::vector<std::pair<Role, Role>> pairs = firstPairs(opt.pairs);
+        double positions = double(pairs.size()) * double(Tablebase::PAIR_SIZE);
+        std::fprintf(out, "%-22s %8s %12s %10s %8s %16s\n", "benchmark", "threads", "positions", "seconds", "sweeps",
+                     "positions/sec");
+        for (size_t threads : threadCounts) {
+            std::string name = "generate/" + std::to_string(threads) + "t";
+            if (!bench::selected(opt.common, name)) {
+                continue;
+            }
+            size_t sweeps = 0;
+            double seconds = generationSeconds(pairs, threads, opt, sweeps);
+            std::fprintf(out, "%-22s %8zu %12.0f %10.3f %8zu %16.0f\n", name.c_str(), threads, positions, seconds,
+                         sweeps, positions / seconds);
+            rows.push_back("{\"name\": " + bench::quote(name) + ", \"threads\": " + std::to_string(threads) +
+                           ", \"positions\": " + bench::fixed(positions, 0) + ", \"seconds\": " +
+                           bench::fixed(seconds, 4) + ", \"sweeps\": " + std::to_string(sweeps) +
+                           ", \"positions_per_sec\": " + bench::fixed(positions / seconds, 1) + "}");
+        }
+
+        // Lookups on BATCH random solved positions that are still running games
+        Tablebase table;
+        table.generate(cores, pairs);
+        std::mt19937 rng(1);
+        std::vector<EndgamePosition> positionsBatch;
+        std::vector<std::unique_ptr<Game>> games;
+        while (positionsBatch.size() < BATCH) {
+            size_t pair = rng() % pairs.size();
+            size_t base = Tablebase::pairIndex(pairs[pair].first, pairs[pair].second) * Tablebase::PAIR_SIZE;
+            EndgamePosition position = Tablebase::position(base + rng() % Tablebase::PAIR_SIZE);
+            if (!Tablebase::canonical(position)) {
+                continue;
+            }
+            positionsBatch.push_back(position);
+            games.push_back(std::make_unique<Game>(1));
+            position.toGame(*games.back());
+        }
+        std::vector<Bot> bots(BATCH, Bot(BotKind::Greedy));
+        for (Bot& bot : bots) {
+            bot.setTablebase(&table);
+        }
+        std::vector<Move> chosen(BATCH);
+        volatile unsigned int sink = 0;
+
+        bench::InstructionCounter counter;
+        std::vector<bench::Result> results;
+        auto add = [&](const std::string& name, auto op) {
+            if (bench::selected(opt.common, name)) {
+                results.push_back(bench::measure(name, BATCH, opt.common, counter, [](size_t) {}, op));
+            }
+        };
+        add("Tablebase::probe", [&](size_t i) { sink = sink + table.probe(positionsBatch[i]); });
+        add("Tablebase::probe/game", [&](size_t i) {
+            std::uint8_t value = 0;
+            table.probe(*games[i], value);
+            sink = sink + value;
+        });
+        add("Tablebase::bestMove", [&](size_t i) { table.bestMove(*games[i], chosen[i]); });
+        add("Bot::choose/tablebase", [&](size_t i) { chosen[i] = bots[i].choose(*games[i]); });
+        bench::printTable(results, counter.available(), out);
+        for (const bench::Result& result : results) {
+            rows.push_back("{\"name\": " + bench::quote(result.name) + ", \"ns_per_op\": " +
+                           bench::fixed(result.nsPerOp, 2) + ", \"allocs_per_op\": " +
+                           bench::fixed(result.allocsPerOp, 3) + "}");
+        }
+        bench::writeReport(opt.common, "tablebase", "  \"pairs\": " + std::to_string(pairs.size()) + ",\n", rows);
+    } catch (const std::exception& e) {
+        std::cerr << "tablebase_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
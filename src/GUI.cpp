@@ -5,29 +5,33 @@
 #include <cmath>
 #include "roles/baron.hpp"
 #include "roles/spy.hpp"
+#include "instrument/metrics.hpp"
+#include "instrument/trace.hpp"
 
 // Button implementation
-Button::Button(float x, float y, float width, float height, const std::string& text, sf::Font& font) {
+// Built from a cached label: the glyph layout is reused, only colour and position change
+Button::Button(float x, float y, float width, float height, const TextLayoutCache::Entry& label, float yOffset) {
     shape.setPosition(x, y);
     shape.setSize(sf::Vector2f(width, height));
     shape.setFillColor(sf::Color(70, 175, 80)); // Green
     shape.setOutlineThickness(2);
     shape.setOutlineColor(sf::Color::Black);
-    
-    buttonText.setFont(font);
-    buttonText.setString(text);
-    buttonText.setCharacterSize(20);
+
+    setLabel(label, yOffset);
+    isHovered = false;
+}
+
+void Button::setLabel(const TextLayoutCache::Entry& label, float yOffset) {
+    buttonText = label.text;
     buttonText.setFillColor(sf::Color::White);
-    buttonText.setStyle(sf::Text::Bold);
-    
-    // Center text in button
-    sf::FloatRect textBounds = buttonText.getLocalBounds();
+
+    // Center text in button using the cached bounds
+    sf::Vector2f pos = shape.getPosition();
+    sf::Vector2f size = shape.getSize();
     buttonText.setPosition(
-        x + (width - textBounds.width) / 2,
-        y + (height - textBounds.height) / 2 - 5
+        pos.x + (size.x - label.bounds.width) / 2,
+        pos.y + (size.y - label.bounds.height) / 2 - yOffset
     );
-    
-    isHovered = false;
 }
 
 void Button::updateHover(sf::Vector2i mousePos) {
@@ -85,6 +89,54 @@ void Button::setSelected(bool selected) {
     }
 }
 
+// TextLayoutCache implementation
+TextLayoutCache::TextLayoutCache(const sf::Font& font, size_t maxEntries)
+    : font(font), maxEntries(maxEntries), entries() {}
+
+bool TextLayoutCache::Key::operator==(const Key& other) const {
+    return size == other.size && style == other.style && str == other.str;
+}
+
+size_t TextLayoutCache::KeyHash::operator()(const Key& key) const {
+    size_t h = std::hash<std::string>()(key.str);
+    h ^= (static_cast<size_t>(key.size) << 8 | key.style) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+/**
+ * @brief Returns the laid-out text for (str, size, style), shaping it only on first use.
+ *
+ * The stored sf::Text has its geometry built by measuring it once, so copies made from it
+ * keep the glyph quads and only need a colour and position.
+ * The cache is flushed when it grows past maxEntries (e.g. many distinct status messages).
+ */
+const TextLayoutCache::Entry& TextLayoutCache::get(const std::string& str, unsigned int size, sf::Uint32 style) {
+    Key key{str, size, style};
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        return it->second;
+    }
+    if (entries.size() >= maxEntries) {
+        entries.clear();
+    }
+
+    Entry entry;
+    entry.text.setFont(font);
+    entry.text.setString(str);
+    entry.text.setCharacterSize(size);
+    entry.text.setStyle(style);
+    entry.bounds = entry.text.getLocalBounds(); // builds the glyph quads
+    return entries.emplace(std::move(key), std::move(entry)).first->second;
+}
+
+void TextLayoutCache::clear() {
+    entries.clear();
+}
+
+size_t TextLayoutCache::size() const {
+    return entries.size();
+}
+
 // TextInput implementation
 TextInput::TextInput(float x, float y, float width, float height, sf::Font& font) {
     box.setPosition(x, y);
@@ -169,9 +221,11 @@ void TextInput::clear() {
 // GameSetupGUI implementation
 GameSetupGUI::GameSetupGUI()
     : _game()
+    , _flow(_game)
     , window(sf::VideoMode(900, 700), "Game Setup - Player Selection")
     , font()                // sf::Font default constructor
     , fontLoaded(false)
+    , textCache(font)
     , playerBoxes()         // vector default constructor
     , errorText()           // sf::Text default constructor
     , currentScreen(PLAYER_COUNT_SELECTION)
@@ -231,6 +285,17 @@ bool GameSetupGUI::loadFont() {
     return false;
 }
 
+/**
+ * @brief Returns a copy of a cached text with the given fill colour.
+ *
+ * Copies keep the glyph layout of the cached entry, so only colour and position are updated.
+ */
+sf::Text GameSetupGUI::cachedText(const std::string& str, unsigned int size, sf::Uint32 style, const sf::Color& color) {
+    sf::Text text = textCache.get(str, size, style).text;
+    text.setFillColor(color);
+    return text;
+}
+
 
 void GameSetupGUI::run() {
     std::cout << "Starting Game Setup GUI..." << std::endl;
@@ -256,14 +321,7 @@ void GameSetupGUI::setupPlayerCountScreen() {
     labels.clear();
     
     // Main Title
-    sf::Text title;
-    if (fontLoaded) {
-        title.setFont(font);
-    }
-    title.setString("CHOOSE NUMBER OF PLAYERS");
-    title.setCharacterSize(32);
-    title.setFillColor(sf::Color::Black);
-    title.setStyle(sf::Text::Bold);
+    sf::Text title = cachedText("CHOOSE NUMBER OF PLAYERS", 32, sf::Text::Bold, sf::Color::Black);
     
     // Center the title
     sf::FloatRect titleBounds = title.getLocalBounds();
@@ -271,13 +329,7 @@ void GameSetupGUI::setupPlayerCountScreen() {
     labels.push_back(title);
     
     // Subtitle
-    sf::Text subtitle;
-    if (fontLoaded) {
-        subtitle.setFont(font);
-    }
-    subtitle.setString("Select between 2-6 players for your game");
-    subtitle.setCharacterSize(20);
-    subtitle.setFillColor(sf::Color(80, 80, 80));
+    sf::Text subtitle = cachedText("Select between 2-6 players for your game", 20, sf::Text::Regular, sf::Color(80, 80, 80));
     
     sf::FloatRect subtitleBounds = subtitle.getLocalBounds();
     subtitle.setPosition((900 - subtitleBounds.width) / 2, 110);
@@ -288,66 +340,36 @@ void GameSetupGUI::setupPlayerCountScreen() {
         float x = 150 + (i - 2) * 120; // Space them 120 pixels apart
         float y = 200;
         
-        auto button = std::make_unique<Button>(x, y, 90, 90, std::to_string(i), font);
+        // Larger bold number, centered from the cached layout
+        auto button = std::make_unique<Button>(x, y, 90, 90, textCache.get(std::to_string(i), 36, sf::Text::Bold), 8);
         
         // Highlight selected button
         if (i == selectedPlayerCount) {
             button->setSelected(true);
         }
         
-        // Make number text larger
-        button->buttonText.setCharacterSize(36);
-        button->buttonText.setStyle(sf::Text::Bold);
-        
-        // Re-center the text after size change
-        sf::FloatRect textBounds = button->buttonText.getLocalBounds();
-        button->buttonText.setPosition(
-            x + (90 - textBounds.width) / 2,
-            y + (90 - textBounds.height) / 2 - 8
-        );
-        
         buttons.push_back(std::move(button));
     }
     
     // Current selection display
-    sf::Text selection;
-    if (fontLoaded) {
-        selection.setFont(font);
-    }
-    selection.setString("Selected: " + std::to_string(selectedPlayerCount) + " players");
-    selection.setCharacterSize(24);
-    selection.setFillColor(sf::Color(50, 120, 200));
-    selection.setStyle(sf::Text::Bold);
+    sf::Text selection = cachedText("Selected: " + std::to_string(selectedPlayerCount) + " players", 24,
+                                    sf::Text::Bold, sf::Color(50, 120, 200));
     
     sf::FloatRect selectionBounds = selection.getLocalBounds();
     selection.setPosition((900 - selectionBounds.width) / 2, 350);
     labels.push_back(selection);
     
     // Instructions
-    sf::Text instruction;
-    if (fontLoaded) {
-        instruction.setFont(font);
-    }
-    instruction.setString("Click on a number above, then click NEXT to continue");
-    instruction.setCharacterSize(18);
-    instruction.setFillColor(sf::Color(120, 120, 120));
+    sf::Text instruction = cachedText("Click on a number above, then click NEXT to continue", 18,
+                                      sf::Text::Regular, sf::Color(120, 120, 120));
     
     sf::FloatRect instructionBounds = instruction.getLocalBounds();
     instruction.setPosition((900 - instructionBounds.width) / 2, 400);
     labels.push_back(instruction);
     
     // Next button - prominent blue button
-    auto nextButton = std::make_unique<Button>(375, 480, 150, 60, "NEXT", font);
+    auto nextButton = std::make_unique<Button>(375, 480, 150, 60, textCache.get("NEXT", 26, sf::Text::Bold));
     nextButton->shape.setFillColor(sf::Color(50, 120, 200)); // Blue
-    nextButton->buttonText.setCharacterSize(26);
-    nextButton->buttonText.setStyle(sf::Text::Bold);
-    
-    // Re-center text in next button
-    sf::FloatRect nextTextBounds = nextButton->buttonText.getLocalBounds();
-    nextButton->buttonText.setPosition(
-        375 + (150 - nextTextBounds.width) / 2,
-        480 + (60 - nextTextBounds.height) / 2 - 5
-    );
     
     buttons.push_back(std::move(nextButton));
 }
@@ -376,7 +398,7 @@ void GameSetupGUI::setupPlayerNamesScreen() {
     if (fontLoaded) {
         subtitle.setFont(font);
     }
-    subtitle.setString("Enter a unique name for each player");
+    subtitle.setString("Enter a unique name for each player, or bot:greedy, bot:couper, ...");
     subtitle.setCharacterSize(18);
     subtitle.setFillColor(sf::Color(80, 80, 80));
     
@@ -405,15 +427,12 @@ void GameSetupGUI::setupPlayerNamesScreen() {
     
     float buttonY = startY + selectedPlayerCount * 60 + 40;
     
-    auto backButton = std::make_unique<Button>(250, buttonY, 120, 50, "BACK", font);
+    auto backButton = std::make_unique<Button>(250, buttonY, 120, 50, textCache.get("BACK", 20, sf::Text::Bold));
     backButton->shape.setFillColor(sf::Color(150, 150, 150));
-    backButton->buttonText.setCharacterSize(20);
     buttons.push_back(std::move(backButton));
     
-    auto startButton = std::make_unique<Button>(430, buttonY, 200, 50, "START GAME", font);
+    auto startButton = std::make_unique<Button>(430, buttonY, 200, 50, textCache.get("START GAME", 20, sf::Text::Bold));
     startButton->shape.setFillColor(sf::Color(220, 60, 60));
-    startButton->buttonText.setCharacterSize(20);
-    startButton->buttonText.setStyle(sf::Text::Bold);
     buttons.push_back(std::move(startButton));
     
     if (fontLoaded) {
@@ -433,12 +452,7 @@ void GameSetupGUI::setupGameScreen(std::string message) {
     playerInputs.clear();
 
     // === כותרת המשחק ===
-    sf::Text title;
-    if (fontLoaded) title.setFont(font);
-    title.setString("C O U P");
-    title.setCharacterSize(32);
-    title.setFillColor(sf::Color(220, 20, 60));
-    title.setStyle(sf::Text::Bold);
+    sf::Text title = cachedText("C O U P", 32, sf::Text::Bold, sf::Color(220, 20, 60));
     sf::FloatRect titleBounds = title.getLocalBounds();
     title.setPosition((900 - titleBounds.width) / 2, 10);
     labels.push_back(title);
@@ -469,7 +483,7 @@ void GameSetupGUI::setupGameScreen(std::string message) {
     for (size_t i = 0; i < actions.size(); ++i) {
         auto actionBtn = std::make_unique<Button>(
             buttonStartX + i * buttonSpacing, buttonY, buttonWidth, buttonHeight,
-            actions[i].displayName, font
+            textCache.get(actions[i].displayName, 20, sf::Text::Bold)
         );
         actionBtn->shape.setFillColor(actions[i].color);
         buttons.push_back(std::move(actionBtn));
@@ -489,37 +503,26 @@ void GameSetupGUI::setupGameScreen(std::string message) {
         {250, 300} // Left middle seat 
     };
 
-    size_t numPlayers = _game.getPlayers().size();
+    std::vector<std::shared_ptr<Player>> players = _game.getPlayers();
+    size_t numPlayers = players.size();
+    size_t currentIndex = static_cast<size_t>(_game.currentPlayerIndex());
 
+    // Names and roles never change during a game, so their layout comes from the cache
     for (size_t i = 0; i < numPlayers && i < seats.size(); ++i) {
         sf::Vector2f pos = seats[i];
-        bool isCurrentPlayer = (i == static_cast<size_t>(_game.currentPlayerIndex()));
-
+        bool isCurrentPlayer = (i == currentIndex);
 
-        sf::Text playerName;
-        if (fontLoaded) playerName.setFont(font);
-        playerName.setString(_game.getPlayers()[i]->getName());
-        playerName.setCharacterSize(18);
-        playerName.setFillColor(isCurrentPlayer ? sf::Color::Green : sf::Color::Red);
-        playerName.setStyle(sf::Text::Bold);
+        sf::Text playerName = cachedText(players[i]->getName(), 18, sf::Text::Bold,
+                                         isCurrentPlayer ? sf::Color::Green : sf::Color::Red);
         sf::FloatRect nameBounds = playerName.getLocalBounds();
         playerName.setPosition(pos.x - nameBounds.width / 2, pos.y - 20);
 
-        sf::Text roleText;
-        if (fontLoaded) roleText.setFont(font);
-        roleText.setString(_game.getPlayers()[i]->get_type());
-        roleText.setCharacterSize(14);
-        roleText.setFillColor(sf::Color(200, 200, 200));
+        sf::Text roleText = cachedText(players[i]->get_type(), 14, sf::Text::Regular, sf::Color(200, 200, 200));
         sf::FloatRect roleBounds = roleText.getLocalBounds();
         roleText.setPosition(pos.x - roleBounds.width / 2, pos.y);
 
-        sf::Text coinText;
-        if (fontLoaded) coinText.setFont(font);
-        std::string coinDisplay = isCurrentPlayer ? std::to_string(_game.getPlayers()[i]->getCoins()) : "???";
-        coinText.setString("coins: " + coinDisplay);
-        coinText.setCharacterSize(16);
-        coinText.setFillColor(sf::Color::Black);
-        coinText.setStyle(sf::Text::Bold);
+        std::string coinDisplay = isCurrentPlayer ? std::to_string(players[i]->getCoins()) : "???";
+        sf::Text coinText = cachedText("coins: " + coinDisplay, 16, sf::Text::Bold, sf::Color::Black);
         sf::FloatRect coinBounds = coinText.getLocalBounds();
         coinText.setPosition(pos.x - coinBounds.width / 2, pos.y + 20);
 
@@ -531,30 +534,17 @@ void GameSetupGUI::setupGameScreen(std::string message) {
 
     }
 
-    sf::Text statusText;
-    if (fontLoaded) statusText.setFont(font);
-    statusText.setString(message);
-    statusText.setCharacterSize(16);
-    statusText.setFillColor(sf::Color::Blue);
-    statusText.setStyle(sf::Text::Italic);
+    sf::Text statusText = cachedText(message, 16, sf::Text::Italic, sf::Color::Blue);
     statusText.setPosition(50, 550); // קרוב לתחתית המסך
     labels.push_back(statusText);
 
     // === מידע משחק בפינה ימנית עליונה ===
-    sf::Text gameInfo;
-    if (fontLoaded) gameInfo.setFont(font);
-    gameInfo.setString("Turn: " + _game.turn());
-    gameInfo.setCharacterSize(18);
-    gameInfo.setFillColor(sf::Color(50, 50, 50));
-    gameInfo.setStyle(sf::Text::Bold);
+    sf::Text gameInfo = cachedText("Turn: " + _game.turn(), 18, sf::Text::Bold, sf::Color(50, 50, 50));
     gameInfo.setPosition(700, 120);
     labels.push_back(gameInfo);
 
-    sf::Text playerCount;
-    if (fontLoaded) playerCount.setFont(font);
-    playerCount.setString("Players: " + std::to_string(numPlayers));
-    playerCount.setCharacterSize(16);
-    playerCount.setFillColor(sf::Color(100, 100, 100));
+    sf::Text playerCount = cachedText("Players: " + std::to_string(numPlayers), 16, sf::Text::Regular,
+                                      sf::Color(100, 100, 100));
     playerCount.setPosition(700, 145);
     labels.push_back(playerCount);
 }
@@ -641,6 +631,7 @@ void GameSetupGUI::handleMouseClick(sf::Vector2i mousePos) {
 }
 
 void GameSetupGUI::handleGameAction(size_t buttonIndex) {
+    COUP_TRACE_SCOPE("GameSetupGUI::handleGameAction");
     // Assuming order matches your actions vector from setupGameScreen()
     int turn = _game.currentPlayerIndex();
     std::string message;
@@ -656,9 +647,9 @@ void GameSetupGUI::handleGameAction(size_t buttonIndex) {
             }
         case 1:  // Tax
             try {
-                _game.getPlayers()[turn]->tax();
+                _flow.begin(Move{Action::Tax, Move::NO_TARGET});
                 message = "Tax action triggered\n";
-                askAllWithRole("Governor");
+                resolveBlockWindow();
                 break;
             } catch (const std::exception& e) {
                 message = e.what();
@@ -667,9 +658,9 @@ void GameSetupGUI::handleGameAction(size_t buttonIndex) {
           
         case 2:  // Bribe
             try {
-                _game.getPlayers()[turn]->bribe();
+                _flow.begin(Move{Action::Bribe, Move::NO_TARGET});
                 message = "Bribe action triggered\n";
-                askAllWithRole("Judge");
+                resolveBlockWindow();
                 break;
             } catch (const std::exception& e) {
                 message = e.what();
@@ -710,15 +701,16 @@ void GameSetupGUI::handleGameAction(size_t buttonIndex) {
         }
         case 5:{  // Coup
             std::shared_ptr<Player> selected = displayPlayerSelection(" Choose Coup");
+            if (!selected) {
+                message = "You didnt select a player";
+                break;
+            }
             try {
-                std::shared_ptr<Player> current = _game.currentPlayer();
-                _game.getPlayers()[turn]->coup(*selected);
-                if(selected->get_type() == "General" && selected->getCoins() >=5){
-                    selected->ability(*current);
+                _flow.begin(Move{Action::Coup, positionOf(*selected)});
+                if(_flow.blocker() == selected.get()){
                     message = "The general block the coup for himself";
                 }
-                if(current->getLastAction() == Action::Coup)
-                    askAllWithRole("General");
+                resolveBlockWindow();
                 std::cout << "Coup action triggered\n";
                 break;
             } catch (const std::exception& e) {
@@ -747,8 +739,8 @@ void GameSetupGUI::handleGameAction(size_t buttonIndex) {
                 break;
             }
     }
-    
-    
+    playBotTurns(message);
+
     if(!_game.isGame()){
         currentScreen = GAME_END;
         showGameEndScreen();
@@ -758,22 +750,58 @@ void GameSetupGUI::handleGameAction(size_t buttonIndex) {
 
 
 
-void GameSetupGUI::askAllWithRole(const std::string& role) {
-    for (const auto& player : _game.getPlayers()) {
-        if (player->get_type() == role && player->getName() != _game.getPlayers()[_game.currentPlayerIndex()]->getName()) { // נניח שאתה בודק גם אם השחקן חי
-            
-            if(role == "General" && player->getCoins() < 5){
-                    continue;
-            }
-            bool approved = allowAction(player->getName()); // מציג שם מלא
-            if (approved) {
-                if((role == "General" && player->getCoins() < 5)){
-                    continue;
-                }
-                player->ability(*_game.currentPlayer());
-            }
+/**
+ * @brief Asks every player who may block the last move, one dialog at a time.
+ *
+ * The turn itself lives in _flow and does not wait on the dialogs; this only feeds
+ * the answers back until the block window is closed.
+ */
+void GameSetupGUI::resolveBlockWindow() {
+    while (_flow.waiting()) {
+        auto bot = _bots.find(&_flow.responder());
+        bool block = bot != _bots.end() ? bot->second.block(_flow) : allowAction(_flow.responder().getName());
+        _flow.respond(block);
+    }
+}
+
+/**
+ * @brief Plays the turns of bot seats until a human is to move or the game ends.
+ *
+ * Bot moves go through _flow like the buttons' moves, so humans still get their
+ * block dialogs. A table of bots only is played out, up to a safety limit.
+ *
+ * @param message Receives what the last bot did, for the status line.
+ */
+void GameSetupGUI::playBotTurns(std::string& message) {
+    for (size_t played = 0; played < 1000 && _game.isGame() && _game.playerCount() > 1; ++played) {
+        Player& actor = _game.playerAt(static_cast<size_t>(_game.currentPlayerIndex()));
+        auto bot = _bots.find(&actor);
+        if (bot == _bots.end()) {
+            return;
+        }
+        Move move = bot->second.choose(_game);
+        std::string name = actor.getName();
+        try {
+            _flow.begin(move);
+            resolveBlockWindow();
+            message = name + " played " + metrics::actionName(move.action);
+        } catch (const std::exception& e) {
+            message = name + ": " + e.what();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Position of an active player in the game's players list, as used by Move targets.
+ */
+std::uint8_t GameSetupGUI::positionOf(const Player& player) const {
+    for (size_t i = 0; i < _game.playerCount(); ++i) {
+        if (&_game.playerAt(i) == &player) {
+            return static_cast<std::uint8_t>(i);
         }
     }
+    return Move::NO_TARGET;
 }
 
 
@@ -897,7 +925,7 @@ std::shared_ptr<Player> GameSetupGUI::displayPlayerSelection(const std::string&
     for (size_t i = 0; i < players.size(); ++i) {
         float y = startY + i * 60;
         playerButtons.push_back(std::make_unique<Button>(
-            100, y, 300, 50, players[i]->getName(), font
+            100, y, 300, 50, textCache.get(players[i]->getName(), 20, sf::Text::Bold)
         ));
     }
 
@@ -950,6 +978,7 @@ void GameSetupGUI::update() {
 }
 
 void GameSetupGUI::render() {
+    COUP_TRACE_SCOPE("GameSetupGUI::render");
     window.clear(sf::Color(245,245,250)); // Clear the window with black color
     
     // Draw player boxes (e.g. for highlighting players or UI decoration)
@@ -988,6 +1017,8 @@ void GameSetupGUI::startGame() {
     // Clear previous error message
     errorText.setString("");
 
+    std::vector<std::pair<size_t, BotKind>> botSeats;
+
     // Check for empty names
     for (const auto& input : playerInputs) {
         if (input == nullptr) {
@@ -1001,6 +1032,16 @@ void GameSetupGUI::startGame() {
             currentScreen = PLAYER_NAMES_INPUT;  // stay on the input screen
             return;  // exit so user can fix input
         }
+        // "bot:<kind>" seats a bot; the seat number keeps several bots of one kind apart
+        BotKind kind;
+        if (Bot::parseSeat(name, kind)) {
+            botSeats.emplace_back(playerNames.size(), kind);
+            name += " #" + std::to_string(playerNames.size() + 1);
+        } else if (name.compare(0, 4, "bot:") == 0) {
+            errorText.setString("Unknown bot: " + name);
+            currentScreen = PLAYER_NAMES_INPUT;
+            return;
+        }
         playerNames.push_back(name);
     }
 
@@ -1020,10 +1061,19 @@ void GameSetupGUI::startGame() {
     for (const auto& name : playerNames) {
         _game.add_player(name);
     }
+    for (const auto& seat : botSeats) {
+        _bots.emplace(&_game.playerAt(seat.first), Bot(seat.second, static_cast<unsigned int>(seat.first + 1)));
+    }
 
     // Clear error message on success
     errorText.setString("");
-    setupGameScreen("Game started");
+    std::string message = "Game started";
+    playBotTurns(message);
+    if(!_game.isGame()){
+        currentScreen = GAME_END;
+        showGameEndScreen();
+    }
+    setupGameScreen(message);
 }
 
 
@@ -5,12 +5,46 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include "game.hpp"
+#include "engine/turn_flow.hpp"
+#include "ai/bot.hpp"
 
 // Forward declarations
 class Button;
 class TextInput;
 
+// Cache of laid-out texts keyed by (string, size, style).
+// Each entry keeps an sf::Text whose glyph quads are already built plus its
+// measured bounds, so copies can be recoloured and positioned without shaping again.
+class TextLayoutCache {
+public:
+    struct Entry {
+        sf::Text text;
+        sf::FloatRect bounds;
+    };
+
+    explicit TextLayoutCache(const sf::Font& font, size_t maxEntries = 512);
+    const Entry& get(const std::string& str, unsigned int size, sf::Uint32 style = sf::Text::Regular);
+    void clear();
+    size_t size() const;
+
+private:
+    struct Key {
+        std::string str;
+        unsigned int size;
+        sf::Uint32 style;
+        bool operator==(const Key& other) const;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    const sf::Font& font;
+    size_t maxEntries;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+};
+
 // Button class for clickable GUI elements
 class Button {
 public:
@@ -24,7 +58,8 @@ public:
     
     void updateHover(sf::Vector2i mousePos);
     
-    Button(float x, float y, float width, float height, const std::string& text, sf::Font& font);
+    Button(float x, float y, float width, float height, const TextLayoutCache::Entry& label, float yOffset = 5);
+    void setLabel(const TextLayoutCache::Entry& label, float yOffset = 5);
     void draw(sf::RenderWindow& window);
     bool isClicked(sf::Vector2i mousePos);
     void update(sf::Vector2i mousePos);
@@ -57,9 +92,12 @@ public:
 class GameSetupGUI {
 private:
     Game _game;
+    TurnFlow _flow;
+    std::unordered_map<const Player*, Bot> _bots; // seats entered as "bot:<kind>"
     sf::RenderWindow window;
     sf::Font font;
     bool fontLoaded;
+    TextLayoutCache textCache;
     std::vector<sf::RectangleShape> playerBoxes;
     sf::Text errorText;
 
@@ -88,10 +126,13 @@ private:
     void render();
     void startGame();
     bool loadFont();
+    sf::Text cachedText(const std::string& str, unsigned int size, sf::Uint32 style, const sf::Color& color);
     void handleGameAction(size_t buttonIndex);
     std::shared_ptr<Player> displayPlayerSelection(const std::string& title);
     bool allowAction(const std::string& playerName);
-    void askAllWithRole(const std::string& role);
+    void resolveBlockWindow();
+    void playBotTurns(std::string& message);
+    std::uint8_t positionOf(const Player& player) const;
     void showGameEndScreen();
 
     
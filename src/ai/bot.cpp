@@ -0,0 +1,184 @@
+#include "bot.hpp"
+#include "game.hpp"
+#include "tablebase.hpp"
+#include "engine/turn_flow.hpp"
+
+namespace {
+
+const char* const KIND_NAMES[] = {"random", "greedy", "couper", "tax", "baron", "spy"};
+static_assert(sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0]) == static_cast<size_t>(BotKind::Count),
+              "every BotKind needs a name");
+
+// Coins the actor gains (or spends) by playing the move; arrests of a Merchant gain nothing
+int coinGain(const Game& game, const Player& actor, const Move& move) {
+    switch (move.action) {
+        case Action::Gather: return 1;
+        case Action::Tax: return actor.role() == Role::Governor ? 3 : 2;
+        case Action::Bribe: return -4;
+        case Action::Arrest: return game.playerAt(move.target).role() == Role::Merchant ? 0 : 1;
+        case Action::Sanction: return game.playerAt(move.target).role() == Role::Judge ? -4 : -3;
+        case Action::Coup: return -7;
+        case Action::Ability: return move.target == Move::NO_TARGET ? 3 : 0; // Baron investment, Spy look
+        default: return 0;
+    }
+}
+
+int targetCoins(const Game& game, const Move& move) {
+    return move.target == Move::NO_TARGET ? 0 : game.playerAt(move.target).getCoins();
+}
+
+}
+
+/**
+ * @brief Creates a bot.
+ *
+ * @param kind The policy it plays.
+ * @param seed Seeds the random bot's choices and its block decisions.
+ */
+Bot::Bot(BotKind kind, unsigned int seed) : _kind(kind), _rng(seed), _tablebase(nullptr), _legal() {}
+
+/**
+ * @brief Picks the move of the player whose turn it is.
+ *
+ * Scores every legal move for the policy and keeps the first of the best, so the
+ * scripted bots are deterministic. With a tablebase set, a two-player position it
+ * holds is played perfectly instead. Nothing is allocated.
+ *
+ * @param game The game, read only; the bot plays for game.currentPlayerIndex().
+ * @return Move A legal move (a pass when nothing else is allowed).
+ */
+Move Bot::choose(const Game& game) {
+    Move solved;
+    if (_tablebase && game.playerCount() == 2 && _tablebase->bestMove(game, solved)) {
+        return solved;
+    }
+    size_t count = moves::legalMoves(game, _legal, moves::MAX_MOVES);
+    if (count == 0) {
+        return Move{};
+    }
+    if (_kind == BotKind::Random) {
+        return _legal[_rng() % count];
+    }
+    if (count == 1) {
+        return _legal[0];
+    }
+    size_t best = 0;
+    int bestScore = score(game, _legal[0]);
+    for (size_t i = 1; i < count; ++i) {
+        int value = score(game, _legal[i]);
+        if (value > bestScore) {
+            bestScore = value;
+            best = i;
+        }
+    }
+    return _legal[best];
+}
+
+/**
+ * @brief Answers a block window for the player being asked.
+ *
+ * Blocking a tax or a bribe is free, so the scripted bots always do. Blocking a coup
+ * costs a General 5 coins to bring somebody else back, which is only worth it against
+ * an actor that has more coins than the General. The random bot flips a coin.
+ *
+ * @param flow A flow waiting on this bot's player (flow.responder()).
+ * @return true to block.
+ */
+bool Bot::block(const TurnFlow& flow) {
+    if (_kind == BotKind::Random) {
+        return (_rng() & 1) != 0;
+    }
+    if (flow.move().action != Action::Coup) {
+        return true;
+    }
+    return flow.actor().getCoins() > flow.responder().getCoins();
+}
+
+BotKind Bot::kind() const {
+    return _kind;
+}
+
+/**
+ * @brief Lets the bot play solved two-player endgames from a table; nullptr turns it off.
+ *
+ * @param tablebase Generated or opened table that outlives the bot, shared read-only between bots.
+ */
+void Bot::setTablebase(const Tablebase* tablebase) {
+    _tablebase = tablebase;
+}
+
+/**
+ * @brief Short name of a policy, as used in "bot:<name>" seats.
+ */
+const char* Bot::kindName(BotKind kind) {
+    size_t index = static_cast<size_t>(kind);
+    return index < static_cast<size_t>(BotKind::Count) ? KIND_NAMES[index] : "unknown";
+}
+
+/**
+ * @brief Recognises a seat that should be played by a bot.
+ *
+ * @param seat A seat name such as "bot:greedy".
+ * @param kind Receives the policy when the name is a bot seat.
+ * @return true if the name is "bot:" followed by a policy name.
+ */
+bool Bot::parseSeat(const std::string& seat, BotKind& kind) {
+    static const std::string PREFIX = "bot:";
+    if (seat.compare(0, PREFIX.size(), PREFIX) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < static_cast<size_t>(BotKind::Count); ++i) {
+        if (seat.compare(PREFIX.size(), std::string::npos, KIND_NAMES[i]) == 0) {
+            kind = static_cast<BotKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Value of a legal move for the current player under the bot's policy; higher is better.
+ */
+int Bot::score(const Game& game, const Move& move) const {
+    const Player& actor = game.playerAt(static_cast<size_t>(game.currentPlayerIndex()));
+    int gain = coinGain(game, actor, move);
+    int victim = targetCoins(game, move);
+    bool baronInvest = move.action == Action::Ability && move.target == Move::NO_TARGET;
+    bool spyLook = move.action == Action::Ability && move.target != Move::NO_TARGET;
+
+    switch (_kind) {
+        case BotKind::Greedy:
+            switch (move.action) {
+                case Action::Coup: return 1000 + victim;
+                case Action::Tax: return actor.role() == Role::Governor ? 30 : 20;
+                case Action::Ability: return baronInvest ? 25 : 1;
+                case Action::Sanction: return 10 + victim;
+                case Action::Arrest: return 15 + victim;
+                case Action::Gather: return 10;
+                case Action::Bribe: return 5;
+                default: return 0;
+            }
+        case BotKind::TaxMaximizer:
+            return 10 * gain;
+        case BotKind::BaronInvestor:
+            if (baronInvest) {
+                return 2000;
+            }
+            break;
+        case BotKind::SpyArrester:
+            if (spyLook) {
+                return 2000 + victim;
+            }
+            if (move.action == Action::Arrest && actor.role() == Role::Spy) {
+                return 500 + 10 * gain + victim;
+            }
+            break;
+        default:
+            break;
+    }
+    // Couper, and the fallback of the plans above: coup the richest, otherwise grow fastest
+    if (move.action == Action::Coup) {
+        return 1000 + victim;
+    }
+    return spyLook ? -1 : 10 * gain;
+}
@@ -0,0 +1,48 @@
+#ifndef BOT_HPP
+#define BOT_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include "engine/move.hpp"
+
+class Game;
+class Tablebase;
+class TurnFlow;
+
+// Scripted policies, from plain random play to simple fixed plans
+enum class BotKind : std::uint8_t {
+    Random,        // uniform over the legal moves
+    Greedy,        // coups first, then income, then hurting the richest opponent
+    Couper,        // coups the richest opponent as soon as it has 7 coins, builds coins otherwise
+    TaxMaximizer,  // largest immediate coin gain; coups only when forced to
+    BaronInvestor, // a Baron invests whenever it can; everyone else plays like Couper
+    SpyArrester,   // a Spy blinds the richest opponent, then arrests; everyone else plays like Couper
+    Count
+};
+
+// A computer player. Every decision is one scan of moves::legalMoves() into a buffer
+// inside the bot: no allocation and no search, so a bot can fill a table seat or play
+// out thousands of rollouts for a search. One bot per thread; choose() is not const.
+class Bot {
+public:
+    explicit Bot(BotKind kind, unsigned int seed = 1);
+
+    Move choose(const Game& game);
+    bool block(const TurnFlow& flow);
+    BotKind kind() const;
+    void setTablebase(const Tablebase* tablebase);
+
+    static const char* kindName(BotKind kind);
+    static bool parseSeat(const std::string& seat, BotKind& kind);
+
+private:
+    int score(const Game& game, const Move& move) const;
+
+    BotKind _kind;
+    std::mt19937 _rng;
+    const Tablebase* _tablebase; // two-player positions are looked up here when set
+    Move _legal[moves::MAX_MOVES];
+};
+
+#endif // BOT_HPP
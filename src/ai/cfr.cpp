@@ -0,0 +1,482 @@
+#include "cfr.hpp"
+#include "bot.hpp"
+#include "game.hpp"
+#include "engine/snapshot.hpp"
+#include "mix.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t PROBE_LIMIT = 64;
+constexpr size_t ROLLOUT_MOVES = 300; // a rollout still running after this many moves is a draw
+constexpr int COIN_CAP = 12;
+const char CHECKPOINT_MAGIC[4] = {'C', 'F', 'R', '1'};
+const char* const SEAT_NAMES[] = {"p0", "p1", "p2", "p3", "p4", "p5", "p6", "p7",
+                                  "p8", "p9", "p10", "p11", "p12", "p13", "p14", "p15"};
+
+using hashing::mix;
+
+std::uint64_t actionKey(std::uint64_t infoSet, size_t action) {
+    std::uint64_t key = mix(infoSet + action + 1);
+    return key ? key : 1; // 0 marks an empty slot
+}
+
+// Position of the player dealt into seat `seat`, or playerCount() once it is out
+size_t positionOfSeat(const Game& game, size_t seat) {
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        if (game.playerAt(i).getIndex() == seat) {
+            return i;
+        }
+    }
+    return game.playerCount();
+}
+
+// Regret matching: play in proportion to positive regret, uniformly when there is none
+void currentStrategy(RegretTable::Entry* const* entries, size_t count, double* out) {
+    double positive = 0;
+    for (size_t i = 0; i < count; ++i) {
+        std::int32_t regret = entries[i] ? entries[i]->regret.load(std::memory_order_relaxed) : 0;
+        out[i] = regret > 0 ? static_cast<double>(regret) : 0.0;
+        positive += out[i];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = positive > 0 ? out[i] / positive : 1.0 / static_cast<double>(count);
+    }
+}
+
+void putU32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+void putU64(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    putU32(out, static_cast<std::uint32_t>(value));
+    putU32(out, static_cast<std::uint32_t>(value >> 32));
+}
+
+std::uint32_t getU32(const std::vector<std::uint8_t>& in, size_t& at) {
+    if (at + 4 > in.size()) {
+        throw std::runtime_error("Truncated CFR checkpoint.");
+    }
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(in[at++]) << (8 * i);
+    }
+    return value;
+}
+
+std::uint64_t getU64(const std::vector<std::uint8_t>& in, size_t& at) {
+    std::uint64_t low = getU32(in, at);
+    return low | static_cast<std::uint64_t>(getU32(in, at)) << 32;
+}
+
+// Everything one thread needs for a traversal, allocated once per thread
+class Worker {
+public:
+    Worker(const CfrOptions& options, RegretTable& table, std::uint64_t seed)
+        : _options(options), _table(table), _rng(seed), _rollout(BotKind::Greedy, static_cast<unsigned int>(seed)),
+          _names(SEAT_NAMES, SEAT_NAMES + options.players) {
+        for (auto& image : _images) {
+            image.reserve(512);
+        }
+    }
+
+    void iterate(std::uint64_t iteration) {
+        unsigned int seed = _options.seed + static_cast<unsigned int>(iteration) * 2654435761u;
+        Game game(_names, seed);
+        traverse(game, static_cast<size_t>(iteration % _options.players), 0);
+    }
+
+private:
+    // Value of the position for the traverser: its chance of winning, 1/alive for a draw
+    double outcome(const Game& game, size_t traverser) const {
+        if (positionOfSeat(game, traverser) == game.playerCount()) {
+            return 0.0;
+        }
+        return 1.0 / static_cast<double>(game.playerCount());
+    }
+
+    double rollout(Game& game, size_t traverser) {
+        for (size_t played = 0; played < ROLLOUT_MOVES && game.isGame() && game.playerCount() > 1; ++played) {
+            moves::apply(game, _rollout.choose(game));
+        }
+        return outcome(game, traverser);
+    }
+
+    double traverse(Game& game, size_t traverser, size_t depth) {
+        if (!game.isGame() || game.playerCount() < 2 || positionOfSeat(game, traverser) == game.playerCount()) {
+            return outcome(game, traverser);
+        }
+        if (depth >= _options.depth) {
+            return rollout(game, traverser);
+        }
+        Move* legal = _legal[depth];
+        size_t count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+        if (count == 1) {
+            moves::apply(game, legal[0]);
+            return traverse(game, traverser, depth + 1);
+        }
+
+        std::uint64_t infoSet = CfrSolver::infoSetKey(game, legal, count);
+        RegretTable::Entry** entries = _entries[depth];
+        for (size_t i = 0; i < count; ++i) {
+            entries[i] = _table.insert(actionKey(infoSet, i));
+        }
+        double* strategy = _strategy[depth];
+        currentStrategy(entries, count, strategy);
+
+        if (game.playerAt(static_cast<size_t>(game.currentPlayerIndex())).getIndex() != traverser) {
+            // Someone else decides: record their strategy and follow one sampled move
+            for (size_t i = 0; i < count; ++i) {
+                if (entries[i]) {
+                    RegretTable::addWeight(*entries[i], strategy[i]);
+                }
+            }
+            double draw = std::uniform_real_distribution<double>(0.0, 1.0)(_rng);
+            size_t pick = count - 1;
+            for (size_t i = 0; i + 1 < count; ++i) {
+                draw -= strategy[i];
+                if (draw < 0) {
+                    pick = i;
+                    break;
+                }
+            }
+            moves::apply(game, legal[pick]);
+            return traverse(game, traverser, depth + 1);
+        }
+
+        // The traverser decides: try every move from the same position
+        std::vector<std::uint8_t>& image = _images[depth];
+        image.clear();
+        Snapshot::write(game, image);
+        double utilities[moves::MAX_MOVES];
+        double value = 0;
+        for (size_t i = 0; i < count; ++i) {
+            moves::apply(game, legal[i]);
+            utilities[i] = traverse(game, traverser, depth + 1);
+            Snapshot::read(game, image.data(), image.size());
+            value += strategy[i] * utilities[i];
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (entries[i]) {
+                RegretTable::addRegret(*entries[i], utilities[i] - value);
+            }
+        }
+        return value;
+    }
+
+    const CfrOptions& _options;
+    RegretTable& _table;
+    std::mt19937_64 _rng;
+    Bot _rollout;
+    std::vector<std::string> _names;
+    Move _legal[CfrSolver::MAX_DEPTH][moves::MAX_MOVES];
+    double _strategy[CfrSolver::MAX_DEPTH][moves::MAX_MOVES];
+    RegretTable::Entry* _entries[CfrSolver::MAX_DEPTH][moves::MAX_MOVES];
+    std::vector<std::uint8_t> _images[CfrSolver::MAX_DEPTH];
+};
+
+}
+
+/**
+ * @brief Creates an empty table of 2^bits entries.
+ *
+ * @throws std::runtime_error If bits is outside 4..32.
+ */
+RegretTable::RegretTable(unsigned int bits) : _mask(0), _entries(), _size(0), _dropped(0) {
+    if (bits < 4 || bits > 32) {
+        throw std::runtime_error("Regret table size must be 2^4 .. 2^32 entries.");
+    }
+    _mask = (size_t(1) << bits) - 1;
+    _entries.reset(new Entry[_mask + 1]()); // value-initialised: every key 0 (empty)
+}
+
+/**
+ * @brief Looks an entry up without claiming a slot.
+ *
+ * @return Entry* The entry, or nullptr if the key was never inserted.
+ */
+RegretTable::Entry* RegretTable::find(std::uint64_t key) const {
+    for (size_t probe = 0; probe < PROBE_LIMIT; ++probe) {
+        Entry& entry = _entries[(key + probe) & _mask];
+        std::uint64_t stored = entry.key.load(std::memory_order_acquire);
+        if (stored == key) {
+            return &entry;
+        }
+        if (stored == 0) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Finds an entry, claiming an empty slot for it if needed.
+ *
+ * @param key Non-zero hashed (information set, action) key.
+ * @return Entry* The entry, or nullptr if PROBE_LIMIT slots from its home are all taken
+ * (counted in dropped(); the solver then treats the action as having no regret).
+ */
+RegretTable::Entry* RegretTable::insert(std::uint64_t key) {
+    for (size_t probe = 0; probe < PROBE_LIMIT; ++probe) {
+        Entry& entry = _entries[(key + probe) & _mask];
+        std::uint64_t stored = entry.key.load(std::memory_order_acquire);
+        if (stored == 0) {
+            if (entry.key.compare_exchange_strong(stored, key, std::memory_order_acq_rel)) {
+                _size.fetch_add(1, std::memory_order_relaxed);
+                return &entry;
+            }
+        }
+        if (stored == key) {
+            return &entry;
+        }
+    }
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+const RegretTable::Entry& RegretTable::slot(size_t index) const {
+    return _entries[index & _mask];
+}
+
+size_t RegretTable::capacity() const {
+    return _mask + 1;
+}
+
+size_t RegretTable::size() const {
+    return _size.load(std::memory_order_relaxed);
+}
+
+std::uint64_t RegretTable::dropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds to an entry's regret, in REGRET_SCALE units, saturating at the int32 range.
+ */
+void RegretTable::addRegret(Entry& entry, double amount) {
+    double next = static_cast<double>(entry.regret.load(std::memory_order_relaxed)) +
+                  std::round(amount * REGRET_SCALE);
+    next = std::max(next, static_cast<double>(std::numeric_limits<std::int32_t>::min()));
+    next = std::min(next, static_cast<double>(std::numeric_limits<std::int32_t>::max()));
+    entry.regret.store(static_cast<std::int32_t>(next), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds to an entry's average-strategy weight, in WEIGHT_SCALE units, saturating.
+ */
+void RegretTable::addWeight(Entry& entry, double amount) {
+    double next = static_cast<double>(entry.weight.load(std::memory_order_relaxed)) +
+                  std::round(amount * WEIGHT_SCALE);
+    next = std::min(next, static_cast<double>(std::numeric_limits<std::uint32_t>::max()));
+    entry.weight.store(static_cast<std::uint32_t>(next), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Creates a solver with an empty regret table.
+ *
+ * @throws std::runtime_error If the options are out of range.
+ */
+CfrSolver::CfrSolver(const CfrOptions& options)
+    : _options(options), _table(options.tableBits), _iterations(0) {
+    if (options.players < 2 || options.players > moves::MAX_TABLE) {
+        throw std::runtime_error("CFR needs 2 to 16 players.");
+    }
+    if (options.depth < 1 || options.depth > MAX_DEPTH) {
+        throw std::runtime_error("CFR depth must be 1 .. 32 plies.");
+    }
+}
+
+/**
+ * @brief Runs more iterations, spread over threads that share the regret table.
+ *
+ * Iteration k always deals the table from the same seed and traverses for seat
+ * k % players, so a resumed run continues exactly where the checkpoint stopped.
+ *
+ * @param iterations How many iterations to add.
+ * @param threads Worker threads; 0 or 1 runs on the calling thread.
+ */
+void CfrSolver::run(std::uint64_t iterations, size_t threads) {
+    std::uint64_t first = _iterations.load(std::memory_order_relaxed);
+    std::uint64_t end = first + iterations;
+    std::atomic<std::uint64_t> next(first);
+    auto work = [&](std::uint64_t seed) {
+        auto worker = std::make_unique<Worker>(_options, _table, seed);
+        for (std::uint64_t k = next.fetch_add(1); k < end; k = next.fetch_add(1)) {
+            worker->iterate(k);
+        }
+    };
+    if (threads <= 1) {
+        work(mix(_options.seed + first));
+    } else {
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < threads; ++t) {
+            pool.emplace_back(work, mix(_options.seed + first + t));
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+    _iterations.store(end, std::memory_order_relaxed);
+}
+
+std::uint64_t CfrSolver::iterations() const {
+    return _iterations.load(std::memory_order_relaxed);
+}
+
+const CfrOptions& CfrSolver::options() const {
+    return _options;
+}
+
+const RegretTable& CfrSolver::table() const {
+    return _table;
+}
+
+/**
+ * @brief The solver's average strategy for the player to move.
+ *
+ * @param game Position to look up.
+ * @param out Receives the legal moves (moves::MAX_MOVES entries).
+ * @param probabilities Receives the probability of each move; uniform for an unseen position.
+ * @return size_t Number of moves written.
+ */
+size_t CfrSolver::averageStrategy(const Game& game, Move* out, double* probabilities) const {
+    size_t count = moves::legalMoves(game, out, moves::MAX_MOVES);
+    if (count == 0) {
+        return 0;
+    }
+    std::uint64_t infoSet = infoSetKey(game, out, count);
+    double total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const RegretTable::Entry* entry = _table.find(actionKey(infoSet, i));
+        probabilities[i] = entry ? static_cast<double>(entry->weight.load(std::memory_order_relaxed)) : 0.0;
+        total += probabilities[i];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        probabilities[i] = total > 0 ? probabilities[i] / total : 1.0 / static_cast<double>(count);
+    }
+    return count;
+}
+
+/**
+ * @brief Hashes what the player to move can see into an information-set key.
+ *
+ * @param game The position.
+ * @param legal The legal moves of the player to move, from moves::legalMoves().
+ * @param count Number of legal moves.
+ */
+std::uint64_t CfrSolver::infoSetKey(const Game& game, const Move* legal, size_t count) {
+    size_t n = game.playerCount();
+    size_t self = static_cast<size_t>(game.currentPlayerIndex());
+    const Player& actor = game.playerAt(self);
+    std::uint64_t h = mix(n);
+    auto add = [&h](std::uint64_t value) { h = mix(h ^ value); };
+
+    add(static_cast<std::uint64_t>(actor.role()) | static_cast<std::uint64_t>(std::min(actor.getCoins(), COIN_CAP)) << 8 |
+        std::uint64_t(actor.isSanctioned()) << 16 | std::uint64_t(actor.getCanArrest()) << 17 |
+        std::uint64_t(actor.getLastAction() == Action::Ability) << 18 | std::uint64_t(actor.isArrested()) << 19 |
+        std::uint64_t(game.getBribe()) << 20);
+    for (size_t offset = 1; offset < n; ++offset) {
+        const Player& other = game.playerAt((self + offset) % n);
+        add(static_cast<std::uint64_t>(other.role()) | std::uint64_t(other.isSanctioned()) << 8 |
+            std::uint64_t(other.isArrested()) << 9 | std::uint64_t(other.getCanArrest()) << 10);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        std::uint64_t target = legal[i].target == Move::NO_TARGET ? 0xFF : (legal[i].target + n - self) % n;
+        add(static_cast<std::uint64_t>(legal[i].action) | target << 8 | std::uint64_t(0x100000) * (i + 1));
+    }
+    return h;
+}
+
+/**
+ * @brief Writes the options, the iteration count and every used entry to a file.
+ *
+ * The file is written next to the destination and renamed over it, so an interrupted
+ * save leaves the previous checkpoint intact. Call it between run() calls.
+ *
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void CfrSolver::save(const std::string& path) const {
+    std::vector<std::uint8_t> data(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + 4);
+    putU32(data, static_cast<std::uint32_t>(_options.players));
+    putU32(data, static_cast<std::uint32_t>(_options.depth));
+    putU32(data, _options.seed);
+    putU64(data, iterations());
+    size_t countAt = data.size();
+    putU64(data, 0);
+    std::uint64_t count = 0;
+    for (size_t i = 0; i < _table.capacity(); ++i) {
+        const RegretTable::Entry& entry = _table.slot(i);
+        std::uint64_t key = entry.key.load(std::memory_order_acquire);
+        if (key != 0) {
+            putU64(data, key);
+            putU32(data, static_cast<std::uint32_t>(entry.regret.load(std::memory_order_relaxed)));
+            putU32(data, entry.weight.load(std::memory_order_relaxed));
+            ++count;
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        data[countAt + i] = static_cast<std::uint8_t>(count >> (8 * i));
+    }
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+            throw std::runtime_error("Cannot write CFR checkpoint " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot rename CFR checkpoint to " + path);
+    }
+}
+
+/**
+ * @brief Adds the entries of a checkpoint to the table and resumes its iteration count.
+ *
+ * The table may have a different size than the one that was saved.
+ *
+ * @throws std::runtime_error If the file is missing, corrupt, made for other options,
+ * or does not fit into the table.
+ */
+void CfrSolver::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open CFR checkpoint " + path);
+    }
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 4 || !std::equal(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + 4, data.begin())) {
+        throw std::runtime_error(path + " is not a CFR checkpoint.");
+    }
+    size_t at = 4;
+    std::uint32_t players = getU32(data, at);
+    std::uint32_t depth = getU32(data, at);
+    std::uint32_t seed = getU32(data, at);
+    if (players != _options.players || depth != _options.depth || seed != _options.seed) {
+        throw std::runtime_error("CFR checkpoint was made for " + std::to_string(players) + " players, depth " +
+                                 std::to_string(depth) + ", seed " + std::to_string(seed) + ".");
+    }
+    std::uint64_t iterations = getU64(data, at);
+    std::uint64_t count = getU64(data, at);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::uint64_t key = getU64(data, at);
+        std::int32_t regret = static_cast<std::int32_t>(getU32(data, at));
+        std::uint32_t weight = getU32(data, at);
+        RegretTable::Entry* entry = _table.insert(key);
+        if (!entry) {
+            throw std::runtime_error("CFR checkpoint does not fit into the regret table.");
+        }
+        entry->regret.store(regret, std::memory_order_relaxed);
+        entry->weight.store(weight, std::memory_order_relaxed);
+    }
+    _iterations.store(iterations, std::memory_order_relaxed);
+}
@@ -0,0 +1,86 @@
+#ifndef CFR_HPP
+#define CFR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "engine/move.hpp"
+
+class Game;
+
+// Fixed-size, open-addressing table of (information set, action) entries.
+// Each entry is 16 bytes: the hashed key, the cumulative regret as 1/1024 fixed point and the
+// average-strategy weight as 1/256 fixed point, both saturating. Threads update entries with
+// relaxed loads and stores (a lost update now and then does not hurt the sampled solver), and
+// claim empty slots with a CAS on the key, so no lock is ever taken.
+class RegretTable {
+public:
+    static constexpr std::int32_t REGRET_SCALE = 1024;
+    static constexpr std::uint32_t WEIGHT_SCALE = 256;
+
+    struct Entry {
+        std::atomic<std::uint64_t> key;
+        std::atomic<std::int32_t> regret;
+        std::atomic<std::uint32_t> weight;
+    };
+
+    explicit RegretTable(unsigned int bits);
+
+    Entry* find(std::uint64_t key) const;
+    Entry* insert(std::uint64_t key);
+    const Entry& slot(size_t index) const;
+    size_t capacity() const;
+    size_t size() const;
+    std::uint64_t dropped() const;
+
+    static void addRegret(Entry& entry, double amount);
+    static void addWeight(Entry& entry, double amount);
+
+private:
+    size_t _mask;
+    std::unique_ptr<Entry[]> _entries;
+    std::atomic<size_t> _size;
+    std::atomic<std::uint64_t> _dropped; // inserts refused because the probe window was full
+};
+
+struct CfrOptions {
+    size_t players = 2;       // table size the solver plays, 2 or 3 are practical
+    size_t depth = 6;         // plies searched before a scripted rollout decides the game
+    unsigned int tableBits = 22;
+    unsigned int seed = 1;
+};
+
+// Monte Carlo CFR with external sampling. An iteration deals a table from the next seed, picks
+// the traverser, tries every move at the traverser's decisions, samples one move from the current
+// strategy at everybody else's, and updates regrets and average strategies in the shared table.
+// After `depth` plies the game is played out by the greedy bot and the winner scores 1.
+//
+// The abstraction of a decision is what its player can see: its own role, coins (capped at 12)
+// and flags, the roles and flags of the others in turn order (not their coins), and the list of
+// legal moves with targets relative to the player. Block windows are not part of the game tree.
+class CfrSolver {
+public:
+    static constexpr size_t MAX_DEPTH = 32;
+
+    explicit CfrSolver(const CfrOptions& options);
+
+    void run(std::uint64_t iterations, size_t threads);
+    std::uint64_t iterations() const;
+    const CfrOptions& options() const;
+    const RegretTable& table() const;
+
+    size_t averageStrategy(const Game& game, Move* out, double* probabilities) const;
+    static std::uint64_t infoSetKey(const Game& game, const Move* legal, size_t count);
+
+    void save(const std::string& path) const;
+    void load(const std::string& path);
+
+private:
+    CfrOptions _options;
+    RegretTable _table;
+    std::atomic<std::uint64_t> _iterations;
+};
+
+#endif // CFR_HPP
@@ -0,0 +1,387 @@
+#include "coin_belief.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Four bins per vector: plain SSE on x86-64 and NEON on ARM, so there is no kernel to pick at run time
+typedef float Lanes __attribute__((vector_size(16)));
+typedef std::int32_t Mask __attribute__((vector_size(16)));
+
+constexpr size_t WIDTH = 4;
+constexpr size_t VECTORS = CoinBelief::BINS / WIDTH;
+
+// Open ends of a cut
+constexpr int NO_MIN = -1000;
+constexpr int NO_MAX = 1000;
+// Evidence against a wrong assume() restarts the belief over the coins players usually hold
+constexpr int USUAL_MAX = 12;
+
+static_assert(CoinBelief::BINS % WIDTH == 0, "whole vectors per seat");
+
+inline Lanes load(const float* bins) {
+    Lanes v;
+    std::memcpy(&v, bins, sizeof v);
+    return v;
+}
+
+inline void store(float* bins, Lanes v) {
+    std::memcpy(bins, &v, sizeof v);
+}
+
+inline Lanes splat(float value) {
+    return Lanes{value, value, value, value};
+}
+
+// Bin numbers of vector v
+inline Lanes index(size_t v) {
+    return Lanes{0, 1, 2, 3} + splat(float(v * WIDTH));
+}
+
+// {carry[3], moving[0], moving[1], moving[2]}: moving one lane up, with the lane the vector before
+// pushed out. GCC before 12 only has __builtin_shuffle, clang only __builtin_shufflevector.
+inline Lanes shiftIn(Lanes carry, Lanes moving) {
+#ifdef __clang__
+    return __builtin_shufflevector(carry, moving, 3, 4, 5, 6);
+#else
+    return __builtin_shuffle(carry, moving, Mask{3, 4, 5, 6});
+#endif
+}
+
+size_t seatOf(const Player& player) {
+    if (player.getIndex() >= moves::MAX_TABLE) {
+        throw std::runtime_error("Coin beliefs support seats 0 to 15.");
+    }
+    return player.getIndex();
+}
+
+}
+
+/**
+ * @brief Starts with every seat known to have no coins.
+ */
+CoinBelief::CoinBelief() {
+    for (size_t seat = 0; seat < moves::MAX_TABLE; ++seat) {
+        reveal(seat, 0);
+    }
+}
+
+/**
+ * @brief Takes every seat's coins from the game as known: the start of a game, where everyone's
+ * coins are public, or a position the observer was shown in full.
+ *
+ * @throws std::runtime_error If a seat number is 16 or more.
+ */
+void CoinBelief::reset(const Game& game) {
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        const Player& player = game.playerAt(i);
+        reveal(seatOf(player), player.getCoins());
+    }
+}
+
+/**
+ * @brief Replaces a seat's belief with a uniform one over a range of coins, e.g. for an observer
+ * joining a game in progress. The range starts at bin 0 (only raise() moves mass up the bins) and
+ * is cut to BINS coin counts.
+ *
+ * @throws std::runtime_error If the seat is 16 or more or the range is empty.
+ */
+void CoinBelief::assume(size_t seat, int minCoins, int maxCoins) {
+    if (seat >= moves::MAX_TABLE || minCoins > maxCoins) {
+        throw std::runtime_error("Invalid coin belief range.");
+    }
+    int width = std::min(maxCoins - minCoins + 1, int(BINS));
+    _lowest[seat] = minCoins;
+    float* bins = _bins[seat];
+    std::fill(bins, bins + BINS, 0.0f);
+    std::fill(bins, bins + width, 1.0f / float(width));
+}
+
+/**
+ * @brief Sets a seat's coins as known: the observer's own, or what a Spy saw.
+ *
+ * @throws std::runtime_error If the seat is 16 or more.
+ */
+void CoinBelief::reveal(size_t seat, int coins) {
+    assume(seat, coins, coins);
+}
+
+/**
+ * @brief Plays a move through moves::apply() and updates the beliefs from what any player at the
+ * table could see.
+ *
+ * The beliefs are only touched once the move went through, so a move the engine refuses leaves
+ * them as they were.
+ *
+ * @param game The game; the move is played on it.
+ * @param move A move of the player whose turn it is.
+ * @throws std::runtime_error If the engine refuses the move or a seat number is 16 or more.
+ */
+void CoinBelief::play(Game& game, const Move& move) {
+    const size_t players = game.playerCount();
+    const Player& mover = game.playerAt(static_cast<size_t>(game.currentPlayerIndex()));
+    const size_t actor = seatOf(mover);
+    const Role role = mover.role();
+    const bool targeted = move.target != Move::NO_TARGET && move.target < players;
+    const size_t target = targeted ? seatOf(game.playerAt(move.target)) : 0;
+    const Role targetRole = targeted ? game.playerAt(move.target).role() : Role::Player;
+
+    // A pass means no move was legal: read what that rules out while the flags are still those of
+    // the position it was played in
+    int passLimit = NO_MAX;
+    std::uint32_t broke = 0; // seats that could have been arrested had they had a coin
+    if (move.action == Action::None) {
+        passLimit = role == Role::Baron ? 2 : 3;
+        bool judgesOnly = true;
+        for (size_t i = 0; i < players; ++i) {
+            const Player& other = game.playerAt(i);
+            if (&other == &mover) {
+                continue;
+            }
+            judgesOnly = judgesOnly && other.role() == Role::Judge;
+            if (mover.getCanArrest() && !other.isArrested()) {
+                broke |= 1u << seatOf(other);
+            }
+        }
+        passLimit = judgesOnly ? std::min(passLimit, 3) : std::min(passLimit, 2);
+    }
+    const int turn = game.getTurn();
+
+    moves::apply(game, move);
+
+    switch (move.action) {
+        case Action::None:
+            cut(actor, NO_MIN, passLimit);
+            for (size_t seat = 0; seat < moves::MAX_TABLE; ++seat) {
+                if (broke & (1u << seat)) {
+                    cut(seat, NO_MIN, 0);
+                }
+            }
+            break;
+        case Action::Gather:
+            cut(actor, NO_MIN, 9);
+            shift(actor, 1);
+            break;
+        case Action::Tax:
+            cut(actor, NO_MIN, 9);
+            shift(actor, role == Role::Governor ? 3 : 2);
+            break;
+        case Action::Bribe:
+            cut(actor, 4, 9);
+            shift(actor, -4);
+            break;
+        case Action::Arrest:
+            cut(actor, NO_MIN, 9);
+            cut(target, 1, NO_MAX);
+            if (targetRole == Role::Merchant) {
+                shift(target, -2);
+            } else {
+                shift(target, -1);
+                shift(actor, 1);
+            }
+            break;
+        case Action::Sanction: {
+            int cost = targetRole == Role::Judge ? 4 : 3;
+            cut(actor, cost, 9);
+            shift(actor, -cost);
+            if (targetRole == Role::Baron) {
+                shift(target, 1);
+            }
+            break;
+        }
+        case Action::Coup:
+            cut(actor, 7, NO_MAX);
+            shift(actor, -7);
+            break;
+        case Action::Ability:
+            if (!targeted) { // the Baron's invest; a Spy's look moves no coins
+                cut(actor, 3, 9);
+                shift(actor, 3);
+            }
+            break;
+    }
+
+    // Game::next_turn() starts each turn in between, giving a Merchant its coin and skipping a
+    // sanctioned player who cannot act; the last one it reached is the player to move now
+    if (!game.isGame() || game.playerCount() < 2) {
+        return;
+    }
+    const int now = game.getTurn();
+    const size_t count = game.playerCount();
+    for (int t = turn + 1; t <= now; ++t) {
+        const Player& player = game.playerAt(static_cast<size_t>(t) % count);
+        size_t seat = seatOf(player);
+        if (player.role() == Role::Merchant) {
+            raise(seat, 3);
+        }
+        if (t < now) {
+            cut(seat, NO_MIN, 2);
+        } else if (player.isSanctioned()) {
+            // Game::canAction(): a sanctioned player with 2 coins or fewer still plays while
+            // someone else is free to be arrested
+            size_t free = 0;
+            for (size_t i = 0; i < count; ++i) {
+                free += game.playerAt(i).isArrested() ? 0 : 1;
+            }
+            if (free <= (player.isArrested() ? 0u : 1u)) {
+                cut(seat, 3, NO_MAX);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Probability that a seat has exactly this many coins.
+ */
+double CoinBelief::probability(size_t seat, int coins) const {
+    if (seat >= moves::MAX_TABLE || coins < _lowest[seat] || coins >= _lowest[seat] + int(BINS)) {
+        return 0.0;
+    }
+    return _bins[seat][coins - _lowest[seat]];
+}
+
+/**
+ * @brief Expected coins of a seat.
+ */
+double CoinBelief::mean(size_t seat) const {
+    double sum = 0;
+    for (size_t i = 0; i < BINS; ++i) {
+        sum += double(_bins[seat][i]) * (_lowest[seat] + int(i));
+    }
+    return sum;
+}
+
+/**
+ * @brief Draws a coin count for a seat from its belief.
+ */
+int CoinBelief::sample(size_t seat, std::mt19937& rng) const {
+    float draw = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+    const float* bins = _bins[seat];
+    size_t last = 0;
+    for (size_t i = 0; i < BINS; ++i) {
+        if (bins[i] > 0.0f) {
+            last = i;
+            draw -= bins[i];
+            if (draw < 0.0f) {
+                break;
+            }
+        }
+    }
+    return _lowest[seat] + int(last);
+}
+
+/**
+ * @brief Gives every player but the observer coins drawn from its belief, turning a game the
+ * observer sees into one concrete deal it could be in.
+ *
+ * @param game The game to fill in, normally a copy restored from a snapshot.
+ * @param observer Seat whose coins are left alone.
+ */
+void CoinBelief::determinize(Game& game, size_t observer, std::mt19937& rng) const {
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        Player& player = game.playerAt(i);
+        size_t seat = seatOf(player);
+        if (seat != observer) {
+            player.setCoins(sample(seat, rng));
+        }
+    }
+}
+
+/**
+ * @brief The BINS probabilities of a seat, bin i for lowest(seat) + i coins.
+ */
+const float* CoinBelief::histogram(size_t seat) const {
+    return _bins[seat];
+}
+
+/**
+ * @brief Coins of a seat's first bin.
+ */
+int CoinBelief::lowest(size_t seat) const {
+    return _lowest[seat];
+}
+
+/**
+ * @brief Moves a whole histogram by delta coins.
+ */
+void CoinBelief::shift(size_t seat, int delta) {
+    _lowest[seat] += delta;
+}
+
+/**
+ * @brief Moves the part of a histogram at minCoins or more up by one coin: each vector takes the
+ * upper part of the one below it shifted in by one lane. When nothing lies below minCoins the
+ * whole histogram moves instead, and mass that reached the last bin is first moved back to bin 0.
+ */
+void CoinBelief::raise(size_t seat, int minCoins) {
+    float* bins = _bins[seat];
+    int from = minCoins - _lowest[seat];
+    if (from >= int(BINS)) {
+        return;
+    }
+    Lanes first = splat(float(from));
+    Lanes below = splat(0.0f);
+    for (size_t v = 0; from > 0 && v * WIDTH < size_t(from); ++v) {
+        below += reinterpret_cast<Lanes>(reinterpret_cast<Mask>(load(bins + v * WIDTH)) & ~(index(v) >= first));
+    }
+    if (below[0] + below[1] + below[2] + below[3] == 0.0f) {
+        shift(seat, 1);
+        return;
+    }
+    if (bins[BINS - 1] > 0.0f) {
+        size_t empty = 0;
+        while (bins[empty] == 0.0f) {
+            ++empty;
+        }
+        std::memmove(bins, bins + empty, (BINS - empty) * sizeof(float));
+        std::fill(bins + (BINS - empty), bins + BINS, 0.0f);
+        _lowest[seat] += int(empty);
+        first -= splat(float(empty));
+    }
+    Lanes carry = splat(0.0f);
+    for (size_t v = 0; v < VECTORS; ++v) {
+        Mask upper = index(v) >= first;
+        Mask x = reinterpret_cast<Mask>(load(bins + v * WIDTH));
+        Lanes moving = reinterpret_cast<Lanes>(x & upper);
+        Lanes staying = reinterpret_cast<Lanes>(x & ~upper);
+        store(bins + v * WIDTH, staying + shiftIn(carry, moving));
+        carry = moving;
+    }
+    bins[BINS - 1] += carry[WIDTH - 1];
+}
+
+/**
+ * @brief Keeps only minCoins .. maxCoins and renormalizes. Evidence that rules out everything the
+ * seat was believed to have (a wrong assume()) starts it over as uniform over the range, within
+ * 0 .. 12 coins where the range is open.
+ */
+void CoinBelief::cut(size_t seat, int minCoins, int maxCoins) {
+    float* bins = _bins[seat];
+    Lanes from = splat(float(std::max(minCoins - _lowest[seat], -1)));
+    Lanes to = splat(float(std::min(maxCoins - _lowest[seat], int(BINS))));
+    Lanes total = splat(0.0f);
+    Lanes dropped = splat(0.0f);
+    for (size_t v = 0; v < VECTORS; ++v) {
+        Mask keep = (index(v) >= from) & (index(v) <= to);
+        Mask x = reinterpret_cast<Mask>(load(bins + v * WIDTH));
+        Lanes kept = reinterpret_cast<Lanes>(x & keep);
+        store(bins + v * WIDTH, kept);
+        total += kept;
+        dropped += reinterpret_cast<Lanes>(x & ~keep);
+    }
+    if (dropped[0] + dropped[1] + dropped[2] + dropped[3] == 0.0f) {
+        return; // nothing ruled out, the most common case
+    }
+    float sum = total[0] + total[1] + total[2] + total[3];
+    if (!(sum > 0.0f)) {
+        int low = std::max(minCoins, 0);
+        assume(seat, low, std::max(std::min(maxCoins, USUAL_MAX), low));
+        return;
+    }
+    Lanes scale = splat(1.0f / sum);
+    for (size_t v = 0; v < VECTORS; ++v) {
+        store(bins + v * WIDTH, load(bins + v * WIDTH) * scale);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef COIN_BELIEF_HPP
+#define COIN_BELIEF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include "engine/move.hpp"
+
+class Game;
+
+// What an observer who sees roles, flags, turns and moves but not coins can know about every
+// seat's coins. Each seat (Player::getIndex) has a histogram of BINS probabilities for the coin
+// counts lowest(seat) .. lowest(seat) + BINS - 1.
+//
+// play() applies a move and updates the histograms from public information only:
+// - the coin effect of the move (tax +2 or +3, arrest -1/+1 or -2 for a Merchant, sanction 3 or
+//   4 and +1 to a Baron, Baron +3, coup -7 ...) moves a histogram, which only changes its lowest
+//   coin count,
+// - the move being legal cuts it (a coup needs 7 coins, anything but a coup or a look means
+//   fewer than 10, an arrest target had at least 1, a pass rules out every move it could make),
+// - at the start of each turn a Merchant with 3 or more coins gains one, which moves only the
+//   upper part of its histogram, and a sanctioned player who is skipped had at most 2.
+// Cuts and the Merchant's coin are a few fixed-width vector operations over the 32 bins.
+//
+// Seats are treated as independent, which is exact for everything above since each cut touches
+// a single seat. What one player learns privately goes in through reveal(): its own coins, or
+// what a Spy saw.
+class CoinBelief {
+public:
+    static constexpr size_t BINS = 32;
+
+    CoinBelief();
+
+    void reset(const Game& game);
+    void assume(size_t seat, int minCoins, int maxCoins);
+    void reveal(size_t seat, int coins);
+    void play(Game& game, const Move& move);
+
+    double probability(size_t seat, int coins) const;
+    double mean(size_t seat) const;
+    int sample(size_t seat, std::mt19937& rng) const;
+    void determinize(Game& game, size_t observer, std::mt19937& rng) const;
+    const float* histogram(size_t seat) const;
+    int lowest(size_t seat) const;
+
+private:
+    void shift(size_t seat, int delta);
+    void raise(size_t seat, int minCoins);
+    void cut(size_t seat, int minCoins, int maxCoins);
+
+    alignas(32) float _bins[moves::MAX_TABLE][BINS];
+    int _lowest[moves::MAX_TABLE]; // coins of bin 0
+};
+
+#endif // COIN_BELIEF_HPP
@@ -0,0 +1,274 @@
+#include "mcts.hpp"
+#include "game.hpp"
+#include "engine/snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Values of Node::first that are not child indices. The root is node 0 and never anyone's child,
+// so 0 is free to mean "no children yet".
+constexpr std::uint32_t UNEXPANDED = 0;
+constexpr std::uint32_t TERMINAL = 0xFFFFFFFEu;  // the game is over here
+constexpr std::uint32_t EXPANDING = 0xFFFFFFFFu; // claimed by a thread that is adding the children
+constexpr size_t MAX_POOL = size_t(1) << 31;
+
+constexpr std::uint8_t NO_SEAT = 0xFF;
+
+}
+
+// One thread's side of the search: its own Game, rollout bot and path. The tree is the only
+// shared state.
+class Mcts::Worker {
+public:
+    Worker(Mcts& mcts, const std::vector<std::uint8_t>& image, unsigned int seed)
+        : _mcts(mcts), _image(image), _game(1), _bot(mcts._options.rollout, seed) {
+        _path.reserve(256);
+    }
+
+    // Select, expand, roll out, back up
+    void playout() {
+        Node* pool = _mcts._pool.get();
+        const std::uint32_t loss = _mcts._options.virtualLoss;
+        Snapshot::read(_game, _image.data(), _image.size());
+        _path.clear();
+        _path.push_back(0);
+        pool[0].visits.fetch_add(loss, std::memory_order_relaxed);
+        for (;;) {
+            Node& node = pool[_path.back()];
+            std::uint32_t first = node.first.load(std::memory_order_acquire);
+            bool fresh = first == UNEXPANDED;
+            if (fresh) {
+                first = _mcts.expand(node, _game);
+            }
+            if (first >= TERMINAL) {
+                break; // the game is over, or another thread owns the node: play out from here
+            }
+            std::uint32_t child = _mcts.select(node, first);
+            pool[child].visits.fetch_add(loss, std::memory_order_relaxed);
+            moves::apply(_game, pool[child].move);
+            _path.push_back(child);
+            if (fresh) {
+                break;
+            }
+        }
+
+        for (size_t played = 0; played < _mcts._options.rolloutMoves && _game.isGame(); ++played) {
+            moves::apply(_game, _bot.choose(_game));
+        }
+        std::array<double, moves::MAX_TABLE> reward{};
+        if (!_game.isGame()) {
+            reward[_game.playerAt(0).getIndex()] = 1.0;
+        } else {
+            for (size_t i = 0; i < _game.playerCount(); ++i) {
+                reward[_game.playerAt(i).getIndex()] = 1.0 / double(_game.playerCount());
+            }
+        }
+
+        // Each node trades its virtual loss for one real visit (unsigned wrap-around when loss > 1)
+        for (std::uint32_t index : _path) {
+            Node& node = pool[index];
+            node.visits.fetch_add(1u - loss, std::memory_order_relaxed);
+            double gain = node.mover == NO_SEAT ? 0.0 : reward[node.mover];
+            if (gain != 0.0) {
+                double sum = node.value.load(std::memory_order_relaxed);
+                while (!node.value.compare_exchange_weak(sum, sum + gain, std::memory_order_relaxed)) {
+                }
+            }
+        }
+    }
+
+private:
+    Mcts& _mcts;
+    const std::vector<std::uint8_t>& _image;
+    Game _game;
+    Bot _bot;
+    std::vector<std::uint32_t> _path;
+};
+
+/**
+ * @brief Allocates the node pool. Its pages are only touched as the tree grows into them.
+ *
+ * @param options Playouts, threads, pool size and the UCT and rollout settings.
+ * @throws std::runtime_error If there are no playouts, the pool size is out of range or the
+ *         exploration constant is negative.
+ */
+Mcts::Mcts(const MctsOptions& options) : _options(options), _used(0), _full(false) {
+    static_assert(sizeof(Node) == 32, "a node is half a cache line");
+    if (options.playouts == 0) {
+        throw std::runtime_error("MCTS needs at least one playout.");
+    }
+    if (options.poolNodes < 2 || options.poolNodes > MAX_POOL) {
+        throw std::runtime_error("MCTS pool must hold 2 to 2^31 nodes.");
+    }
+    if (!(options.exploration >= 0)) {
+        throw std::runtime_error("MCTS exploration constant must not be negative.");
+    }
+    _pool.reset(new Node[options.poolNodes]);
+}
+
+/**
+ * @brief Builds a fresh tree for the player to move with every thread playing into it.
+ *
+ * The game itself is not touched: each thread plays on a Game restored from its snapshot.
+ *
+ * @param game The position.
+ * @return MctsResult The most visited root move and the visits of each. A game that is over
+ *         gives a pass and no playouts.
+ * @throws std::runtime_error If a seat number is 16 or more, or if the engine throws on a move.
+ */
+MctsResult Mcts::search(const Game& game) {
+    MctsResult result;
+    if (!game.isGame() || game.playerCount() < 2) {
+        return result;
+    }
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        if (game.playerAt(i).getIndex() >= moves::MAX_TABLE) {
+            throw std::runtime_error("MCTS supports seats 0 to 15.");
+        }
+    }
+    std::vector<std::uint8_t> image;
+    Snapshot::write(game, image);
+
+    Node& root = _pool[0];
+    root.visits.store(0, std::memory_order_relaxed);
+    root.first.store(UNEXPANDED, std::memory_order_relaxed);
+    root.value.store(0.0, std::memory_order_relaxed);
+    root.move = Move();
+    root.children = 0;
+    root.mover = NO_SEAT;
+    _used.store(1, std::memory_order_relaxed);
+    _full.store(false, std::memory_order_relaxed);
+
+    size_t threads = _options.threads ? _options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<size_t>(std::min<std::uint64_t>(threads, _options.playouts));
+    std::atomic<std::uint64_t> next(0);
+    std::vector<std::string> errors(threads);
+    auto work = [&](size_t thread) {
+        try {
+            Worker worker(*this, image, _options.seed + static_cast<unsigned int>(thread));
+            while (next.fetch_add(1, std::memory_order_relaxed) < _options.playouts) {
+                worker.playout();
+            }
+        } catch (const std::exception& e) {
+            errors[thread] = e.what();
+            next.store(_options.playouts, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    result.playouts = _options.playouts;
+    result.nodes = std::min<size_t>(_used.load(), _options.poolNodes);
+    result.poolFull = _full.load();
+    std::uint32_t first = root.first.load(std::memory_order_acquire);
+    if (first == UNEXPANDED || first >= TERMINAL) {
+        Move legal[moves::MAX_MOVES];
+        moves::legalMoves(game, legal, moves::MAX_MOVES);
+        result.best = legal[0];
+        return result;
+    }
+    std::uint32_t most = 0;
+    for (std::uint32_t i = 0; i < root.children; ++i) {
+        const Node& child = _pool[first + i];
+        std::uint32_t visits = child.visits.load();
+        result.visits.emplace_back(child.move, visits);
+        if (visits > most) {
+            most = visits;
+            result.best = child.move;
+            result.value = child.value.load() / visits;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief The options the search was built with.
+ */
+const MctsOptions& Mcts::options() const {
+    return _options;
+}
+
+/**
+ * @brief Claims an unexpanded node and links a block of children for the legal moves of the game.
+ *
+ * @param node The node, reached by playing its path into game.
+ * @param game The position at the node.
+ * @return std::uint32_t The first child's index; TERMINAL when the game is over; EXPANDING when
+ *         another thread holds the node or the pool is full (the node stays unexpanded then).
+ */
+std::uint32_t Mcts::expand(Node& node, const Game& game) {
+    std::uint32_t expected = UNEXPANDED;
+    if (!node.first.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire)) {
+        return expected;
+    }
+    Move legal[moves::MAX_MOVES];
+    size_t count = game.isGame() ? moves::legalMoves(game, legal, moves::MAX_MOVES) : 0;
+    if (count == 0) {
+        node.first.store(TERMINAL, std::memory_order_release);
+        return TERMINAL;
+    }
+    if (_full.load(std::memory_order_relaxed)) {
+        node.first.store(UNEXPANDED, std::memory_order_release);
+        return EXPANDING;
+    }
+    std::uint32_t index = _used.fetch_add(static_cast<std::uint32_t>(count), std::memory_order_relaxed);
+    if (index + count > _options.poolNodes) {
+        _full.store(true, std::memory_order_relaxed);
+        node.first.store(UNEXPANDED, std::memory_order_release);
+        return EXPANDING;
+    }
+
+    std::uint8_t mover = static_cast<std::uint8_t>(game.playerAt(static_cast<size_t>(game.currentPlayerIndex())).getIndex());
+    for (size_t i = 0; i < count; ++i) {
+        Node& child = _pool[index + i];
+        child.visits.store(0, std::memory_order_relaxed);
+        child.first.store(UNEXPANDED, std::memory_order_relaxed);
+        child.value.store(0.0, std::memory_order_relaxed);
+        child.move = legal[i];
+        child.children = 0;
+        child.mover = mover;
+    }
+    node.children = static_cast<std::uint16_t>(count);
+    node.first.store(index, std::memory_order_release);
+    return index;
+}
+
+/**
+ * @brief UCT over the children of an expanded node: an unvisited child first, else the largest
+ * mean reward plus exploration bonus. Virtual losses count as visits with no reward.
+ */
+std::uint32_t Mcts::select(const Node& node, std::uint32_t first) const {
+    const Node* children = &_pool[first];
+    double logParent = std::log(std::max(1.0, double(node.visits.load(std::memory_order_relaxed))));
+    double best = -1.0;
+    std::uint32_t chosen = 0;
+    for (std::uint32_t i = 0; i < node.children; ++i) {
+        std::uint32_t visits = children[i].visits.load(std::memory_order_relaxed);
+        if (visits == 0) {
+            return first + i;
+        }
+        double score = children[i].value.load(std::memory_order_relaxed) / visits +
+                       _options.exploration * std::sqrt(logParent / visits);
+        if (score > best) {
+            best = score;
+            chosen = i;
+        }
+    }
+    return first + chosen;
+}
@@ -0,0 +1,77 @@
+#ifndef MCTS_HPP
+#define MCTS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "ai/bot.hpp"
+#include "engine/move.hpp"
+
+class Game;
+
+struct MctsOptions {
+    std::uint64_t playouts = 10000;    // per search, over all threads
+    size_t threads = 0;                // 0: one per core
+    size_t poolNodes = size_t(1) << 20; // tree capacity, 32 bytes a node
+    double exploration = 1.0;          // UCT constant
+    std::uint32_t virtualLoss = 3;     // visits a thread adds to a node while its playout is in flight
+    BotKind rollout = BotKind::Greedy;
+    size_t rolloutMoves = 200;         // a rollout still running after this many moves is a draw
+    unsigned int seed = 1;
+};
+
+struct MctsResult {
+    Move best;                 // the most visited root move
+    double value = 0;          // its mean reward for the player to move
+    std::uint64_t playouts = 0;
+    size_t nodes = 0;          // pool nodes in use, the root included
+    bool poolFull = false;     // expansion stopped because the pool ran out
+    std::vector<std::pair<Move, std::uint32_t>> visits; // per root move, in legalMoves() order
+};
+
+// Monte Carlo tree search with one tree shared by every thread (tree parallelism), instead of a
+// tree per thread whose root counts are merged afterwards.
+//
+// Nodes live in one preallocated pool and link by index: a node keeps the index of its first child
+// and the children of a node are contiguous. A thread that reaches an unexpanded node claims it
+// with a compare-and-swap, takes a block of children from the pool with one fetch_add and
+// publishes it with a release store; a thread that finds a node being expanded plays out from
+// there instead of waiting. Visits and value sums are atomics, so no lock is taken anywhere.
+// While a playout is in flight each node on its path carries virtualLoss extra visits with no
+// reward, which steers the other threads to different branches.
+//
+// A playout restores the root from a snapshot, descends by UCT, plays the rollout bot to the end
+// of the game (a draw splits the reward among the living players) and adds each player's reward
+// to the nodes of the moves it made.
+class Mcts {
+public:
+    explicit Mcts(const MctsOptions& options = MctsOptions());
+
+    MctsResult search(const Game& game);
+    const MctsOptions& options() const;
+
+private:
+    struct alignas(32) Node {
+        std::atomic<std::uint32_t> visits;
+        std::atomic<std::uint32_t> first;  // first child, or UNEXPANDED / EXPANDING / TERMINAL
+        std::atomic<double> value;         // rewards of the player who made `move`
+        Move move;
+        std::uint16_t children;            // valid once first holds an index
+        std::uint8_t mover;                // seat that made `move`
+    };
+
+    class Worker;
+
+    std::uint32_t expand(Node& node, const Game& game);
+    std::uint32_t select(const Node& node, std::uint32_t first) const;
+
+    MctsOptions _options;
+    std::unique_ptr<Node[]> _pool;
+    std::atomic<std::uint32_t> _used;
+    std::atomic<bool> _full;
+};
+
+#endif // MCTS_HPP
@@ -0,0 +1,18 @@
+#ifndef MIX_HPP
+#define MIX_HPP
+
+#include <cstdint>
+
+namespace hashing {
+
+// splitmix64's step: a cheap 64-bit mix for table keys, position hashes and seed streams
+inline std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // namespace hashing
+
+#endif // MIX_HPP
@@ -0,0 +1,306 @@
+#include "role_sweep.hpp"
+#include "game.hpp"
+#include "engine/move.hpp"
+#include "mix.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const char* const ROLE_NAMES[] = {"Spy", "Merchant", "Judge", "Governor", "General", "Baron"};
+const char* const ROLE_SHORT[] = {"Spy", "Mer", "Jud", "Gov", "Gen", "Bar"};
+
+using hashing::mix;
+
+size_t roleColumn(Role role) {
+    return static_cast<size_t>(role) - 1;
+}
+
+const std::vector<std::string>& seatNames() {
+    static const std::vector<std::string> names = [] {
+        std::vector<std::string> list;
+        for (size_t i = 0; i < moves::MAX_TABLE; ++i) {
+            list.push_back("p" + std::to_string(i));
+        }
+        return list;
+    }();
+    return names;
+}
+
+}
+
+/**
+ * @brief Prepares one row per role assignment of the table size.
+ *
+ * @param options Table size, games per assignment, seed, mode and policy.
+ * @throws std::runtime_error If the table size is out of range or there are no games to play.
+ */
+RoleSweep::RoleSweep(const SweepOptions& options) : _options(options) {
+    if (options.players < 2 || options.players > moves::MAX_TABLE) {
+        throw std::runtime_error("Role sweeps need 2 to 16 players.");
+    }
+    if (options.seatings && options.players > MAX_SEATINGS_PLAYERS) {
+        throw std::runtime_error("Seatings are enumerated for up to 6 players; use multisets.");
+    }
+    if (options.games == 0) {
+        throw std::runtime_error("A role sweep needs at least one game per assignment.");
+    }
+    for (std::vector<Role>& roles : assignments(options.players, options.seatings)) {
+        SweepRow row;
+        row.wins.assign(roles.size(), 0);
+        row.roles = std::move(roles);
+        _rows.push_back(std::move(row));
+    }
+}
+
+/**
+ * @brief Every assignment of the six roles to a table, in lexicographic order of role values.
+ *
+ * @param players Table size.
+ * @param seatings true for every seat ordering (6^players), false for every multiset, each
+ *        listed once in nondecreasing order (C(players + 5, 5)).
+ * @return std::vector<std::vector<Role>> The assignments.
+ */
+std::vector<std::vector<Role>> RoleSweep::assignments(size_t players, bool seatings) {
+    std::vector<std::vector<Role>> all;
+    std::vector<size_t> digits(players, 0);
+    while (true) {
+        std::vector<Role> roles(players);
+        for (size_t i = 0; i < players; ++i) {
+            roles[i] = static_cast<Role>(digits[i] + 1);
+        }
+        all.push_back(std::move(roles));
+
+        // Odometer step; multisets restart the digits after the carry at the new value
+        size_t i = players;
+        while (i > 0 && digits[i - 1] == ROLES - 1) {
+            --i;
+        }
+        if (i == 0) {
+            break;
+        }
+        size_t value = ++digits[i - 1];
+        for (size_t j = i; j < players; ++j) {
+            digits[j] = seatings ? 0 : value;
+        }
+    }
+    return all;
+}
+
+/**
+ * @brief Plays every row's games on the given number of threads.
+ *
+ * Counts are cleared first, so a sweep can be run again.
+ *
+ * @param threads Worker threads; rows are handed out one at a time.
+ * @throws std::runtime_error If a game fails (the first error of any thread).
+ */
+void RoleSweep::run(size_t threads) {
+    for (SweepRow& row : _rows) {
+        std::fill(row.wins.begin(), row.wins.end(), 0);
+        row.draws = 0;
+    }
+    threads = std::max<size_t>(1, std::min(threads, _rows.size()));
+    std::atomic<size_t> next(0);
+    std::vector<std::string> errors(threads);
+    auto work = [&](size_t worker) {
+        try {
+            for (size_t i = next.fetch_add(1); i < _rows.size(); i = next.fetch_add(1)) {
+                playRow(_rows[i]);
+            }
+        } catch (const std::exception& e) {
+            errors[worker] = e.what();
+        }
+    };
+    if (threads == 1) {
+        work(0);
+    } else {
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < threads; ++t) {
+            pool.emplace_back(work, t);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+}
+
+/**
+ * @brief Plays the configured number of games for one assignment.
+ *
+ * Game g uses seed + g * 2654435761 for the table, the policy and the exploring moves and, in
+ * multiset mode, a Fisher-Yates shuffle of the seats drawn from the same seed.
+ */
+void RoleSweep::playRow(SweepRow& row) const {
+    const std::vector<std::string>& allNames = seatNames();
+    std::vector<std::string> names(allNames.begin(), allNames.begin() + _options.players);
+    std::vector<size_t> holder(_options.players); // seat -> entry of row.roles
+    std::vector<Role> seated(_options.players);
+    Move legal[moves::MAX_MOVES];
+    for (size_t g = 0; g < _options.games; ++g) {
+        unsigned int gameSeed = _options.seed + static_cast<unsigned int>(g) * 2654435761u;
+        std::iota(holder.begin(), holder.end(), 0);
+        if (!_options.seatings) {
+            std::uint64_t state = gameSeed;
+            for (size_t i = holder.size() - 1; i > 0; --i) {
+                state = mix(state);
+                std::swap(holder[i], holder[state % (i + 1)]);
+            }
+        }
+        for (size_t s = 0; s < seated.size(); ++s) {
+            seated[s] = row.roles[holder[s]];
+        }
+
+        Game game(names, seated, gameSeed);
+        Bot bot(_options.bot, gameSeed);
+        std::uint64_t explore = mix(gameSeed ^ 0x5eedull);
+        size_t played = 0;
+        while (game.isGame() && game.playerCount() > 1 && played < _options.maxMoves) {
+            explore = mix(explore);
+            size_t count = 0;
+            if (double(explore >> 11) * 0x1.0p-53 < _options.explore) {
+                count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+            }
+            moves::apply(game, count ? legal[(explore >> 7) % count] : bot.choose(game));
+            ++played;
+        }
+        if (game.playerCount() == 1) {
+            row.wins[holder[game.playerAt(0).getIndex()]]++;
+        } else {
+            row.draws++;
+        }
+    }
+}
+
+/**
+ * @brief Rows of the last run, in assignments() order.
+ */
+const std::vector<SweepRow>& RoleSweep::rows() const {
+    return _rows;
+}
+
+/**
+ * @brief The options the sweep was built with.
+ */
+const SweepOptions& RoleSweep::options() const {
+    return _options;
+}
+
+/**
+ * @brief Prints one line per assignment with the win rate of each role (multisets) or seat.
+ *
+ * A multiset line gives how many players hold each role, then the win rate of one such player
+ * (its wins / (games x holders)), "-" for absent roles, and the draw rate. A final line pools
+ * every row, next to the fair share 1/players.
+ *
+ * @param out Destination stream.
+ */
+void RoleSweep::writeMatrix(std::FILE* out) const {
+    double games = double(_options.games);
+    if (_options.seatings) {
+        std::fprintf(out, "%-*s |", int(_options.players * 4), "seats");
+        for (size_t s = 0; s < _options.players; ++s) {
+            std::fprintf(out, " %5zu", s);
+        }
+        std::fprintf(out, "  draws\n");
+        for (const SweepRow& row : _rows) {
+            for (Role role : row.roles) {
+                std::fprintf(out, "%-4s", ROLE_SHORT[roleColumn(role)]);
+            }
+            std::fprintf(out, " |");
+            for (std::uint32_t wins : row.wins) {
+                std::fprintf(out, " %.3f", wins / games);
+            }
+            std::fprintf(out, "  %.3f\n", row.draws / games);
+        }
+        return;
+    }
+
+    std::fprintf(out, "%3s %3s %3s %3s %3s %3s |", ROLE_SHORT[0], ROLE_SHORT[1], ROLE_SHORT[2], ROLE_SHORT[3],
+                 ROLE_SHORT[4], ROLE_SHORT[5]);
+    for (const char* name : ROLE_SHORT) {
+        std::fprintf(out, " %5s", name);
+    }
+    std::fprintf(out, "  draws\n");
+    double pooledWins[ROLES] = {};
+    double pooledSeats[ROLES] = {};
+    for (const SweepRow& row : _rows) {
+        std::uint32_t holders[ROLES] = {};
+        std::uint32_t wins[ROLES] = {};
+        for (size_t i = 0; i < row.roles.size(); ++i) {
+            holders[roleColumn(row.roles[i])]++;
+            wins[roleColumn(row.roles[i])] += row.wins[i];
+        }
+        for (size_t r = 0; r < ROLES; ++r) {
+            std::fprintf(out, "%3u ", holders[r]);
+            pooledWins[r] += wins[r];
+            pooledSeats[r] += holders[r] * games;
+        }
+        std::fprintf(out, "|");
+        for (size_t r = 0; r < ROLES; ++r) {
+            if (holders[r]) {
+                std::fprintf(out, " %.3f", wins[r] / (holders[r] * games));
+            } else {
+                std::fprintf(out, "     -");
+            }
+        }
+        std::fprintf(out, "  %.3f\n", row.draws / games);
+    }
+    std::fprintf(out, "%-24s|", "all rows");
+    for (size_t r = 0; r < ROLES; ++r) {
+        std::fprintf(out, " %.3f", pooledSeats[r] > 0 ? pooledWins[r] / pooledSeats[r] : 0.0);
+    }
+    std::fprintf(out, "  (fair share %.3f)\n", 1.0 / double(_options.players));
+}
+
+/**
+ * @brief Writes the raw counts: one line per row, roles then wins then draws and games.
+ *
+ * Multiset rows have a holder count per role and wins per role; seating rows have the role of
+ * each seat and wins per seat.
+ *
+ * @param path Output file.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void RoleSweep::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    if (_options.seatings) {
+        for (size_t s = 0; s < _options.players; ++s) out << "seat" << s << ',';
+        for (size_t s = 0; s < _options.players; ++s) out << "wins" << s << ',';
+    } else {
+        for (const char* name : ROLE_NAMES) out << name << ',';
+        for (const char* name : ROLE_NAMES) out << "wins_" << name << ',';
+    }
+    out << "draws,games\n";
+    for (const SweepRow& row : _rows) {
+        if (_options.seatings) {
+            for (Role role : row.roles) out << ROLE_NAMES[roleColumn(role)] << ',';
+            for (std::uint32_t wins : row.wins) out << wins << ',';
+        } else {
+            std::uint32_t holders[ROLES] = {};
+            std::uint32_t wins[ROLES] = {};
+            for (size_t i = 0; i < row.roles.size(); ++i) {
+                holders[roleColumn(row.roles[i])]++;
+                wins[roleColumn(row.roles[i])] += row.wins[i];
+            }
+            for (std::uint32_t count : holders) out << count << ',';
+            for (std::uint32_t count : wins) out << count << ',';
+        }
+        out << row.draws << ',' << _options.games << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef ROLE_SWEEP_HPP
+#define ROLE_SWEEP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "ai/bot.hpp"
+#include "roles/role_type.hpp"
+
+struct SweepOptions {
+    size_t players = 4;
+    size_t games = 64;           // seeded games per role assignment
+    unsigned int seed = 1;
+    bool seatings = false;       // every seat ordering instead of every multiset of roles
+    BotKind bot = BotKind::Greedy;
+    double explore = 0.1;        // chance of a uniform random legal move instead of the bot's, so
+                                 // seeded games differ even with a deterministic policy
+    size_t maxMoves = 1000;      // a game still running after this many moves is a draw
+};
+
+// Results of one role assignment. In multiset mode `roles` is sorted and each game seats them in
+// that game's shuffled order; in seatings mode `roles` is the seat order. wins[i] counts the games
+// won by whoever held roles[i].
+struct SweepRow {
+    std::vector<Role> roles;
+    std::vector<std::uint32_t> wins;
+    std::uint32_t draws = 0;
+};
+
+// Plays a fixed number of seeded games for every assignment of the six roles to a table, in place
+// of roleGenerator's random draws, and tabulates who won.
+//
+// Multiset mode enumerates each combination of roles once (462 instead of 46656 seatings at six
+// players) and evens out seat advantage by shuffling the seats per game. Game g of every assignment
+// uses the same seed and the same shuffle, so rows differ only by their roles. Assignments are
+// handed to threads one at a time; the results do not depend on the thread count.
+class RoleSweep {
+public:
+    static constexpr size_t ROLES = 6;
+    static constexpr size_t MAX_SEATINGS_PLAYERS = 6; // 6^players rows
+
+    explicit RoleSweep(const SweepOptions& options);
+
+    void run(size_t threads);
+    const std::vector<SweepRow>& rows() const;
+    const SweepOptions& options() const;
+
+    void writeMatrix(std::FILE* out) const;
+    void writeCsv(const std::string& path) const;
+
+    static std::vector<std::vector<Role>> assignments(size_t players, bool seatings);
+
+private:
+    void playRow(SweepRow& row) const;
+
+    SweepOptions _options;
+    std::vector<SweepRow> _rows;
+};
+
+#endif // ROLE_SWEEP_HPP
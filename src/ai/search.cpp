@@ -0,0 +1,384 @@
+#include "search.hpp"
+#include "engine/snapshot.hpp"
+#include "mix.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::uint8_t EXACT = 0;
+constexpr std::uint8_t LOWER = 1;     // the value is at least this
+constexpr std::uint8_t UPPER = 2;     // the value is at most this
+constexpr std::uint8_t MOVE_ONLY = 3; // max-n: only the best move is kept
+
+using hashing::mix;
+
+// Coups first, then taxes, abilities and the moves that hurt an opponent
+int priority(Action action) {
+    switch (action) {
+        case Action::Coup: return 7;
+        case Action::Tax: return 6;
+        case Action::Ability: return 5;
+        case Action::Sanction: return 4;
+        case Action::Arrest: return 3;
+        case Action::Bribe: return 2;
+        case Action::Gather: return 1;
+        default: return 0;
+    }
+}
+
+// lcm(1 .. n): after eliminations the player to move is the turn counter modulo a smaller table,
+// so two positions only play alike when their counters agree modulo every table size still to come
+constexpr std::uint64_t TURN_PERIOD[moves::MAX_TABLE + 1] = {
+    1, 1, 2, 6, 12, 60, 60, 420, 840, 2520, 2520, 27720, 27720, 360360, 360360, 360360, 720720};
+
+double strength(int coins) {
+    return 1.0 + std::min(std::max(coins, 0), 10) / 7.0;
+}
+
+}
+
+/**
+ * @brief Node ratio of the last two completed iterations, 0 with fewer than two.
+ */
+double SearchResult::branchingFactor() const {
+    if (iterations.size() < 2 || iterations[iterations.size() - 2].nodes == 0) {
+        return 0;
+    }
+    return double(iterations.back().nodes) / double(iterations[iterations.size() - 2].nodes);
+}
+
+/**
+ * @brief Allocates the transposition table.
+ *
+ * @param options Mode, depth limit, node budget and table size.
+ * @throws std::runtime_error If the depth or the table size is out of range.
+ */
+Searcher::Searcher(const SearchOptions& options) : _options(options), _mask(0), _game(1), _root(0), _salt(0),
+                                                   _nodes(0), _aborted(false) {
+    if (options.maxDepth == 0 || options.maxDepth > MAX_PLIES) {
+        throw std::runtime_error("Search depth must be 1 to 64 plies.");
+    }
+    if (options.tableBits < 4 || options.tableBits > 30) {
+        throw std::runtime_error("Transposition table size must be 2^4 .. 2^30 entries.");
+    }
+    _mask = (size_t(1) << options.tableBits) - 1;
+    _table.reset(new Entry[_mask + 1]());
+    for (auto& image : _images) {
+        image.reserve(256);
+    }
+}
+
+/**
+ * @brief Searches the position for the player to move, deepening one ply at a time.
+ *
+ * The game itself is not touched: the search plays on its own copy. The transposition table is
+ * kept from earlier searches.
+ *
+ * @param game The position.
+ * @return SearchResult Best move and value of the deepest completed iteration, and every
+ *         iteration's node count. A game that is over gives a pass and no iterations.
+ * @throws std::runtime_error If a seat number is 16 or more.
+ */
+SearchResult Searcher::search(const Game& game) {
+    SearchResult result;
+    if (!game.isGame() || game.playerCount() < 2) {
+        return result;
+    }
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        if (game.playerAt(i).getIndex() >= moves::MAX_TABLE) {
+            throw std::runtime_error("Search supports seats 0 to 15.");
+        }
+    }
+    std::vector<std::uint8_t>& image = _images[0];
+    image.clear();
+    Snapshot::write(game, image);
+    Snapshot::read(_game, image.data(), image.size());
+    _root = _game.playerAt(static_cast<size_t>(_game.currentPlayerIndex())).getIndex();
+    _salt = mix((std::uint64_t(_options.mode) << 8) | _root);
+    _nodes = 0;
+    _aborted = false;
+
+    // If not even depth 1 fits in the budget, the best ordered move stands in
+    order(0, Move());
+    result.best = _legal[0][0];
+
+    for (size_t depth = 1; depth <= _options.maxDepth; ++depth) {
+        std::uint64_t before = _nodes;
+        double value = 0;
+        if (_options.mode == SearchMode::Paranoid) {
+            value = paranoid(0, depth, -1.0, 2.0);
+        } else {
+            Shares values;
+            maxN(0, depth, 2.0, values);
+            value = values[_root];
+        }
+        if (_aborted) {
+            break;
+        }
+        result.iterations.push_back(SearchIteration{depth, _nodes - before, value, _rootBest});
+        result.best = _rootBest;
+        result.value = value;
+        result.depth = depth;
+        if (_options.mode == SearchMode::Paranoid && (value >= 1.0 || value <= 0.0)) {
+            break; // a forced win or loss: deeper iterations cannot change it
+        }
+    }
+    result.nodes = _nodes;
+    return result;
+}
+
+/**
+ * @brief Empties the transposition table.
+ */
+void Searcher::clear() {
+    std::fill(_table.get(), _table.get() + _mask + 1, Entry());
+}
+
+/**
+ * @brief The options the searcher was built with.
+ */
+const SearchOptions& Searcher::options() const {
+    return _options;
+}
+
+/**
+ * @brief 64-bit hash of everything the rules look at: the turn counter modulo lcm(1 .. players),
+ * the bribe and each player's seat, role, coins, flags and last action in turn order.
+ *
+ * The round counter and the rest of the turn counter are left out, so the same position reached
+ * on a later turn is a transposition.
+ */
+std::uint64_t Searcher::positionKey(const Game& game) {
+    size_t players = std::min(game.playerCount(), moves::MAX_TABLE);
+    std::uint64_t turn = static_cast<std::uint64_t>(game.getTurn()) % TURN_PERIOD[players];
+    std::uint64_t h = mix(turn | (std::uint64_t(game.getBribe()) << 32) | (std::uint64_t(players) << 40));
+    for (size_t i = 0; i < game.playerCount(); ++i) {
+        const Player& player = game.playerAt(i);
+        std::uint64_t flags = (player.isSanctioned() ? 1 : 0) | (player.isArrested() ? 2 : 0) |
+                              (player.getCanArrest() ? 4 : 0);
+        std::uint64_t packed = std::uint64_t(player.getIndex() & 0xFF) |
+                               (std::uint64_t(player.role()) << 8) |
+                               (std::uint64_t(static_cast<std::uint16_t>(player.getCoins())) << 16) |
+                               (flags << 32) | (std::uint64_t(player.getLastAction()) << 40);
+        h = mix(h + packed);
+    }
+    return h;
+}
+
+/**
+ * @brief Alpha-beta on the searching player's share; it moves at max nodes, everyone else at min nodes.
+ */
+double Searcher::paranoid(size_t ply, size_t depth, double alpha, double beta) {
+    if (!spend()) {
+        return 0;
+    }
+    if (!_game.isGame() || depth == 0) {
+        return share(_root);
+    }
+    double value = share(_root);
+    if (value <= 0.0) {
+        return value; // the searching player is out
+    }
+
+    std::uint64_t key = positionKey(_game) ^ _salt;
+    Move first;
+    if (Entry* entry = probe(key)) {
+        first = entry->move;
+        if (entry->depth >= depth && ply > 0) {
+            double stored = entry->value;
+            if (entry->bound == EXACT) return stored;
+            if (entry->bound == LOWER) alpha = std::max(alpha, stored);
+            if (entry->bound == UPPER) beta = std::min(beta, stored);
+            if (alpha >= beta) return stored;
+        }
+    }
+
+    size_t count = order(ply, first);
+    const Move* legal = _legal[ply];
+    bool maximizing = _game.playerAt(static_cast<size_t>(_game.currentPlayerIndex())).getIndex() == _root;
+    std::vector<std::uint8_t>& image = _images[ply];
+    image.clear();
+    Snapshot::write(_game, image);
+
+    double alphaStart = alpha;
+    double betaStart = beta;
+    double best = maximizing ? -1.0 : 2.0;
+    Move bestMove = legal[0];
+    for (size_t i = 0; i < count; ++i) {
+        moves::apply(_game, legal[i]);
+        double child = paranoid(ply + 1, depth - 1, alpha, beta);
+        Snapshot::read(_game, image.data(), image.size());
+        if (_aborted) {
+            return 0;
+        }
+        if (maximizing ? child > best : child < best) {
+            best = child;
+            bestMove = legal[i];
+        }
+        if (maximizing) {
+            alpha = std::max(alpha, best);
+        } else {
+            beta = std::min(beta, best);
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    store(key, depth, best, best <= alphaStart ? UPPER : best >= betaStart ? LOWER : EXACT, bestMove);
+    if (ply == 0) {
+        _rootBest = bestMove;
+    }
+    return best;
+}
+
+/**
+ * @brief Max-n: the player to move picks the child with its largest share.
+ *
+ * @param limit Once the mover's share reaches it, the previous mover (another player) cannot
+ *        gain here any more and the remaining moves are skipped; above 1 when there is no bound.
+ * @param out The shares of the chosen line, by seat.
+ */
+void Searcher::maxN(size_t ply, size_t depth, double limit, Shares& out) {
+    if (!spend()) {
+        return;
+    }
+    if (!_game.isGame() || depth == 0) {
+        shares(out);
+        return;
+    }
+
+    std::uint64_t key = positionKey(_game) ^ _salt;
+    Move first;
+    if (Entry* entry = probe(key)) {
+        first = entry->move;
+    }
+    size_t count = order(ply, first);
+    const Move* legal = _legal[ply];
+    size_t mover = _game.playerAt(static_cast<size_t>(_game.currentPlayerIndex())).getIndex();
+    std::vector<std::uint8_t>& image = _images[ply];
+    image.clear();
+    Snapshot::write(_game, image);
+
+    double best = -1.0;
+    Move bestMove = legal[0];
+    Shares child;
+    for (size_t i = 0; i < count; ++i) {
+        moves::apply(_game, legal[i]);
+        bool sameMover = _game.isGame() &&
+                         _game.playerAt(static_cast<size_t>(_game.currentPlayerIndex())).getIndex() == mover;
+        maxN(ply + 1, depth - 1, sameMover ? 2.0 : 1.0 - best, child);
+        Snapshot::read(_game, image.data(), image.size());
+        if (_aborted) {
+            return;
+        }
+        if (child[mover] > best) {
+            best = child[mover];
+            bestMove = legal[i];
+            out = child;
+        }
+        if (best >= limit) {
+            break;
+        }
+    }
+    store(key, depth, best, MOVE_ONLY, bestMove);
+    if (ply == 0) {
+        _rootBest = bestMove;
+    }
+}
+
+/**
+ * @brief Counts a node; false once the budget is spent, which abandons the iteration.
+ */
+bool Searcher::spend() {
+    if (++_nodes > _options.nodeBudget) {
+        _aborted = true;
+    }
+    return !_aborted;
+}
+
+/**
+ * @brief Lists the legal moves of the ply in search order: the table move, then by priority().
+ *
+ * @return size_t Number of moves in _legal[ply].
+ */
+size_t Searcher::order(size_t ply, const Move& first) {
+    Move* legal = _legal[ply];
+    size_t count = moves::legalMoves(_game, legal, moves::MAX_MOVES);
+    auto rank = [&](const Move& move) { return move == first ? 100 : priority(move.action); };
+    // Insertion sort: stable and fast for the few dozen moves of a turn
+    for (size_t i = 1; i < count; ++i) {
+        Move move = legal[i];
+        int score = rank(move);
+        size_t j = i;
+        for (; j > 0 && rank(legal[j - 1]) < score; --j) {
+            legal[j] = legal[j - 1];
+        }
+        legal[j] = move;
+    }
+    return count;
+}
+
+/**
+ * @brief A seat's share of the win: 1 or 0 once the game is over, else its strength over the
+ * table's total.
+ */
+double Searcher::share(size_t seat) const {
+    if (!_game.isGame()) {
+        return _game.playerAt(0).getIndex() == seat ? 1.0 : 0.0;
+    }
+    double total = 0;
+    double mine = 0;
+    for (size_t i = 0; i < _game.playerCount(); ++i) {
+        const Player& player = _game.playerAt(i);
+        double value = strength(player.getCoins());
+        total += value;
+        if (player.getIndex() == seat) {
+            mine = value;
+        }
+    }
+    return mine / total;
+}
+
+/**
+ * @brief Every seat's share, 0 for seats that are out.
+ */
+void Searcher::shares(Shares& out) const {
+    out.fill(0.0);
+    if (!_game.isGame()) {
+        out[_game.playerAt(0).getIndex()] = 1.0;
+        return;
+    }
+    double total = 0;
+    for (size_t i = 0; i < _game.playerCount(); ++i) {
+        const Player& player = _game.playerAt(i);
+        out[player.getIndex()] = strength(player.getCoins());
+        total += out[player.getIndex()];
+    }
+    for (double& value : out) {
+        value /= total;
+    }
+}
+
+/**
+ * @brief The table entry holding the key, or nullptr.
+ */
+Searcher::Entry* Searcher::probe(std::uint64_t key) {
+    Entry& entry = _table[key & _mask];
+    return entry.key == key ? &entry : nullptr;
+}
+
+/**
+ * @brief Stores a result, keeping a deeper one of the same position.
+ */
+void Searcher::store(std::uint64_t key, size_t depth, double value, std::uint8_t bound, const Move& move) {
+    Entry& entry = _table[key & _mask];
+    if (entry.key == key && entry.depth > depth) {
+        return;
+    }
+    entry.key = key;
+    entry.value = static_cast<float>(value);
+    entry.depth = static_cast<std::uint8_t>(depth);
+    entry.bound = bound;
+    entry.move = move;
+}
@@ -0,0 +1,101 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "engine/move.hpp"
+#include "game.hpp"
+
+enum class SearchMode : std::uint8_t {
+    Paranoid, // everybody else plays against the searching player: one value, alpha-beta
+    MaxN      // every player maximizes its own share: a value per seat, shallow pruning
+};
+
+struct SearchOptions {
+    SearchMode mode = SearchMode::Paranoid;
+    size_t maxDepth = 16;                // plies of the deepest iteration
+    std::uint64_t nodeBudget = 200000;   // nodes per search; the iteration that runs out is dropped
+    unsigned int tableBits = 18;         // transposition table of 2^bits entries
+};
+
+// One completed iteration of iterative deepening
+struct SearchIteration {
+    size_t depth = 0;
+    std::uint64_t nodes = 0; // nodes this iteration visited
+    double value = 0;        // the searching player's value of `best`
+    Move best;
+};
+
+struct SearchResult {
+    Move best;                               // from the deepest completed iteration
+    double value = 0;
+    size_t depth = 0;
+    std::uint64_t nodes = 0;                 // every iteration, the dropped one included
+    std::vector<SearchIteration> iterations;
+
+    double branchingFactor() const;
+};
+
+// Depth-limited search of the perfect-information game, where every player sees every coin (what
+// the Spy sees, for everyone). A ply is one move, so a Spy's look or a bribed extra action is a
+// ply of the same player.
+//
+// Values are shares of a win: 1 for the winner and 0 for the others at the end of a game; at the
+// horizon each living player gets (1 + coins / 7) over the same sum for the whole table, so shares
+// always add up to 1. Paranoid search gives the searching player that share and the others its
+// complement, which makes it a two-sided alpha-beta; max-n keeps the whole vector and prunes when
+// the player to move is already sure to leave the previous mover no better than what it has.
+//
+// Moves are tried transposition-table move first, then coups, taxes, abilities, sanctions,
+// arrests, bribes and gathers. The table keeps exact values and bounds (paranoid) or just the best
+// move (max-n) under a key of the position and the searching seat, so it stays valid from one
+// search to the next. Iterative deepening stops at maxDepth or when the node budget runs out.
+class Searcher {
+public:
+    static constexpr size_t MAX_PLIES = 64;
+
+    explicit Searcher(const SearchOptions& options = SearchOptions());
+
+    SearchResult search(const Game& game);
+    void clear();
+    const SearchOptions& options() const;
+
+    static std::uint64_t positionKey(const Game& game);
+
+private:
+    using Shares = std::array<double, moves::MAX_TABLE>;
+
+    struct Entry {
+        std::uint64_t key;
+        float value;
+        std::uint8_t depth;
+        std::uint8_t bound;
+        Move move;
+    };
+
+    double paranoid(size_t ply, size_t depth, double alpha, double beta);
+    void maxN(size_t ply, size_t depth, double limit, Shares& shares);
+    bool spend();
+    size_t order(size_t ply, const Move& first);
+    double share(size_t seat) const;
+    void shares(Shares& out) const;
+    Entry* probe(std::uint64_t key);
+    void store(std::uint64_t key, size_t depth, double value, std::uint8_t bound, const Move& move);
+
+    SearchOptions _options;
+    std::unique_ptr<Entry[]> _table;
+    size_t _mask;
+    Game _game;
+    size_t _root;          // seat of the searching player
+    std::uint64_t _salt;   // mixed into every key: the searching seat and the mode
+    std::uint64_t _nodes;
+    bool _aborted;
+    Move _rootBest;
+    Move _legal[MAX_PLIES][moves::MAX_MOVES];
+    std::vector<std::uint8_t> _images[MAX_PLIES];
+};
+
+#endif // SEARCH_HPP
@@ -0,0 +1,629 @@
+#include "tablebase.hpp"
+#include "game.hpp"
+#include "engine/snapshot.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 64;
+constexpr std::uint32_t VERSION = 1;
+const char MAGIC[4] = {'C', 'T', 'B', '1'};
+constexpr std::uint32_t COUP = 0xFFFFFFFF;    // successor "the mover wins by coup"
+constexpr std::uint32_t OUTSIDE = 0xFFFFFFFE; // successor with coins outside the table
+
+constexpr size_t roleOf(Role role) {
+    return static_cast<size_t>(role) - 1; // Role::Spy .. Role::Baron
+}
+
+size_t seatIndex(const EndgameSeat& seat) {
+    size_t flags = size_t(seat.sanctioned) | size_t(seat.arrested) << 1 | size_t(seat.canArrest) << 2 |
+                   size_t(seat.looked) << 3;
+    return static_cast<size_t>(seat.coins - Tablebase::MIN_COINS) * 16 + flags;
+}
+
+EndgameSeat seatAt(Role role, size_t index) {
+    EndgameSeat seat;
+    seat.role = role;
+    seat.coins = static_cast<int>(index / 16) + Tablebase::MIN_COINS;
+    seat.sanctioned = index & 1;
+    seat.arrested = index & 2;
+    seat.canArrest = index & 4;
+    seat.looked = index & 8;
+    return seat;
+}
+
+// Game::next_turn for two players, including the Merchant's bonus and the skip of a
+// sanctioned player who cannot act
+void endTurn(EndgamePosition& p) {
+    for (;;) {
+        EndgameSeat& actor = p.seats[p.current];
+        actor.sanctioned = false;
+        actor.canArrest = true;
+        if (p.bribe) {
+            p.bribe = false;
+            return;
+        }
+        p.current ^= 1;
+        if (p.current == 0) {
+            p.seats[0].arrested = false;
+            p.seats[1].arrested = false;
+        }
+        EndgameSeat& next = p.seats[p.current];
+        if (next.role == Role::Merchant && next.coins >= 3) {
+            next.coins++;
+        }
+        if (!next.sanctioned || next.coins > 2 || !p.seats[p.current ^ 1].arrested) {
+            return;
+        }
+        next.sanctioned = false;
+    }
+}
+
+// Orders values for the player choosing: quick wins, then draws, then slow losses
+int preference(std::uint8_t value) {
+    if (value == Tablebase::DRAW) {
+        return 0;
+    }
+    return value < Tablebase::LOSS ? 1000 - value : -1000 + (value - Tablebase::LOSS);
+}
+
+void putU32(std::uint8_t* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+}
+
+bool EndgameSeat::operator==(const EndgameSeat& other) const {
+    return role == other.role && coins == other.coins && sanctioned == other.sanctioned &&
+           arrested == other.arrested && canArrest == other.canArrest && looked == other.looked;
+}
+
+bool EndgamePosition::operator==(const EndgamePosition& other) const {
+    return seats[0] == other.seats[0] && seats[1] == other.seats[1] && current == other.current &&
+           bribe == other.bribe;
+}
+
+/**
+ * @brief Reads the position of a running two-player game.
+ *
+ * @param game The game.
+ * @param out Receives the position.
+ * @return true if the game is running with exactly two players of the six roles.
+ */
+bool EndgamePosition::fromGame(const Game& game, EndgamePosition& out) {
+    if (!game.isGame() || game.playerCount() != 2) {
+        return false;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        const Player& player = game.playerAt(i);
+        EndgameSeat& seat = out.seats[i];
+        seat.role = player.role();
+        if (seat.role == Role::Player) {
+            return false;
+        }
+        seat.coins = player.getCoins();
+        seat.sanctioned = player.isSanctioned();
+        seat.arrested = player.isArrested();
+        seat.canArrest = player.getCanArrest();
+        seat.looked = seat.role == Role::Spy && player.getLastAction() == Action::Ability;
+    }
+    out.current = static_cast<std::uint8_t>(game.currentPlayerIndex());
+    out.bribe = game.getBribe();
+    return true;
+}
+
+/**
+ * @brief Loads the position into a game, replacing its players (through a Snapshot image).
+ *
+ * The players are named "p0" and "p1" after their seats.
+ */
+void EndgamePosition::toGame(Game& game) const {
+    static const char* const NAMES[2] = {"p0", "p1"};
+    SnapshotState state;
+    state.turn = current;
+    state.bribe = bribe;
+    SnapshotEntry entries[2];
+    for (size_t i = 0; i < 2; ++i) {
+        const EndgameSeat& seat = seats[i];
+        entries[i].role = seat.role;
+        entries[i].seat = static_cast<std::uint8_t>(i);
+        entries[i].coins = seat.coins;
+        entries[i].sanctioned = seat.sanctioned;
+        entries[i].arrested = seat.arrested;
+        entries[i].canArrest = seat.canArrest;
+        entries[i].lastAction = seat.looked ? Action::Ability : Action::None;
+        entries[i].name = NAMES[i];
+    }
+    std::vector<std::uint8_t> image;
+    Snapshot::build(state, entries, 2, 0, image);
+    Snapshot::read(game, image.data(), image.size());
+}
+
+/**
+ * @brief The moves of the player to move, in the order of moves::legalMoves().
+ *
+ * @param out At least moves::MAX_MOVES entries.
+ * @return size_t Number of moves written (a single pass if nothing else is allowed).
+ */
+size_t EndgamePosition::legalMoves(Move* out) const {
+    size_t count = 0;
+    const EndgameSeat& actor = seats[current];
+    const EndgameSeat& target = seats[current ^ 1];
+    std::uint8_t other = static_cast<std::uint8_t>(current ^ 1);
+    bool mustCoup = actor.coins >= 10;
+    if (!mustCoup) {
+        if (!actor.sanctioned) {
+            out[count++] = Move{Action::Gather, Move::NO_TARGET};
+            out[count++] = Move{Action::Tax, Move::NO_TARGET};
+        }
+        if (actor.coins >= 4) {
+            out[count++] = Move{Action::Bribe, Move::NO_TARGET};
+        }
+        if (actor.role == Role::Baron && actor.coins >= 3) {
+            out[count++] = Move{Action::Ability, Move::NO_TARGET};
+        }
+        if (actor.canArrest && !target.arrested && target.coins > 0) {
+            out[count++] = Move{Action::Arrest, other};
+        }
+        if (actor.coins >= 3 && (actor.coins >= 4 || target.role != Role::Judge)) {
+            out[count++] = Move{Action::Sanction, other};
+        }
+    }
+    if (actor.coins >= 7) {
+        out[count++] = Move{Action::Coup, other};
+    }
+    if (actor.role == Role::Spy && !actor.looked) {
+        out[count++] = Move{Action::Ability, other};
+    }
+    if (count == 0) {
+        out[count++] = Move{Action::None, Move::NO_TARGET};
+    }
+    return count;
+}
+
+/**
+ * @brief Plays a legal move the way moves::apply() does on a two-player Game.
+ *
+ * @param move One of legalMoves().
+ * @param next Receives the position after the move.
+ * @return false if the move is a coup, which ends the game with the mover as the winner.
+ */
+bool EndgamePosition::play(const Move& move, EndgamePosition& next) const {
+    next = *this;
+    EndgameSeat& actor = next.seats[next.current];
+    EndgameSeat& target = next.seats[next.current ^ 1];
+    switch (move.action) {
+        case Action::Coup:
+            return false;
+        case Action::Gather:
+            actor.coins += 1;
+            break;
+        case Action::Tax:
+            actor.coins += actor.role == Role::Governor ? 3 : 2;
+            break;
+        case Action::Bribe:
+            actor.coins -= 4;
+            actor.looked = false;
+            next.bribe = true;
+            return true;
+        case Action::Arrest:
+            if (target.role == Role::Merchant) {
+                target.coins -= 2;
+            } else {
+                target.coins -= 1;
+                actor.coins += 1;
+            }
+            target.arrested = true;
+            break;
+        case Action::Sanction:
+            if (target.role == Role::Baron) {
+                target.coins++;
+            }
+            if (target.role == Role::Judge) {
+                actor.coins--;
+            }
+            actor.coins -= 3;
+            target.sanctioned = true;
+            break;
+        case Action::Ability:
+            if (move.target == Move::NO_TARGET) { // Baron investment
+                actor.coins += 3;
+                break;
+            }
+            target.canArrest = false; // the Spy's look does not end the turn
+            actor.looked = true;
+            return true;
+        default: // pass: the turn ends without an action
+            endTurn(next);
+            return true;
+    }
+    actor.looked = false;
+    endTurn(next);
+    return true;
+}
+
+Tablebase::Tablebase()
+    : _owned(), _values(nullptr), _pairs(0), _sweeps(0), _mapping(nullptr), _mappingSize(0) {}
+
+Tablebase::~Tablebase() {
+    close();
+}
+
+void Tablebase::close() {
+    if (_mapping) {
+        munmap(_mapping, _mappingSize);
+        _mapping = nullptr;
+    }
+    _owned.clear();
+    _owned.shrink_to_fit();
+    _values = nullptr;
+    _pairs = 0;
+    _sweeps = 0;
+}
+
+/**
+ * @brief Solves role pairs, replacing whatever the table held.
+ *
+ * @param threads Worker threads; each solves whole role pairs.
+ * @param pairs Role pairs (in players-list order) to solve; empty for all 36.
+ * @throws std::runtime_error If a pair needs more than MAX_DISTANCE sweeps.
+ */
+void Tablebase::generate(size_t threads, const std::vector<std::pair<Role, Role>>& pairs) {
+    close();
+    _owned.assign(SIZE, DRAW);
+    _values = _owned.data();
+    std::vector<size_t> work;
+    if (pairs.empty()) {
+        for (size_t pair = 0; pair < PAIRS; ++pair) {
+            work.push_back(pair);
+        }
+    } else {
+        for (const auto& pair : pairs) {
+            work.push_back(pairIndex(pair.first, pair.second));
+        }
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<size_t> sweeps(work.size(), 0);
+    std::vector<std::string> errors(std::max<size_t>(threads, 1));
+    auto solve = [&](size_t worker) {
+        try {
+            for (size_t i = next.fetch_add(1); i < work.size(); i = next.fetch_add(1)) {
+                sweeps[i] = solvePair(work[i], _owned.data() + work[i] * PAIR_SIZE);
+            }
+        } catch (const std::exception& e) {
+            errors[worker] = e.what();
+        }
+    };
+    if (threads <= 1) {
+        solve(0);
+    } else {
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < threads; ++t) {
+            pool.emplace_back(solve, t);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+    for (size_t i = 0; i < work.size(); ++i) {
+        _pairs |= std::uint64_t(1) << work[i];
+        _sweeps = std::max(_sweeps, sweeps[i]);
+    }
+}
+
+/**
+ * @brief Solves one role pair by backward induction.
+ *
+ * Builds the pair's move graph once, then sweeps it: in sweep k a position becomes a win in k
+ * plies if some move reaches a position lost for the opponent (or won for the mover, after a
+ * bribe or a look) in fewer plies, and a loss in k if every move does the opposite. Each sweep
+ * only reads the previous sweep's values, so the distances are exact. Positions still open when
+ * a sweep changes nothing are draws: neither side can force a coup.
+ *
+ * @return size_t Number of sweeps.
+ */
+size_t Tablebase::solvePair(size_t pair, std::uint8_t* values) const {
+    constexpr size_t BLOCK = SEAT_STATES * SEAT_STATES;
+    size_t base = pair * PAIR_SIZE;
+    std::vector<std::uint32_t> offsets(PAIR_SIZE + 1, 0);
+    std::vector<std::uint32_t> targets;
+    targets.reserve(PAIR_SIZE * 6);
+    Move legal[moves::MAX_MOVES];
+    for (size_t local = 0; local < PAIR_SIZE; ++local) {
+        offsets[local] = static_cast<std::uint32_t>(targets.size());
+        EndgamePosition from = position(base + local);
+        if (!canonical(from)) {
+            continue;
+        }
+        size_t count = from.legalMoves(legal);
+        for (size_t i = 0; i < count; ++i) {
+            EndgamePosition to;
+            if (!from.play(legal[i], to)) {
+                targets.push_back(COUP);
+            } else if (!covers(to)) {
+                targets.push_back(OUTSIDE);
+            } else {
+                targets.push_back(static_cast<std::uint32_t>(index(to) - base));
+            }
+        }
+    }
+    offsets[PAIR_SIZE] = static_cast<std::uint32_t>(targets.size());
+
+    std::vector<std::uint8_t> previous(PAIR_SIZE, DRAW);
+    std::vector<std::uint8_t> current;
+    size_t sweep = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        ++sweep;
+        if (sweep > MAX_DISTANCE) {
+            throw std::runtime_error("Tablebase distances exceed 127 plies.");
+        }
+        current = previous;
+        for (size_t local = 0; local < PAIR_SIZE; ++local) {
+            if (previous[local] != DRAW || offsets[local] == offsets[local + 1]) {
+                continue;
+            }
+            size_t mover = (local / BLOCK) >> 1;
+            bool win = false;
+            bool allLost = true;
+            for (std::uint32_t e = offsets[local]; e < offsets[local + 1] && !win; ++e) {
+                std::uint32_t to = targets[e];
+                if (to == COUP) {
+                    win = true;
+                    break;
+                }
+                if (to == OUTSIDE) {
+                    allLost = false;
+                    continue;
+                }
+                std::uint8_t value = previous[to];
+                if (((to / BLOCK) >> 1) != mover) {
+                    value = flip(value);
+                }
+                if (value != DRAW && value < LOSS) {
+                    win = true;
+                } else if (value == DRAW) {
+                    allLost = false;
+                }
+            }
+            if (win || allLost) {
+                current[local] = static_cast<std::uint8_t>(win ? sweep : LOSS + sweep);
+                changed = true;
+            }
+        }
+        previous.swap(current);
+    }
+    std::copy(previous.begin(), previous.end(), values);
+    return sweep;
+}
+
+/**
+ * @brief Writes the table: a 64-byte header, then one byte per position.
+ *
+ * @throws std::runtime_error If nothing was generated or the file cannot be written.
+ */
+void Tablebase::save(const std::string& path) const {
+    if (!_values) {
+        throw std::runtime_error("Tablebase is empty.");
+    }
+    std::uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, 4);
+    putU32(header + 4, VERSION);
+    putU32(header + 8, static_cast<std::uint32_t>(MIN_COINS));
+    putU32(header + 12, static_cast<std::uint32_t>(MAX_COINS));
+    putU32(header + 16, static_cast<std::uint32_t>(_pairs));
+    putU32(header + 20, static_cast<std::uint32_t>(_pairs >> 32));
+    putU32(header + 24, static_cast<std::uint32_t>(SIZE));
+    putU32(header + 28, static_cast<std::uint32_t>(_sweeps));
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+        file.write(reinterpret_cast<const char*>(_values), static_cast<std::streamsize>(SIZE));
+        if (!file) {
+            throw std::runtime_error("Cannot write tablebase " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot rename tablebase to " + path);
+    }
+}
+
+/**
+ * @brief Maps a saved table read-only; pages are loaded on first probe and shared between processes.
+ *
+ * @throws std::runtime_error If the file is missing or was written for another layout.
+ */
+void Tablebase::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open tablebase " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != HEADER_SIZE + SIZE) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a tablebase of this version.");
+    }
+    void* mapping = mmap(nullptr, HEADER_SIZE + SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map tablebase " + path);
+    }
+    const std::uint8_t* header = static_cast<const std::uint8_t*>(mapping);
+    if (std::memcmp(header, MAGIC, 4) != 0 || getU32(header + 4) != VERSION ||
+        static_cast<int>(getU32(header + 8)) != MIN_COINS || static_cast<int>(getU32(header + 12)) != MAX_COINS ||
+        getU32(header + 24) != SIZE) {
+        munmap(mapping, HEADER_SIZE + SIZE);
+        throw std::runtime_error(path + " is not a tablebase of this version.");
+    }
+    _mapping = mapping;
+    _mappingSize = HEADER_SIZE + SIZE;
+    _values = header + HEADER_SIZE;
+    _pairs = getU32(header + 16) | static_cast<std::uint64_t>(getU32(header + 20)) << 32;
+    _sweeps = getU32(header + 28);
+}
+
+bool Tablebase::solved(Role first, Role second) const {
+    return _values && first != Role::Player && second != Role::Player &&
+           (_pairs >> pairIndex(first, second) & 1) != 0;
+}
+
+/**
+ * @brief Value of a position for the player to move; DRAW for positions the table does not hold.
+ */
+std::uint8_t Tablebase::probe(const EndgamePosition& position) const {
+    if (!covers(position) || !solved(position.seats[0].role, position.seats[1].role)) {
+        return DRAW;
+    }
+    return _values[index(position)];
+}
+
+/**
+ * @brief Value of a running game for the player to move.
+ *
+ * @return true if the game is a two-player position of a solved role pair.
+ */
+bool Tablebase::probe(const Game& game, std::uint8_t& value) const {
+    EndgamePosition position;
+    if (!EndgamePosition::fromGame(game, position) || !covers(position) ||
+        !solved(position.seats[0].role, position.seats[1].role)) {
+        return false;
+    }
+    value = _values[index(position)];
+    return true;
+}
+
+/**
+ * @brief Picks the move with the best table value: the fastest win, else a draw, else the slowest loss.
+ *
+ * One probe per legal move and no allocation.
+ *
+ * @return true if the game is covered by the table and out holds the move.
+ */
+bool Tablebase::bestMove(const Game& game, Move& out) const {
+    EndgamePosition position;
+    if (!EndgamePosition::fromGame(game, position) || !covers(position) ||
+        !solved(position.seats[0].role, position.seats[1].role)) {
+        return false;
+    }
+    Move legal[moves::MAX_MOVES];
+    size_t count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+    int best = 0;
+    for (size_t i = 0; i < count; ++i) {
+        EndgamePosition next;
+        int score = preference(1); // a coup wins at once
+        if (position.play(legal[i], next)) {
+            std::uint8_t value = probe(next);
+            if (next.current != position.current) {
+                value = flip(value);
+            }
+            score = preference(value);
+            if (value != DRAW) {
+                // One ply further away, counted on the score: value + 1 would wrap a win in 127 into
+                // the loss marker and a loss in 127 into a draw
+                score += score > 0 ? -1 : 1;
+            }
+        }
+        if (i == 0 || score > best) {
+            best = score;
+            out = legal[i];
+        }
+    }
+    return count > 0;
+}
+
+size_t Tablebase::sweeps() const {
+    return _sweeps;
+}
+
+/**
+ * @brief Whether the position's coins are inside the table.
+ */
+bool Tablebase::covers(const EndgamePosition& position) {
+    for (const EndgameSeat& seat : position.seats) {
+        if (seat.coins < MIN_COINS || seat.coins > MAX_COINS || seat.role == Role::Player) {
+            return false;
+        }
+    }
+    return position.current < 2;
+}
+
+/**
+ * @brief Whether the position is the one stored for its index (looked is only set for a Spy).
+ */
+bool Tablebase::canonical(const EndgamePosition& position) {
+    for (const EndgameSeat& seat : position.seats) {
+        if (seat.looked && seat.role != Role::Spy) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Perfect index of a covered position: role pair, turn, bribe, then both seats.
+ */
+size_t Tablebase::index(const EndgamePosition& position) {
+    size_t pair = pairIndex(position.seats[0].role, position.seats[1].role);
+    size_t turn = size_t(position.current) * 2 + size_t(position.bribe);
+    return ((pair * 4 + turn) * SEAT_STATES + seatIndex(position.seats[0])) * SEAT_STATES +
+           seatIndex(position.seats[1]);
+}
+
+/**
+ * @brief The position stored at an index; the inverse of index().
+ */
+EndgamePosition Tablebase::position(size_t index) {
+    EndgamePosition position;
+    size_t second = index % SEAT_STATES;
+    index /= SEAT_STATES;
+    size_t first = index % SEAT_STATES;
+    index /= SEAT_STATES;
+    size_t turn = index % 4;
+    size_t pair = index / 4;
+    position.seats[0] = seatAt(static_cast<Role>(pair / ROLES + 1), first);
+    position.seats[1] = seatAt(static_cast<Role>(pair % ROLES + 1), second);
+    position.current = static_cast<std::uint8_t>(turn >> 1);
+    position.bribe = turn & 1;
+    return position;
+}
+
+size_t Tablebase::pairIndex(Role first, Role second) {
+    return roleOf(first) * ROLES + roleOf(second);
+}
+
+/**
+ * @brief The same value seen by the other player: a win in d becomes a loss in d and back.
+ */
+std::uint8_t Tablebase::flip(std::uint8_t value) {
+    if (value == DRAW) {
+        return DRAW;
+    }
+    return static_cast<std::uint8_t>(value < LOSS ? value + LOSS : value - LOSS);
+}
@@ -0,0 +1,98 @@
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "engine/move.hpp"
+#include "roles/role_type.hpp"
+
+class Game;
+
+// One player of a two-player position. looked is only kept for a Spy (its last action was
+// the free look, so it may not look again); it means nothing for the other roles.
+struct EndgameSeat {
+    Role role = Role::Spy;
+    int coins = 0;
+    bool sanctioned = false;
+    bool arrested = false;
+    bool canArrest = true;
+    bool looked = false;
+
+    bool operator==(const EndgameSeat& other) const;
+};
+
+// Everything the rules look at in a two-player game: both seats in players-list order,
+// whose turn it is and whether a bribe grants the player to move another action.
+// Block windows are not part of it; the tablebase plays by moves::apply().
+struct EndgamePosition {
+    EndgameSeat seats[2];
+    std::uint8_t current = 0;
+    bool bribe = false;
+
+    static bool fromGame(const Game& game, EndgamePosition& out);
+    void toGame(Game& game) const;
+    size_t legalMoves(Move* out) const;
+    bool play(const Move& move, EndgamePosition& next) const;
+
+    bool operator==(const EndgamePosition& other) const;
+};
+
+// Solved two-player positions, one byte each, for every pair of roles, coins from -1 to 15 and
+// every flag combination: 36 role pairs x 295936 positions, about 10.7 MB.
+//
+// A value is from the point of view of the player to move: 0 is a draw (or an unsolved pair),
+// 1..127 a win in that many plies, 128 + d a loss in d plies. The index is a plain mixed-radix
+// number, so a probe is one array read. generate() solves each role pair on its own (roles never
+// change during a game) by backward induction over the pair's move graph; save() writes it to a
+// file that open() maps read-only, so any number of processes share one copy.
+class Tablebase {
+public:
+    static constexpr int MIN_COINS = -1;
+    static constexpr int MAX_COINS = 15;
+    static constexpr size_t ROLES = 6;
+    static constexpr size_t PAIRS = ROLES * ROLES;
+    static constexpr size_t SEAT_STATES = (MAX_COINS - MIN_COINS + 1) * 16;
+    static constexpr size_t PAIR_SIZE = 4 * SEAT_STATES * SEAT_STATES;
+    static constexpr size_t SIZE = PAIRS * PAIR_SIZE;
+    static constexpr std::uint8_t DRAW = 0;
+    static constexpr std::uint8_t LOSS = 128;
+    static constexpr size_t MAX_DISTANCE = 127;
+
+    Tablebase();
+    ~Tablebase();
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    void generate(size_t threads, const std::vector<std::pair<Role, Role>>& pairs = {});
+    void save(const std::string& path) const;
+    void open(const std::string& path);
+
+    bool solved(Role first, Role second) const;
+    std::uint8_t probe(const EndgamePosition& position) const;
+    bool probe(const Game& game, std::uint8_t& value) const;
+    bool bestMove(const Game& game, Move& out) const;
+    size_t sweeps() const;
+
+    static bool covers(const EndgamePosition& position);
+    static bool canonical(const EndgamePosition& position);
+    static size_t index(const EndgamePosition& position);
+    static EndgamePosition position(size_t index);
+    static size_t pairIndex(Role first, Role second);
+    static std::uint8_t flip(std::uint8_t value);
+
+private:
+    void close();
+    size_t solvePair(size_t pair, std::uint8_t* values) const;
+
+    std::vector<std::uint8_t> _owned; // generated in this process
+    const std::uint8_t* _values;      // SIZE bytes, owned or mapped
+    std::uint64_t _pairs;             // bit per solved role pair
+    size_t _sweeps;
+    void* _mapping;
+    size_t _mappingSize;
+};
+
+#endif // TABLEBASE_HPP
@@ -0,0 +1,71 @@
+#ifndef COLUMN_ARENA_HPP
+#define COLUMN_ARENA_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// A range of bytes that a seat table's columns are carved out of, front to back. The bytes belong
+// to whoever built the table (a roster block); the arena never frees them.
+struct ColumnArena {
+    unsigned char* begin = nullptr;
+    unsigned char* next = nullptr;
+    unsigned char* end = nullptr;
+
+    // Aligned room for `bytes`, or nullptr once the arena is used up
+    void* take(size_t bytes, size_t align) {
+        void* at = next;
+        size_t space = static_cast<size_t>(end - next);
+        if (next == nullptr || std::align(align, bytes, at, space) == nullptr) {
+            return nullptr;
+        }
+        next = static_cast<unsigned char*>(at) + bytes;
+        return at;
+    }
+
+    bool owns(const void* p) const {
+        std::less<const void*> before;
+        return begin != nullptr && !before(p, begin) && before(p, end);
+    }
+};
+
+// Allocator of the columns: memory from the arena while it lasts, from the heap after that (or
+// always, without an arena). Giving memory back to the arena is a no-op.
+template <class T>
+struct ColumnAllocator {
+    using value_type = T;
+
+    explicit ColumnAllocator(ColumnArena* arena = nullptr) : arena(arena) {}
+    template <class U>
+    ColumnAllocator(const ColumnAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (arena != nullptr) {
+            if (void* at = arena->take(n * sizeof(T), alignof(T))) {
+                return static_cast<T*>(at);
+            }
+        }
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) {
+        if (arena == nullptr || !arena->owns(p)) {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    // Room the arena needs to hand out n elements, whatever alignment it starts at
+    static constexpr size_t bytesFor(size_t n) { return n * sizeof(T) + alignof(T) - 1; }
+
+    template <class U>
+    bool operator==(const ColumnAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ColumnAllocator<U>& other) const { return !(*this == other); }
+
+    ColumnArena* arena;
+};
+
+template <class T>
+using Column = std::vector<T, ColumnAllocator<T>>;
+
+#endif // COLUMN_ARENA_HPP
@@ -0,0 +1,195 @@
+#include "differential.hpp"
+#include "ai/tablebase.hpp"
+#include "engine/snapshot.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+const char* const ACTION_NAMES[] = {"pass", "gather", "tax", "bribe", "arrest", "sanction", "coup", "ability"};
+const char* const SEAT_NAMES[LockstepBatch::MAX_SEATS] = {"p0", "p1", "p2", "p3", "p4", "p5", "p6", "p7"};
+
+std::uint8_t byteAt(const std::uint8_t* data, size_t size, size_t& offset) {
+    return offset < size ? data[offset++] : 0;
+}
+
+std::string describe(const Move& move) {
+    std::string text = ACTION_NAMES[static_cast<size_t>(move.action)];
+    if (move.target != Move::NO_TARGET) {
+        text += " " + std::to_string(move.target);
+    }
+    return text;
+}
+
+}
+
+/**
+ * @brief Prepares the reference games and one lockstep batch per kernel the CPU supports.
+ */
+DifferentialCheck::DifferentialCheck() : _reference(1), _shadow(1), _ply(0), _moves(0) {
+    _batches.emplace_back(LockstepBatch::Kernel::Generic);
+    if (LockstepBatch::bestKernel() == LockstepBatch::Kernel::Avx2) {
+        _batches.emplace_back(LockstepBatch::Kernel::Avx2);
+    }
+}
+
+/**
+ * @brief Decodes an input and replays it on every engine, stopping at the first disagreement.
+ *
+ * @param data Input bytes (any content).
+ * @param size Number of bytes.
+ * @return true If every engine agreed after every move; false with error() set otherwise.
+ */
+bool DifferentialCheck::run(const std::uint8_t* data, size_t size) {
+    _error.clear();
+    _ply = 0;
+    size_t offset = 0;
+    start(data, size, offset);
+    _before.clear();
+    Snapshot::write(_reference, _before);
+    for (LockstepBatch& batch : _batches) {
+        batch = LockstepBatch(batch.kernel()); // rows for this table's size only
+        batch.load(0, _reference);
+        if (!compareLockstep(batch)) {
+            return false;
+        }
+    }
+
+    Move legal[moves::MAX_MOVES];
+    Move other[moves::MAX_MOVES];
+    Move lanes[LockstepBatch::LANES];
+    while (offset < size && _ply < MAX_PLIES) {
+        size_t count = moves::legalMoves(_reference, legal, moves::MAX_MOVES);
+        if (count == 0) {
+            break;
+        }
+        EndgamePosition position;
+        bool endgame = EndgamePosition::fromGame(_reference, position);
+        if (endgame) {
+            size_t expected = position.legalMoves(other);
+            if (expected != count) {
+                return fail("endgame lists " + std::to_string(expected) + " moves, the engine " +
+                            std::to_string(count));
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (other[i] != legal[i]) {
+                    return fail("endgame move " + std::to_string(i) + " is " + describe(other[i]) +
+                                ", the engine's " + describe(legal[i]));
+                }
+            }
+        }
+
+        Move move = legal[byteAt(data, size, offset) % count];
+        try {
+            moves::apply(_reference, move);
+            Snapshot::read(_shadow, _before.data(), _before.size());
+            moves::apply(_shadow, move);
+        } catch (const std::exception& e) {
+            return fail("the engine threw on " + describe(move) + ": " + e.what());
+        }
+        ++_ply;
+        ++_moves;
+
+        _after.clear();
+        _restored.clear();
+        Snapshot::write(_reference, _after);
+        Snapshot::write(_shadow, _restored);
+        if (_after != _restored) {
+            return fail("a game restored from a snapshot diverges after " + describe(move));
+        }
+        _before.swap(_after);
+
+        lanes[0] = move;
+        for (LockstepBatch& batch : _batches) {
+            batch.apply(lanes);
+            if (!compareLockstep(batch)) {
+                return false;
+            }
+        }
+
+        if (endgame) {
+            EndgamePosition next;
+            EndgamePosition read;
+            bool running = position.play(move, next);
+            if (running != _reference.isGame()) {
+                return fail(std::string("endgame says the game ") + (running ? "goes on" : "is over") + " after " +
+                            describe(move));
+            }
+            if (running && (!EndgamePosition::fromGame(_reference, read) || !(read == next))) {
+                return fail("endgame predicts another position after " + describe(move));
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief The first disagreement of the last run, naming the ply and the engine.
+ */
+const std::string& DifferentialCheck::error() const {
+    return _error;
+}
+
+/**
+ * @brief Moves replayed over all runs.
+ */
+std::uint64_t DifferentialCheck::moves() const {
+    return _moves;
+}
+
+/**
+ * @brief Builds the start position of an input with Snapshot::build and loads it into the reference.
+ *
+ * Every player starts with nobody sanctioned or arrested, permission to arrest and no last action.
+ */
+void DifferentialCheck::start(const std::uint8_t* data, size_t size, size_t& offset) {
+    size_t players = 2 + byteAt(data, size, offset) % (LockstepBatch::MAX_SEATS - 1);
+    SnapshotEntry entries[LockstepBatch::MAX_SEATS];
+    for (size_t i = 0; i < players; ++i) {
+        std::uint8_t seat = byteAt(data, size, offset);
+        entries[i].role = static_cast<Role>(1 + seat % 6);
+        entries[i].seat = static_cast<std::uint8_t>(i);
+        entries[i].coins = (seat / 6) % 13;
+        entries[i].name = SEAT_NAMES[i];
+    }
+    SnapshotState state;
+    state.turn = byteAt(data, size, offset) % players;
+    _after.clear();
+    Snapshot::build(state, entries, players, 0, _after);
+    Snapshot::read(_reference, _after.data(), _after.size());
+}
+
+/**
+ * @brief Compares lane 0 of a batch with the reference: turn, bribe, current seat and every player.
+ */
+bool DifferentialCheck::compareLockstep(const LockstepBatch& batch) {
+    std::string kernel = LockstepBatch::kernelName(batch.kernel());
+    if (batch.running(0) != _reference.isGame()) {
+        return fail(kernel + " lane disagrees on whether the game is over");
+    }
+    if (batch.players(0) != _reference.playerCount() || batch.turn(0) != _reference.getTurn() ||
+        batch.bribe(0) != _reference.getBribe() ||
+        batch.current(0) != static_cast<size_t>(_reference.currentPlayerIndex())) {
+        return fail(kernel + " lane disagrees on the players, the turn or the bribe");
+    }
+    for (size_t i = 0; i < _reference.playerCount(); ++i) {
+        LockstepBatch::Seat seat = batch.seat(0, i);
+        const Player& player = _reference.playerAt(i);
+        if (seat.id != player.getIndex() || seat.role != player.role() || seat.coins != player.getCoins() ||
+            seat.sanctioned != player.isSanctioned() || seat.arrested != player.isArrested() ||
+            seat.canArrest != player.getCanArrest() || seat.lastAction != player.getLastAction()) {
+            return fail(kernel + " lane disagrees on player " + std::to_string(i) + " (" + player.getName() + ")");
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Records a disagreement at the current ply.
+ *
+ * @return false, so callers can return fail(...).
+ */
+bool DifferentialCheck::fail(std::string message) {
+    _error = "ply " + std::to_string(_ply) + ": " + std::move(message);
+    return false;
+}
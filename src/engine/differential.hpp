@@ -0,0 +1,53 @@
+#ifndef DIFFERENTIAL_HPP
+#define DIFFERENTIAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "engine/lockstep.hpp"
+#include "game.hpp"
+
+// Differential check of the alternate engines against the reference rules in Game and the role
+// classes, driven by arbitrary bytes so a fuzzer can steer it. An input decodes to a table and a
+// move sequence:
+//
+//   byte 0         players = 2 + b % 7 (2 .. LockstepBatch::MAX_SEATS)
+//   one per seat   role = 1 + b % 6, starting coins = (b / 6) % 13
+//   next byte      the seat that moves first, b % players
+//   every other    the next move: entry b % count of moves::legalMoves() on the reference
+//
+// Missing bytes read as 0; an input stops after MAX_PLIES moves or when the game is over.
+// After every move the reference is compared with:
+// - each LockstepBatch kernel the CPU has, one lane replaying the same moves,
+// - a second Game restored from a Snapshot of the reference taken before the move, then given
+//   the same move (the two images must be byte for byte equal),
+// - in two-player positions, the tablebase's EndgamePosition: its legal moves and the position
+//   its play() predicts.
+class DifferentialCheck {
+public:
+    static constexpr size_t MAX_PLIES = 10000; // well below LockstepBatch::MAX_TURN
+
+    DifferentialCheck();
+
+    bool run(const std::uint8_t* data, size_t size);
+    const std::string& error() const;
+    std::uint64_t moves() const;
+
+private:
+    void start(const std::uint8_t* data, size_t size, size_t& offset);
+    bool compareLockstep(const LockstepBatch& batch);
+    bool fail(std::string message);
+
+    Game _reference;
+    Game _shadow;
+    std::vector<LockstepBatch> _batches;
+    std::vector<std::uint8_t> _before;
+    std::vector<std::uint8_t> _after;
+    std::vector<std::uint8_t> _restored;
+    std::string _error;
+    size_t _ply;
+    std::uint64_t _moves;
+};
+
+#endif // DIFFERENTIAL_HPP
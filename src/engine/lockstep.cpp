@@ -0,0 +1,500 @@
+#include "lockstep.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+using State = LockstepBatch::State;
+constexpr size_t LANES = LockstepBatch::LANES;
+
+// A row is LANES 16-bit lanes. The kernels are templates over the vector that holds part of a
+// row: all 16 lanes in one AVX2 register, or 8 lanes in an SSE2 register for the baseline build,
+// which then runs each kernel twice. GCC lowers the operators without branches either way.
+typedef std::int16_t Wide __attribute__((vector_size(32)));
+typedef std::int16_t Narrow __attribute__((vector_size(16)));
+
+// Kernels are inlined into each target's entry point, so every helper must be inlined too.
+#define COUP_KERNEL inline __attribute__((always_inline))
+
+// Without -mavx, GCC warns (-Wpsabi) that a function returning a 32-byte vector has a different
+// ABI with and without AVX. The helpers below are always inlined, so no vector ever crosses a real
+// call. GCC reports the warning when it expands the function, at the end of the translation unit
+// rather than at the helper, so a push / pop around the kernels does not silence it: the pragma
+// covers this file, which holds nothing else that passes vectors. clang has no such warning.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+template <class V>
+COUP_KERNEL V load(const std::int16_t* row) {
+    V v;
+    std::memcpy(&v, row, sizeof v);
+    return v;
+}
+
+template <class V>
+COUP_KERNEL void store(std::int16_t* row, const V& v) {
+    std::memcpy(row, &v, sizeof v);
+}
+
+template <class V>
+COUP_KERNEL V splat(int value) {
+    return V{} + static_cast<std::int16_t>(value);
+}
+
+template <class V>
+COUP_KERNEL V splat(Action action) {
+    return splat<V>(static_cast<int>(action));
+}
+
+template <class V>
+COUP_KERNEL V splat(Role role) {
+    return splat<V>(static_cast<int>(role));
+}
+
+template <class V>
+COUP_KERNEL V select(const V& mask, const V& a, const V& b) {
+    return (a & mask) | (b & ~mask);
+}
+
+template <class V>
+COUP_KERNEL bool any(const V& mask) {
+    std::uint64_t words[sizeof(V) / 8];
+    std::memcpy(words, &mask, sizeof mask);
+    std::uint64_t bits = 0;
+    for (std::uint64_t word : words) {
+        bits |= word;
+    }
+    return bits != 0;
+}
+
+// The policy of LockstepBatch::choose(), for all lanes: coup the richest opponent with 7 coins,
+// a Baron invests, otherwise tax; when sanctioned, arrest or sanction the richest possible
+// target, a Spy looks, and pass only when nothing at all is legal.
+template <class V>
+COUP_KERNEL void chooseKernel(const State& s, size_t seats, size_t first, std::int16_t* actionOut,
+                              std::int16_t* targetOut) {
+    V size = load<V>(s.size + first);
+    V pos = load<V>(s.pos + first);
+    V coins = splat<V>(0), role = splat<V>(0), sanctioned = splat<V>(0);
+    V canArrest = splat<V>(0), last = splat<V>(0);
+    V richest = splat<V>(INT16_MIN), richestSeat = splat<V>(Move::NO_TARGET);
+    V arrestCoins = splat<V>(INT16_MIN), arrestSeat = splat<V>(Move::NO_TARGET);
+    // Seat loops (here and in applyKernel) step an index vector instead of broadcasting the seat
+    // counter, which GCC would rebuild lane by lane.
+    V index = splat<V>(0);
+    for (size_t i = 0; i < seats; ++i, index += 1) {
+        V self = pos == index;
+        coins |= self & load<V>(s.coins[i] + first);
+        role |= self & load<V>(s.role[i] + first);
+        sanctioned |= self & load<V>(s.sanctioned[i] + first);
+        canArrest |= self & load<V>(s.canArrest[i] + first);
+        last |= self & load<V>(s.last[i] + first);
+    }
+    V sanctionCoins = splat<V>(INT16_MIN), sanctionSeat = splat<V>(Move::NO_TARGET);
+    index = splat<V>(0);
+    for (size_t i = 0; i < seats; ++i, index += 1) {
+        V c = load<V>(s.coins[i] + first);
+        V other = (index < size) & (index != pos);
+        V better = other & (c > richest);
+        richest = select(better, c, richest);
+        richestSeat = select(better, index, richestSeat);
+        V arrestable = other & ~load<V>(s.arrested[i] + first) & (c > 0) & (c > arrestCoins);
+        arrestCoins = select(arrestable, c, arrestCoins);
+        arrestSeat = select(arrestable, index, arrestSeat);
+        V judge = load<V>(s.role[i] + first) == splat<V>(Role::Judge);
+        V sanctionable = other & ((coins >= 4) | ~judge) & (c > sanctionCoins);
+        sanctionCoins = select(sanctionable, c, sanctionCoins);
+        sanctionSeat = select(sanctionable, index, sanctionSeat);
+    }
+
+    V open = splat<V>(-1);
+    V action = splat<V>(Action::None);
+    V target = splat<V>(Move::NO_TARGET);
+    V none = splat<V>(Move::NO_TARGET);
+    V m = open & (coins >= 7) & (richestSeat != none);
+    action = select(m, splat<V>(Action::Coup), action);
+    target = select(m, richestSeat, target);
+    open &= ~m;
+    m = open & (role == splat<V>(Role::Baron)) & (coins >= 3);
+    action = select(m, splat<V>(Action::Ability), action);
+    open &= ~m;
+    m = open & ~sanctioned;
+    action = select(m, splat<V>(Action::Tax), action);
+    open &= ~m;
+    m = open & canArrest & (arrestSeat != none);
+    action = select(m, splat<V>(Action::Arrest), action);
+    target = select(m, arrestSeat, target);
+    open &= ~m;
+    m = open & (coins >= 3) & (sanctionSeat != none);
+    action = select(m, splat<V>(Action::Sanction), action);
+    target = select(m, sanctionSeat, target);
+    open &= ~m;
+    m = open & (role == splat<V>(Role::Spy)) & (last != splat<V>(Action::Ability)) & (richestSeat != none);
+    action = select(m, splat<V>(Action::Ability), action);
+    target = select(m, richestSeat, target);
+    store(actionOut + first, action);
+    store(targetOut + first, target);
+}
+
+// Game::next_turn for the lanes in turnEnded: manageAfterTrun, the bribe, the turn counter with
+// its round reset of arrests, the Merchant's bonus and the skip of a player who cannot act.
+// Skipping repeats the whole step, so lanes loop until none is pending.
+template <class V>
+COUP_KERNEL void nextTurnKernel(State& s, size_t seats, size_t first, const V& turnEnded) {
+    V pending = turnEnded;
+    V size = load<V>(s.size + first);
+    while (any(pending)) {
+        V pos = load<V>(s.pos + first);
+        V index = splat<V>(0);
+        for (size_t i = 0; i < seats; ++i, index += 1) {
+            V self = pending & (pos == index);
+            store(s.sanctioned[i] + first, load<V>(s.sanctioned[i] + first) & ~self);
+            store(s.canArrest[i] + first, load<V>(s.canArrest[i] + first) | self);
+        }
+        V bribe = load<V>(s.bribe + first);
+        V bribed = pending & bribe;
+        store(s.bribe + first, bribe & ~bribed);
+        pending &= ~bribed;
+
+        store(s.turn + first, load<V>(s.turn + first) - pending); // pending lanes are -1
+        pos -= pending;
+        V round = pending & (pos == size);
+        pos = select(round, splat<V>(0), pos);
+        store(s.pos + first, pos);
+        V live = pending & (size > 1);
+        V coins = splat<V>(0), sanctioned = splat<V>(0), othersFree = splat<V>(0);
+        index = splat<V>(0);
+        for (size_t i = 0; i < seats; ++i, index += 1) {
+            V self = pos == index;
+            V arrested = load<V>(s.arrested[i] + first) & ~round;
+            store(s.arrested[i] + first, arrested);
+            V c = load<V>(s.coins[i] + first);
+            V bonus = live & self & (load<V>(s.role[i] + first) == splat<V>(Role::Merchant)) & (c >= 3);
+            c -= bonus;
+            store(s.coins[i] + first, c);
+            store(s.last[i] + first, select(bonus, splat<V>(Action::Ability), load<V>(s.last[i] + first)));
+            coins |= self & c;
+            sanctioned |= self & load<V>(s.sanctioned[i] + first);
+            othersFree |= ~self & (index < size) & ~arrested;
+        }
+        V stuck = live & sanctioned & (coins <= 2) & ~othersFree;
+        index = splat<V>(0);
+        for (size_t i = 0; i < seats; ++i, index += 1) {
+            V self = stuck & (pos == index);
+            store(s.sanctioned[i] + first, load<V>(s.sanctioned[i] + first) & ~self);
+        }
+        pending = stuck;
+    }
+}
+
+// moves::apply for every running lane; the moves must be legal
+template <class V>
+COUP_KERNEL void applyKernel(State& s, size_t seats, size_t first, const std::int16_t* actionIn,
+                             const std::int16_t* targetIn) {
+    V running = load<V>(s.running + first);
+    V action = load<V>(actionIn + first);
+    V target = load<V>(targetIn + first);
+    V size = load<V>(s.size + first);
+    V pos = load<V>(s.pos + first);
+    V role = splat<V>(0), targetRole = splat<V>(0);
+    V index = splat<V>(0);
+    for (size_t i = 0; i < seats; ++i, index += 1) {
+        role |= (pos == index) & load<V>(s.role[i] + first);
+        targetRole |= (target == index) & load<V>(s.role[i] + first);
+    }
+
+    V none = splat<V>(Move::NO_TARGET);
+    V gather = running & (action == splat<V>(Action::Gather));
+    V tax = running & (action == splat<V>(Action::Tax));
+    V bribe = running & (action == splat<V>(Action::Bribe));
+    V arrest = running & (action == splat<V>(Action::Arrest));
+    V sanction = running & (action == splat<V>(Action::Sanction));
+    V coup = running & (action == splat<V>(Action::Coup));
+    V invest = running & (action == splat<V>(Action::Ability)) & (target == none);
+    V look = running & (action == splat<V>(Action::Ability)) & (target != none);
+    V pass = running & (action == splat<V>(Action::None));
+
+    V merchant = targetRole == splat<V>(Role::Merchant);
+    V actorGain = (gather & 1) + (tax & (2 - (role == splat<V>(Role::Governor)))) + (bribe & -4) +
+                  (arrest & ~merchant & 1) + (sanction & (-3 + (targetRole == splat<V>(Role::Judge)))) +
+                  (coup & -7) + (invest & 3);
+    V targetGain = (arrest & (-1 + merchant)) + (sanction & -(targetRole == splat<V>(Role::Baron)));
+    V acted = running & ~pass;
+    index = splat<V>(0);
+    for (size_t i = 0; i < seats; ++i, index += 1) {
+        V self = pos == index;
+        V hit = target == index;
+        store(s.coins[i] + first, load<V>(s.coins[i] + first) + (self & actorGain) + (hit & targetGain));
+        store(s.arrested[i] + first, load<V>(s.arrested[i] + first) | (hit & arrest));
+        store(s.sanctioned[i] + first, load<V>(s.sanctioned[i] + first) | (hit & sanction));
+        store(s.canArrest[i] + first, load<V>(s.canArrest[i] + first) & ~(hit & look));
+        store(s.last[i] + first, select(self & acted, action, load<V>(s.last[i] + first)));
+    }
+    store(s.bribe + first, load<V>(s.bribe + first) | bribe);
+
+    // Game::gameCoup: the target leaves the list and the seats after it move up one place
+    if (any(coup)) {
+        V index = splat<V>(0);
+        for (size_t i = 0; i + 1 < seats; ++i, index += 1) {
+            V shift = coup & (index >= target);
+            for (std::int16_t(*rows)[LANES] : {s.coins, s.role, s.sanctioned, s.arrested, s.canArrest, s.last, s.id}) {
+                store(rows[i] + first, select(shift, load<V>(rows[i + 1] + first), load<V>(rows[i] + first)));
+            }
+        }
+        store(s.size + first, size + coup);
+        // The current seat is the turn counter modulo the new size; a coup is rare enough for a plain loop
+        for (size_t lane = 0; lane < sizeof(V) / 2; ++lane) {
+            if (coup[lane]) {
+                size_t at = first + lane;
+                s.pos[at] = static_cast<std::int16_t>(s.turn[at] % s.size[at]);
+            }
+        }
+    }
+
+    nextTurnKernel(s, seats, first, gather | tax | arrest | sanction | coup | invest | pass);
+    V over = (load<V>(s.size + first) <= 1) | (load<V>(s.turn + first) >= LockstepBatch::MAX_TURN);
+    store(s.running + first, running & ~over);
+}
+
+void chooseGeneric(const State& s, size_t seats, std::int16_t* action, std::int16_t* target) {
+    for (size_t first = 0; first < LANES; first += sizeof(Narrow) / 2) {
+        chooseKernel<Narrow>(s, seats, first, action, target);
+    }
+}
+
+void applyGeneric(State& s, size_t seats, const std::int16_t* action, const std::int16_t* target) {
+    for (size_t first = 0; first < LANES; first += sizeof(Narrow) / 2) {
+        applyKernel<Narrow>(s, seats, first, action, target);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COUP_LOCKSTEP_AVX2 1
+
+__attribute__((target("avx2"))) void chooseAvx2(const State& s, size_t seats, std::int16_t* action,
+                                                std::int16_t* target) {
+    chooseKernel<Wide>(s, seats, 0, action, target);
+}
+
+__attribute__((target("avx2"))) void applyAvx2(State& s, size_t seats, const std::int16_t* action,
+                                               const std::int16_t* target) {
+    applyKernel<Wide>(s, seats, 0, action, target);
+}
+#endif
+
+}
+
+/**
+ * @brief Creates an empty batch; every lane is finished until load() fills it.
+ *
+ * @param kernel Which build of the kernels to run.
+ * @throws std::runtime_error If AVX2 is requested on a CPU without it.
+ */
+LockstepBatch::LockstepBatch(Kernel kernel) : _state(), _seats(0), _kernel(kernel) {
+    if (kernel == Kernel::Avx2 && bestKernel() != Kernel::Avx2) {
+        throw std::runtime_error("AVX2 is not available on this CPU.");
+    }
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        _state.size[lane] = 1;
+    }
+}
+
+/**
+ * @brief Copies a game into a lane: its players in list order, the turn counter and the bribe.
+ *
+ * @param lane Lane to fill, below LANES.
+ * @param game The game; its players must have a role and at most 64 coins.
+ * @throws std::runtime_error If the lane is out of range or the game has more than MAX_SEATS players.
+ */
+void LockstepBatch::load(size_t lane, const Game& game) {
+    size_t count = game.playerCount();
+    if (lane >= LANES || count > MAX_SEATS || count == 0) {
+        throw std::runtime_error("Game does not fit in the lockstep batch.");
+    }
+    for (size_t i = 0; i < MAX_SEATS; ++i) {
+        const Player* player = i < count ? &game.playerAt(i) : nullptr;
+        _state.coins[i][lane] = static_cast<std::int16_t>(player ? player->getCoins() : 0);
+        _state.role[i][lane] = static_cast<std::int16_t>(player ? player->role() : Role::Player);
+        _state.sanctioned[i][lane] = player && player->isSanctioned() ? -1 : 0;
+        _state.arrested[i][lane] = player && player->isArrested() ? -1 : 0;
+        _state.canArrest[i][lane] = player && player->getCanArrest() ? -1 : 0;
+        _state.last[i][lane] = static_cast<std::int16_t>(player ? player->getLastAction() : Action::None);
+        _state.id[i][lane] = static_cast<std::int16_t>(player ? player->getIndex() : 0);
+    }
+    _state.turn[lane] = static_cast<std::int16_t>(game.getTurn());
+    _state.pos[lane] = static_cast<std::int16_t>(game.currentPlayerIndex());
+    _state.size[lane] = static_cast<std::int16_t>(count);
+    _state.bribe[lane] = game.getBribe() ? -1 : 0;
+    _state.running[lane] = game.isGame() && count > 1 ? -1 : 0;
+    _seats = std::max(_seats, count);
+}
+
+/**
+ * @brief Starts a new game in a lane without building a Game: the table that Game(seed) gets
+ * from `players` add_player calls (same role draws, no coins, nobody has played).
+ *
+ * @param lane Lane to fill, below LANES.
+ * @param seed Seed of the role generator.
+ * @param players Players at the table, 2 to MAX_SEATS.
+ * @throws std::runtime_error If the lane or the player count is out of range.
+ */
+void LockstepBatch::deal(size_t lane, unsigned int seed, size_t players) {
+    if (lane >= LANES || players < 2 || players > MAX_SEATS) {
+        throw std::runtime_error("Game does not fit in the lockstep batch.");
+    }
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> roles(0, 5); // Game::roleGenerator: Spy .. Baron
+    for (size_t i = 0; i < MAX_SEATS; ++i) {
+        _state.coins[i][lane] = 0;
+        _state.role[i][lane] = static_cast<std::int16_t>(i < players ? roles(rng) + 1 : 0);
+        _state.sanctioned[i][lane] = 0;
+        _state.arrested[i][lane] = 0;
+        _state.canArrest[i][lane] = -1;
+        _state.last[i][lane] = static_cast<std::int16_t>(Action::None);
+        _state.id[i][lane] = static_cast<std::int16_t>(i);
+    }
+    _state.turn[lane] = 0;
+    _state.pos[lane] = 0;
+    _state.size[lane] = static_cast<std::int16_t>(players);
+    _state.bribe[lane] = 0;
+    _state.running[lane] = -1;
+    _seats = std::max(_seats, players);
+}
+
+/**
+ * @brief The built-in policy's move for every lane (a pass for finished lanes).
+ *
+ * Coups the richest opponent with 7 coins, a Baron invests, otherwise taxes. A sanctioned
+ * player arrests or sanctions the richest target it can, a Spy looks, and a player only
+ * passes when nothing is legal.
+ *
+ * @param out LANES moves.
+ */
+void LockstepBatch::choose(Move* out) const {
+    alignas(32) std::int16_t action[LANES];
+    alignas(32) std::int16_t target[LANES];
+#ifdef COUP_LOCKSTEP_AVX2
+    if (_kernel == Kernel::Avx2) {
+        chooseAvx2(_state, _seats, action, target);
+    } else
+#endif
+    {
+        chooseGeneric(_state, _seats, action, target);
+    }
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        Move move{static_cast<Action>(action[lane]), static_cast<std::uint8_t>(target[lane])};
+        out[lane] = _state.running[lane] ? move : Move{};
+    }
+}
+
+/**
+ * @brief Plays one move in every running lane, as moves::apply() would on the lane's game.
+ *
+ * Moves are not checked: each must be legal in its lane (moves::legalMoves). Finished lanes
+ * ignore theirs. A lane stops when one player is left or its turn counter reaches MAX_TURN.
+ *
+ * @param moves LANES moves.
+ */
+void LockstepBatch::apply(const Move* moves) {
+    alignas(32) std::int16_t action[LANES];
+    alignas(32) std::int16_t target[LANES];
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        action[lane] = static_cast<std::int16_t>(moves[lane].action);
+        target[lane] = static_cast<std::int16_t>(moves[lane].target);
+    }
+#ifdef COUP_LOCKSTEP_AVX2
+    if (_kernel == Kernel::Avx2) {
+        applyAvx2(_state, _seats, action, target);
+        return;
+    }
+#endif
+    applyGeneric(_state, _seats, action, target);
+}
+
+/**
+ * @brief Plays the built-in policy in every lane until all games are over.
+ *
+ * @param maxPlies Moves per lane after which the remaining games are left running.
+ * @return size_t Moves played per lane (the longest game).
+ */
+size_t LockstepBatch::run(size_t maxPlies) {
+    Move moves[LANES];
+    size_t plies = 0;
+    for (; plies < maxPlies; ++plies) {
+        bool anyRunning = false;
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            anyRunning = anyRunning || _state.running[lane] != 0;
+        }
+        if (!anyRunning) {
+            break;
+        }
+        choose(moves);
+        apply(moves);
+    }
+    return plies;
+}
+
+bool LockstepBatch::running(size_t lane) const {
+    return _state.running[lane] != 0;
+}
+
+size_t LockstepBatch::players(size_t lane) const {
+    return static_cast<size_t>(_state.size[lane]);
+}
+
+/**
+ * @brief Seat of the player to move, like Game::currentPlayerIndex().
+ */
+size_t LockstepBatch::current(size_t lane) const {
+    return static_cast<size_t>(_state.pos[lane]);
+}
+
+bool LockstepBatch::bribe(size_t lane) const {
+    return _state.bribe[lane] != 0;
+}
+
+int LockstepBatch::turn(size_t lane) const {
+    return _state.turn[lane];
+}
+
+/**
+ * @brief One player of a lane, in current list order.
+ */
+LockstepBatch::Seat LockstepBatch::seat(size_t lane, size_t index) const {
+    return Seat{static_cast<Role>(_state.role[index][lane]),  _state.coins[index][lane],
+                _state.sanctioned[index][lane] != 0,           _state.arrested[index][lane] != 0,
+                _state.canArrest[index][lane] != 0,            static_cast<Action>(_state.last[index][lane]),
+                static_cast<size_t>(_state.id[index][lane])};
+}
+
+/**
+ * @brief Seat id (as loaded) of the last player standing, or NO_WINNER while the game runs.
+ */
+size_t LockstepBatch::winner(size_t lane) const {
+    return _state.size[lane] == 1 ? static_cast<size_t>(_state.id[0][lane]) : NO_WINNER;
+}
+
+LockstepBatch::Kernel LockstepBatch::kernel() const {
+    return _kernel;
+}
+
+/**
+ * @brief AVX2 when this CPU has it, the baseline build otherwise.
+ */
+LockstepBatch::Kernel LockstepBatch::bestKernel() {
+#ifdef COUP_LOCKSTEP_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::Avx2;
+    }
+#endif
+    return Kernel::Generic;
+}
+
+const char* LockstepBatch::kernelName(Kernel kernel) {
+    return kernel == Kernel::Avx2 ? "avx2" : "generic";
+}
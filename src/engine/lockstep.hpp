@@ -0,0 +1,80 @@
+#ifndef LOCKSTEP_HPP
+#define LOCKSTEP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "engine/move.hpp"
+#include "roles/role_type.hpp"
+
+class Game;
+
+// Up to LANES independent games stepped together, one game per lane, for balance sweeps.
+//
+// Every per-seat field is a row of LANES 16-bit values (structure of arrays), so a rule is
+// applied to all lanes at once as a few masked vector operations instead of a branch per game.
+// Seats stay in players-list order and are compacted on a coup, and the turn counter works like
+// Game's, so a lane replays the scalar engine move for move (block windows are not modelled).
+// The kernels are built twice: for AVX2, used when the CPU has it, and for the baseline target
+// (SSE2 on x86-64), which works on half a row at a time.
+class LockstepBatch {
+public:
+    static constexpr size_t LANES = 16;
+    static constexpr size_t MAX_SEATS = 8;
+    static constexpr std::int16_t MAX_TURN = 30000; // lanes are abandoned before the counter overflows
+    static constexpr size_t NO_WINNER = static_cast<size_t>(-1);
+
+    enum class Kernel : std::uint8_t { Generic, Avx2 };
+
+    struct Seat {
+        Role role;
+        int coins;
+        bool sanctioned;
+        bool arrested;
+        bool canArrest;
+        Action lastAction;
+        size_t id; // seat in the players list when the lane was loaded
+    };
+
+    explicit LockstepBatch(Kernel kernel = bestKernel());
+
+    void load(size_t lane, const Game& game);
+    void deal(size_t lane, unsigned int seed, size_t players);
+    void choose(Move* out) const;
+    void apply(const Move* moves);
+    size_t run(size_t maxPlies);
+
+    bool running(size_t lane) const;
+    size_t players(size_t lane) const;
+    size_t current(size_t lane) const;
+    bool bribe(size_t lane) const;
+    int turn(size_t lane) const;
+    Seat seat(size_t lane, size_t index) const;
+    size_t winner(size_t lane) const;
+    Kernel kernel() const;
+
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    // Rows of the batch; flags are 0 or -1 so they can be used as masks
+    struct alignas(32) State {
+        std::int16_t coins[MAX_SEATS][LANES];
+        std::int16_t role[MAX_SEATS][LANES];
+        std::int16_t sanctioned[MAX_SEATS][LANES];
+        std::int16_t arrested[MAX_SEATS][LANES];
+        std::int16_t canArrest[MAX_SEATS][LANES];
+        std::int16_t last[MAX_SEATS][LANES];
+        std::int16_t id[MAX_SEATS][LANES];
+        std::int16_t turn[LANES];
+        std::int16_t pos[LANES]; // turn % size, the current seat
+        std::int16_t size[LANES];
+        std::int16_t bribe[LANES];
+        std::int16_t running[LANES];
+    };
+
+private:
+    State _state;
+    size_t _seats; // rows in use: the largest table loaded
+    Kernel _kernel;
+};
+
+#endif // LOCKSTEP_HPP
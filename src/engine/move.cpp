@@ -0,0 +1,272 @@
+#include "move.hpp"
+#include "game.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace moves {
+
+/**
+ * @brief Lists every action the current player can take without the engine throwing.
+ *
+ * Mirrors the checks in Player and the role classes:
+ * - With 10 or more coins only coup (and the Spy's free look) is allowed.
+ * - Gather and tax need the player not to be sanctioned.
+ * - Bribe needs 4 coins, sanction 3 (4 against a Judge), coup 7.
+ * - Arrest needs permission to arrest and a target that is not arrested and has coins.
+ * - Baron may invest with at least 3 coins; the Spy may look once per turn
+ *   (spyAbility does not end the turn, so a second look would never make progress).
+ * If nothing is allowed, a single pass move (Action::None) is returned.
+ *
+ * Nothing is allocated, so this is safe to call on hot paths.
+ *
+ * @param game The game, read only.
+ * @param out Output array.
+ * @param capacity Size of the output array; MAX_MOVES is always enough for MAX_TABLE players.
+ * @return size_t Number of moves written.
+ */
+size_t legalMoves(const Game& game, Move* out, size_t capacity) {
+    size_t count = 0;
+    auto push = [&](Action action, size_t target) {
+        if (count < capacity) {
+            out[count++] = Move{action, static_cast<std::uint8_t>(target)};
+        }
+    };
+
+    size_t n = game.playerCount();
+    if (n < 2 || capacity == 0) {
+        return 0;
+    }
+    size_t self = static_cast<size_t>(game.currentPlayerIndex());
+    const Player& actor = game.playerAt(self);
+    int coins = actor.getCoins();
+    bool mustCoup = coins >= 10;
+    Role role = actor.role();
+
+    if (!mustCoup) {
+        if (!actor.isSanctioned()) {
+            push(Action::Gather, Move::NO_TARGET);
+            push(Action::Tax, Move::NO_TARGET);
+        }
+        if (coins >= 4) {
+            push(Action::Bribe, Move::NO_TARGET);
+        }
+        if (role == Role::Baron && coins >= 3) {
+            push(Action::Ability, Move::NO_TARGET);
+        }
+    }
+
+    for (size_t t = 0; t < n; ++t) {
+        if (t == self) {
+            continue;
+        }
+        const Player& target = game.playerAt(t);
+        if (!mustCoup) {
+            if (actor.getCanArrest() && !target.isArrested() && target.getCoins() > 0) {
+                push(Action::Arrest, t);
+            }
+            if (coins >= 3 && (coins >= 4 || target.role() != Role::Judge)) {
+                push(Action::Sanction, t);
+            }
+        }
+        if (coins >= 7) {
+            push(Action::Coup, t);
+        }
+        if (role == Role::Spy && actor.getLastAction() != Action::Ability) {
+            push(Action::Ability, t);
+        }
+    }
+
+    if (count == 0) {
+        push(Action::None, Move::NO_TARGET);
+    }
+    return count;
+}
+
+/**
+ * @brief Checks a single move against the rules of legalMoves().
+ *
+ * The move is tested on its own, so apply() can check every move it plays; only a pass,
+ * which needs every other move to be ruled out, generates the full list.
+ *
+ * @return true if legalMoves() lists the move for the current player.
+ */
+bool isLegal(const Game& game, const Move& move) {
+    size_t n = game.playerCount();
+    if (n < 2) {
+        return false;
+    }
+    if (move.action == Action::None) {
+        Move buffer[MAX_MOVES];
+        return move.target == Move::NO_TARGET && legalMoves(game, buffer, MAX_MOVES) == 1 &&
+               buffer[0].action == Action::None;
+    }
+    size_t self = static_cast<size_t>(game.currentPlayerIndex());
+    const Player& actor = game.playerAt(self);
+    int coins = actor.getCoins();
+    bool mustCoup = coins >= 10;
+    Role role = actor.role();
+
+    switch (move.action) {
+        case Action::Gather:
+        case Action::Tax:
+            return move.target == Move::NO_TARGET && !mustCoup && !actor.isSanctioned();
+        case Action::Bribe:
+            return move.target == Move::NO_TARGET && !mustCoup && coins >= 4;
+        case Action::Ability:
+            if (move.target == Move::NO_TARGET) {
+                return !mustCoup && role == Role::Baron && coins >= 3;
+            }
+            break; // the Spy's look
+        case Action::Arrest:
+        case Action::Sanction:
+        case Action::Coup:
+            break;
+        default:
+            return false;
+    }
+
+    if (move.target >= n || move.target == self) {
+        return false;
+    }
+    const Player& target = game.playerAt(move.target);
+    switch (move.action) {
+        case Action::Arrest:
+            return !mustCoup && actor.getCanArrest() && !target.isArrested() && target.getCoins() > 0;
+        case Action::Sanction:
+            return !mustCoup && coins >= 3 && (coins >= 4 || target.role() != Role::Judge);
+        case Action::Coup:
+            return coins >= 7;
+        default:
+            return role == Role::Spy && actor.getLastAction() != Action::Ability;
+    }
+}
+
+/**
+ * @brief Plays a move for the current player through the Player and role classes.
+ *
+ * The move is checked against legalMoves() first, so apply() accepts exactly the moves
+ * the generator lists: a role's block reaction or a Merchant's passive coin is never a
+ * move, and a stray target or unknown action byte is refused. The Player method that is
+ * called then carries the move out.
+ *
+ * @param game The game to update.
+ * @param move The move to play.
+ * @throws std::runtime_error If the game is over or the move is not legal; the message names the
+ *         rejectReason().
+ */
+void apply(Game& game, const Move& move) {
+    COUP_TRACE_SCOPE("moves::apply");
+    COUP_ALLOC_SCOPE("moves::apply");
+    if (!game.isGame() || game.playerCount() < 2) {
+        throw std::runtime_error("The game is over.");
+    }
+    if (!isLegal(game, move)) {
+        throw std::runtime_error(std::string("Illegal move: ") + rejectName(rejectReason(game, move)) + ".");
+    }
+    Player& actor = game.playerAt(static_cast<size_t>(game.currentPlayerIndex()));
+
+    switch (move.action) {
+        case Action::None:
+            game.next_turn();
+            break;
+        case Action::Gather:
+            actor.gather();
+            break;
+        case Action::Tax:
+            actor.tax();
+            break;
+        case Action::Bribe:
+            actor.bribe();
+            break;
+        case Action::Arrest:
+            actor.arrest(game.playerAt(move.target));
+            break;
+        case Action::Sanction:
+            actor.sanction(game.playerAt(move.target));
+            break;
+        case Action::Coup:
+            actor.coup(game.playerAt(move.target));
+            break;
+        case Action::Ability:
+            if (move.target == Move::NO_TARGET) {
+                actor.ability(); // the Baron's invest
+            } else {
+                actor.spyAbility(game.playerAt(move.target));
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Explains why apply() would refuse a move, without playing it.
+ *
+ * Only meant for the failure path (metrics, error reports): it repeats the checks of
+ * legalMoves() for the one move, so a legal move returns Reject::None.
+ *
+ * @param game The game, read only.
+ * @param move The move that was refused.
+ * @return Reject The first rule the move breaks.
+ */
+Reject rejectReason(const Game& game, const Move& move) {
+    if (!game.isGame() || game.playerCount() < 2) {
+        return Reject::GameOver;
+    }
+    if (move.action > Action::Ability) {
+        return Reject::UnknownAction;
+    }
+    if (isLegal(game, move)) {
+        return Reject::None;
+    }
+    size_t self = static_cast<size_t>(game.currentPlayerIndex());
+    const Player& actor = game.playerAt(self);
+    int coins = actor.getCoins();
+    bool targeted = move.action == Action::Arrest || move.action == Action::Sanction || move.action == Action::Coup ||
+                    (move.action == Action::Ability && move.target != Move::NO_TARGET);
+    if (targeted && (move.target >= game.playerCount() || move.target == self)) {
+        return Reject::InvalidTarget;
+    }
+    if (!targeted && move.target != Move::NO_TARGET) {
+        return Reject::InvalidTarget; // a target on a move that takes none
+    }
+    if (move.action == Action::None) {
+        return Reject::MustAct;
+    }
+    if (coins >= 10 && move.action != Action::Coup && move.action != Action::Ability) {
+        return Reject::MustCoup;
+    }
+    switch (move.action) {
+        case Action::Gather:
+        case Action::Tax:
+            return Reject::Sanctioned;
+        case Action::Arrest:
+            return Reject::CannotArrest;
+        case Action::Ability:
+            return actor.role() == Role::Baron && move.target == Move::NO_TARGET ? Reject::NotEnoughCoins
+                                                                                  : Reject::AbilityUnavailable;
+        default:
+            return Reject::NotEnoughCoins; // bribe, sanction, coup
+    }
+}
+
+/**
+ * @brief Short snake_case name of a reason, as used in metrics labels.
+ */
+const char* rejectName(Reject reason) {
+    switch (reason) {
+        case Reject::None: return "none";
+        case Reject::GameOver: return "game_over";
+        case Reject::UnknownAction: return "unknown_action";
+        case Reject::InvalidTarget: return "invalid_target";
+        case Reject::MustCoup: return "must_coup";
+        case Reject::Sanctioned: return "sanctioned";
+        case Reject::NotEnoughCoins: return "not_enough_coins";
+        case Reject::CannotArrest: return "cannot_arrest";
+        case Reject::AbilityUnavailable: return "ability_unavailable";
+        case Reject::MustAct: return "must_act";
+        default: return "other";
+    }
+}
+
+} // namespace moves
@@ -0,0 +1,51 @@
+#ifndef MOVE_HPP
+#define MOVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "roles/actions.hpp"
+
+class Game;
+
+// One decision of the player whose turn it is.
+// target is a position in Game::getPlayers(); Action::None means "no legal action, pass".
+struct Move {
+    static constexpr std::uint8_t NO_TARGET = 0xFF;
+
+    Action action = Action::None;
+    std::uint8_t target = NO_TARGET;
+
+    bool operator==(const Move& other) const { return action == other.action && target == other.target; }
+    bool operator!=(const Move& other) const { return !(*this == other); }
+};
+
+namespace moves {
+
+// Why the rules refuse a move, for metrics and client diagnostics
+enum class Reject : std::uint8_t {
+    None,               // the move is legal
+    GameOver,
+    UnknownAction,
+    InvalidTarget,
+    MustCoup,           // 10 or more coins
+    Sanctioned,
+    NotEnoughCoins,
+    CannotArrest,       // no permission, target already arrested or broke
+    AbilityUnavailable, // role has no such ability, or the Spy already looked
+    MustAct,            // pass while another move is available
+    Count
+};
+
+// Upper bound on legalMoves() output for tables of up to MAX_TABLE players
+constexpr size_t MAX_TABLE = 16;
+constexpr size_t MAX_MOVES = 4 + 4 * (MAX_TABLE - 1);
+
+size_t legalMoves(const Game& game, Move* out, size_t capacity);
+bool isLegal(const Game& game, const Move& move);
+void apply(Game& game, const Move& move);
+Reject rejectReason(const Game& game, const Move& move);
+const char* rejectName(Reject reason);
+
+} // namespace moves
+
+#endif // MOVE_HPP
@@ -0,0 +1,133 @@
+#include "name_table.hpp"
+#include <stdexcept>
+
+/**
+ * @brief Creates an empty table with room for a full table of players before growing.
+ */
+NameTable::NameTable() : _buckets(16, NONE) {}
+
+/**
+ * @brief Creates an empty table whose arrays, sized for a number of names, come from an arena.
+ *
+ * @param arena Arena with at least arenaBytes(names) left.
+ * @param names Names the table takes before its hash regrows.
+ */
+NameTable::NameTable(ColumnArena& arena, size_t names)
+    : _names(ColumnAllocator<std::string>(&arena)),
+      _hashes(ColumnAllocator<std::uint32_t>(&arena)),
+      _buckets(bucketsFor(names), NONE, ColumnAllocator<std::uint32_t>(&arena)) {
+    _names.reserve(names);
+    _hashes.reserve(names);
+}
+
+/**
+ * @brief Arena bytes NameTable(arena, names) takes.
+ */
+size_t NameTable::arenaBytes(size_t names) {
+    return ColumnAllocator<std::string>::bytesFor(names) + ColumnAllocator<std::uint32_t>::bytesFor(names) +
+           ColumnAllocator<std::uint32_t>::bytesFor(bucketsFor(names));
+}
+
+/**
+ * @brief Returns the id of a name, adding it to the table when it is new.
+ *
+ * @param name The player name.
+ * @return std::uint32_t Its id: ids are handed out in order from 0.
+ */
+std::uint32_t NameTable::intern(std::string_view name) {
+    std::uint32_t h = hash(name);
+    size_t bucket = bucketOf(name, h);
+    if (_buckets[bucket] != NONE) {
+        return _buckets[bucket];
+    }
+    std::uint32_t id = static_cast<std::uint32_t>(_names.size());
+    _names.emplace_back(name);
+    _hashes.push_back(h);
+    _buckets[bucket] = id;
+    if (_names.size() * 2 > _buckets.size()) {
+        grow();
+    }
+    return id;
+}
+
+/**
+ * @brief Looks a name up without adding it.
+ *
+ * @param name The player name.
+ * @return std::uint32_t Its id, or NONE if the name was never interned.
+ */
+std::uint32_t NameTable::find(std::string_view name) const {
+    return _buckets[bucketOf(name, hash(name))];
+}
+
+/**
+ * @brief The text of an interned name.
+ *
+ * @param id An id returned by intern().
+ * @return const std::string& The name; valid until the next intern().
+ * @throws std::runtime_error If the id is unknown.
+ */
+const std::string& NameTable::name(std::uint32_t id) const {
+    if (id >= _names.size()) {
+        throw std::runtime_error("Unknown name id.");
+    }
+    return _names[id];
+}
+
+/**
+ * @brief Number of distinct names interned so far.
+ */
+size_t NameTable::size() const {
+    return _names.size();
+}
+
+/**
+ * @brief 32-bit FNV-1a of the name's bytes.
+ */
+std::uint32_t NameTable::hash(std::string_view name) {
+    std::uint32_t h = 2166136261u;
+    for (char c : name) {
+        h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Buckets of a table holding a number of names at most half full: 16 or more, a power of two.
+ */
+size_t NameTable::bucketsFor(size_t names) {
+    size_t buckets = 16;
+    while (names * 2 > buckets) {
+        buckets *= 2;
+    }
+    return buckets;
+}
+
+/**
+ * @brief The bucket holding the name, or the empty bucket where it would go.
+ */
+size_t NameTable::bucketOf(std::string_view name, std::uint32_t hash) const {
+    size_t mask = _buckets.size() - 1;
+    for (size_t bucket = hash & mask;; bucket = (bucket + 1) & mask) {
+        std::uint32_t id = _buckets[bucket];
+        if (id == NONE || (_hashes[id] == hash && _names[id] == name)) {
+            return bucket;
+        }
+    }
+}
+
+/**
+ * @brief Doubles the bucket array and reinserts every id from its stored hash.
+ */
+void NameTable::grow() {
+    Column<std::uint32_t> buckets(_buckets.size() * 2, NONE, _buckets.get_allocator());
+    size_t mask = buckets.size() - 1;
+    for (std::uint32_t id = 0; id < _names.size(); ++id) {
+        size_t bucket = _hashes[id] & mask;
+        while (buckets[bucket] != NONE) {
+            bucket = (bucket + 1) & mask;
+        }
+        buckets[bucket] = id;
+    }
+    _buckets.swap(buckets);
+}
@@ -0,0 +1,42 @@
+#ifndef NAME_TABLE_HPP
+#define NAME_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "engine/column_arena.hpp"
+
+// Per-game symbol table: every player name is stored once and known by a small integer id,
+// so the engine compares and looks up names as integers. Lookup is an open-addressing hash
+// (FNV-1a, linear probing, at most half full). Ids are never reused; interning the same text
+// again returns the same id. A table built for a known number of names takes its arrays from a
+// column arena.
+class NameTable {
+public:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+    NameTable();
+    NameTable(ColumnArena& arena, size_t names);
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    static size_t arenaBytes(size_t names);
+    std::uint32_t intern(std::string_view name);
+    std::uint32_t find(std::string_view name) const;
+    const std::string& name(std::uint32_t id) const;
+    size_t size() const;
+
+private:
+    static std::uint32_t hash(std::string_view name);
+    static size_t bucketsFor(size_t names);
+    size_t bucketOf(std::string_view name, std::uint32_t hash) const;
+    void grow();
+
+    Column<std::string> _names;
+    Column<std::uint32_t> _hashes; // per id
+    Column<std::uint32_t> _buckets; // ids, NONE when empty; size is a power of two
+};
+
+#endif // NAME_TABLE_HPP
@@ -0,0 +1,221 @@
+#include "perft.hpp"
+#include "game.hpp"
+#include "engine/snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+// A position reached at the split depth and the first move that led to it
+struct Subtree {
+    std::vector<std::uint8_t> image;
+    size_t root;
+};
+
+// Depth-first walk over one Game, restoring each position from a snapshot after every move.
+// Counts go to its own arrays, so every thread has a walker of its own.
+class Walker {
+public:
+    Walker(const std::vector<std::string>& names, const std::vector<Role>& roles, unsigned int seed, size_t depth,
+           size_t rootMoves)
+        : game(names, roles, seed), nodes(depth + 1, 0), finished(depth + 1, 0), leaves(rootMoves, 0),
+          _depth(depth), _legal(depth), _images(depth) {
+        for (auto& image : _images) {
+            image.reserve(256);
+        }
+    }
+
+    // Counts every sequence from the position at ply down to stop; positions at stop from which
+    // the game goes on are kept in subtrees when it is given
+    void walk(size_t ply, size_t stop, size_t root, std::vector<Subtree>* subtrees) {
+        if (ply == stop) {
+            if (subtrees && ply < _depth && game.isGame()) {
+                subtrees->push_back(Subtree{{}, root});
+                Snapshot::write(game, subtrees->back().image);
+            }
+            return;
+        }
+        Move* legal = _legal[ply].data();
+        size_t count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+        if (count == 0) {
+            return;
+        }
+        std::vector<std::uint8_t>& image = _images[ply];
+        image.clear();
+        Snapshot::write(game, image);
+        for (size_t i = 0; i < count; ++i) {
+            size_t branch = ply == 0 ? i : root;
+            moves::apply(game, legal[i]);
+            nodes[ply + 1]++;
+            if (!game.isGame()) {
+                finished[ply + 1]++;
+            }
+            if (ply + 1 == _depth) {
+                leaves[branch]++;
+            }
+            walk(ply + 1, stop, branch, subtrees);
+            Snapshot::read(game, image.data(), image.size());
+        }
+    }
+
+    Game game;
+    std::vector<std::uint64_t> nodes;
+    std::vector<std::uint64_t> finished;
+    std::vector<std::uint64_t> leaves; // full-depth sequences per first move
+
+private:
+    size_t _depth;
+    std::vector<std::array<Move, moves::MAX_MOVES>> _legal;
+    std::vector<std::vector<std::uint8_t>> _images;
+};
+
+std::vector<std::string> seatNames(size_t players) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < players; ++i) {
+        names.push_back("p" + std::to_string(i));
+    }
+    return names;
+}
+
+}
+
+/**
+ * @brief Sum of the node counts over all depths, the start position included.
+ */
+std::uint64_t PerftResult::total() const {
+    std::uint64_t sum = 0;
+    for (std::uint64_t count : nodes) {
+        sum += count;
+    }
+    return sum;
+}
+
+/**
+ * @brief Fixes the start position: players p0, p1, ... seated with the given or rolled roles.
+ *
+ * @param options Table size or roles, seed, depth and split depth.
+ * @throws std::runtime_error If the table size, the roles or the depth are out of range.
+ */
+Perft::Perft(const PerftOptions& options) : _options(options), _roles(options.roles) {
+    if (!_roles.empty()) {
+        _options.players = _roles.size();
+    }
+    if (_options.players < 2 || _options.players > moves::MAX_TABLE) {
+        throw std::runtime_error("Perft needs 2 to 16 players.");
+    }
+    if (_options.depth > MAX_DEPTH) {
+        throw std::runtime_error("Perft depth is limited to 32 plies.");
+    }
+    for (Role role : _roles) {
+        if (role < Role::Spy || role > Role::Baron) {
+            throw std::runtime_error("Perft roles must be Spy .. Baron.");
+        }
+    }
+    if (_roles.empty()) {
+        Game start(seatNames(_options.players), _options.seed);
+        for (size_t i = 0; i < start.playerCount(); ++i) {
+            _roles.push_back(start.playerAt(i).role());
+        }
+    }
+}
+
+/**
+ * @brief Counts every move sequence up to the configured depth.
+ *
+ * The first min(splitDepth, depth) plies are walked on the calling thread, which keeps a snapshot
+ * of every position reached there that is still running; threads then take those subtrees one at
+ * a time and the per-thread counts are added up at the end.
+ *
+ * @param threads Worker threads for the subtrees.
+ * @return PerftResult Counts per depth and per first move.
+ * @throws std::runtime_error If the engine throws on a move it listed as legal.
+ */
+PerftResult Perft::run(size_t threads) const {
+    const std::vector<std::string> names = seatNames(_roles.size());
+    const size_t depth = _options.depth;
+    Move first[moves::MAX_MOVES];
+    size_t rootMoves = 0;
+    {
+        Game start(names, _roles, _options.seed);
+        rootMoves = depth > 0 ? moves::legalMoves(start, first, moves::MAX_MOVES) : 0;
+    }
+
+    Walker top(names, _roles, _options.seed, depth, rootMoves);
+    std::vector<Subtree> subtrees;
+    size_t split = std::min(_options.splitDepth, depth);
+    top.walk(0, split, 0, split < depth ? &subtrees : nullptr);
+
+    threads = std::max<size_t>(1, std::min(threads, subtrees.size()));
+    std::vector<Walker> walkers;
+    walkers.reserve(threads);
+    for (size_t t = 0; t < threads && !subtrees.empty(); ++t) {
+        walkers.emplace_back(names, _roles, _options.seed, depth, rootMoves);
+    }
+    std::atomic<size_t> next(0);
+    std::vector<std::string> errors(walkers.size());
+    auto work = [&](size_t worker) {
+        Walker& walker = walkers[worker];
+        try {
+            for (size_t i = next.fetch_add(1); i < subtrees.size(); i = next.fetch_add(1)) {
+                const Subtree& subtree = subtrees[i];
+                Snapshot::read(walker.game, subtree.image.data(), subtree.image.size());
+                walker.walk(split, depth, subtree.root, nullptr);
+            }
+        } catch (const std::exception& e) {
+            errors[worker] = e.what();
+        }
+    };
+    if (walkers.size() == 1) {
+        work(0);
+    } else if (walkers.size() > 1) {
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < walkers.size(); ++t) {
+            pool.emplace_back(work, t);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    PerftResult result;
+    result.nodes = top.nodes;
+    result.finished = top.finished;
+    result.nodes[0] = 1;
+    std::vector<std::uint64_t> leaves = top.leaves;
+    for (const Walker& walker : walkers) {
+        for (size_t d = 0; d <= depth; ++d) {
+            result.nodes[d] += walker.nodes[d];
+            result.finished[d] += walker.finished[d];
+        }
+        for (size_t i = 0; i < rootMoves; ++i) {
+            leaves[i] += walker.leaves[i];
+        }
+    }
+    for (size_t i = 0; i < rootMoves; ++i) {
+        result.divide.emplace_back(first[i], leaves[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief Roles of the start position in seat order, rolled from the seed if none were given.
+ */
+const std::vector<Role>& Perft::roles() const {
+    return _roles;
+}
+
+/**
+ * @brief The options the counter was built with; players matches roles().
+ */
+const PerftOptions& Perft::options() const {
+    return _options;
+}
@@ -0,0 +1,53 @@
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "engine/move.hpp"
+#include "roles/role_type.hpp"
+
+struct PerftOptions {
+    size_t players = 2;
+    std::vector<Role> roles;     // seat order; empty: rolled from the seed like Game(names, seed)
+    unsigned int seed = 1;
+    size_t depth = 6;
+    size_t splitDepth = 3;       // plies expanded on the calling thread before splitting the subtrees
+};
+
+// Node counts of one run. nodes[d] is the number of move sequences of length d from the start
+// (nodes[0] == 1) and finished[d] how many of them end the game. divide has one entry per legal
+// first move with the number of sequences of full depth that begin with it.
+struct PerftResult {
+    std::vector<std::uint64_t> nodes;
+    std::vector<std::uint64_t> finished;
+    std::vector<std::pair<Move, std::uint64_t>> divide;
+
+    std::uint64_t total() const;
+};
+
+// Enumerates every legal move sequence from a start position up to a depth through moves::apply(),
+// Game and the role classes, like perft in chess engines: the counts validate move generation and
+// rules against known values and time the engine on a fixed workload.
+//
+// A ply is one move, so a Spy's free look or a bribed extra action is a ply of its own. Positions
+// are restored from a Snapshot after each move. The first splitDepth plies are walked on the calling
+// thread; the positions reached there are handed to the threads one at a time, and the counts do
+// not depend on the thread count or the split.
+class Perft {
+public:
+    static constexpr size_t MAX_DEPTH = 32;
+
+    explicit Perft(const PerftOptions& options);
+
+    PerftResult run(size_t threads) const;
+    const std::vector<Role>& roles() const;
+    const PerftOptions& options() const;
+
+private:
+    PerftOptions _options;
+    std::vector<Role> _roles;
+};
+
+#endif // PERFT_HPP
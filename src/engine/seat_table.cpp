@@ -0,0 +1,134 @@
+#include "seat_table.hpp"
+
+/**
+ * @brief Creates an empty table whose columns and name table, sized for a number of slots, are
+ * carved out of the given bytes.
+ *
+ * @param arena At least arenaBytes(slots) bytes that outlive the table.
+ * @param bytes Size of the arena.
+ * @param slots Slots the table takes without growing.
+ */
+SeatTable::SeatTable(unsigned char* arena, size_t bytes, size_t slots)
+    : _arena{arena, arena, arena + bytes},
+      names(_arena, slots),
+      coins(ColumnAllocator<int>(&_arena)),
+      sanctioned(ColumnAllocator<std::uint8_t>(&_arena)),
+      arrested(ColumnAllocator<std::uint8_t>(&_arena)),
+      canArrest(ColumnAllocator<std::uint8_t>(&_arena)),
+      active(ColumnAllocator<std::uint8_t>(&_arena)),
+      lastAction(ColumnAllocator<Action>(&_arena)),
+      role(ColumnAllocator<Role>(&_arena)),
+      nameId(ColumnAllocator<std::uint32_t>(&_arena)),
+      _seated_by_name(ColumnAllocator<std::uint32_t>(&_arena)) {
+    coins.reserve(slots);
+    sanctioned.reserve(slots);
+    arrested.reserve(slots);
+    canArrest.reserve(slots);
+    active.reserve(slots);
+    lastAction.reserve(slots);
+    role.reserve(slots);
+    nameId.reserve(slots);
+    _seated_by_name.reserve(slots);
+}
+
+/**
+ * @brief Arena bytes SeatTable(arena, bytes, slots) takes.
+ */
+size_t SeatTable::arenaBytes(size_t slots) {
+    return NameTable::arenaBytes(slots) + ColumnAllocator<int>::bytesFor(slots) +
+           4 * ColumnAllocator<std::uint8_t>::bytesFor(slots) + ColumnAllocator<Action>::bytesFor(slots) +
+           ColumnAllocator<Role>::bytesFor(slots) + 2 * ColumnAllocator<std::uint32_t>::bytesFor(slots);
+}
+
+/**
+ * @brief Reserves a slot with the values of a fresh Player.
+ *
+ * Reuses the slot of a destroyed player if there is one, otherwise grows every column.
+ *
+ * @param name The player's name, interned into the table.
+ * @return size_t The slot, valid until release().
+ */
+size_t SeatTable::claim(std::string_view name) {
+    size_t slot;
+    if (!_free.empty()) {
+        slot = _free.back();
+        _free.pop_back();
+    } else {
+        slot = coins.size();
+        coins.push_back(0);
+        sanctioned.push_back(0);
+        arrested.push_back(0);
+        canArrest.push_back(0);
+        active.push_back(0);
+        lastAction.push_back(Action::None);
+        role.push_back(Role::Player);
+        nameId.push_back(0);
+    }
+    coins[slot] = 0;
+    sanctioned[slot] = 0;
+    arrested[slot] = 0;
+    canArrest[slot] = 1;
+    active[slot] = 0;
+    lastAction[slot] = Action::None;
+    role[slot] = Role::Player;
+    nameId[slot] = names.intern(name);
+    if (nameId[slot] >= _seated_by_name.size()) {
+        _seated_by_name.resize(names.size(), 0);
+    }
+    return slot;
+}
+
+/**
+ * @brief Returns a slot for reuse; it no longer counts as an active seat.
+ *
+ * @param slot A slot obtained from claim().
+ */
+void SeatTable::release(size_t slot) {
+    setActive(slot, false);
+    _free.push_back(slot);
+}
+
+/**
+ * @brief Gives a slot another name, keeping the seated-name counts right.
+ *
+ * @param slot A claimed slot.
+ * @param name The new name.
+ */
+void SeatTable::rename(size_t slot, std::string_view name) {
+    bool wasActive = active[slot];
+    setActive(slot, false);
+    nameId[slot] = names.intern(name);
+    if (nameId[slot] >= _seated_by_name.size()) {
+        _seated_by_name.resize(names.size(), 0);
+    }
+    setActive(slot, wasActive);
+}
+
+/**
+ * @brief Marks a slot as in or out of the players list.
+ *
+ * @param slot A claimed slot.
+ * @param isActive true while the player is in the players list.
+ */
+void SeatTable::setActive(size_t slot, bool isActive) {
+    if (active[slot] != isActive) {
+        active[slot] = isActive;
+        _seated_by_name[nameId[slot]] += isActive ? 1 : -1;
+    }
+}
+
+/**
+ * @brief Whether a player with this name is in the players list: a hash lookup, not a scan.
+ *
+ * @param nameId An id from `names`, or NameTable::NONE.
+ */
+bool SeatTable::seated(std::uint32_t nameId) const {
+    return nameId < _seated_by_name.size() && _seated_by_name[nameId] > 0;
+}
+
+/**
+ * @brief Number of slots, including released ones (their `active` is 0).
+ */
+size_t SeatTable::size() const {
+    return coins.size();
+}
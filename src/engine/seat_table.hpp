@@ -0,0 +1,58 @@
+#ifndef SEAT_TABLE_HPP
+#define SEAT_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "engine/column_arena.hpp"
+#include "engine/name_table.hpp"
+#include "roles/actions.hpp"
+#include "roles/role_type.hpp"
+
+// Hot per-seat fields of a Game, one column per field (structure of arrays).
+//
+// Every Player owns one slot for its whole life and its accessors read and write the columns at
+// that slot, so Game's per-turn scans (canAction, resetArrest) are plain loops over a few bytes
+// instead of a pointer chase per player. Flags are 0 or 1. `active` marks the slots of players
+// in the players list and `role` is filled in when a player joins it; slots of destroyed players
+// are recycled. A copy of a Game copies its players into a table of its own.
+// Names are interned in `names`; `nameId` holds each slot's name id.
+// A table built for a known number of slots carves its columns and name arrays out of bytes
+// handed to it (a roster puts them in the same block as its players); it only reaches for the
+// heap once it grows past them.
+class SeatTable {
+private:
+    ColumnArena _arena; // first: the members below are built from it
+
+public:
+    SeatTable() = default;
+    SeatTable(unsigned char* arena, size_t bytes, size_t slots);
+    SeatTable(const SeatTable&) = delete;
+    SeatTable& operator=(const SeatTable&) = delete;
+
+    static size_t arenaBytes(size_t slots);
+    size_t claim(std::string_view name);
+    void release(size_t slot);
+    void rename(size_t slot, std::string_view name);
+    void setActive(size_t slot, bool isActive);
+    bool seated(std::uint32_t nameId) const;
+    size_t size() const;
+
+    NameTable names;
+
+    Column<int> coins;
+    Column<std::uint8_t> sanctioned;
+    Column<std::uint8_t> arrested;
+    Column<std::uint8_t> canArrest;
+    Column<std::uint8_t> active;
+    Column<Action> lastAction;
+    Column<Role> role;
+    Column<std::uint32_t> nameId;
+
+private:
+    std::vector<size_t> _free;
+    Column<std::uint32_t> _seated_by_name; // active slots holding each name id
+};
+
+#endif // SEAT_TABLE_HPP
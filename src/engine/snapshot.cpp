@@ -0,0 +1,293 @@
+#include "snapshot.hpp"
+#include "game.hpp"
+#include "roles/player_factory.hpp"
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 4 + 4 + 4 + 3;
+constexpr size_t ENTRY_SIZE = 7; // without the name
+constexpr std::uint8_t STATE_BRIBE = 1;
+constexpr std::uint8_t STATE_ACTIVE = 2;
+constexpr std::uint8_t FLAG_SANCTIONED = 1;
+constexpr std::uint8_t FLAG_ARRESTED = 2;
+constexpr std::uint8_t FLAG_CAN_ARREST = 4;
+
+const char* roleName(Role role) {
+    switch (role) {
+        case Role::Spy: return "Spy";
+        case Role::Merchant: return "Merchant";
+        case Role::Judge: return "Judge";
+        case Role::Governor: return "Governor";
+        case Role::General: return "General";
+        case Role::Baron: return "Baron";
+        default: return "Player";
+    }
+}
+
+std::uint8_t* putU32(std::uint8_t* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        *out++ = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+    return out;
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+// The entry of a player of a game
+SnapshotEntry entryOf(const Player& player, const NameTable& names) {
+    SnapshotEntry entry;
+    entry.role = player.role();
+    entry.seat = static_cast<std::uint8_t>(player.getIndex());
+    entry.coins = player.getCoins();
+    entry.sanctioned = player.isSanctioned();
+    entry.arrested = player.isArrested();
+    entry.canArrest = player.getCanArrest();
+    entry.lastAction = player.getLastAction();
+    entry.name = names.name(player.getNameId());
+    return entry;
+}
+
+// Bytes of a player's entry, name included
+size_t entrySize(const Player& player, const NameTable& names) {
+    size_t length = names.name(player.getNameId()).size();
+    if (length > 255 || player.getIndex() > 255) {
+        throw std::runtime_error("Player cannot be stored in a snapshot.");
+    }
+    return ENTRY_SIZE + length;
+}
+
+std::uint8_t* putHeader(std::uint8_t* out, const SnapshotState& state, size_t players, size_t outList) {
+    *out++ = 'C';
+    *out++ = 'S';
+    *out++ = Snapshot::VERSION;
+    *out++ = 0;
+    out = putU32(out, static_cast<std::uint32_t>(state.turn));
+    out = putU32(out, static_cast<std::uint32_t>(state.round));
+    std::uint8_t bits = 0;
+    if (state.bribe) bits |= STATE_BRIBE;
+    if (state.active) bits |= STATE_ACTIVE;
+    *out++ = bits;
+    *out++ = static_cast<std::uint8_t>(players);
+    *out++ = static_cast<std::uint8_t>(outList);
+    return out;
+}
+
+std::uint8_t* putEntry(const SnapshotEntry& entry, std::uint8_t* out) {
+    std::uint16_t coins = static_cast<std::uint16_t>(static_cast<std::int16_t>(entry.coins));
+    std::uint8_t flags = 0;
+    if (entry.sanctioned) flags |= FLAG_SANCTIONED;
+    if (entry.arrested) flags |= FLAG_ARRESTED;
+    if (entry.canArrest) flags |= FLAG_CAN_ARREST;
+    *out++ = static_cast<std::uint8_t>(entry.role);
+    *out++ = entry.seat;
+    *out++ = static_cast<std::uint8_t>(coins);
+    *out++ = static_cast<std::uint8_t>(coins >> 8);
+    *out++ = flags;
+    *out++ = static_cast<std::uint8_t>(entry.lastAction);
+    *out++ = static_cast<std::uint8_t>(entry.name.size());
+    return std::copy(entry.name.begin(), entry.name.end(), out);
+}
+
+// The players of a game being read, parked by seat until the image claims them. The array is kept
+// per thread, so a read does not construct and destroy 256 pointers; players the image does not
+// claim are released when the read ends. Seats can repeat (add_player seats a newcomer at the size
+// of the players list, which a coup may have shrunk), so only the first player of a seat is parked
+// and the others are created again.
+struct ParkedPlayers {
+    static std::array<std::shared_ptr<Player>, 256>& seats() {
+        thread_local std::array<std::shared_ptr<Player>, 256> bySeat;
+        return bySeat;
+    }
+
+    ~ParkedPlayers() {
+        for (size_t i = 0; i < count; ++i) {
+            bySeat[used[i]].reset();
+        }
+    }
+
+    void park(std::shared_ptr<Player>& player) {
+        size_t seat = player->getIndex();
+        if (seat < bySeat.size()) {
+            if (!bySeat[seat]) {
+                used[count++] = static_cast<std::uint8_t>(seat);
+                bySeat[seat] = std::move(player);
+            }
+        }
+    }
+
+    std::array<std::shared_ptr<Player>, 256>& bySeat = seats();
+    std::array<std::uint8_t, 256> used;
+    size_t count = 0;
+};
+
+}
+
+/**
+ * @brief Appends the image of a game.
+ *
+ * @param game The game to save.
+ * @param out Receives the image.
+ * @return size_t Number of bytes appended.
+ * @throws std::runtime_error If the game has more than 255 players in a list, or a name longer than 255 bytes.
+ */
+size_t Snapshot::write(const Game& game, std::vector<std::uint8_t>& out) {
+    if (game._players_list.size() > 255 || game._out_list.size() > 255) {
+        throw std::runtime_error("Game is too large for a snapshot.");
+    }
+    // Size the image first and fill it in place
+    const NameTable& names = game._seats->names;
+    size_t bytes = HEADER_SIZE;
+    for (const auto& player : game._players_list) {
+        bytes += entrySize(*player, names);
+    }
+    for (const auto& player : game._out_list) {
+        bytes += entrySize(*player, names);
+    }
+    size_t start = out.size();
+    out.resize(start + bytes);
+
+    SnapshotState state;
+    state.turn = game._current_turn;
+    state.round = game._current_round;
+    state.bribe = game.isbribe;
+    state.active = game.isStillActive;
+    std::uint8_t* at = putHeader(out.data() + start, state, game._players_list.size(), game._out_list.size());
+    for (const auto& player : game._players_list) {
+        at = putEntry(entryOf(*player, names), at);
+    }
+    for (const auto& player : game._out_list) {
+        at = putEntry(entryOf(*player, names), at);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Appends the image of a position given field by field, as write() would for a game in
+ * that position; read() loads it.
+ *
+ * @param state Turn, round and flags.
+ * @param entries The players list followed by the out list.
+ * @param players Number of entries in the players list.
+ * @param out Number of entries in the out list, after them.
+ * @param image Receives the image.
+ * @return size_t Number of bytes appended.
+ * @throws std::runtime_error If a list has more than 255 players or a name is longer than 255 bytes.
+ */
+size_t Snapshot::build(const SnapshotState& state, const SnapshotEntry* entries, size_t players, size_t out,
+                       std::vector<std::uint8_t>& image) {
+    if (players > 255 || out > 255) {
+        throw std::runtime_error("Game is too large for a snapshot.");
+    }
+    size_t bytes = HEADER_SIZE;
+    for (size_t i = 0; i < players + out; ++i) {
+        if (entries[i].name.size() > 255) {
+            throw std::runtime_error("Player cannot be stored in a snapshot.");
+        }
+        bytes += ENTRY_SIZE + entries[i].name.size();
+    }
+    size_t start = image.size();
+    image.resize(start + bytes);
+    std::uint8_t* at = putHeader(image.data() + start, state, players, out);
+    for (size_t i = 0; i < players + out; ++i) {
+        at = putEntry(entries[i], at);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Loads an image into an existing game, reusing its Player objects where it can.
+ *
+ * The image is validated completely before the game is touched. A player of the game
+ * is reused when its seat, role and name match an entry of the image, so restoring a
+ * table into the Game it was taken from (or a copy with the same roster) only overwrites
+ * fields in place: no Player is created and the lists keep their capacity.
+ * Players without a match are created; unmatched players of the game are dropped.
+ *
+ * @param game Game to overwrite.
+ * @param data Image written by write().
+ * @param size Size of the image.
+ * @throws std::runtime_error If the image is truncated, malformed or of another version.
+ */
+void Snapshot::read(Game& game, const std::uint8_t* data, size_t size) {
+    if (size < HEADER_SIZE || data[0] != 'C' || data[1] != 'S') {
+        throw std::runtime_error("Not a game snapshot.");
+    }
+    if (data[2] != VERSION) {
+        throw std::runtime_error("Unsupported snapshot version.");
+    }
+    size_t active = data[13];
+    size_t total = active + data[14];
+
+    // Validate every entry first, so a bad image leaves the game untouched
+    size_t offset = HEADER_SIZE;
+    for (size_t i = 0; i < total; ++i) {
+        if (offset + ENTRY_SIZE > size) {
+            throw std::runtime_error("Truncated snapshot.");
+        }
+        const std::uint8_t* entry = data + offset;
+        if (entry[0] > static_cast<std::uint8_t>(Role::Baron) ||
+            entry[5] > static_cast<std::uint8_t>(Action::Ability)) {
+            throw std::runtime_error("Corrupt snapshot.");
+        }
+        offset += ENTRY_SIZE + entry[6];
+        if (offset > size) {
+            throw std::runtime_error("Truncated snapshot.");
+        }
+    }
+
+    ParkedPlayers parked;
+    for (auto& player : game._players_list) {
+        game.setSeated(*player, false);
+        parked.park(player);
+    }
+    for (auto& player : game._out_list) {
+        parked.park(player);
+    }
+    game._players_list.clear();
+    game._out_list.clear();
+
+    offset = HEADER_SIZE;
+    for (size_t i = 0; i < total; ++i) {
+        const std::uint8_t* entry = data + offset;
+        Role role = static_cast<Role>(entry[0]);
+        std::uint8_t seat = entry[1];
+        const char* name = reinterpret_cast<const char*>(entry + ENTRY_SIZE);
+        size_t nameLength = entry[6];
+        offset += ENTRY_SIZE + nameLength;
+
+        std::shared_ptr<Player> player = std::move(parked.bySeat[seat]);
+        bool reusable = player && player->role() == role &&
+                        player->getNameId() == game._seats->names.find(std::string_view(name, nameLength));
+        if (!reusable) {
+            std::string playerName(name, nameLength);
+            player = role == Role::Player ? std::make_shared<Player>(game, playerName, seat)
+                                          : PlayerFactory::createPlayer(game, roleName(role), playerName, seat);
+        }
+        std::uint8_t flags = entry[4];
+        player->setIndex(seat);
+        player->setCoins(static_cast<std::int16_t>(entry[2] | (entry[3] << 8)));
+        player->setSanctioned(flags & FLAG_SANCTIONED);
+        player->setArrest(flags & FLAG_ARRESTED);
+        player->setCanArrest(flags & FLAG_CAN_ARREST);
+        player->setAction(static_cast<Action>(entry[5]));
+        game.setSeated(*player, i < active);
+        (i < active ? game._players_list : game._out_list).push_back(std::move(player));
+    }
+
+    game._current_turn = getU32(data + 4);
+    game._current_round = getU32(data + 8);
+    game.isbribe = data[12] & STATE_BRIBE;
+    game.isStillActive = data[12] & STATE_ACTIVE;
+}
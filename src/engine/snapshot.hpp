@@ -0,0 +1,54 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "roles/actions.hpp"
+#include "roles/role_type.hpp"
+
+class Game;
+
+// Turn counters and flags of an image written by Snapshot::build
+struct SnapshotState {
+    size_t turn = 0;
+    size_t round = 1;
+    bool bribe = false;
+    bool active = true;
+};
+
+// One player of an image written by Snapshot::build; the defaults are a fresh player's
+struct SnapshotEntry {
+    Role role = Role::Player;
+    std::uint8_t seat = 0;
+    int coins = 0;
+    bool sanctioned = false;
+    bool arrested = false;
+    bool canArrest = true;
+    Action lastAction = Action::None;
+    std::string_view name;
+};
+
+// Versioned binary image of a Game: turn counters, bribe / active flags, the players list
+// and the out list with every player's role, seat, coins, flags, last action and name.
+//
+// Layout (little endian), version 1:
+//   u8 'C', u8 'S', u8 version, u8 reserved
+//   u32 current turn, u32 current round, u8 state bits, u8 players, u8 out
+//   per player (players list, then out list):
+//     u8 role, u8 seat, i16 coins, u8 flags, u8 last action, u8 name length, name
+//
+// The role generator's random state is not part of the image. build() writes an image of a
+// position given field by field, so code that sets up positions never depends on the layout.
+class Snapshot {
+public:
+    static constexpr std::uint8_t VERSION = 1;
+
+    static size_t write(const Game& game, std::vector<std::uint8_t>& out);
+    static size_t build(const SnapshotState& state, const SnapshotEntry* entries, size_t players, size_t out,
+                        std::vector<std::uint8_t>& image);
+    static void read(Game& game, const std::uint8_t* data, size_t size);
+};
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,126 @@
+#include "state_delta.hpp"
+#include "game.hpp"
+#include <stdexcept>
+
+namespace delta {
+
+/**
+ * @brief Packs the sanction / arrest / arrest-permission state of a player.
+ */
+std::uint8_t seatFlags(const Player& player) {
+    std::uint8_t flags = 0;
+    if (player.isSanctioned()) flags |= SANCTIONED;
+    if (player.isArrested()) flags |= ARRESTED;
+    if (player.getCanArrest()) flags |= CAN_ARREST;
+    return flags;
+}
+
+/**
+ * @brief Packs whether the game is running and whether a bribe is pending.
+ */
+std::uint8_t statusBits(const Game& game) {
+    std::uint8_t status = 0;
+    if (game.isGame()) status |= ACTIVE;
+    if (game.getBribe()) status |= BRIBE;
+    return status;
+}
+
+} // namespace delta
+
+namespace {
+
+void record(std::vector<std::uint8_t>& out, delta::Kind kind, std::uint8_t seat, std::uint8_t value) {
+    out.push_back(static_cast<std::uint8_t>(kind));
+    out.push_back(seat);
+    out.push_back(value);
+}
+
+}
+
+StateDiff::StateDiff() : _seats(), _turn(delta::NO_SEAT), _status(0) {}
+
+/**
+ * @brief Takes the current state of a game as the new baseline without emitting anything.
+ *
+ * Used right after the state was sent in full.
+ *
+ * @param game The observed game.
+ */
+void StateDiff::reset(const Game& game) {
+    std::vector<std::uint8_t> discard;
+    discard.reserve(delta::RECORD_SIZE * (2 * moves::MAX_TABLE + 2));
+    diff(game, discard);
+}
+
+/**
+ * @brief Appends the records that turn the baseline into the current state, then moves the baseline.
+ *
+ * Eliminations are seats that were active and are no longer in the players list (gameCoup);
+ * restores are seats that come back (restorePlayer). Coins and flags are only reported for
+ * active seats. Records are ordered: eliminations and restores first, then per-seat fields,
+ * then the turn and the game status.
+ *
+ * Does not allocate once out has room for a full table's worth of records.
+ *
+ * @param game The observed game.
+ * @param out Receives the records.
+ * @return size_t Number of records appended.
+ * @throws std::runtime_error If a seat index does not fit a table of MAX_TABLE players.
+ */
+size_t StateDiff::diff(const Game& game, std::vector<std::uint8_t>& out) {
+    size_t before = out.size();
+    size_t n = game.playerCount();
+
+    std::array<bool, moves::MAX_TABLE> seen{};
+    for (size_t i = 0; i < n; ++i) {
+        size_t seat = game.playerAt(i).getIndex();
+        if (seat >= moves::MAX_TABLE) {
+            throw std::runtime_error("Seat out of range for a state diff.");
+        }
+        seen[seat] = true;
+    }
+    for (size_t seat = 0; seat < moves::MAX_TABLE; ++seat) {
+        Seat& s = _seats[seat];
+        if (s.known && s.active && !seen[seat]) {
+            record(out, delta::Kind::Eliminated, static_cast<std::uint8_t>(seat), 0);
+            s.active = false;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const Player& player = game.playerAt(i);
+        std::uint8_t seat = static_cast<std::uint8_t>(player.getIndex());
+        Seat& s = _seats[seat];
+        std::int8_t coins = static_cast<std::int8_t>(player.getCoins());
+        std::uint8_t flags = delta::seatFlags(player);
+        if (!s.known || !s.active) {
+            record(out, delta::Kind::Restored, seat, static_cast<std::uint8_t>(player.role()));
+            record(out, delta::Kind::Coins, seat, static_cast<std::uint8_t>(coins));
+            record(out, delta::Kind::Flags, seat, flags);
+            s.known = true;
+            s.active = true;
+        } else {
+            if (s.coins != coins) {
+                record(out, delta::Kind::Coins, seat, static_cast<std::uint8_t>(coins));
+            }
+            if (s.flags != flags) {
+                record(out, delta::Kind::Flags, seat, flags);
+            }
+        }
+        s.coins = coins;
+        s.flags = flags;
+    }
+
+    std::uint8_t turn = n == 0 ? delta::NO_SEAT
+        : static_cast<std::uint8_t>(game.playerAt(static_cast<size_t>(game.currentPlayerIndex())).getIndex());
+    if (turn != _turn) {
+        record(out, delta::Kind::Turn, turn, turn);
+        _turn = turn;
+    }
+    std::uint8_t status = delta::statusBits(game);
+    if (status != _status) {
+        record(out, delta::Kind::Status, delta::NO_SEAT, status);
+        _status = status;
+    }
+    return (out.size() - before) / delta::RECORD_SIZE;
+}
@@ -0,0 +1,63 @@
+#ifndef STATE_DELTA_HPP
+#define STATE_DELTA_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "engine/move.hpp"
+
+class Game;
+class Player;
+
+// Compact changes between two observations of a Game, for spectators.
+// Every record is 3 bytes: u8 kind, u8 seat (Player::getIndex), u8 value.
+// Values are absolute, so applying a record twice is harmless and a spectator
+// may join from a full state taken at any point of a tick.
+namespace delta {
+
+constexpr size_t RECORD_SIZE = 3;
+constexpr std::uint8_t NO_SEAT = 0xFF;
+
+enum class Kind : std::uint8_t {
+    Coins = 1,       // value: coins as i8
+    Flags = 2,       // value: SeatFlags
+    Eliminated = 3,  // value: 0
+    Restored = 4,    // value: role (also sent for seats seen for the first time)
+    Turn = 5,        // value: seat of the current player
+    Status = 6       // seat NO_SEAT, value: StatusBits
+};
+
+// Same bit values as protocol::PlayerFlags and protocol::StatusBits
+enum SeatFlags : std::uint8_t { SANCTIONED = 1, ARRESTED = 2, CAN_ARREST = 4 };
+enum StatusBits : std::uint8_t { ACTIVE = 1, BRIBE = 2 };
+
+std::uint8_t seatFlags(const Player& player);
+std::uint8_t statusBits(const Game& game);
+
+} // namespace delta
+
+// Remembers what a Game looked like when it was last observed and appends
+// the records needed to bring an observer from that point to now.
+// Several moves between two calls collapse into one record per changed field.
+class StateDiff {
+public:
+    StateDiff();
+
+    void reset(const Game& game);
+    size_t diff(const Game& game, std::vector<std::uint8_t>& out);
+
+private:
+    struct Seat {
+        std::int8_t coins;
+        std::uint8_t flags;
+        bool active;
+        bool known;
+    };
+
+    std::array<Seat, moves::MAX_TABLE> _seats;
+    std::uint8_t _turn;
+    std::uint8_t _status;
+};
+
+#endif // STATE_DELTA_HPP
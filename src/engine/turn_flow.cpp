@@ -0,0 +1,254 @@
+#include "turn_flow.hpp"
+#include "game.hpp"
+#include <stdexcept>
+
+namespace {
+
+constexpr std::uint8_t NO_SEAT = 0xFF;
+
+}
+
+TurnFlow::TurnFlow(Game& game)
+    : _game(game), _state(State::Idle), _move(), _role(Role::Player),
+      _actor(nullptr), _blocker(nullptr), _responders(), _count(0), _next(0) {}
+
+/**
+ * @brief Applies the current player's move and opens its block window, if it has one.
+ *
+ * - Tax can be blocked by any Governor, who takes the coins back.
+ * - Bribe can be blocked by any Judge, who cancels the extra turn.
+ * - Coup can be blocked by any General with 5 coins, who brings the target back.
+ *   A General who is the target and can pay blocks for himself without being asked.
+ * The actor is never asked about their own move.
+ *
+ * @param move A move for the player whose turn it is.
+ * @throws std::runtime_error If a block decision is still pending, or the engine rejects the move
+ *         (the flow is then left Idle and the game unchanged).
+ */
+void TurnFlow::begin(const Move& move) {
+    if (_state == State::AwaitingResponse) {
+        throw std::runtime_error("A block decision is pending.");
+    }
+    reset();
+    Player* actor = _game.currentPlayer().get();
+    Player* target = nullptr;
+    if (move.action == Action::Coup && move.target < _game.playerCount()) {
+        target = &_game.playerAt(move.target);
+    }
+
+    moves::apply(_game, move);
+    _move = move;
+    _actor = actor;
+
+    switch (move.action) {
+        case Action::Tax:
+            openWindow(Role::Governor);
+            break;
+        case Action::Bribe:
+            openWindow(Role::Judge);
+            break;
+        case Action::Coup:
+            if (target->role() == Role::General && target->getCoins() >= 5) {
+                target->ability(*_actor);
+                _role = Role::General;
+                _blocker = target;
+                _state = State::Done;
+            } else {
+                openWindow(Role::General);
+            }
+            break;
+        default:
+            _state = State::Done;
+            break;
+    }
+}
+
+/**
+ * @brief Resumes the flow with the answer of the player being asked.
+ *
+ * A block applies the responder's ability to the actor and closes the window;
+ * otherwise the next eligible player is asked, or the turn is done.
+ *
+ * @param block true to block the action, false to allow it.
+ * @throws std::runtime_error If nobody is being asked.
+ */
+void TurnFlow::respond(bool block) {
+    if (_state != State::AwaitingResponse) {
+        throw std::runtime_error("No block decision is pending.");
+    }
+    Player* responder = _responders[_next++];
+    if (block) {
+        responder->ability(*_actor);
+        _blocker = responder;
+        _state = State::Done;
+        return;
+    }
+    advance();
+}
+
+/**
+ * @brief Forgets the previous turn; a pending window is dropped without being resolved.
+ */
+void TurnFlow::reset() {
+    _state = State::Idle;
+    _move = Move();
+    _role = Role::Player;
+    _actor = nullptr;
+    _blocker = nullptr;
+    _count = 0;
+    _next = 0;
+}
+
+/**
+ * @brief Appends the flow's position: state, move, blocking role, actor, blocker and responders by seat.
+ *
+ * Together with a Snapshot of the game this lets a suspended turn survive a restart.
+ */
+void TurnFlow::save(std::vector<std::uint8_t>& out) const {
+    auto seatOf = [](const Player* player) {
+        return player ? static_cast<std::uint8_t>(player->getIndex()) : NO_SEAT;
+    };
+    out.push_back(static_cast<std::uint8_t>(_state));
+    out.push_back(static_cast<std::uint8_t>(_move.action));
+    out.push_back(_move.target);
+    out.push_back(static_cast<std::uint8_t>(_role));
+    out.push_back(seatOf(_actor));
+    out.push_back(seatOf(_blocker));
+    out.push_back(static_cast<std::uint8_t>(_count));
+    out.push_back(static_cast<std::uint8_t>(_next));
+    for (size_t i = 0; i < _count; ++i) {
+        out.push_back(seatOf(_responders[i]));
+    }
+}
+
+/**
+ * @brief Restores a position written by save(), resolving seats against the game.
+ *
+ * @throws std::runtime_error If the data is malformed or names a seat the game does not have.
+ */
+void TurnFlow::load(const std::uint8_t* data, size_t size) {
+    if (size < 8 || size != 8u + data[6] || data[6] > _responders.size() || data[7] > data[6] ||
+        data[0] > static_cast<std::uint8_t>(State::Done)) {
+        throw std::runtime_error("Corrupt turn flow.");
+    }
+    auto playerAt = [this](std::uint8_t seat) -> Player* {
+        if (seat == NO_SEAT) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < _game.playerCount(); ++i) {
+            if (_game.playerAt(i).getIndex() == seat) {
+                return &_game.playerAt(i);
+            }
+        }
+        for (const auto& player : _game.getOutList()) {
+            if (player->getIndex() == seat) {
+                return player.get();
+            }
+        }
+        throw std::runtime_error("Turn flow names an unknown seat.");
+    };
+    try {
+        _state = static_cast<State>(data[0]);
+        _move = Move{static_cast<Action>(data[1]), data[2]};
+        _role = static_cast<Role>(data[3]);
+        _actor = playerAt(data[4]);
+        _blocker = playerAt(data[5]);
+        _count = data[6];
+        _next = data[7];
+        for (size_t i = 0; i < _count; ++i) {
+            _responders[i] = playerAt(data[8 + i]);
+        }
+        if (_state == State::AwaitingResponse && (_next >= _count || !_actor || !_responders[_next])) {
+            throw std::runtime_error("Corrupt turn flow.");
+        }
+    } catch (const std::exception&) {
+        reset();
+        throw;
+    }
+}
+
+TurnFlow::State TurnFlow::state() const {
+    return _state;
+}
+
+bool TurnFlow::waiting() const {
+    return _state == State::AwaitingResponse;
+}
+
+const Move& TurnFlow::move() const {
+    return _move;
+}
+
+/**
+ * @brief The player whose move is being resolved.
+ *
+ * @throws std::runtime_error If no turn has begun.
+ */
+Player& TurnFlow::actor() const {
+    if (!_actor) {
+        throw std::runtime_error("No turn in progress.");
+    }
+    return *_actor;
+}
+
+/**
+ * @brief The player who must answer now.
+ *
+ * @throws std::runtime_error If nobody is being asked.
+ */
+Player& TurnFlow::responder() const {
+    if (_state != State::AwaitingResponse) {
+        throw std::runtime_error("No block decision is pending.");
+    }
+    return *_responders[_next];
+}
+
+/**
+ * @brief Role that may block the current move, Role::Player if it cannot be blocked.
+ */
+Role TurnFlow::blockingRole() const {
+    return _role;
+}
+
+bool TurnFlow::blocked() const {
+    return _blocker != nullptr;
+}
+
+/**
+ * @brief The player who blocked the move, or nullptr.
+ */
+const Player* TurnFlow::blocker() const {
+    return _blocker;
+}
+
+/**
+ * @brief Lists the active players of a role, in seating order, who may block the actor.
+ */
+void TurnFlow::openWindow(Role role) {
+    _role = role;
+    _count = 0;
+    _next = 0;
+    size_t n = _game.playerCount();
+    for (size_t i = 0; i < n && _count < _responders.size(); ++i) {
+        Player& player = _game.playerAt(i);
+        if (&player != _actor && player.role() == role) {
+            _responders[_count++] = &player;
+        }
+    }
+    advance();
+}
+
+/**
+ * @brief Moves to the next responder who can still act (a General needs 5 coins), or finishes.
+ */
+void TurnFlow::advance() {
+    while (_next < _count) {
+        if (_role == Role::General && _responders[_next]->getCoins() < 5) {
+            ++_next;
+            continue;
+        }
+        _state = State::AwaitingResponse;
+        return;
+    }
+    _state = State::Done;
+}
@@ -0,0 +1,56 @@
+#ifndef TURN_FLOW_HPP
+#define TURN_FLOW_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "engine/move.hpp"
+#include "roles/role_type.hpp"
+
+class Game;
+class Player;
+
+// One turn of a table as a resumable state machine.
+// begin() applies the move and, for tax / bribe / coup, opens a block window in which the
+// players able to block (Governors / Judges / Generals with 5 coins) are asked one at a time.
+// Instead of waiting for the answer, the flow stops in AwaitingResponse and keeps everything
+// it needs to continue; respond() resumes it. A table waiting on a human therefore costs
+// a couple hundred bytes and no thread. The first block closes the window.
+class TurnFlow {
+public:
+    enum class State : std::uint8_t { Idle, AwaitingResponse, Done };
+
+    explicit TurnFlow(Game& game);
+
+    void begin(const Move& move);
+    void respond(bool block);
+    void reset();
+    void save(std::vector<std::uint8_t>& out) const;
+    void load(const std::uint8_t* data, size_t size);
+
+    State state() const;
+    bool waiting() const;
+    const Move& move() const;
+    Player& actor() const;
+    Player& responder() const;
+    Role blockingRole() const;
+    bool blocked() const;
+    const Player* blocker() const;
+
+private:
+    void openWindow(Role role);
+    void advance();
+
+    Game& _game;
+    State _state;
+    Move _move;
+    Role _role;
+    Player* _actor;    // players live as long as their Game, eliminated ones included
+    Player* _blocker;
+    std::array<Player*, moves::MAX_TABLE> _responders;
+    size_t _count;
+    size_t _next;
+};
+
+#endif // TURN_FLOW_HPP
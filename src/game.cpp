@@ -3,14 +3,186 @@
 #include <random>
 #include <chrono>
 #include "roles/player_factory.hpp"
+#include "roles/baron.hpp"
+#include "roles/general.hpp"
+#include "roles/governor.hpp"
+#include "roles/judge.hpp"
+#include "roles/merchant.hpp"
+#include "roles/spy.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
+#include <new>
+#include <type_traits>
+
+namespace {
+
+// Room for one player of any role
+using SeatStorage = std::aligned_union_t<0, Player, Spy, Merchant, Judge, Governor, General, Baron>;
+
+// Allocator for allocate_shared that adds `extra` bytes after the control block and reports
+// where they start, so a roster's players share one allocation with their reference count.
+template <class T>
+struct TrailingAllocator {
+    using value_type = T;
+
+    TrailingAllocator(size_t extra, unsigned char** trailing) : extra(extra), trailing(trailing) {}
+    template <class U>
+    TrailingAllocator(const TrailingAllocator<U>& other) : extra(other.extra), trailing(other.trailing) {}
+
+    T* allocate(size_t n) {
+        size_t head = (n * sizeof(T) + alignof(SeatStorage) - 1) / alignof(SeatStorage) * alignof(SeatStorage);
+        unsigned char* block = static_cast<unsigned char*>(::operator new(head + extra));
+        *trailing = block + head;
+        return reinterpret_cast<T*>(block);
+    }
+    void deallocate(T* block, size_t) { ::operator delete(block); }
+
+    template <class U>
+    bool operator==(const TrailingAllocator<U>& other) const { return trailing == other.trailing; }
+    template <class U>
+    bool operator!=(const TrailingAllocator<U>& other) const { return !(*this == other); }
+
+    size_t extra;
+    unsigned char** trailing;
+};
+
+// Owner of a roster's players and their seat table, all in the trailing bytes: `seats` storage,
+// the constructed players' pointers, the table and the arena its columns are carved from. The
+// players are shared_ptrs aliasing the block, which destroys them, then the table, when the last
+// reference is released.
+struct RosterBlock {
+    RosterBlock(unsigned char* const* trailing, size_t size)
+        : seats(reinterpret_cast<SeatStorage*>(*trailing)),
+          players(reinterpret_cast<Player**>(*trailing + size * sizeof(SeatStorage))),
+          count(0),
+          table(new (*trailing + tableOffset(size))
+                    SeatTable(*trailing + tableOffset(size) + sizeof(SeatTable), SeatTable::arenaBytes(size), size)) {}
+    ~RosterBlock() {
+        while (count > 0) {
+            players[--count]->~Player();
+        }
+        table->~SeatTable();
+    }
+    RosterBlock(const RosterBlock&) = delete;
+    RosterBlock& operator=(const RosterBlock&) = delete;
+
+    static size_t tableOffset(size_t size) {
+        size_t end = size * (sizeof(SeatStorage) + sizeof(Player*));
+        return (end + alignof(SeatTable) - 1) / alignof(SeatTable) * alignof(SeatTable);
+    }
+    static size_t trailingBytes(size_t size) {
+        return tableOffset(size) + sizeof(SeatTable) + SeatTable::arenaBytes(size);
+    }
+
+    SeatStorage* seats;
+    Player** players;
+    size_t count;
+    SeatTable* table;
+};
+
+// A block for `size` players, in one allocation with its reference count
+std::shared_ptr<RosterBlock> makeRosterBlock(size_t size) {
+    unsigned char* trailing = nullptr;
+    TrailingAllocator<RosterBlock> allocator(RosterBlock::trailingBytes(size), &trailing);
+    return std::allocate_shared<RosterBlock>(allocator, &trailing, size);
+}
+
+// The block's table as seen by the players inside it: without a reference, or the block would
+// keep itself alive
+std::shared_ptr<SeatTable> unownedTable(const RosterBlock& block) {
+    return std::shared_ptr<SeatTable>(std::shared_ptr<SeatTable>(), block.table);
+}
+
+// Constructs a player of the given role in a seat of a RosterBlock
+Player* constructSeat(void* seat, Game& game, Role role, const std::string& name, size_t index) {
+    switch (role) {
+        case Role::Spy: return new (seat) Spy(game, name, index);
+        case Role::Merchant: return new (seat) Merchant(game, name, index);
+        case Role::Judge: return new (seat) Judge(game, name, index);
+        case Role::Governor: return new (seat) Governor(game, name, index);
+        case Role::General: return new (seat) General(game, name, index);
+        case Role::Baron: return new (seat) Baron(game, name, index);
+        default: return new (seat) Player(game, name, index);
+    }
+}
+
+}
 
 /**
  * @brief Default constructor for the Game class.
  *
  * Initializes the game with the current turn set to 0
  * and the current round set to 1.
+ * The role generator is seeded with the current time.
+ */
+Game::Game()
+    : Game(static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count())) {}
+
+/**
+ * @brief Constructs a game whose role generator uses the given seed.
+ *
+ * Two games built with the same seed and the same add_player calls get the same roles,
+ * which lets a remote client mirror a table hosted by the server.
+ *
+ * @param seed Seed for the role generator.
+ */
+Game::Game(unsigned int seed) : Game(seed, std::make_shared<SeatTable>()) {}
+
+/**
+ * @brief Constructs an empty game on a given seat table; the roster constructors pass none and
+ * build theirs with the players.
+ *
+ * @param seed Seed for the role generator.
+ * @param seats The seat table.
+ */
+Game::Game(unsigned int seed, std::shared_ptr<SeatTable> seats)
+    : _current_turn(0), _current_round(1), isbribe(false), isStillActive(true), _rng(seed),
+      _seats(std::move(seats)) {}
+
+/**
+ * @brief Constructs a full table with roles drawn from the given seed.
+ *
+ * The roles are the ones `names.size()` add_player calls would draw on Game(seed),
+ * so both ways of building a table give the same game.
+ *
+ * @param names Player names in seat order.
+ * @param seed Seed for the role generator.
+ * @throws std::runtime_error If a name is duplicated.
+ */
+Game::Game(const std::vector<std::string>& names, unsigned int seed) : Game(seed, nullptr) {
+    seatRoster(names, nullptr);
+}
+
+/**
+ * @brief Constructs a full table with the given roles.
+ *
+ * @param names Player names in seat order.
+ * @param roles Role of each seat (Role::Player seats a player without a role).
+ * @param seed Seed for the role generator, used by later add_player calls.
+ * @throws std::runtime_error If a name is duplicated, a role is unknown or the sizes differ.
+ */
+Game::Game(const std::vector<std::string>& names, const std::vector<Role>& roles, unsigned int seed)
+    : Game(seed, nullptr) {
+    seatRoster(names, &roles);
+}
+
+/**
+ * @brief Builds a roster table on the heap, with roles drawn from the seed.
+ *
+ * @see Game(const std::vector<std::string>&, unsigned int)
  */
-Game::Game() : _current_turn(0), _current_round(1), isbribe(false),isStillActive(true) {}
+std::unique_ptr<Game> Game::fromRoster(const std::vector<std::string>& names, unsigned int seed) {
+    return std::make_unique<Game>(names, seed);
+}
+
+/**
+ * @brief Builds a roster table on the heap with the given roles.
+ *
+ * @see Game(const std::vector<std::string>&, const std::vector<Role>&, unsigned int)
+ */
+std::unique_ptr<Game> Game::fromRoster(const std::vector<std::string>& names, const std::vector<Role>& roles) {
+    return std::make_unique<Game>(names, roles);
+}
 
 /**
  * @brief Destructor for the Game class.
@@ -28,7 +200,8 @@ Game::~Game() {
  * @brief Copy constructor for the Game class.
  *
  * Performs a deep copy of the game state including current turn,
- * round, bribery status, and player lists.
+ * round, bribery status, and player lists. The copy gets its own
+ * seat table and its own players, so playing one game never changes the other.
  *
  * @param other The Game object to copy from.
  */
@@ -36,17 +209,18 @@ Game::Game(const Game& other)
     : _current_turn(other._current_turn),
       _current_round(other._current_round),
       isbribe(other.isbribe),
-      isStillActive(other.isStillActive)
+      isStillActive(other.isStillActive),
+      _rng(other._rng)
 {
-    _players_list = other._players_list; // shared_ptr allows safe copy
-    _out_list = other._out_list;
+    copyPlayers(other);
 }
 
 /**
  * @brief Copy assignment operator for the Game class.
  *
  * Safely assigns one Game object to another, ensuring no self-assignment,
- * and copies all game state data members.
+ * and copies all game state data members. The old players leave this game's
+ * seat table, which is replaced by a copy of the other game's.
  *
  * @param other The Game object to assign from.
  * @return Reference to this Game object.
@@ -56,30 +230,32 @@ Game& Game::operator=(const Game& other) {
         _current_turn = other._current_turn;
         _current_round = other._current_round;
         isbribe = other.isbribe;
-        _players_list = other._players_list;
-        _out_list = other._out_list;
+        isStillActive = other.isStillActive;
+        _rng = other._rng;
+        for (const auto& player : _players_list) {
+            setSeated(*player, false);
+        }
+        _players_list.clear();
+        _out_list.clear();
+        copyPlayers(other);
     }
     return *this;
 }
 
 /**
  * @brief Adds a player to the game.
- * check for duplicated names
+ * check for duplicated names with a lookup in the name table, so adding n players is O(n)
  *
  * @param player A shared pointer to the Player to add.
  */
 void Game::add_player(const std::string& name) {
-    for (const std::string& _name : players()){
-        if(_name == name){
-            throw std::runtime_error("Cant use duplicated names");
-        }
+    COUP_ALLOC_SCOPE("Game::add_player");
+    if(_seats->seated(_seats->names.find(name))){
+        throw std::runtime_error("Cant use duplicated names");
     }
     std::string role = roleGenerator();
-    std::shared_ptr<Player> player;
-    if(players().empty())
-        player = PlayerFactory::createPlayer(*this,role,name,0);
-    else
-        player = PlayerFactory::createPlayer(*this,role,name,players().size());
+    std::shared_ptr<Player> player = PlayerFactory::createPlayer(*this,role,name,_players_list.size());
+    setSeated(*player, true);
     _players_list.push_back(player);
 }
 
@@ -94,6 +270,7 @@ void Game::add_player(const std::string& name) {
  * @throws std::runtime_error if no players exist.
  */
 std::string Game::turn() const {
+    COUP_ALLOC_SCOPE("Game::turn");
     if (_players_list.empty()) {
         throw std::runtime_error("No players in the game");
     }
@@ -108,6 +285,8 @@ std::string Game::turn() const {
  * If a bribe is active, just clears the bribe flag without advancing turn.
  */
 void Game::next_turn(){
+    COUP_TRACE_SCOPE("Game::next_turn");
+    COUP_ALLOC_SCOPE("Game::next_turn");
     manageAfterTrun();
     if(!isbribe){
         _current_turn++;
@@ -116,12 +295,12 @@ void Game::next_turn(){
             resetArrest();
         }
         if(_players_list.size() > 1){
-            std::shared_ptr<Player> current = currentPlayer();
-            if(current->get_type() == "Merchant"){
-                current->ability(); 
+            Player& current = *_players_list[currentPlayerIndex()];
+            if(_seats->role[current.getSlot()] == Role::Merchant){
+                current.ability(); 
             }
             if(!canAction()){
-                current->setSanctioned(false);
+                current.setSanctioned(false);
                 next_turn();
             }
         }
@@ -145,14 +324,15 @@ void Game::bribe(){
 /**
  * @brief Resets the arrest status of all players.
  * 
- * Sets arrest flag to false for every player in the players list.
+ * Clears the arrest flag of every seated slot of the seat table; players out of the game keep theirs.
  */
 void Game::resetArrest(){
-    for (size_t i = 0; i < _players_list.size(); i++)
+    std::uint8_t* arrested = _seats->arrested.data();
+    const std::uint8_t* seated = _seats->active.data();
+    for (size_t slot = 0; slot < _seats->size(); slot++)
     {
-        _players_list[i]->setArrest(false);
+        arrested[slot] &= seated[slot] ^ 1;
     }
-    
 }
 
 /**
@@ -181,6 +361,7 @@ int Game::currentPlayerIndex() const{
  * @return std::vector<std::string> Vector containing names of active players.
  */
 std::vector<std::string> Game::players() const {
+    COUP_ALLOC_SCOPE("Game::players");
     std::vector<std::string> active_players;
     for (const auto& p : _players_list) {
         active_players.push_back(p->getName());
@@ -193,21 +374,25 @@ std::vector<std::string> Game::players() const {
  * 
  * A player can act if they are not sanctioned or have more than 2 coins.
  * If sanctioned, checks if there is at least one other player who is not arrested.
- * As arrest costs 0 coins.
+ * As arrest costs 0 coins. The check is a scan of the seat table's columns.
  * 
  * @return true if the current player can act, false otherwise.
  */
 bool Game::canAction(){
-    std::shared_ptr<Player> player = currentPlayer();
-    if(!player->isSanctioned() || player->getCoins() > 2){
+    COUP_TRACE_SCOPE("Game::canAction");
+    COUP_ALLOC_SCOPE("Game::canAction");
+    size_t current = _players_list[currentPlayerIndex()]->getSlot();
+    if(!_seats->sanctioned[current] || _seats->coins[current] > 2){
         return true;
     }
-    for (const auto& p : _players_list) {
-        if (p->getName() != player->getName() && !p->isArrested()) {
-            return true;
-        }
+    const std::uint8_t* arrested = _seats->arrested.data();
+    const std::uint8_t* seated = _seats->active.data();
+    size_t free = 0;
+    for (size_t slot = 0; slot < _seats->size(); slot++) {
+        free += seated[slot] & (arrested[slot] ^ 1);
     }
-    return false;
+    // The current player is seated too and counted unless arrested
+    return free > static_cast<size_t>(arrested[current] ^ 1);
 }
 
 
@@ -217,6 +402,7 @@ bool Game::canAction(){
  * @return std::vector<std::shared_ptr<Player>> Vector containing shared pointers to all players.
  */
 std::vector<std::shared_ptr<Player>> Game::getPlayers(){
+    COUP_ALLOC_SCOPE("Game::getPlayers");
     return _players_list;
 }
 
@@ -224,35 +410,57 @@ std::vector<std::shared_ptr<Player>> Game::getPlayers(){
  * @brief Randomly generates and returns a role name.
  * 
  * The role is chosen randomly from a fixed set of role names.
- * Uses a Mersenne Twister random number generator seeded with current time.
+ * Uses the game's own Mersenne Twister, so tables never share generator state.
  * 
  * @return std::string A randomly selected role name.
  */
 std::string Game::roleGenerator() const {
+    COUP_ALLOC_SCOPE("Game::roleGenerator");
     static const std::vector<std::string> roles = {
         "Spy", "Merchant", "Judge", "Governor", "General", "Baron"
     };
 
-    static std::mt19937 rng(
-        static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count())
-    );
+    return roles[static_cast<size_t>(rollRole()) - 1];
+}
 
-    std::uniform_int_distribution<size_t> dist(0, roles.size() - 1);
-    return roles[dist(rng)];
+/**
+ * @brief Draws a role uniformly from the six roles with the game's generator.
+ * 
+ * @return Role One of Role::Spy .. Role::Baron.
+ */
+Role Game::rollRole() const {
+    std::uniform_int_distribution<size_t> dist(0, 5);
+    return static_cast<Role>(dist(_rng) + 1);
 }
 
 
 /**
  * @brief Removes a player from active players and adds them to the out list by name.
  * 
- * Iterates through the active players to find a player with the given name.
- * If found, adds the player to the out list and removes them from active players.
+ * Looks the name up in the name table and removes the player holding that id.
  * 
  * @param name The name of the player to remove from the game.
  */
 void Game::gameCoup(const std::string& name){
+    std::uint32_t id = _seats->names.find(name);
+    if(id != NameTable::NONE){
+        gameCoup(id);
+    }
+}
+
+/**
+ * @brief Removes a player from active players and adds them to the out list by name id.
+ * 
+ * Iterates through the active players to find the player whose name has the given id.
+ * If found, adds the player to the out list and removes them from active players.
+ * 
+ * @param nameId The name id (Player::getNameId) of the player to remove from the game.
+ */
+void Game::gameCoup(std::uint32_t nameId){
+    COUP_ALLOC_SCOPE("Game::gameCoup");
     for (auto it = _players_list.begin(); it != _players_list.end(); ++it) {
-        if ((*it)->getName() == name) {
+        if (_seats->nameId[(*it)->getSlot()] == nameId) {
+            setSeated(**it, false);
             _out_list.push_back(*it);       
             _players_list.erase(it);    
             isGameDone();   
@@ -271,9 +479,11 @@ void Game::gameCoup(const std::string& name){
  * @return std::vector<std::shared_ptr<Player>> Vector of players excluding the given name.
  */
 std::vector<std::shared_ptr<Player>> Game::playersForSelection(const std::string& name) {
+    COUP_ALLOC_SCOPE("Game::playersForSelection");
     std::vector<std::shared_ptr<Player>> result;
+    std::uint32_t id = _seats->names.find(name);
     for (const auto& player : _players_list) {
-        if (player->getName() != name) {
+        if (_seats->nameId[player->getSlot()] != id) {
             result.push_back(player);
         }
     }
@@ -290,6 +500,7 @@ std::vector<std::shared_ptr<Player>> Game::playersForSelection(const std::string
  * @throws std::runtime_error if the game is still ongoing.
  */
 std::string Game::winner() const {
+    COUP_ALLOC_SCOPE("Game::winner");
     if(_players_list.size() == 1)
         return _players_list[0]->getName();
         
@@ -304,13 +515,11 @@ std::string Game::winner() const {
  * - If the player cannot arrest, permission is restored.
  */
 void Game::manageAfterTrun(){
-    std::shared_ptr<Player> current = currentPlayer();
-    if(current->isSanctioned()){
-        current->setSanctioned(false);
-    }
-    if(!current->getCanArrest()){
-        current->setCanArrest(true);
-    }
+    COUP_TRACE_SCOPE("Game::manageAfterTrun");
+    COUP_ALLOC_SCOPE("Game::manageAfterTrun");
+    size_t current = _players_list[currentPlayerIndex()]->getSlot();
+    _seats->sanctioned[current] = 0;
+    _seats->canArrest[current] = 1;
 }
 
 /**
@@ -320,6 +529,7 @@ void Game::manageAfterTrun(){
  * @throws std::runtime_error If no players exist in the game.
  */
 std::shared_ptr<Player> Game::currentPlayer() const{
+    COUP_ALLOC_SCOPE("Game::currentPlayer");
     if (_players_list.empty()) {
         throw std::runtime_error("No players available to retrieve current player.");
     }
@@ -343,7 +553,7 @@ void Game::isGameDone(){
  * 
  * @return true if the game is ongoing, false otherwise.
  */
-bool Game::isGame(){
+bool Game::isGame() const{
     return isStillActive;
 }
 
@@ -352,16 +562,19 @@ bool Game::isGame(){
  * 
  * Removes the last player from the out list and inserts them back to their original position
  * in the players list if possible; otherwise, adds to the end.
+ * The game is active again if more than one player is left afterwards.
  * 
  * @throws std::runtime_error If the out list is empty (no players to restore).
  */
 void Game::restorePlayer() {
+    COUP_ALLOC_SCOPE("Game::restorePlayer");
     if (_out_list.empty()) {
         throw std::runtime_error("No players to restore.");
     }
 
     std::shared_ptr<Player> restored = _out_list.back();
     _out_list.pop_back();
+    setSeated(*restored, true);
 
     size_t idx = restored->getIndex();  // You need a getIndex() function in Player
 
@@ -376,6 +589,8 @@ void Game::restorePlayer() {
         // If the index is too large, push to the end
         _players_list.push_back(restored);
     }
+    // A coup that ended the game may be undone
+    isStillActive = _players_list.size() > 1;
 }
 
 /**
@@ -402,6 +617,7 @@ int Game::getTurn() const{
  * @return std::vector<std::shared_ptr<Player>> Vector containing pointers to players out of the game.
  */
 std::vector<std::shared_ptr<Player>> Game::getOutList(){
+    COUP_ALLOC_SCOPE("Game::getOutList");
     return _out_list;
 }
 
@@ -415,7 +631,119 @@ bool Game::getBribe() const{
 }
 
 std::shared_ptr<Player> Game::lastPlayer(){
+    COUP_ALLOC_SCOPE("Game::lastPlayer");
     return _players_list[(_current_turn - 1) % _players_list.size()];
 }
 
+/**
+ * @brief Number of active players, without copying the players list.
+ * 
+ * @return size_t Count of players still in the game.
+ */
+size_t Game::playerCount() const{
+    return _players_list.size();
+}
+
+/**
+ * @brief Access an active player by position without copying the players list.
+ * 
+ * @param index Position in the active players list (same order as getPlayers()).
+ * @return Player& The player at that position.
+ * @throws std::runtime_error If the index is out of range.
+ */
+Player& Game::playerAt(size_t index) const{
+    if (index >= _players_list.size()) {
+        throw std::runtime_error("Player index out of range.");
+    }
+    return *_players_list[index];
+}
+
+/**
+ * @brief The columns holding every player's coins, flags, last action and role.
+ * 
+ * @return std::shared_ptr<SeatTable> The table, shared by the game's players.
+ */
+std::shared_ptr<SeatTable> Game::seatTable() const{
+    return _seats;
+}
+
+/**
+ * @brief Marks a player's slot as in or out of the players list, for the table scans.
+ * 
+ * @param player A player of this game.
+ * @param seated true when the player joins the players list, false when it leaves.
+ */
+void Game::setSeated(const Player& player, bool seated){
+    _seats->setActive(player.getSlot(), seated);
+    _seats->role[player.getSlot()] = player.role();
+}
+
+/**
+ * @brief Seats a whole roster: validates it, then builds every player in one allocation.
+ * 
+ * The players live in a single block together with their shared reference count and the
+ * game's seat table, whose columns and name table are carved out of the same block. They are
+ * destroyed when the last of them is released.
+ * 
+ * @param names Player names in seat order.
+ * @param roles Role of each seat, or nullptr to draw them from the role generator in seat order.
+ * @throws std::runtime_error If a name is duplicated, a role is unknown or the sizes differ.
+ */
+void Game::seatRoster(const std::vector<std::string>& names, const std::vector<Role>* roles){
+    COUP_ALLOC_SCOPE("Game::seatRoster");
+    if(roles != nullptr && names.size() != roles->size()){
+        throw std::runtime_error("A roster needs one role per name.");
+    }
+    std::shared_ptr<RosterBlock> block = makeRosterBlock(names.size());
+    _seats = unownedTable(*block);
+    for (size_t i = 0; i < names.size(); i++) {
+        // The table is fresh, so ids come in order unless a name repeats
+        if(_seats->names.intern(names[i]) != i){
+            throw std::runtime_error("Cant use duplicated names");
+        }
+        if(roles != nullptr && (*roles)[i] > Role::Baron){
+            throw std::runtime_error("Unknown role in roster.");
+        }
+    }
+
+    _players_list.reserve(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        Role role = roles != nullptr ? (*roles)[i] : rollRole();
+        Player* player = constructSeat(&block->seats[i], *this, role, names[i], i);
+        block->players[block->count++] = player;
+        setSeated(*player, true);
+        _players_list.emplace_back(block, player);
+    }
+    _seats = std::shared_ptr<SeatTable>(block, block->table);
+}
 
+/**
+ * @brief Replaces this game's empty lists and seat table with copies of another game's.
+ *
+ * Each copy has the role, name, seat, coins, flags and last action of its original and is
+ * built in one block with the others and the table, like a roster; the originals are not touched.
+ *
+ * @param other The game to copy from.
+ */
+void Game::copyPlayers(const Game& other){
+    COUP_ALLOC_SCOPE("Game::copyPlayers");
+    size_t total = other._players_list.size() + other._out_list.size();
+    std::shared_ptr<RosterBlock> block = makeRosterBlock(total);
+    _seats = unownedTable(*block);
+    _players_list.reserve(other._players_list.size());
+    _out_list.reserve(other._out_list.size());
+    for (size_t i = 0; i < total; i++) {
+        bool seated = i < other._players_list.size();
+        const Player& original = seated ? *other._players_list[i] : *other._out_list[i - other._players_list.size()];
+        Player* player = constructSeat(&block->seats[i], *this, original.role(), original.getName(), original.getIndex());
+        block->players[block->count++] = player;
+        player->setCoins(original.getCoins());
+        player->setSanctioned(original.isSanctioned());
+        player->setArrest(original.isArrested());
+        player->setCanArrest(original.getCanArrest());
+        player->setAction(original.getLastAction());
+        setSeated(*player, seated);
+        (seated ? _players_list : _out_list).emplace_back(block, player);
+    }
+    _seats = std::shared_ptr<SeatTable>(block, block->table);
+}
@@ -6,15 +6,25 @@
 #include <memory>
 #include <stdexcept>
 #include <unordered_map>
+#include <random>
 #include "roles/player.hpp"
+#include "engine/seat_table.hpp"
 
 class Game {
 public:
     Game();
+    explicit Game(unsigned int seed); // Seeds the role generator for reproducible tables
+    // Whole table at once, every seat in one allocation; same roles as add_player with this seed
+    Game(const std::vector<std::string>& names, unsigned int seed);
+    Game(const std::vector<std::string>& names, const std::vector<Role>& roles, unsigned int seed = 0);
     ~Game(); // Destructor
-    Game(const Game& other); // Copy constructor
+    Game(const Game& other); // Copy constructor, players and seat table included
     Game& operator=(const Game& other); // Copy assignment
 
+    // Heap-allocated roster tables; a Game cannot be returned by value, its players refer to it
+    static std::unique_ptr<Game> fromRoster(const std::vector<std::string>& names, unsigned int seed);
+    static std::unique_ptr<Game> fromRoster(const std::vector<std::string>& names, const std::vector<Role>& roles);
+
     void add_player(const std::string& name);
 
     std::string turn() const;       
@@ -29,25 +39,39 @@ public:
     void bribe();    
     std::vector<std::shared_ptr<Player>> playersForSelection(const std::string& name);
     void gameCoup(const std::string& name);
+    void gameCoup(std::uint32_t nameId);
     bool canAction();
     void manageAfterTrun();
     void manageNextTurn();
     void isGameDone();
-    bool isGame();
+    bool isGame() const;
     void restorePlayer();
     void setBribe(bool bribe);
     int getTurn() const;
     std::vector<std::shared_ptr<Player>> getOutList();
     bool getBribe() const;
     std::shared_ptr<Player> lastPlayer();
+    size_t playerCount() const;
+    Player& playerAt(size_t index) const;
+    std::shared_ptr<SeatTable> seatTable() const;
 
 private:
+    friend class Snapshot; // reads and restores the private state below
+
+    Game(unsigned int seed, std::shared_ptr<SeatTable> seats);
+    void setSeated(const Player& player, bool seated);
+    Role rollRole() const;
+    void seatRoster(const std::vector<std::string>& names, const std::vector<Role>* roles);
+    void copyPlayers(const Game& other);
+
     std::vector<std::shared_ptr<Player>> _players_list;  
     std::vector<std::shared_ptr<Player>> _out_list;
     size_t _current_turn;     
     size_t _current_round;
     bool isbribe;
     bool isStillActive;
+    mutable std::mt19937 _rng;
+    std::shared_ptr<SeatTable> _seats; // copies get their own, with their own players
 };
 
 #endif
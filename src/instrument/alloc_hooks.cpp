@@ -0,0 +1,22 @@
+// Global operator new / delete that report every allocation to instrument::noteAllocation.
+// Not part of the engine library: link this file only into binaries that want allocation
+// counts (the benchmarks), so the game, the server and the tests keep the default allocator.
+#include "alloc_scope.hpp"
+#include <cstdlib>
+#include <new>
+
+void* operator new(size_t size) {
+    instrument::noteAllocation(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
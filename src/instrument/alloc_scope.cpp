@@ -0,0 +1,127 @@
+#include "alloc_scope.hpp"
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+namespace instrument {
+
+namespace {
+
+std::atomic<ScopeSite*> sites{nullptr};
+std::atomic<std::uint64_t> allocationCount{0};
+thread_local AllocScope* innermost = nullptr;
+thread_local bool scopesPaused = false;
+
+}
+
+/**
+ * @brief Registers a scope site. Sites are never unregistered.
+ *
+ * @param name Printed in reports; must outlive the program (a string literal).
+ */
+ScopeSite::ScopeSite(const char* name)
+    : _name(name), _calls(0), _self(0), _self_bytes(0), _total(0), _next(nullptr) {
+    ScopeSite* head = sites.load(std::memory_order_relaxed);
+    do {
+        _next = head;
+    } while (!sites.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+AllocScope::AllocScope(ScopeSite& site) : _site(site), _parent(innermost) {
+    if (!scopesPaused) {
+        _site._calls.fetch_add(1, std::memory_order_relaxed);
+    }
+    innermost = this;
+}
+
+AllocScope::~AllocScope() {
+    innermost = _parent;
+}
+
+void pauseScopes(bool paused) {
+    scopesPaused = paused;
+}
+
+/**
+ * @brief Charges one allocation to the scopes open on the calling thread.
+ *
+ * @param size Requested size in bytes.
+ */
+void noteAllocation(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    AllocScope* scope = innermost;
+    if (!scope || scopesPaused) {
+        return;
+    }
+    scope->_site._self.fetch_add(1, std::memory_order_relaxed);
+    scope->_site._self_bytes.fetch_add(size, std::memory_order_relaxed);
+    // A recursive entry point (next_turn) appears once per level; count its total once
+    for (AllocScope* s = scope; s; s = s->_parent) {
+        bool seen = false;
+        for (AllocScope* inner = scope; inner != s; inner = inner->_parent) {
+            if (&inner->_site == &s->_site) {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen) {
+            s->_site._total.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::uint64_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Visits the counters of every registered site, in no particular order.
+ */
+void forEachScope(const std::function<void(const ScopeStats&)>& visit) {
+    for (ScopeSite* site = sites.load(std::memory_order_acquire); site; site = site->_next) {
+        visit(ScopeStats{site->_name, site->_calls.load(std::memory_order_relaxed),
+                         site->_self.load(std::memory_order_relaxed),
+                         site->_self_bytes.load(std::memory_order_relaxed),
+                         site->_total.load(std::memory_order_relaxed)});
+    }
+}
+
+/**
+ * @brief Zeroes every site's counters (not the process-wide allocation count).
+ */
+void resetAllocationCounters() {
+    for (ScopeSite* site = sites.load(std::memory_order_acquire); site; site = site->_next) {
+        site->_calls.store(0, std::memory_order_relaxed);
+        site->_self.store(0, std::memory_order_relaxed);
+        site->_self_bytes.store(0, std::memory_order_relaxed);
+        site->_total.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Prints the sites that were entered, most allocations (self) first.
+ *
+ * @param out Stream to print to.
+ */
+void printAllocationReport(std::FILE* out) {
+    std::vector<ScopeStats> stats;
+    forEachScope([&](const ScopeStats& s) {
+        if (s.calls > 0) {
+            stats.push_back(s);
+        }
+    });
+    std::sort(stats.begin(), stats.end(), [](const ScopeStats& a, const ScopeStats& b) {
+        return a.self != b.self ? a.self > b.self : std::string_view(a.name) < std::string_view(b.name);
+    });
+    std::fprintf(out, "%-32s %12s %12s %10s %12s %10s\n", "scope", "calls", "self", "self/call", "self bytes",
+                 "total/call");
+    for (const ScopeStats& s : stats) {
+        double calls = static_cast<double>(s.calls);
+        std::fprintf(out, "%-32s %12llu %12llu %10.3f %12llu %10.3f\n", s.name,
+                     static_cast<unsigned long long>(s.calls), static_cast<unsigned long long>(s.self),
+                     static_cast<double>(s.self) / calls, static_cast<unsigned long long>(s.selfBytes),
+                     static_cast<double>(s.total) / calls);
+    }
+}
+
+} // namespace instrument
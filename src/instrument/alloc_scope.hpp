@@ -0,0 +1,104 @@
+#ifndef ALLOC_SCOPE_HPP
+#define ALLOC_SCOPE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+
+// Opt-in allocation accounting.
+//
+// COUP_ALLOC_SCOPE("Game::add_player") at the top of a function marks it as a scope. While a
+// scope is open on a thread, every operator new made by that thread is charged to it: "self"
+// for the innermost open scope, "total" for it and every enclosing one. The macro compiles to
+// nothing unless COUP_ALLOC_TRACKING is defined, so normal builds pay nothing.
+//
+// Allocations are only seen in binaries that link src/instrument/alloc_hooks.cpp, which
+// replaces the global operator new (the benchmarks do; `make bench ALLOC_TRACKING=1`).
+namespace instrument {
+
+struct ScopeStats;
+
+// One COUP_ALLOC_SCOPE line; lives for the whole program and is shared by all threads
+class ScopeSite {
+public:
+    explicit ScopeSite(const char* name);
+    ScopeSite(const ScopeSite&) = delete;
+    ScopeSite& operator=(const ScopeSite&) = delete;
+
+    const char* name() const { return _name; }
+
+private:
+    friend class AllocScope;
+    friend void noteAllocation(size_t size);
+    friend void forEachScope(const std::function<void(const ScopeStats&)>& visit);
+    friend void resetAllocationCounters();
+
+    const char* _name;
+    std::atomic<std::uint64_t> _calls;
+    std::atomic<std::uint64_t> _self;
+    std::atomic<std::uint64_t> _self_bytes;
+    std::atomic<std::uint64_t> _total;
+    ScopeSite* _next; // registry of every site, newest first
+};
+
+struct ScopeStats {
+    const char* name;
+    std::uint64_t calls;
+    std::uint64_t self;       // allocations made while this was the innermost scope
+    std::uint64_t selfBytes;
+    std::uint64_t total;      // allocations made while this scope was open at all
+};
+
+// Opens a scope for the current thread until destroyed
+class AllocScope {
+public:
+    explicit AllocScope(ScopeSite& site);
+    ~AllocScope();
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    friend void noteAllocation(size_t size);
+
+    ScopeSite& _site;
+    AllocScope* _parent;
+};
+
+// Called by the operator new hook
+void noteAllocation(size_t size);
+
+// Every operator new of the process so far; 0 without the hook
+std::uint64_t allocations();
+
+// While paused, the calling thread opens no scopes and charges nothing to them (a benchmark's
+// untimed setup, for instance); allocations() still counts
+void pauseScopes(bool paused);
+
+void forEachScope(const std::function<void(const ScopeStats&)>& visit);
+void resetAllocationCounters();
+void printAllocationReport(std::FILE* out);
+
+constexpr bool trackingEnabled() {
+#ifdef COUP_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace instrument
+
+#define COUP_ALLOC_CONCAT_(a, b) a##b
+#define COUP_ALLOC_CONCAT(a, b) COUP_ALLOC_CONCAT_(a, b)
+
+#ifdef COUP_ALLOC_TRACKING
+#define COUP_ALLOC_SCOPE(name)                                                          \
+    static instrument::ScopeSite COUP_ALLOC_CONCAT(coup_alloc_site_, __LINE__)(name); \
+    instrument::AllocScope COUP_ALLOC_CONCAT(coup_alloc_scope_, __LINE__)(COUP_ALLOC_CONCAT(coup_alloc_site_, __LINE__))
+#else
+#define COUP_ALLOC_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif // ALLOC_SCOPE_HPP
@@ -0,0 +1,281 @@
+#include "metrics.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace metrics {
+
+namespace {
+
+// Adds to a counter that only the calling thread writes: no locked instruction needed
+inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+struct Shard {
+    std::array<std::atomic<std::uint64_t>, ACTIONS> applied{};
+    std::array<std::array<std::atomic<std::uint64_t>, REASONS>, ACTIONS> rejected{};
+    std::array<Histogram, ACTIONS> latency;
+    Shard* next = nullptr;
+};
+
+std::atomic<Shard*> shards{nullptr};
+thread_local Shard* local = nullptr;
+
+Shard& localShard() {
+    if (!local) {
+        Shard* shard = new Shard();
+        Shard* head = shards.load(std::memory_order_relaxed);
+        do {
+            shard->next = head;
+        } while (!shards.compare_exchange_weak(head, shard, std::memory_order_release, std::memory_order_relaxed));
+        local = shard;
+    }
+    return *local;
+}
+
+size_t actionIndex(Action action) {
+    size_t index = static_cast<size_t>(action);
+    return index < ACTIONS ? index : 0;
+}
+
+}
+
+const char* reasonName(size_t reason) {
+    if (reason < static_cast<size_t>(moves::Reject::Count)) {
+        return moves::rejectName(static_cast<moves::Reject>(reason));
+    }
+    switch (static_cast<Refusal>(reason)) {
+        case Refusal::UnknownTable: return "unknown_table";
+        case Refusal::BlockPending: return "block_pending";
+        case Refusal::Malformed: return "malformed";
+        default: return "other";
+    }
+}
+
+const char* actionName(Action action) {
+    switch (action) {
+        case Action::Gather: return "gather";
+        case Action::Tax: return "tax";
+        case Action::Bribe: return "bribe";
+        case Action::Arrest: return "arrest";
+        case Action::Sanction: return "sanction";
+        case Action::Coup: return "coup";
+        case Action::Ability: return "ability";
+        default: return "none";
+    }
+}
+
+Histogram::Histogram() : _counts(), _count(0), _sum(0), _max(0) {
+    for (auto& bucket : _counts) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Index of the bucket holding a value.
+ */
+size_t Histogram::bucketOf(std::uint64_t value) {
+    if (value < 2 * SUB) {
+        return static_cast<size_t>(value);
+    }
+    if (value >= (std::uint64_t(1) << MAX_BITS)) {
+        value = (std::uint64_t(1) << MAX_BITS) - 1;
+    }
+    unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = msb - SUB_BITS;
+    return (shift + 1) * SUB + static_cast<size_t>((value >> shift) - SUB);
+}
+
+/**
+ * @brief Largest value that falls into a bucket.
+ */
+std::uint64_t Histogram::bucketHigh(size_t bucket) {
+    if (bucket < 2 * SUB) {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>(bucket / SUB - 1);
+    std::uint64_t low = static_cast<std::uint64_t>(bucket % SUB + SUB) << shift;
+    return low + (std::uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(std::uint64_t value) {
+    bump(_counts[bucketOf(value)]);
+    bump(_count);
+    bump(_sum, value);
+    if (value > _max.load(std::memory_order_relaxed)) {
+        _max.store(value, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Adds another histogram's counts to this one (used when scraping).
+ */
+void Histogram::add(const Histogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        bump(_counts[i], other._counts[i].load(std::memory_order_relaxed));
+    }
+    bump(_count, other._count.load(std::memory_order_relaxed));
+    bump(_sum, other._sum.load(std::memory_order_relaxed));
+    std::uint64_t otherMax = other._max.load(std::memory_order_relaxed);
+    if (otherMax > _max.load(std::memory_order_relaxed)) {
+        _max.store(otherMax, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t Histogram::count() const {
+    return _count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::sum() const {
+    return _sum.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::max() const {
+    return _max.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Smallest bucket bound that covers the given share of the recorded values.
+ *
+ * @param quantile Between 0 and 1, e.g. 0.99.
+ * @return std::uint64_t The value, never above max(); 0 for an empty histogram.
+ */
+std::uint64_t Histogram::percentile(double quantile) const {
+    std::uint64_t total = 0;
+    for (const auto& bucket : _counts) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    std::uint64_t rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total) + 0.5);
+    rank = rank < 1 ? 1 : (rank > total ? total : rank);
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += _counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            std::uint64_t high = bucketHigh(i);
+            return high < max() ? high : max();
+        }
+    }
+    return max();
+}
+
+/**
+ * @brief Counts an applied move and its engine latency on the calling thread's shard.
+ *
+ * @param action The move's action.
+ * @param nanos Time spent applying it.
+ */
+void recordApplied(Action action, std::uint64_t nanos) {
+    Shard& shard = localShard();
+    size_t index = actionIndex(action);
+    bump(shard.applied[index]);
+    shard.latency[index].record(nanos);
+}
+
+void recordRejected(Action action, moves::Reject reason) {
+    bump(localShard().rejected[actionIndex(action)][static_cast<size_t>(reason)]);
+}
+
+void recordRejected(Action action, Refusal reason) {
+    bump(localShard().rejected[actionIndex(action)][static_cast<size_t>(reason)]);
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds, for latencies passed to recordApplied().
+ */
+std::uint64_t nowNanos() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/**
+ * @brief Adds up every shard. Safe while other threads keep recording.
+ *
+ * @param out Receives the totals; must be freshly constructed.
+ */
+void scrape(Scrape& out) {
+    for (Shard* shard = shards.load(std::memory_order_acquire); shard; shard = shard->next) {
+        for (size_t a = 0; a < ACTIONS; ++a) {
+            out.applied[a] += shard->applied[a].load(std::memory_order_relaxed);
+            for (size_t r = 0; r < REASONS; ++r) {
+                out.rejected[a][r] += shard->rejected[a][r].load(std::memory_order_relaxed);
+            }
+            out.latency[a].add(shard->latency[a]);
+        }
+    }
+}
+
+/**
+ * @brief Renders the current totals in the Prometheus text exposition format.
+ *
+ * Rejection reasons that never happened and latencies of actions never applied are
+ * left out. Latencies are the engine time of applied moves, in nanoseconds. The
+ * action "none" covers passes and frames whose action could not be decoded.
+ *
+ * @return std::string The text, one sample per line.
+ */
+std::string renderText() {
+    auto totals = std::make_unique<Scrape>();
+    scrape(*totals);
+    std::ostringstream out;
+    out << "# TYPE coup_moves_applied_total counter\n";
+    for (size_t a = 0; a < ACTIONS; ++a) {
+        out << "coup_moves_applied_total{action=\"" << actionName(static_cast<Action>(a)) << "\"} "
+            << totals->applied[a] << "\n";
+    }
+    out << "# TYPE coup_moves_rejected_total counter\n";
+    for (size_t a = 0; a < ACTIONS; ++a) {
+        for (size_t r = 0; r < REASONS; ++r) {
+            if (totals->rejected[a][r] > 0) {
+                out << "coup_moves_rejected_total{action=\"" << actionName(static_cast<Action>(a)) << "\",reason=\""
+                    << reasonName(r) << "\"} " << totals->rejected[a][r] << "\n";
+            }
+        }
+    }
+    out << "# TYPE coup_move_latency_ns summary\n";
+    for (size_t a = 0; a < ACTIONS; ++a) {
+        const Histogram& h = totals->latency[a];
+        if (h.count() == 0) {
+            continue;
+        }
+        const char* name = actionName(static_cast<Action>(a));
+        for (double q : {0.5, 0.9, 0.99, 0.999}) {
+            char quantile[16];
+            std::snprintf(quantile, sizeof(quantile), "%g", q);
+            out << "coup_move_latency_ns{action=\"" << name << "\",quantile=\"" << quantile << "\"} "
+                << h.percentile(q) << "\n";
+        }
+        out << "coup_move_latency_ns_max{action=\"" << name << "\"} " << h.max() << "\n";
+        out << "coup_move_latency_ns_sum{action=\"" << name << "\"} " << h.sum() << "\n";
+        out << "coup_move_latency_ns_count{action=\"" << name << "\"} " << h.count() << "\n";
+    }
+    return out.str();
+}
+
+/**
+ * @brief Replaces a file with renderText(), atomically (temporary file and rename).
+ *
+ * @param path Destination, e.g. a node_exporter textfile collector directory entry.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void writeText(const std::string& path) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary);
+        if (!(file << renderText())) {
+            throw std::runtime_error("Cannot write metrics to " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot rename metrics file to " + path);
+    }
+}
+
+} // namespace metrics
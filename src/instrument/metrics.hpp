@@ -0,0 +1,80 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "engine/move.hpp"
+
+// Runtime counters for a running server: moves applied and rejected per Action, rejections
+// by reason, and a latency histogram per Action.
+//
+// Every thread that records gets its own shard (single writer, relaxed stores), so the hot
+// path never shares a cache line with another thread. scrape() adds the shards up; shards
+// of finished threads are kept so their counts are not lost.
+namespace metrics {
+
+constexpr size_t ACTIONS = static_cast<size_t>(Action::Ability) + 1;
+
+// Refusals that come from the server rather than from the rules; counted after moves::Reject
+enum class Refusal : std::uint8_t {
+    UnknownTable = static_cast<std::uint8_t>(moves::Reject::Count),
+    BlockPending,
+    Malformed,
+    Other,
+    End
+};
+constexpr size_t REASONS = static_cast<size_t>(Refusal::End);
+
+const char* reasonName(size_t reason);
+const char* actionName(Action action);
+
+// Log-linear (HDR style) histogram of nanosecond values: exact below 64, then 32 buckets
+// per power of two, so any recorded value is reported within about 3%. Values above
+// 2^40 ns are clamped. One thread records into a histogram; any thread may read it.
+class Histogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr size_t SUB = size_t(1) << SUB_BITS;
+    static constexpr unsigned MAX_BITS = 40;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS) * SUB + SUB;
+
+    Histogram();
+    void record(std::uint64_t value);
+    void add(const Histogram& other);
+    std::uint64_t count() const;
+    std::uint64_t sum() const;
+    std::uint64_t max() const;
+    std::uint64_t percentile(double quantile) const;
+
+    static size_t bucketOf(std::uint64_t value);
+    static std::uint64_t bucketHigh(size_t bucket);
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS> _counts;
+    std::atomic<std::uint64_t> _count;
+    std::atomic<std::uint64_t> _sum;
+    std::atomic<std::uint64_t> _max;
+};
+
+// Totals over every shard at one point in time
+struct Scrape {
+    std::array<std::uint64_t, ACTIONS> applied{};
+    std::array<std::array<std::uint64_t, REASONS>, ACTIONS> rejected{};
+    std::array<Histogram, ACTIONS> latency;
+};
+
+void recordApplied(Action action, std::uint64_t nanos);
+void recordRejected(Action action, moves::Reject reason);
+void recordRejected(Action action, Refusal reason);
+std::uint64_t nowNanos();
+
+void scrape(Scrape& out);
+std::string renderText();
+void writeText(const std::string& path);
+
+} // namespace metrics
+
+#endif // METRICS_HPP
@@ -0,0 +1,197 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+// Fields are relaxed atomics so a concurrent dump is a benign race, not undefined behaviour
+struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<std::uint64_t> start{0};
+    std::atomic<std::uint64_t> duration{0};
+};
+
+struct Event {
+    const char* name;
+    std::uint64_t start;
+    std::uint64_t duration;
+};
+
+// One per thread that ever recorded; kept after the thread exits so its events can be dumped
+struct Ring {
+    std::uint32_t tid = 0;
+    std::atomic<std::uint64_t> head{0};   // events ever written; only the owner thread stores
+    std::atomic<const char*> name{nullptr};
+    Ring* next = nullptr;
+    Slot slots[RING_CAPACITY];
+};
+
+std::atomic<Ring*> rings{nullptr};
+std::atomic<std::uint32_t> nextTid{1};
+thread_local Ring* local = nullptr;
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+Ring& localRing() {
+    if (!local) {
+        Ring* ring = new Ring();
+        ring->tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+        Ring* head = rings.load(std::memory_order_relaxed);
+        do {
+            ring->next = head;
+        } while (!rings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+        local = ring;
+    }
+    return *local;
+}
+
+// Copies the events of one ring that were not overwritten while copying
+std::vector<Event> snapshot(const Ring& ring) {
+    std::uint64_t end = ring.head.load(std::memory_order_acquire);
+    std::uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (std::uint64_t i = begin; i < end; ++i) {
+        const Slot& slot = ring.slots[i % RING_CAPACITY];
+        events.push_back(Event{slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed),
+                               slot.duration.load(std::memory_order_relaxed)});
+    }
+    // The owner may have lapped the oldest slots meanwhile
+    std::uint64_t after = ring.head.load(std::memory_order_acquire);
+    size_t overwritten = static_cast<size_t>(std::min<std::uint64_t>(
+        events.size(), after > RING_CAPACITY + begin ? after - RING_CAPACITY - begin : 0));
+    events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(overwritten));
+    return events;
+}
+
+void writeEscaped(std::ostream& out, const char* text) {
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out << *c;
+        }
+    }
+}
+
+void writeMicros(std::ostream& out, std::uint64_t nanos) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%llu.%03llu", static_cast<unsigned long long>(nanos / 1000),
+                  static_cast<unsigned long long>(nanos % 1000));
+    out << text;
+}
+
+}
+
+Span::Span(const char* name) : _name(name), _start(nowNanos()) {}
+
+Span::~Span() {
+    record(_name, _start, nowNanos() - _start);
+}
+
+/**
+ * @brief Nanoseconds since the program started, from the monotonic clock.
+ */
+std::uint64_t nowNanos() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+/**
+ * @brief Appends one complete event to the calling thread's ring.
+ *
+ * @param name Event name; must outlive the program (a string literal).
+ * @param start Start time from nowNanos().
+ * @param duration Duration in nanoseconds.
+ */
+void record(const char* name, std::uint64_t start, std::uint64_t duration) {
+    Ring& ring = localRing();
+    std::uint64_t index = ring.head.load(std::memory_order_relaxed);
+    Slot& slot = ring.slots[index % RING_CAPACITY];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Names the calling thread in the trace (e.g. "loop 3").
+ *
+ * The string is kept for the life of the program.
+ */
+void setThreadName(const std::string& name) {
+    Ring& ring = localRing();
+    char* copy = new char[name.size() + 1];
+    std::copy(name.begin(), name.end(), copy);
+    copy[name.size()] = '\0';
+    ring.name.store(copy, std::memory_order_release);
+}
+
+/**
+ * @brief Writes the events of every thread as Chrome trace-event JSON.
+ *
+ * Safe to call while other threads keep recording: events they overwrite during the
+ * copy are left out. Timestamps are microseconds since the program started.
+ *
+ * @param out Stream receiving the JSON object.
+ * @return size_t Number of events written.
+ */
+size_t writeChromeTrace(std::ostream& out) {
+    size_t written = 0;
+    bool first = true;
+    auto separator = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    for (Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        if (const char* name = ring->name.load(std::memory_order_acquire)) {
+            separator();
+            out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->tid
+                << ", \"args\": {\"name\": \"";
+            writeEscaped(out, name);
+            out << "\"}}";
+        }
+        for (const Event& event : snapshot(*ring)) {
+            if (!event.name) {
+                continue;
+            }
+            separator();
+            out << "{\"name\": \"";
+            writeEscaped(out, event.name);
+            out << "\", \"cat\": \"coup\", \"ph\": \"X\", \"ts\": ";
+            writeMicros(out, event.start);
+            out << ", \"dur\": ";
+            writeMicros(out, event.duration);
+            out << ", \"pid\": 1, \"tid\": " << ring->tid << "}";
+            ++written;
+        }
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+/**
+ * @brief Writes the trace to a file.
+ *
+ * @param path Output file.
+ * @return size_t Number of events written.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+size_t writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    size_t written = writeChromeTrace(file);
+    if (!file) {
+        throw std::runtime_error("Cannot write trace " + path);
+    }
+    return written;
+}
+
+} // namespace trace
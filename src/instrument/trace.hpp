@@ -0,0 +1,60 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Compile-time trace points.
+//
+// COUP_TRACE_SCOPE("Game::next_turn") records one complete event (start and duration) when the
+// enclosing block ends. Each thread writes into its own fixed-size ring buffer with plain stores
+// and one release store of its head, so recording never locks, never allocates after the first
+// event of a thread, and the oldest events are overwritten when the ring is full.
+// writeChromeTrace() collects every thread's ring into Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev). Without COUP_TRACING the macro compiles to nothing.
+namespace trace {
+
+constexpr size_t RING_CAPACITY = size_t(1) << 16; // events kept per thread
+
+// Times the enclosing block
+class Span {
+public:
+    explicit Span(const char* name);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* _name;
+    std::uint64_t _start;
+};
+
+std::uint64_t nowNanos();
+void record(const char* name, std::uint64_t start, std::uint64_t duration);
+void setThreadName(const std::string& name);
+
+size_t writeChromeTrace(std::ostream& out);
+size_t writeChromeTrace(const std::string& path);
+
+constexpr bool enabled() {
+#ifdef COUP_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace trace
+
+#define COUP_TRACE_CONCAT_(a, b) a##b
+#define COUP_TRACE_CONCAT(a, b) COUP_TRACE_CONCAT_(a, b)
+
+#ifdef COUP_TRACING
+#define COUP_TRACE_SCOPE(name) trace::Span COUP_TRACE_CONCAT(coup_trace_span_, __LINE__)(name)
+#else
+#define COUP_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif // TRACE_HPP
@@ -1,10 +1,17 @@
 #include "GUI.hpp"
+#include "instrument/trace.hpp"
+#include <cstdlib>
 #include <iostream>
 
 int main() {
     try {
         GameSetupGUI gameSetup;
         gameSetup.run();
+        // Builds made with TRACING=1 dump their trace points when COUP_TRACE names a file
+        const char* tracePath = std::getenv("COUP_TRACE");
+        if (trace::enabled() && tracePath) {
+            trace::writeChromeTrace(tracePath);
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return -1;
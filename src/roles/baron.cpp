@@ -1,5 +1,7 @@
 #include "baron.hpp"
 #include "game.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 
 /**
@@ -11,17 +13,23 @@
  * @throws std::runtime_error If the Baron has 10 or more coins (must perform a coup instead).
  */
 void Baron::ability() {
-    if (_coins < 3) {
+    COUP_TRACE_SCOPE("Baron::ability");
+    if (coins() < 3) {
         throw std::runtime_error("Baron needs at least 3 coins to use ability.");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
-    _coins += 3;
-    _last_action = Action::Ability;
+    coins() += 3;
+    setAction(Action::Ability);
     _game.next_turn();
 }
 
 std::string Baron::get_type() const{
+    COUP_ALLOC_SCOPE("Baron::get_type");
     return "Baron";
+}
+
+Role Baron::role() const{
+    return Role::Baron;
 }
\ No newline at end of file
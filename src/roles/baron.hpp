@@ -7,6 +7,7 @@ class Baron : public Player {
 public:
     void ability() override;
     std::string get_type() const override;
+    Role role() const override;
     Baron(Game& game, const std::string& name,size_t index) : Player(game, name, index) { }
 };
 
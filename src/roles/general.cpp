@@ -1,10 +1,17 @@
 #include "general.hpp"
 #include "game.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 std::string General::get_type() const{
+    COUP_ALLOC_SCOPE("General::get_type");
     return "General";
 }
 
+Role General::role() const{
+    return Role::General;
+}
+
 /**
  * @brief Executes the General's targeted ability.
  * 
@@ -16,11 +23,12 @@ std::string General::get_type() const{
  * @throws std::runtime_error If the General has fewer than 5 coins.
  */
 void General::ability(Player& target){
-    if(_coins < 5){
+    COUP_TRACE_SCOPE("General::ability");
+    if(coins() < 5){
         throw std::runtime_error("General ability costs 5");
     }
-    _coins -= 5;
+    coins() -= 5;
     _game.restorePlayer();
-    _last_action = Action::Ability;
+    setAction(Action::Ability);
     target.setAction(Action::None);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 class General : public Player {
 public:
     std::string get_type() const override;
+    Role role() const override;
     General(Game& game, const std::string& name,size_t index) : Player(game, name,index) { }
     void ability(Player& player) override;
 };
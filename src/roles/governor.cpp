@@ -1,5 +1,7 @@
 #include "governor.hpp"
 #include "game.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 
 /**
@@ -11,20 +13,26 @@
  * @throws std::runtime_error If the Governor already has 10 or more coins (must coup instead).
  */
 void Governor::tax() {
-    if (_sanctioned) {
+    COUP_TRACE_SCOPE("Governor::tax");
+    if (isSanctioned()) {
         throw std::runtime_error("Governor is sanctioned and cannot collect tax.");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
-    _coins += 3;
-    _last_action = Action::Tax;
+    coins() += 3;
+    setAction(Action::Tax);
     _game.next_turn();
 }
 std::string Governor::get_type() const{
+    COUP_ALLOC_SCOPE("Governor::get_type");
     return "Governor";
 }
 
+Role Governor::role() const{
+    return Role::Governor;
+}
+
 /**
  * @brief Executes the Governor's targeted ability.
  * 
@@ -35,10 +43,11 @@ std::string Governor::get_type() const{
  * @param target The player to target for coin reduction.
  */
 void Governor::ability(Player& target){
+    COUP_TRACE_SCOPE("Governor::ability");
     if(target.get_type() == "Governor")
         target.setCoins(target.getCoins() - 3);
     else
         target.setCoins(target.getCoins() - 2);
-    _last_action = Action::Ability;
+    setAction(Action::Ability);
     target.setAction(Action::None);
 }
\ No newline at end of file
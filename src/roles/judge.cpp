@@ -1,10 +1,17 @@
 #include "judge.hpp"
 #include "game.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 std::string Judge::get_type() const{
+    COUP_ALLOC_SCOPE("Judge::get_type");
     return "Judge";
 }
 
+Role Judge::role() const{
+    return Role::Judge;
+}
+
 /**
  * @brief Executes the Judge's targeted ability.
  * 
@@ -15,7 +22,8 @@ std::string Judge::get_type() const{
  * @param target The player targeted by the Judge's ability.
  */
 void Judge::ability(Player& target){
-    _last_action = Action::Ability;
+    COUP_TRACE_SCOPE("Judge::ability");
+    setAction(Action::Ability);
     target.setAction(Action::None);
     _game.setBribe(false);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 class Judge : public Player {
 public:
     std::string get_type() const override;
+    Role role() const override;
     Judge(Game& game, const std::string& name, size_t index) : Player(game, name, index) { }
     void ability(Player& target) override;
 };
@@ -1,9 +1,16 @@
 #include "merchant.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 std::string Merchant::get_type() const{
+    COUP_ALLOC_SCOPE("Merchant::get_type");
     return "Merchant";
 }
 
+Role Merchant::role() const{
+    return Role::Merchant;
+}
+
 /**
  * @brief Executes the Merchant's ability.
  * 
@@ -12,8 +19,9 @@ std::string Merchant::get_type() const{
  * last action to Ability.
  */
 void Merchant::ability(){
-    if(_coins >= 3){
-        _coins++;
-        _last_action = Action::Ability;
+    COUP_TRACE_SCOPE("Merchant::ability");
+    if(coins() >= 3){
+        coins()++;
+        setAction(Action::Ability);
     }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 class Merchant : public Player {
 public:
     std::string get_type() const override;
+    Role role() const override;
     Merchant(Game& game,const std::string& name,size_t index) : Player(game, name,index) { }
     void ability() override;
 };
@@ -2,29 +2,33 @@
 #include "player.hpp"
 #include <stdexcept>
 #include "game.hpp"
+#include "engine/seat_table.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 
 /**
  * @brief Constructs a new Player with the given name.
  * 
- * Initializes the player's coin count to 0, and sets status flags to default values.
+ * Claims a slot in the game's seat table, where the name is interned, the coin
+ * count starts at 0 and the status flags at their default values.
  * 
  * @param name The name of the player.
  */
 Player::Player(Game& game, const std::string& name, size_t index)
-    : _name(name),
-      _coins(0),
-      _sanctioned(false),
-      _arrested(false),
-      _can_arrest(true),
-      _game(game),
-      _last_action(Action::None),
-      _index(index)
+    : _game(game),
+      _index(index),
+      _seats(game.seatTable()),
+      _slot(_seats->claim(name))
 {}
 /**
  * @brief Destructor for the Player class.
+ *
+ * Returns the player's slot to the seat table.
  */
-Player::~Player() {}
+Player::~Player() {
+    _seats->release(_slot);
+}
 
 /**
  * @brief Copy constructor for Player.
@@ -34,15 +38,15 @@ Player::~Player() {}
  * @param other The Player object to copy.
  */
 Player::Player(const Player& other)
-    : _name(other._name),
-      _coins(other._coins),
-      _sanctioned(other._sanctioned),
-      _arrested(false),          // אם בכוונה אתה מאתחל ל־false
-      _can_arrest(true),         // כנ״ל
-      _game(other._game),
-      _last_action(other._last_action),
-      _index(other._index)
-{}
+    : _game(other._game),
+      _index(other._index),
+      _seats(other._seats),
+      _slot(_seats->claim(other.getName()))
+{
+    _seats->coins[_slot] = other.getCoins();
+    _seats->sanctioned[_slot] = other.isSanctioned();
+    _seats->lastAction[_slot] = other.getLastAction();
+}
 
 
 /**
@@ -56,12 +60,12 @@ Player::Player(const Player& other)
 Player& Player::operator=(const Player& other) {
     if (this != &other) {
         _game = other._game;
-        _name = other._name;
-        _coins = other._coins;
-        _sanctioned = other._sanctioned;
-        _arrested = other._arrested;
-        _can_arrest = other._can_arrest;
-        _last_action = other._last_action;
+        _seats->rename(_slot, other.getName());
+        setCoins(other.getCoins());
+        setSanctioned(other.isSanctioned());
+        setArrest(other.isArrested());
+        setCanArrest(other.getCanArrest());
+        setAction(other.getLastAction());
         _index = other._index;
     }
     return *this;
@@ -74,14 +78,16 @@ Player& Player::operator=(const Player& other) {
  * @return false If the player is sanctioned and cannot gather.
  */
 void Player::gather() {
-    if (_sanctioned) {
+    COUP_TRACE_SCOPE("Player::gather");
+    COUP_ALLOC_SCOPE("Player::gather");
+    if (isSanctioned()) {
         throw std::runtime_error("Sanctioned players cannot gather coins.");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
-    _last_action = Action::Gather;
-    _coins += 1;
+    setAction(Action::Gather);
+    coins() += 1;
     _game.next_turn();
 }
 
@@ -95,14 +101,16 @@ void Player::gather() {
  */
 
 void Player::tax() {
-    if (_sanctioned) {
+    COUP_TRACE_SCOPE("Player::tax");
+    COUP_ALLOC_SCOPE("Player::tax");
+    if (isSanctioned()) {
         throw std::runtime_error("Sanctioned players cannot use tax.");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
-    _coins += 2;
-    _last_action = Action::Tax;
+    coins() += 2;
+    setAction(Action::Tax);
     _game.next_turn();
 }
 
@@ -116,14 +124,16 @@ void Player::tax() {
  * @return false If the player does not have enough coins.
  */
 void Player::bribe() {
-    if (_coins < 4) {
+    COUP_TRACE_SCOPE("Player::bribe");
+    COUP_ALLOC_SCOPE("Player::bribe");
+    if (coins() < 4) {
         throw std::runtime_error("You must have 4 coins");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
-    _coins -= 4;
-    _last_action = Action::Bribe;
+    coins() -= 4;
+    setAction(Action::Bribe);
     _game.bribe();
 }
 
@@ -143,26 +153,28 @@ void Player::bribe() {
  * @param target The player to arrest.
  */
 void Player::arrest(Player& target) {
-    if (target._arrested) {
+    COUP_TRACE_SCOPE("Player::arrest");
+    COUP_ALLOC_SCOPE("Player::arrest");
+    if (target.isArrested()) {
         throw std::runtime_error("Target is already arrested.");
     }
-    if (!_can_arrest) {
+    if (!getCanArrest()) {
         throw std::runtime_error("You are not allowed to arrest.");
     }
-    if (target._coins <= 0) {
+    if (target.coins() <= 0) {
         throw std::runtime_error("Target does not have enough coins to be arrested.");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
     if (target.get_type() == "Merchant") {
-        target._coins -= 2;
+        target.coins() -= 2;
     } else {
-        target._coins -= 1;
-        _coins += 1;
+        target.coins() -= 1;
+        coins() += 1;
     }
-    target._arrested = true;
-    _last_action = Action::Arrest;
+    target.setArrest(true);
+    setAction(Action::Arrest);
     _game.next_turn();
 }
 
@@ -173,7 +185,7 @@ void Player::arrest(Player& target) {
  * @param can A boolean indicating if the player can arrest.
  */
 void Player::setCanArrest(bool can){
-    _can_arrest = can;
+    _seats->canArrest[_slot] = can;
 }
 
 /**
@@ -182,8 +194,8 @@ void Player::setCanArrest(bool can){
  * @return true If the player can arrest.
  * @return false Otherwise.
  */
-bool Player::getCanArrest(){
-    return _can_arrest;
+bool Player::getCanArrest() const{
+    return _seats->canArrest[_slot];
 }
 
 /**
@@ -195,24 +207,26 @@ bool Player::getCanArrest(){
  * @param target The player to sanction.
  */
 void Player::sanction(Player& target) {
-    if (_coins < 3) {
+    COUP_TRACE_SCOPE("Player::sanction");
+    COUP_ALLOC_SCOPE("Player::sanction");
+    if (coins() < 3) {
         throw std::runtime_error("Not enough coins to sanction.");
     }
-    if(_coins >= 10){
+    if(coins() >= 10){
         throw std::runtime_error("You have 10 or more coins must coup.");
     }
     if (target.get_type() == "Baron") {
-        target._coins++;
+        target.coins()++;
     }
     if (target.get_type() == "Judge") {
-        if (_coins < 4) {
+        if (coins() < 4) {
             throw std::runtime_error("Not enough coins to sanction a Judge.");
         }
-        _coins--;
+        coins()--;
     }
-    _coins -= 3;
-    target._sanctioned = true;
-    _last_action = Action::Sanction;
+    coins() -= 3;
+    target.setSanctioned(true);
+    setAction(Action::Sanction);
     _game.next_turn();
 }
 
@@ -227,12 +241,14 @@ void Player::sanction(Player& target) {
  * @return false If the player had fewer than 7 coins.
  */
 void Player::coup(Player& target) {
-    if (_coins < 7) {
+    COUP_TRACE_SCOPE("Player::coup");
+    COUP_ALLOC_SCOPE("Player::coup");
+    if (coins() < 7) {
         throw std::runtime_error("Not enough coins to perform a coup.");
     }
-    _coins -= 7;
-    _game.gameCoup(target.getName());
-    _last_action = Action::Coup;
+    coins() -= 7;
+    _game.gameCoup(target.getNameId());
+    setAction(Action::Coup);
     _game.next_turn();
 }
 
@@ -245,16 +261,40 @@ void Player::coup(Player& target) {
  * @return The type of the player.
  */
 std::string Player::get_type() const {
+    COUP_ALLOC_SCOPE("Player::get_type");
     return "Player";
 }
 
+/**
+ * @brief Gets the role of this player as an enum.
+ *
+ * Same information as get_type() but cheap to compare and to encode.
+ *
+ * @return Role::Player for the base class.
+ */
+Role Player::role() const {
+    return Role::Player;
+}
+
 /**
  * @brief Gets the player's name.
  *
  * @return The name of the player.
  */
 std::string Player::getName() const {
-    return _name;
+    COUP_ALLOC_SCOPE("Player::getName");
+    return _seats->names.name(_seats->nameId[_slot]);
+}
+
+/**
+ * @brief Gets the id of the player's name in the game's name table.
+ *
+ * Two players of a game have the same name exactly when they have the same id.
+ *
+ * @return std::uint32_t The name id.
+ */
+std::uint32_t Player::getNameId() const {
+    return _seats->nameId[_slot];
 }
 
 /**
@@ -263,7 +303,7 @@ std::string Player::getName() const {
  * @return The number of coins.
  */
 int Player::getCoins() const {
-    return _coins;
+    return _seats->coins[_slot];
 }
 
 /**
@@ -274,7 +314,7 @@ int Player::getCoins() const {
  * @param coins The new coin count.
  */
 void Player::setCoins(int coins){
-    _coins = coins;
+    _seats->coins[_slot] = coins;
 }
 
 /**
@@ -286,7 +326,7 @@ void Player::setCoins(int coins){
  * @return false otherwise.
  */
 bool Player::isSanctioned() const {
-    return _sanctioned;
+    return _seats->sanctioned[_slot];
 }
 
 /**
@@ -295,7 +335,7 @@ bool Player::isSanctioned() const {
  * @param status true to sanction the player, false to remove sanction.
  */
 void Player::setSanctioned(bool status) {
-    _sanctioned = status;
+    _seats->sanctioned[_slot] = status;
 }
 
 /**
@@ -307,7 +347,7 @@ void Player::setSanctioned(bool status) {
  * @return false otherwise.
  */
 bool Player::isArrested() const{
-    return _arrested;
+    return _seats->arrested[_slot];
 }
 
 /**
@@ -316,7 +356,7 @@ bool Player::isArrested() const{
  * @param status true to arrest the player, false to release.
  */
 void Player::setArrest(bool status) {
-    _arrested = status;
+    _seats->arrested[_slot] = status;
 }
 
 /**
@@ -343,7 +383,7 @@ void Player::setIndex(size_t index){
  * @param action The action to set.
  */
 void Player::setAction(Action action){
-    _last_action = action;
+    _seats->lastAction[_slot] = action;
 }
 
 /**
@@ -366,5 +406,27 @@ void Player::ability(Player& target) {
 }
 
 Action Player::getLastAction() const{
-    return _last_action;
+    return _seats->lastAction[_slot];
+}
+
+/**
+ * @brief Returns the player's slot in the game's seat table.
+ *
+ * Unlike the index, the slot never changes and is unique among live players of a game.
+ *
+ * @return size_t The slot.
+ */
+size_t Player::getSlot() const{
+    return _slot;
+}
+
+/**
+ * @brief The player's coin count in the seat table, for role actions to update in place.
+ */
+int& Player::coins() {
+    return _seats->coins[_slot];
+}
+
+int Player::coins() const {
+    return _seats->coins[_slot];
 }
\ No newline at end of file
@@ -1,11 +1,15 @@
 #ifndef PLAYER_HPP
 #define PLAYER_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
 #include "actions.hpp"
+#include "role_type.hpp"
 
 class Game;
+class SeatTable;
 
 class Player {
 public:
@@ -21,12 +25,14 @@ public:
     void sanction(Player& target);
     void coup(Player& target);
     virtual std::string get_type() const;
+    virtual Role role() const;
     virtual void ability();
     virtual int spyAbility(Player& target);
     virtual void ability(Player& target);
 
 
     std::string getName() const;
+    std::uint32_t getNameId() const;
     int getCoins() const;
     bool isSanctioned() const;
     void setSanctioned(bool status);
@@ -34,21 +40,22 @@ public:
     void setArrest(bool status);
     void setCoins(int coins);
     void setCanArrest(bool can);
-    bool getCanArrest();
+    bool getCanArrest() const;
     size_t getIndex() const;
     void setIndex(size_t index);
+    size_t getSlot() const;
     void setAction(Action action);
     Action getLastAction() const;
 
 protected:
-    std::string _name;
-    int _coins;
-    bool _sanctioned;
-    bool _arrested;
-    bool _can_arrest;
+    // Name, coins, flags and last action live in the game's SeatTable at _slot
+    int& coins();
+    int coins() const;
+
     Game& _game;
-    Action _last_action;
     size_t _index;
+    std::shared_ptr<SeatTable> _seats;
+    size_t _slot;
 };
 
 #endif
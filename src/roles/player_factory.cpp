@@ -6,10 +6,12 @@
 #include "governor.hpp"
 #include "general.hpp"
 #include "baron.hpp"
+#include "instrument/alloc_scope.hpp"
 
 #include <algorithm>
 
 std::shared_ptr<Player> PlayerFactory::createPlayer(Game& game, const std::string& role, const std::string& name, int index) {
+    COUP_ALLOC_SCOPE("PlayerFactory::createPlayer");
     std::string role_lower = role;
     std::transform(role_lower.begin(), role_lower.end(), role_lower.begin(), ::tolower);
 
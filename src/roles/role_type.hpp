@@ -0,0 +1,16 @@
+#ifndef ROLE_TYPE_H
+#define ROLE_TYPE_H
+
+#include <cstdint>
+
+enum class Role : std::uint8_t {
+    Player,
+    Spy,
+    Merchant,
+    Judge,
+    Governor,
+    General,
+    Baron
+};
+
+#endif //ROLE_TYPE_H
@@ -1,4 +1,6 @@
 #include "spy.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/trace.hpp"
 
 
 /**
@@ -10,8 +12,9 @@
  * @return int The number of coins the target player has.
  */
 int Spy::spyAbility(Player& player){
+    COUP_TRACE_SCOPE("Spy::spyAbility");
     player.setCanArrest(false);
-    _last_action = Action::Ability;
+    setAction(Action::Ability);
     return player.getCoins();
 }
 
@@ -21,5 +24,10 @@ int Spy::spyAbility(Player& player){
  * @return std::string The string "Spy".
  */
 std::string Spy::get_type() const{
+    COUP_ALLOC_SCOPE("Spy::get_type");
     return "Spy";
+}
+
+Role Spy::role() const{
+    return Role::Spy;
 }
\ No newline at end of file
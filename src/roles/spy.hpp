@@ -8,5 +8,6 @@ class Spy : public Player{
         Spy(Game& game,const std::string& name, size_t index) : Player(game,name,index) { }
         int spyAbility(Player& player) override;
         std::string get_type() const override;
+        Role role() const override;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "client.hpp"
+#include "protocol.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Client::Client() : _fd(-1), _buffer(), _offset(0) {}
+
+Client::~Client() {
+    close();
+}
+
+/**
+ * @brief Connects to a server listening on a Unix socket.
+ *
+ * @throws std::runtime_error If the connection fails.
+ */
+void Client::connectUnix(const std::string& path) {
+    close();
+    _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (_fd < 0 || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Cannot open Unix socket " + path);
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    if (::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        throw std::runtime_error("connect " + path + ": " + std::strerror(errno));
+    }
+}
+
+/**
+ * @brief Connects to a server listening on TCP, with Nagle disabled.
+ *
+ * @throws std::runtime_error If the connection fails.
+ */
+void Client::connectTcp(const std::string& host, std::uint16_t port) {
+    close();
+    _fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (_fd < 0 || inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("Cannot open TCP socket to " + host);
+    }
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        throw std::runtime_error("connect " + host + ": " + std::strerror(errno));
+    }
+}
+
+/**
+ * @brief Writes one or more complete frames.
+ *
+ * @throws std::runtime_error If the connection is lost.
+ */
+void Client::send(const std::vector<std::uint8_t>& frames) {
+    size_t sent = 0;
+    while (sent < frames.size()) {
+        ssize_t n = ::send(_fd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            throw std::runtime_error("Connection lost while sending.");
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief Blocks until one complete frame arrives and copies it (with its length prefix).
+ *
+ * @throws std::runtime_error If the connection is closed.
+ */
+void Client::receive(std::vector<std::uint8_t>& frame) {
+    while (true) {
+        size_t length = protocol::frameLength(_buffer.data() + _offset, _buffer.size() - _offset);
+        if (length > 0) {
+            frame.assign(_buffer.begin() + static_cast<std::ptrdiff_t>(_offset),
+                         _buffer.begin() + static_cast<std::ptrdiff_t>(_offset + length));
+            _offset += length;
+            if (_offset == _buffer.size()) {
+                _buffer.clear();
+                _offset = 0;
+            }
+            return;
+        }
+        std::uint8_t chunk[4096];
+        ssize_t got = ::recv(_fd, chunk, sizeof(chunk), 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            throw std::runtime_error("Connection closed by server.");
+        }
+        _buffer.insert(_buffer.end(), chunk, chunk + got);
+    }
+}
+
+void Client::close() {
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _buffer.clear();
+    _offset = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef CLIENT_HPP
+#define CLIENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Blocking client connection speaking the frame protocol (used by tools and tests).
+class Client {
+public:
+    Client();
+    ~Client();
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    void connectUnix(const std::string& path);
+    void connectTcp(const std::string& host, std::uint16_t port);
+    void send(const std::vector<std::uint8_t>& frames);
+    void receive(std::vector<std::uint8_t>& frame);
+    void close();
+
+private:
+    int _fd;
+    std::vector<std::uint8_t> _buffer;
+    size_t _offset;
+};
+
+#endif // CLIENT_HPP
@@ -0,0 +1,652 @@
+#include "event_loop.hpp"
+#include "protocol.hpp"
+#include "instrument/trace.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int MAX_EVENTS = 128;
+constexpr size_t READ_CHUNK = 16384;
+constexpr std::uint64_t LISTEN_ID = 0;
+constexpr std::uint64_t WAKE_ID = 1;
+constexpr std::uint64_t TICK_ID = 2;
+constexpr std::uint64_t FIRST_CONNECTION_ID = 16;
+constexpr int MAX_IOV = 64;
+
+void throwErrno(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}
+
+/**
+ * @brief Creates the epoll instance and registers the listening socket, the shard's wake-up
+ * eventfd and the spectator tick timer.
+ *
+ * The listening socket is shared by every loop; EPOLLEXCLUSIVE makes the kernel wake
+ * only one of them per incoming connection.
+ *
+ * @param listenFd Non-blocking listening socket (TCP or Unix).
+ * @param shard Index of this loop, also used for the table ids it hands out.
+ * @param registry Routes frames for tables owned by other shards.
+ * @param options Spectator tick and write-ahead log settings; with a log, the shard's
+ *        tables are recovered from it first.
+ * @throws std::runtime_error If a system call fails or the log cannot be replayed.
+ */
+EventLoop::EventLoop(int listenFd, std::uint32_t shard, TableRegistry& registry, const LoopOptions& options)
+    : _epoll(-1), _listen(listenFd), _shard(shard), _registry(registry), _host(shard),
+      _connections(), _retry(), _scratch(), _fanout(registry.shardCount()), _touched(),
+      _timer(-1), _options(options), _tick_armed(false), _wal(), _last_checkpoint(std::chrono::steady_clock::now()),
+      _held(),
+      _next_connection(FIRST_CONNECTION_ID), _running(false)
+{
+    if (!_options.walPath.empty()) {
+        _wal = std::make_unique<WriteAheadLog>(_options.walPath);
+        _host.recover(*_wal);
+        _host.checkpoint(*_wal); // the next crash replays from here
+        _host.attachLog(_wal.get());
+    }
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll < 0) {
+        throwErrno("epoll_create1");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.u64 = LISTEN_ID;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _listen, &ev) < 0) {
+        close(_epoll);
+        throwErrno("epoll_ctl(listen)");
+    }
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_ID;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _registry.wakeFd(_shard), &ev) < 0) {
+        close(_epoll);
+        throwErrno("epoll_ctl(eventfd)");
+    }
+    _timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    ev.data.u64 = TICK_ID;
+    if (_timer < 0 || epoll_ctl(_epoll, EPOLL_CTL_ADD, _timer, &ev) < 0) {
+        int err = errno;
+        if (_timer >= 0) close(_timer);
+        close(_epoll);
+        errno = err;
+        throwErrno("timerfd");
+    }
+}
+
+/**
+ * @brief Closes every client connection and the epoll instance.
+ *
+ * The listening socket and the wake-up eventfd belong to the server and registry.
+ */
+EventLoop::~EventLoop() {
+    for (auto& entry : _connections) {
+        close(entry.second->fd);
+    }
+    _connections.clear();
+    close(_timer);
+    close(_epoll);
+}
+
+/**
+ * @brief Runs the loop on the calling thread until stop() is called.
+ */
+void EventLoop::run() {
+    _running = true;
+    if (trace::enabled()) {
+        trace::setThreadName("loop " + std::to_string(_shard));
+    }
+    epoll_event events[MAX_EVENTS];
+    while (_running) {
+        while (!_retry.empty() && _registry.post(_retry.front().first, std::move(_retry.front().second))) {
+            _retry.pop_front();
+        }
+        int ready = epoll_wait(_epoll, events, MAX_EVENTS, _retry.empty() ? -1 : 1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("epoll_wait");
+        }
+        for (int i = 0; i < ready; ++i) {
+            std::uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                acceptClients();
+                continue;
+            }
+            if (id == WAKE_ID) {
+                std::uint64_t value;
+                while (read(_registry.wakeFd(_shard), &value, sizeof(value)) > 0) {}
+                drainInbox();
+                continue;
+            }
+            if (id == TICK_ID) {
+                std::uint64_t expirations;
+                while (read(_timer, &expirations, sizeof(expirations)) > 0) {}
+                _tick_armed = false;
+                publish();
+                continue;
+            }
+            auto it = _connections.find(id);
+            if (it == _connections.end()) continue;
+            Connection& conn = *it->second;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                closeConnection(id);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                touch(conn); // written at the end of the pass, after the commit
+            }
+            if (events[i].events & EPOLLIN) {
+                onReadable(conn);
+            }
+        }
+        schedulePublish();
+        commitPass();
+    }
+}
+
+/**
+ * @brief Asks the loop to exit; safe to call from any thread.
+ */
+void EventLoop::stop() {
+    _running = false;
+    _registry.wake(_shard);
+}
+
+TableHost& EventLoop::host() {
+    return _host;
+}
+
+/**
+ * @brief Accepts every pending client and registers it for reads.
+ */
+void EventLoop::acceptClients() {
+    while (true) {
+        int fd = accept4(_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // EAGAIN: another loop took it, or the backlog is empty
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // fails harmlessly on Unix sockets
+        auto conn = std::make_unique<Connection>();
+        conn->id = _next_connection++;
+        conn->fd = fd;
+        conn->sent = 0;
+        conn->waitingWrite = false;
+        conn->nextSequence = 0;
+        conn->flushSequence = 0;
+        conn->sharedSent = 0;
+        conn->touched = false;
+        conn->closing = false;
+        conn->in.reserve(READ_CHUNK);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = conn->id;
+        if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+        _connections[conn->id] = std::move(conn);
+    }
+}
+
+/**
+ * @brief Drains the socket and dispatches every complete frame.
+ *
+ * Replies are only queued; they are written after the loop pass has committed its
+ * log records, all replies of the connection with a single send.
+ */
+void EventLoop::onReadable(Connection& conn) {
+    std::uint64_t id = conn.id;
+    bool closed = false;
+    std::uint8_t chunk[READ_CHUNK];
+    while (true) {
+        ssize_t got = read(conn.fd, chunk, sizeof(chunk));
+        if (got > 0) {
+            conn.in.insert(conn.in.end(), chunk, chunk + got);
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closed = true;
+        }
+        break;
+    }
+
+    size_t offset = 0;
+    try {
+        while (true) {
+            size_t length = protocol::frameLength(conn.in.data() + offset, conn.in.size() - offset);
+            if (length == 0) break;
+            dispatch(conn, conn.in.data() + offset, length);
+            offset += length;
+        }
+    } catch (const std::exception&) {
+        // A corrupt length prefix leaves the stream unusable
+        closeConnection(id);
+        return;
+    }
+    conn.in.erase(conn.in.begin(), conn.in.begin() + static_cast<std::ptrdiff_t>(offset));
+
+    conn.closing = closed;
+    touch(conn);
+}
+
+/**
+ * @brief Answers a frame locally or forwards it to the shard that owns its table.
+ *
+ * Every frame gets a sequence number so replies leave in request order even when
+ * some of them come back from other shards.
+ */
+void EventLoop::dispatch(Connection& conn, const std::uint8_t* frame, size_t size) {
+    std::uint64_t sequence = conn.nextSequence++;
+    std::uint32_t owner = route(frame, size);
+    trackSubscription(conn, frame, size);
+
+    if (owner == _shard) {
+        Subscriber from{_shard, conn.id};
+        if (sequence == conn.flushSequence) {
+            _host.handle(frame, size, conn.out, from);
+            conn.flushSequence++;
+            drainParked(conn);
+        } else {
+            _scratch.clear();
+            _host.handle(frame, size, _scratch, from);
+            deliver(conn, sequence, _scratch.data(), _scratch.size());
+        }
+        return;
+    }
+
+    if (size > Envelope::CAPACITY) {
+        _scratch.clear();
+        protocol::encodeError(_scratch, 0, "Frame too large.");
+        deliver(conn, sequence, _scratch.data(), _scratch.size());
+        return;
+    }
+    // A full owner inbox only delays the request: it waits in _retry like a held reply
+    Envelope envelope;
+    envelope.kind = Envelope::Request;
+    envelope.origin = _shard;
+    envelope.connection = conn.id;
+    envelope.sequence = sequence;
+    envelope.size = static_cast<std::uint16_t>(size);
+    std::memcpy(envelope.bytes, frame, size);
+    sendEnvelope(owner, std::move(envelope));
+}
+
+/**
+ * @brief Queues a reply in request order: appended now if it is the next one, parked otherwise.
+ */
+void EventLoop::deliver(Connection& conn, std::uint64_t sequence, const std::uint8_t* bytes, size_t size) {
+    if (sequence == conn.flushSequence) {
+        conn.out.insert(conn.out.end(), bytes, bytes + size);
+        conn.flushSequence++;
+        drainParked(conn);
+        touch(conn);
+    } else {
+        conn.parked.emplace(sequence, std::vector<std::uint8_t>(bytes, bytes + size));
+    }
+}
+
+void EventLoop::drainParked(Connection& conn) {
+    auto it = conn.parked.begin();
+    while (it != conn.parked.end() && it->first == conn.flushSequence) {
+        conn.out.insert(conn.out.end(), it->second.begin(), it->second.end());
+        conn.flushSequence++;
+        it = conn.parked.erase(it);
+    }
+}
+
+/**
+ * @brief Handles everything other shards posted: requests for our tables, replies for
+ * our clients and spectator frames for our subscribers.
+ */
+void EventLoop::drainInbox() {
+    COUP_TRACE_SCOPE("EventLoop::drainInbox");
+    Envelope envelope;
+    while (_registry.poll(_shard, envelope)) {
+        if (envelope.kind == Envelope::Request) {
+            _scratch.clear();
+            _host.handle(envelope.bytes, envelope.size, _scratch, Subscriber{envelope.origin, envelope.connection});
+            if (_scratch.size() > Envelope::CAPACITY) {
+                _scratch.clear();
+                protocol::encodeError(_scratch, 0, "Reply too large.");
+            }
+            Envelope reply;
+            reply.kind = Envelope::Reply;
+            reply.origin = envelope.origin;
+            reply.connection = envelope.connection;
+            reply.sequence = envelope.sequence;
+            reply.size = static_cast<std::uint16_t>(_scratch.size());
+            std::memcpy(reply.bytes, _scratch.data(), _scratch.size());
+            _held.emplace_back(envelope.origin, std::move(reply));
+        } else if (envelope.kind == Envelope::Broadcast) {
+            size_t targets = envelope.size / sizeof(std::uint64_t);
+            for (size_t i = 0; i < targets; ++i) {
+                std::uint64_t connection;
+                std::memcpy(&connection, envelope.bytes + i * sizeof(connection), sizeof(connection));
+                enqueueShared(connection, envelope.shared);
+            }
+            envelope.shared.reset();
+        } else {
+            auto it = _connections.find(envelope.connection);
+            if (it == _connections.end()) {
+                continue; // client left while its request was away
+            }
+            deliver(*it->second, envelope.sequence, envelope.bytes, envelope.size);
+        }
+    }
+}
+
+/**
+ * @brief Posts an envelope to another shard, keeping it for a retry if that inbox is full.
+ */
+void EventLoop::sendEnvelope(std::uint32_t shard, Envelope&& envelope) {
+    if (_retry.empty() && _registry.post(shard, std::move(envelope))) {
+        return;
+    }
+    _retry.emplace_back(shard, std::move(envelope));
+}
+
+/**
+ * @brief Returns the shard that must handle a frame.
+ *
+ * Table operations go to the shard encoded in the table id; new tables are
+ * placed by the registry. Malformed frames stay local and get an error reply.
+ */
+std::uint32_t EventLoop::route(const std::uint8_t* frame, size_t size) const {
+    if (size < protocol::HEADER_SIZE + 1) {
+        return _shard;
+    }
+    protocol::Opcode op = static_cast<protocol::Opcode>(frame[protocol::HEADER_SIZE]);
+    if (op == protocol::Opcode::CreateTable) {
+        return _registry.placeTable(_shard);
+    }
+    if (size < protocol::HEADER_SIZE + 5) {
+        return _shard;
+    }
+    protocol::Reader reader(frame + protocol::HEADER_SIZE + 1, 4);
+    std::uint32_t owner = TableRegistry::shardOf(reader.u32());
+    return owner < _registry.shardCount() ? owner : _shard;
+}
+
+/**
+ * @brief Writes as much pending output as the socket accepts, replies and spectator frames
+ * together in one gathered write.
+ *
+ * Frames are never interleaved: a partly sent spectator frame is finished before
+ * any reply, and replies go before the spectator frames queued after them.
+ *
+ * @return false if the connection failed and must be closed.
+ */
+bool EventLoop::flush(Connection& conn) {
+    while (true) {
+        iovec iov[MAX_IOV];
+        int count = 0;
+        bool headFirst = conn.sharedSent > 0;
+        if (headFirst) {
+            const auto& head = *conn.shared.front();
+            iov[count++] = iovec{const_cast<std::uint8_t*>(head.data()) + conn.sharedSent, head.size() - conn.sharedSent};
+        }
+        size_t outLeft = conn.out.size() - conn.sent;
+        if (outLeft > 0) {
+            iov[count++] = iovec{conn.out.data() + conn.sent, outLeft};
+        }
+        for (size_t i = headFirst ? 1 : 0; i < conn.shared.size() && count < MAX_IOV; ++i) {
+            const auto& frame = *conn.shared[i];
+            iov[count++] = iovec{const_cast<std::uint8_t*>(frame.data()), frame.size()};
+        }
+        if (count == 0) {
+            break;
+        }
+
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t n = sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watchWrites(conn, true);
+                return true;
+            }
+            return false;
+        }
+
+        // Consume in the same order as the iovecs
+        size_t left = static_cast<size_t>(n);
+        if (headFirst) {
+            size_t rest = conn.shared.front()->size() - conn.sharedSent;
+            size_t take = left < rest ? left : rest;
+            conn.sharedSent += take;
+            left -= take;
+            if (take == rest) {
+                conn.shared.pop_front();
+                conn.sharedSent = 0;
+            }
+        }
+        size_t take = left < outLeft ? left : outLeft;
+        conn.sent += take;
+        left -= take;
+        if (conn.sent == conn.out.size()) {
+            conn.out.clear();
+            conn.sent = 0;
+        }
+        while (left > 0) {
+            size_t size = conn.shared.front()->size();
+            if (left < size) {
+                conn.sharedSent = left;
+                break;
+            }
+            conn.shared.pop_front();
+            left -= size;
+        }
+    }
+    conn.out.clear();
+    conn.sent = 0;
+    watchWrites(conn, false);
+    return true;
+}
+
+void EventLoop::watchWrites(Connection& conn, bool enable) {
+    if (conn.waitingWrite == enable) return;
+    conn.waitingWrite = enable;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (enable ? static_cast<std::uint32_t>(EPOLLOUT) : 0u);
+    ev.data.u64 = conn.id;
+    epoll_ctl(_epoll, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+/**
+ * @brief Closes a client and withdraws its subscriptions from the tables' owners.
+ */
+void EventLoop::closeConnection(std::uint64_t id) {
+    auto it = _connections.find(id);
+    if (it == _connections.end()) return;
+    std::vector<std::uint8_t> request;
+    for (std::uint32_t table : it->second->watching) {
+        request.clear();
+        protocol::Writer writer(request);
+        writer.begin(protocol::Opcode::Unsubscribe);
+        writer.u32(table);
+        writer.end();
+        std::uint32_t owner = route(request.data(), request.size());
+        if (owner == _shard) {
+            _scratch.clear();
+            _host.handle(request.data(), request.size(), _scratch, Subscriber{_shard, id});
+            continue;
+        }
+        // The owner's reply finds no connection and is dropped
+        Envelope envelope;
+        envelope.kind = Envelope::Request;
+        envelope.origin = _shard;
+        envelope.connection = id;
+        envelope.size = static_cast<std::uint16_t>(request.size());
+        std::memcpy(envelope.bytes, request.data(), request.size());
+        sendEnvelope(owner, std::move(envelope));
+    }
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, it->second->fd, nullptr);
+    close(it->second->fd);
+    _connections.erase(it);
+}
+
+/**
+ * @brief Remembers which tables a connection watches, so closing it can unsubscribe.
+ */
+void EventLoop::trackSubscription(Connection& conn, const std::uint8_t* frame, size_t size) {
+    if (size < protocol::HEADER_SIZE + 5) {
+        return;
+    }
+    protocol::Opcode op = static_cast<protocol::Opcode>(frame[protocol::HEADER_SIZE]);
+    if (op != protocol::Opcode::Subscribe && op != protocol::Opcode::Unsubscribe) {
+        return;
+    }
+    protocol::Reader reader(frame + protocol::HEADER_SIZE + 1, 4);
+    std::uint32_t table = reader.u32();
+    auto& watching = conn.watching;
+    for (size_t i = 0; i < watching.size(); ++i) {
+        if (watching[i] == table) {
+            if (op == protocol::Opcode::Unsubscribe) {
+                watching[i] = watching.back();
+                watching.pop_back();
+            }
+            return;
+        }
+    }
+    if (op == protocol::Opcode::Subscribe) {
+        watching.push_back(table);
+    }
+}
+
+/**
+ * @brief Starts the tick timer when tables changed, so all moves until it fires share one delta.
+ */
+void EventLoop::schedulePublish() {
+    if (_tick_armed || !_host.hasUpdates()) {
+        return;
+    }
+    if (_options.tickMillis == 0) {
+        publish();
+        return;
+    }
+    itimerspec spec{};
+    spec.it_value.tv_sec = _options.tickMillis / 1000;
+    spec.it_value.tv_nsec = static_cast<long>(_options.tickMillis % 1000) * 1000000L;
+    if (timerfd_settime(_timer, 0, &spec, nullptr) == 0) {
+        _tick_armed = true;
+    }
+}
+
+/**
+ * @brief Sends one tick's spectator deltas: local subscribers get the shared frame queued
+ * directly, subscribers on other shards get it through one Broadcast envelope per shard.
+ */
+void EventLoop::publish() {
+    COUP_TRACE_SCOPE("EventLoop::publish");
+    _host.publish([this](const protocol::SharedFrame& frame, const std::vector<Subscriber>& subscribers) {
+        for (const Subscriber& subscriber : subscribers) {
+            if (subscriber.shard == _shard) {
+                enqueueShared(subscriber.connection, frame);
+                continue;
+            }
+            Envelope& batch = _fanout[subscriber.shard];
+            std::memcpy(batch.bytes + batch.size, &subscriber.connection, sizeof(subscriber.connection));
+            batch.size = static_cast<std::uint16_t>(batch.size + sizeof(subscriber.connection));
+            if (batch.size / sizeof(std::uint64_t) == Envelope::MAX_TARGETS) {
+                batch.kind = Envelope::Broadcast;
+                batch.origin = _shard;
+                batch.shared = frame;
+                _held.emplace_back(subscriber.shard, std::move(batch));
+                batch = Envelope();
+            }
+        }
+        for (std::uint32_t shard = 0; shard < _fanout.size(); ++shard) {
+            Envelope& batch = _fanout[shard];
+            if (batch.size == 0) continue;
+            batch.kind = Envelope::Broadcast;
+            batch.origin = _shard;
+            batch.shared = frame;
+            _held.emplace_back(shard, std::move(batch));
+            batch = Envelope();
+        }
+    });
+}
+
+/**
+ * @brief Queues a spectator frame on a local connection; the bytes are shared, not copied.
+ */
+void EventLoop::enqueueShared(std::uint64_t connection, const protocol::SharedFrame& frame) {
+    auto it = _connections.find(connection);
+    if (it == _connections.end()) {
+        return; // spectator left; its unsubscribe is on the way
+    }
+    it->second->shared.push_back(frame);
+    touch(*it->second);
+}
+
+/**
+ * @brief Marks a connection as having output for the end of the loop pass.
+ */
+void EventLoop::touch(Connection& conn) {
+    if (!conn.touched) {
+        conn.touched = true;
+        _touched.push_back(conn.id);
+    }
+}
+
+void EventLoop::flushTouched() {
+    for (std::uint64_t id : _touched) {
+        auto it = _connections.find(id);
+        if (it == _connections.end()) continue;
+        it->second->touched = false;
+        if (!flush(*it->second) || it->second->closing) {
+            closeConnection(id);
+        }
+    }
+    _touched.clear();
+}
+
+/**
+ * @brief Ends a loop pass: makes the pass's log records durable with one commit
+ * (group commit over every table touched), then releases what they acknowledge,
+ * replies and spectator frames for other shards first, then local sockets.
+ * Every checkpointSeconds the log is also compacted into one snapshot per table;
+ * a checkpoint that fails is logged and tried again one interval later, the old
+ * log staying in use meanwhile.
+ *
+ * @throws std::runtime_error If the commit fails; nothing of the pass may then be
+ *         acknowledged, so the loop must stop.
+ */
+void EventLoop::commitPass() {
+    COUP_TRACE_SCOPE("EventLoop::commitPass");
+    if (_wal) {
+        _wal->commit();
+        auto now = std::chrono::steady_clock::now();
+        if (_options.checkpointSeconds > 0 && now - _last_checkpoint >= std::chrono::seconds(_options.checkpointSeconds)) {
+            try {
+                _host.checkpoint(*_wal);
+            } catch (const std::exception& e) {
+                std::cerr << "Loop " << _shard << ": checkpoint failed, keeping the log: " << e.what() << std::endl;
+            }
+            _last_checkpoint = now;
+        }
+    }
+    for (auto& held : _held) {
+        sendEnvelope(held.first, std::move(held.second));
+    }
+    _held.clear();
+    flushTouched();
+}
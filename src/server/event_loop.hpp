@@ -0,0 +1,99 @@
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "table_host.hpp"
+#include "table_registry.hpp"
+#include "wal.hpp"
+
+struct LoopOptions {
+    unsigned int tickMillis = 20;         // spectator delta batching period, 0 = every pass
+    std::string walPath;                  // write-ahead log of the shard, empty = no logging
+    unsigned int checkpointSeconds = 30;  // how often the log is rewritten as snapshots, 0 = never
+};
+
+// Single-threaded epoll loop for one shard: accepts clients on a shared listening socket,
+// reads length-prefixed frames, answers those for its own tables from its TableHost and
+// hands the others to the owning shard through the TableRegistry. Spectator deltas of its
+// tables are published once per tick and queued as shared buffers on every subscriber.
+// With a write-ahead log, nothing a pass acknowledges leaves before the pass's single commit.
+class EventLoop {
+public:
+    EventLoop(int listenFd, std::uint32_t shard, TableRegistry& registry,
+              const LoopOptions& options = LoopOptions());
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void run();
+    void stop();
+    TableHost& host();
+
+private:
+    struct Connection {
+        std::uint64_t id;
+        int fd;
+        std::vector<std::uint8_t> in;
+        std::vector<std::uint8_t> out;
+        size_t sent;
+        bool waitingWrite;
+        std::uint64_t nextSequence;   // next request number
+        std::uint64_t flushSequence;  // next reply allowed into out
+        std::map<std::uint64_t, std::vector<std::uint8_t>> parked; // replies that arrived early
+        std::deque<protocol::SharedFrame> shared; // spectator frames, sent after out
+        size_t sharedSent;                         // bytes of shared.front() already sent
+        bool touched;                              // queued in _touched for the next flush
+        bool closing;                              // peer hung up; close after the next flush
+        std::vector<std::uint32_t> watching;       // tables this connection subscribed to
+    };
+
+    void acceptClients();
+    void onReadable(Connection& conn);
+    void dispatch(Connection& conn, const std::uint8_t* frame, size_t size);
+    void deliver(Connection& conn, std::uint64_t sequence, const std::uint8_t* bytes, size_t size);
+    void drainParked(Connection& conn);
+    void drainInbox();
+    void sendEnvelope(std::uint32_t shard, Envelope&& envelope);
+    void trackSubscription(Connection& conn, const std::uint8_t* frame, size_t size);
+    void schedulePublish();
+    void publish();
+    void enqueueShared(std::uint64_t connection, const protocol::SharedFrame& frame);
+    void touch(Connection& conn);
+    void flushTouched();
+    void commitPass();
+    std::uint32_t route(const std::uint8_t* frame, size_t size) const;
+    bool flush(Connection& conn);
+    void watchWrites(Connection& conn, bool enable);
+    void closeConnection(std::uint64_t id);
+
+    int _epoll;
+    int _listen;
+    std::uint32_t _shard;
+    TableRegistry& _registry;
+    TableHost _host;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Connection>> _connections;
+    std::deque<std::pair<std::uint32_t, Envelope>> _retry; // envelopes waiting for room in a full inbox
+    std::vector<std::uint8_t> _scratch;
+    std::vector<Envelope> _fanout;         // per remote shard, spectators of one frame
+    std::vector<std::uint64_t> _touched;   // connections with new spectator frames
+    int _timer;
+    LoopOptions _options;
+    bool _tick_armed;
+    std::unique_ptr<WriteAheadLog> _wal;
+    std::chrono::steady_clock::time_point _last_checkpoint;
+    std::vector<std::pair<std::uint32_t, Envelope>> _held; // replies and broadcasts released by the next commit
+    std::uint64_t _next_connection;
+    std::atomic<bool> _running;
+};
+
+#endif // EVENT_LOOP_HPP
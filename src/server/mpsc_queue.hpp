@@ -0,0 +1,77 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Bounded lock-free multi-producer / single-consumer queue (sequence-numbered ring).
+// Any thread may push; only the owning thread may pop. Push fails instead of blocking when full.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity)
+        : _cells(new Cell[capacity]), _mask(capacity - 1), _tail(0), _head(0)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::runtime_error("Queue capacity must be a power of two.");
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Claims a slot with a CAS on the tail, then publishes it through the slot's sequence number
+    bool tryPush(T&& value) {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only
+    bool tryPop(T& value) {
+        Cell* cell = &_cells[_head & _mask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (seq != _head + 1) {
+            return false; // empty, or the producer has not published yet
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(_head + _mask + 1, std::memory_order_release);
+        ++_head;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _tail;
+    alignas(64) size_t _head;
+};
+
+#endif // MPSC_QUEUE_HPP
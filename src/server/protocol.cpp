@@ -0,0 +1,132 @@
+#include "protocol.hpp"
+#include "game.hpp"
+#include "engine/state_delta.hpp"
+#include <stdexcept>
+
+namespace protocol {
+
+Writer::Writer(std::vector<std::uint8_t>& out) : _out(out), _start(0) {}
+
+/**
+ * @brief Starts a frame; the length prefix is patched by end().
+ */
+void Writer::begin(Opcode op) {
+    _start = _out.size();
+    u16(0);
+    u8(static_cast<std::uint8_t>(op));
+}
+
+void Writer::u8(std::uint8_t value) {
+    _out.push_back(value);
+}
+
+void Writer::u16(std::uint16_t value) {
+    _out.push_back(static_cast<std::uint8_t>(value));
+    _out.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+void Writer::u32(std::uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        _out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void Writer::bytes(const void* data, size_t size) {
+    const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+    _out.insert(_out.end(), p, p + size);
+}
+
+/**
+ * @brief Finishes the current frame by writing its length prefix.
+ *
+ * @throws std::runtime_error If the frame is larger than MAX_FRAME.
+ */
+void Writer::end() {
+    size_t length = _out.size() - _start - HEADER_SIZE;
+    if (length > MAX_FRAME) {
+        throw std::runtime_error("Frame too large.");
+    }
+    _out[_start] = static_cast<std::uint8_t>(length);
+    _out[_start + 1] = static_cast<std::uint8_t>(length >> 8);
+}
+
+Reader::Reader(const std::uint8_t* data, size_t size) : _data(data), _size(size), _pos(0) {}
+
+std::uint8_t Reader::u8() {
+    if (_pos + 1 > _size) {
+        throw std::runtime_error("Truncated frame.");
+    }
+    return _data[_pos++];
+}
+
+std::uint16_t Reader::u16() {
+    std::uint16_t low = u8();
+    return static_cast<std::uint16_t>(low | (u8() << 8));
+}
+
+std::uint32_t Reader::u32() {
+    std::uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        value |= static_cast<std::uint32_t>(u8()) << shift;
+    }
+    return value;
+}
+
+size_t Reader::remaining() const {
+    return _size - _pos;
+}
+
+/**
+ * @brief Appends the compact state of a table (4 bytes per active player).
+ *
+ * @param writer Frame being built.
+ * @param game Table to encode.
+ */
+void encodeState(Writer& writer, const Game& game) {
+    size_t n = game.playerCount();
+    writer.u8(delta::statusBits(game));
+    writer.u8(n == 0 ? 0 : static_cast<std::uint8_t>(game.currentPlayerIndex()));
+    writer.u8(static_cast<std::uint8_t>(n));
+    for (size_t i = 0; i < n; ++i) {
+        const Player& p = game.playerAt(i);
+        writer.u8(static_cast<std::uint8_t>(p.getIndex()));
+        writer.u8(static_cast<std::uint8_t>(p.role()));
+        writer.u8(static_cast<std::uint8_t>(static_cast<std::int8_t>(p.getCoins())));
+        writer.u8(delta::seatFlags(p));
+    }
+}
+
+/**
+ * @brief Appends an Error frame carrying a short message (truncated to 255 bytes).
+ */
+void encodeError(std::vector<std::uint8_t>& out, std::uint32_t table, const std::string& message) {
+    Writer writer(out);
+    size_t length = message.size() < 255 ? message.size() : 255;
+    writer.begin(Opcode::Error);
+    writer.u32(table);
+    writer.u8(static_cast<std::uint8_t>(length));
+    writer.bytes(message.data(), length);
+    writer.end();
+}
+
+/**
+ * @brief Returns the size of the first complete frame in a buffer.
+ *
+ * @return size_t Header plus body size, or 0 if the frame is not complete yet.
+ * @throws std::runtime_error If the length prefix is invalid.
+ */
+size_t frameLength(const std::uint8_t* data, size_t size) {
+    if (size < HEADER_SIZE) {
+        return 0;
+    }
+    size_t length = static_cast<size_t>(data[0]) | (static_cast<size_t>(data[1]) << 8);
+    if (length == 0 || length > MAX_FRAME) {
+        throw std::runtime_error("Invalid frame length.");
+    }
+    if (size < HEADER_SIZE + length) {
+        return 0;
+    }
+    return HEADER_SIZE + length;
+}
+
+} // namespace protocol
@@ -0,0 +1,86 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine/move.hpp"
+
+class Game;
+
+// Wire format: every frame is [u16 length][u8 opcode][payload], length = 1 + payload size.
+// All integers are little endian.
+namespace protocol {
+
+constexpr size_t HEADER_SIZE = 2;
+constexpr size_t MAX_FRAME = 4096;
+
+enum class Opcode : std::uint8_t {
+    // client -> server
+    CreateTable = 0x01,   // u8 players, u32 seed [, u8 TableOptions]
+    Move = 0x02,          // u32 table, u8 action, u8 target
+    GetState = 0x03,      // u32 table
+    CloseTable = 0x04,    // u32 table
+    Subscribe = 0x05,     // u32 table: receive Delta frames for it
+    Unsubscribe = 0x06,   // u32 table
+    Respond = 0x07,       // u32 table, u8 block: answer to a BlockWindow
+    // server -> client
+    TableCreated = 0x81,  // u32 table, state
+    MoveApplied = 0x82,   // u32 table, state
+    State = 0x83,         // u32 table, state
+    TableClosed = 0x84,   // u32 table
+    Subscribed = 0x85,    // u32 table, state
+    Unsubscribed = 0x86,  // u32 table
+    Delta = 0x87,         // u32 table, u8 records, records (see engine/state_delta.hpp)
+    BlockWindow = 0x88,   // u32 table, u8 responder seat, u8 action: follows a reply while a block decision is pending
+    Error = 0xFF          // u32 table, u8 length, message
+};
+
+// Compact table state: u8 status bits, u8 current index, u8 players,
+// then per active player u8 seat, u8 role, i8 coins, u8 flags.
+enum StatusBits : std::uint8_t { STATUS_ACTIVE = 1, STATUS_BRIBE = 2 };
+enum PlayerFlags : std::uint8_t { FLAG_SANCTIONED = 1, FLAG_ARRESTED = 2, FLAG_CAN_ARREST = 4 };
+// TABLE_BLOCK_WINDOWS: tax / bribe / coup wait for Respond frames from the players who may block
+enum TableOptions : std::uint8_t { TABLE_BLOCK_WINDOWS = 1 };
+
+// Encoded once and queued on every subscriber's connection; never modified after creation
+using SharedFrame = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+class Writer {
+public:
+    explicit Writer(std::vector<std::uint8_t>& out);
+    void begin(Opcode op);
+    void u8(std::uint8_t value);
+    void u16(std::uint16_t value);
+    void u32(std::uint32_t value);
+    void bytes(const void* data, size_t size);
+    void end();
+
+private:
+    std::vector<std::uint8_t>& _out;
+    size_t _start;
+};
+
+class Reader {
+public:
+    Reader(const std::uint8_t* data, size_t size);
+    std::uint8_t u8();
+    std::uint16_t u16();
+    std::uint32_t u32();
+    size_t remaining() const;
+
+private:
+    const std::uint8_t* _data;
+    size_t _size;
+    size_t _pos;
+};
+
+void encodeState(Writer& writer, const Game& game);
+void encodeError(std::vector<std::uint8_t>& out, std::uint32_t table, const std::string& message);
+size_t frameLength(const std::uint8_t* data, size_t size);
+
+} // namespace protocol
+
+#endif // PROTOCOL_HPP
@@ -0,0 +1,179 @@
+#include "server.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Opens the listening socket and creates one event loop per configured core.
+ *
+ * @param config Listening address, number of loops, table placement and log directory.
+ * @throws std::runtime_error If the socket cannot be opened or a log cannot be recovered.
+ */
+CoupServer::CoupServer(const ServerConfig& config) : _config(config), _listen(-1), _registry(), _loops(), _threads(), _failed(false) {
+    if (_config.loops == 0) {
+        _config.loops = std::thread::hardware_concurrency();
+        if (_config.loops == 0) _config.loops = 1;
+    }
+    if (_config.loops > 255) {
+        throw std::runtime_error("At most 255 loops are supported.");
+    }
+    if (!_config.walDir.empty()) {
+        // Table ids carry their shard, so every existing log needs its loop back
+        for (size_t i = _config.loops; i < 256; ++i) {
+            if (access(walPath(i).c_str(), F_OK) == 0) {
+                throw std::runtime_error("Found a log for loop " + std::to_string(i) + "; start with at least " +
+                                         std::to_string(i + 1) + " loops.");
+            }
+        }
+    }
+    _listen = openListener();
+    _registry = std::make_unique<TableRegistry>(_config.loops, _config.spreadTables);
+    for (size_t i = 0; i < _config.loops; ++i) {
+        LoopOptions options;
+        options.tickMillis = _config.tickMillis;
+        options.walPath = _config.walDir.empty() ? std::string() : walPath(i);
+        options.checkpointSeconds = _config.checkpointSeconds;
+        _loops.push_back(std::make_unique<EventLoop>(_listen, static_cast<std::uint32_t>(i), *_registry, options));
+    }
+}
+
+/**
+ * @brief Stops the loops, joins their threads and removes the Unix socket file.
+ */
+CoupServer::~CoupServer() {
+    stop();
+    wait();
+    _loops.clear();
+    if (_listen >= 0) {
+        close(_listen);
+    }
+    if (!_config.unixPath.empty()) {
+        unlink(_config.unixPath.c_str());
+    }
+}
+
+/**
+ * @brief Starts one thread per loop, pinned to its own core when requested.
+ *
+ * A loop that stops on an error (a log it can no longer write, most often) takes the whole
+ * server down: every loop is stopped, failed() turns true and SIGTERM is raised, so the
+ * process exits instead of running on with one shard's clients and handoffs left hanging.
+ */
+void CoupServer::start() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    for (size_t i = 0; i < _loops.size(); ++i) {
+        EventLoop* loop = _loops[i].get();
+        _threads.emplace_back([this, loop, i]() {
+            try {
+                loop->run();
+            } catch (const std::exception& e) {
+                std::cerr << "Event loop " << i << " stopped: " << e.what() << "; stopping the server" << std::endl;
+                _failed = true;
+                stop();
+                kill(getpid(), SIGTERM);
+            }
+        });
+        if (_config.pinThreads && cores > 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % cores, &set);
+            pthread_setaffinity_np(_threads.back().native_handle(), sizeof(set), &set);
+        }
+    }
+}
+
+void CoupServer::stop() {
+    for (auto& loop : _loops) {
+        loop->stop();
+    }
+}
+
+void CoupServer::wait() {
+    for (auto& thread : _threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    _threads.clear();
+}
+
+/**
+ * @brief Log file of one loop inside the configured directory.
+ */
+std::string CoupServer::walPath(size_t loop) const {
+    return _config.walDir + "/shard-" + std::to_string(loop) + ".wal";
+}
+
+size_t CoupServer::loopCount() const {
+    return _loops.size();
+}
+
+/**
+ * @brief Whether a loop stopped on an error rather than through stop().
+ */
+bool CoupServer::failed() const {
+    return _failed;
+}
+
+/**
+ * @brief Creates the non-blocking listening socket (Unix if a path is set, TCP otherwise).
+ *
+ * @return int The listening descriptor.
+ * @throws std::runtime_error If socket, bind or listen fails.
+ */
+int CoupServer::openListener() {
+    int fd;
+    if (!_config.unixPath.empty()) {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (_config.unixPath.size() >= sizeof(addr.sun_path)) {
+            close(fd);
+            throw std::runtime_error("Unix socket path is too long.");
+        }
+        std::strcpy(addr.sun_path, _config.unixPath.c_str());
+        unlink(_config.unixPath.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            int err = errno;
+            close(fd);
+            throw std::runtime_error(std::string("bind: ") + std::strerror(err));
+        }
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_config.port);
+        if (inet_pton(AF_INET, _config.host.c_str(), &addr.sin_addr) != 1) {
+            close(fd);
+            throw std::runtime_error("Invalid listen address: " + _config.host);
+        }
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            int err = errno;
+            close(fd);
+            throw std::runtime_error(std::string("bind: ") + std::strerror(err));
+        }
+    }
+    if (listen(fd, SOMAXCONN) < 0) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error(std::string("listen: ") + std::strerror(err));
+    }
+    return fd;
+}
@@ -0,0 +1,52 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "event_loop.hpp"
+
+struct ServerConfig {
+    std::string unixPath;      // listen on a Unix socket when set
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 7777; // TCP port otherwise
+    size_t loops = 0;          // 0 = one loop per core
+    bool pinThreads = true;
+    bool spreadTables = false; // place new tables round robin over all loops
+    unsigned int tickMillis = 20; // spectator delta batching period
+    std::string walDir;        // write-ahead logs (one per loop) when set; tables are recovered at start
+    unsigned int checkpointSeconds = 30; // log compaction into table snapshots
+};
+
+// Hosts many Game tables: one epoll loop per core, each owning a shard of the tables.
+// Frames for a table owned by another loop are handed over through the TableRegistry.
+class CoupServer {
+public:
+    explicit CoupServer(const ServerConfig& config);
+    ~CoupServer();
+    CoupServer(const CoupServer&) = delete;
+    CoupServer& operator=(const CoupServer&) = delete;
+
+    void start();
+    void stop();
+    void wait();
+    size_t loopCount() const;
+    bool failed() const; // a loop stopped on an error and took the server down
+
+private:
+    int openListener();
+    std::string walPath(size_t loop) const;
+
+    ServerConfig _config;
+    int _listen;
+    std::unique_ptr<TableRegistry> _registry;
+    std::vector<std::unique_ptr<EventLoop>> _loops;
+    std::vector<std::thread> _threads;
+    std::atomic<bool> _failed;
+};
+
+#endif // SERVER_HPP
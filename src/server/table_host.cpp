@@ -0,0 +1,508 @@
+#include "table_host.hpp"
+#include "table_registry.hpp"
+#include "wal.hpp"
+#include "engine/snapshot.hpp"
+#include "protocol.hpp"
+#include "engine/move.hpp"
+#include "instrument/metrics.hpp"
+#include "instrument/trace.hpp"
+#include <stdexcept>
+#include <string>
+
+using protocol::Opcode;
+
+namespace {
+
+/**
+ * @brief Appends a Delta frame for a table; nothing if there are no records.
+ */
+void appendDelta(std::vector<std::uint8_t>& out, std::uint32_t table, const std::vector<std::uint8_t>& records) {
+    if (records.empty()) {
+        return;
+    }
+    protocol::Writer writer(out);
+    writer.begin(Opcode::Delta);
+    writer.u32(table);
+    writer.u8(static_cast<std::uint8_t>(records.size() / delta::RECORD_SIZE));
+    writer.bytes(records.data(), records.size());
+    writer.end();
+}
+
+/**
+ * @brief Appends a BlockWindow frame if the table's turn is waiting for a block decision.
+ */
+void appendBlockWindow(protocol::Writer& writer, std::uint32_t table, const TurnFlow* flow) {
+    if (!flow || !flow->waiting()) {
+        return;
+    }
+    writer.begin(Opcode::BlockWindow);
+    writer.u32(table);
+    writer.u8(static_cast<std::uint8_t>(flow->responder().getIndex()));
+    writer.u8(static_cast<std::uint8_t>(flow->move().action));
+    writer.end();
+}
+
+}
+
+/**
+ * @brief Creates an empty host for the given shard number.
+ *
+ * Table ids carry the shard in their top 8 bits, so any loop can tell where a table lives.
+ *
+ * @param shard Index of the loop that owns this host.
+ */
+TableHost::TableHost(std::uint32_t shard)
+    : _shard(shard), _next_id(1), _tables(), _dirty(), _closed(), _records(), _log(nullptr)
+{
+    _records.reserve(delta::RECORD_SIZE * (3 * moves::MAX_TABLE + 2));
+}
+
+/**
+ * @brief Decodes one request frame, runs it against the engine and appends the reply.
+ *
+ * Rule violations reported by the engine come back to the client as Error frames;
+ * a malformed frame is reported the same way. Moves on watched tables only mark the
+ * table; its spectators are served by publish(). On tables with block windows a move
+ * may leave the turn suspended in its TurnFlow; the reply is then followed by a
+ * BlockWindow frame and the table waits for Respond frames, holding no thread.
+ *
+ * @param frame Complete frame including its length prefix.
+ * @param size Frame size in bytes.
+ * @param out Connection output buffer that receives the reply frame.
+ * @param from Connection that sent the frame, recorded by Subscribe / Unsubscribe.
+ */
+void TableHost::handle(const std::uint8_t* frame, size_t size, std::vector<std::uint8_t>& out,
+                       const Subscriber& from) {
+    COUP_TRACE_SCOPE("TableHost::handle");
+    protocol::Reader reader(frame + protocol::HEADER_SIZE, size - protocol::HEADER_SIZE);
+    std::uint32_t table = 0;
+    size_t mark = out.size();
+    Opcode op = Opcode::Error;
+    bool counted = false;
+    try {
+        op = static_cast<Opcode>(reader.u8());
+        protocol::Writer writer(out);
+        switch (op) {
+            case Opcode::CreateTable: {
+                std::uint8_t players = reader.u8();
+                std::uint32_t seed = reader.u32();
+                std::uint8_t options = reader.remaining() > 0 ? reader.u8() : 0;
+                table = freeId();
+                Table& entry = createTable(table, players, seed, options);
+                _next_id = (table & 0xFFFFFF) + 1;
+                std::uint8_t body[] = {players, 0, 0, 0, 0, options};
+                for (int i = 0; i < 4; ++i) {
+                    body[1 + i] = static_cast<std::uint8_t>(seed >> (8 * i));
+                }
+                log(WriteAheadLog::RecordType::Create, table, body, sizeof(body));
+                writer.begin(Opcode::TableCreated);
+                writer.u32(table);
+                protocol::encodeState(writer, *entry.game);
+                writer.end();
+                break;
+            }
+            case Opcode::Move: {
+                table = reader.u32();
+                Move move;
+                move.action = static_cast<Action>(reader.u8());
+                move.target = reader.u8();
+                counted = true;
+                Table& entry = playCounted(table, move);
+                std::uint8_t body[] = {static_cast<std::uint8_t>(move.action), move.target};
+                log(WriteAheadLog::RecordType::Move, table, body, sizeof(body));
+                markDirty(table, entry);
+                writer.begin(Opcode::MoveApplied);
+                writer.u32(table);
+                protocol::encodeState(writer, *entry.game);
+                writer.end();
+                appendBlockWindow(writer, table, entry.flow.get());
+                break;
+            }
+            case Opcode::Respond: {
+                table = reader.u32();
+                bool block = reader.u8() != 0;
+                Table& entry = find(table);
+                if (!entry.flow) {
+                    throw std::runtime_error("Table has no block windows.");
+                }
+                entry.flow->respond(block);
+                std::uint8_t body[] = {static_cast<std::uint8_t>(block)};
+                log(WriteAheadLog::RecordType::Respond, table, body, sizeof(body));
+                markDirty(table, entry);
+                writer.begin(Opcode::State);
+                writer.u32(table);
+                protocol::encodeState(writer, *entry.game);
+                writer.end();
+                appendBlockWindow(writer, table, entry.flow.get());
+                break;
+            }
+            case Opcode::GetState: {
+                table = reader.u32();
+                Table& entry = find(table);
+                writer.begin(Opcode::State);
+                writer.u32(table);
+                protocol::encodeState(writer, *entry.game);
+                writer.end();
+                appendBlockWindow(writer, table, entry.flow.get());
+                break;
+            }
+            case Opcode::CloseTable: {
+                table = reader.u32();
+                Table& entry = find(table);
+                if (!entry.subscribers.empty()) {
+                    // Spectators get the last changes and the closing notice in one shared buffer
+                    auto notice = std::make_shared<std::vector<std::uint8_t>>();
+                    _records.clear();
+                    entry.diff.diff(*entry.game, _records);
+                    appendDelta(*notice, table, _records);
+                    protocol::Writer closing(*notice);
+                    closing.begin(Opcode::TableClosed);
+                    closing.u32(table);
+                    closing.end();
+                    _closed.push_back(Farewell{std::move(notice), std::move(entry.subscribers)});
+                }
+                _tables.erase(table);
+                log(WriteAheadLog::RecordType::Close, table, nullptr, 0);
+                writer.begin(Opcode::TableClosed);
+                writer.u32(table);
+                writer.end();
+                break;
+            }
+            case Opcode::Subscribe: {
+                table = reader.u32();
+                Table& entry = find(table);
+                if (entry.subscribers.empty()) {
+                    entry.diff.reset(*entry.game);
+                }
+                bool known = false;
+                for (const Subscriber& s : entry.subscribers) {
+                    known = known || s == from;
+                }
+                if (!known) {
+                    entry.subscribers.push_back(from);
+                }
+                writer.begin(Opcode::Subscribed);
+                writer.u32(table);
+                protocol::encodeState(writer, *entry.game);
+                writer.end();
+                break;
+            }
+            case Opcode::Unsubscribe: {
+                table = reader.u32();
+                Table& entry = find(table);
+                for (size_t i = 0; i < entry.subscribers.size(); ++i) {
+                    if (entry.subscribers[i] == from) {
+                        entry.subscribers[i] = entry.subscribers.back();
+                        entry.subscribers.pop_back();
+                        break;
+                    }
+                }
+                writer.begin(Opcode::Unsubscribed);
+                writer.u32(table);
+                writer.end();
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown opcode.");
+        }
+    } catch (const std::exception& e) {
+        if (op == Opcode::Move && !counted) {
+            metrics::recordRejected(Action::None, metrics::Refusal::Malformed);
+        }
+        out.resize(mark);
+        protocol::encodeError(out, table, e.what());
+    }
+}
+
+/**
+ * @brief Starts recording every table change in a write-ahead log.
+ *
+ * Records are only buffered here; the event loop commits them before any reply leaves.
+ *
+ * @param log Log of this shard, or nullptr to stop logging.
+ */
+void TableHost::attachLog(WriteAheadLog* log) {
+    _log = log;
+}
+
+/**
+ * @brief Rebuilds the tables of this shard by replaying a log through the rules engine.
+ *
+ * Tables start from their last checkpoint snapshot (or are recreated from their seed)
+ * and every move logged after it is applied again, so the recovered games are the
+ * ones that were acknowledged before the crash.
+ *
+ * @param log Log of this shard, not yet attached.
+ * @return size_t Number of records replayed.
+ * @throws std::runtime_error If the log belongs to another shard or does not match the rules.
+ */
+size_t TableHost::recover(WriteAheadLog& log) {
+    return log.replay([this](const WriteAheadLog::Record& record) {
+        if (TableRegistry::shardOf(record.table) != _shard) {
+            throw std::runtime_error("Log record for a table of another shard.");
+        }
+        protocol::Reader body(record.body, record.size);
+        switch (record.type) {
+            case WriteAheadLog::RecordType::Create: {
+                std::uint8_t players = body.u8();
+                std::uint32_t seed = body.u32();
+                std::uint8_t options = body.u8();
+                createTable(record.table, players, seed, options);
+                std::uint32_t next = (record.table & 0xFFFFFF) + 1;
+                if (next > _next_id) {
+                    _next_id = next;
+                }
+                break;
+            }
+            case WriteAheadLog::RecordType::Move: {
+                Move move;
+                move.action = static_cast<Action>(body.u8());
+                move.target = body.u8();
+                play(find(record.table), move);
+                break;
+            }
+            case WriteAheadLog::RecordType::Respond: {
+                Table& entry = find(record.table);
+                if (!entry.flow) {
+                    throw std::runtime_error("Logged response for a table without block windows.");
+                }
+                entry.flow->respond(body.u8() != 0);
+                break;
+            }
+            case WriteAheadLog::RecordType::Close:
+                _tables.erase(record.table);
+                break;
+            case WriteAheadLog::RecordType::Snapshot: {
+                std::uint8_t options = body.u8();
+                size_t flowSize = body.u16();
+                if (flowSize + 3 > record.size) {
+                    throw std::runtime_error("Corrupt snapshot record.");
+                }
+                const std::uint8_t* flow = record.body + 3;
+                const std::uint8_t* image = flow + flowSize;
+                Table& entry = _tables[record.table];
+                if (!entry.game) {
+                    entry.game = std::make_unique<Game>(0);
+                }
+                Snapshot::read(*entry.game, image, record.size - 3 - flowSize);
+                entry.options = options;
+                entry.flow.reset();
+                if (options & protocol::TABLE_BLOCK_WINDOWS) {
+                    entry.flow = std::make_unique<TurnFlow>(*entry.game);
+                    entry.flow->load(flow, flowSize);
+                }
+                std::uint32_t next = (record.table & 0xFFFFFF) + 1;
+                if (next > _next_id) {
+                    _next_id = next;
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown log record.");
+        }
+    });
+}
+
+/**
+ * @brief Rewrites a log as one Snapshot record per live table.
+ *
+ * After this, recovery loads each table from its image instead of replaying its
+ * whole history.
+ *
+ * @param log Log of this shard.
+ */
+void TableHost::checkpoint(WriteAheadLog& log) {
+    std::vector<std::uint8_t> body;
+    log.checkpoint([&](WriteAheadLog& fresh) {
+        for (const auto& entry : _tables) {
+            const Table& table = entry.second;
+            body.assign({table.options, 0, 0});
+            if (table.flow) {
+                table.flow->save(body);
+            }
+            size_t flowSize = body.size() - 3;
+            body[1] = static_cast<std::uint8_t>(flowSize);
+            body[2] = static_cast<std::uint8_t>(flowSize >> 8);
+            Snapshot::write(*table.game, body);
+            fresh.append(WriteAheadLog::RecordType::Snapshot, entry.first, body.data(), body.size());
+        }
+    });
+}
+
+/**
+ * @brief Whether publish() has anything to send.
+ */
+bool TableHost::hasUpdates() const {
+    return !_dirty.empty() || !_closed.empty();
+}
+
+/**
+ * @brief Encodes one Delta frame per changed, watched table and hands it to the sink.
+ *
+ * Called once per network tick: every move made on a table since the previous tick
+ * is folded into a single frame, which is encoded once and shared by all of the
+ * table's spectators.
+ *
+ * @param sink Receives each frame with the subscribers that must get it.
+ * @return size_t Number of frames handed out.
+ */
+size_t TableHost::publish(const Sink& sink) {
+    size_t frames = 0;
+    for (std::uint32_t id : _dirty) {
+        auto it = _tables.find(id);
+        if (it == _tables.end()) {
+            continue; // closed since it was marked
+        }
+        Table& entry = it->second;
+        entry.dirty = false;
+        if (entry.subscribers.empty()) {
+            continue;
+        }
+        _records.clear();
+        if (entry.diff.diff(*entry.game, _records) == 0) {
+            continue;
+        }
+        auto frame = std::make_shared<std::vector<std::uint8_t>>();
+        frame->reserve(protocol::HEADER_SIZE + 6 + _records.size());
+        appendDelta(*frame, id, _records);
+        sink(frame, entry.subscribers);
+        ++frames;
+    }
+    _dirty.clear();
+    for (const Farewell& farewell : _closed) {
+        sink(farewell.frame, farewell.subscribers);
+        ++frames;
+    }
+    _closed.clear();
+    return frames;
+}
+
+size_t TableHost::tableCount() const {
+    return _tables.size();
+}
+
+std::uint32_t TableHost::shard() const {
+    return _shard;
+}
+
+/**
+ * @brief Looks up a table owned by this host.
+ *
+ * @throws std::runtime_error If the table does not exist here.
+ */
+TableHost::Table& TableHost::find(std::uint32_t table) {
+    auto it = _tables.find(table);
+    if (it == _tables.end()) {
+        if (TableRegistry::shardOf(table) != _shard) {
+            throw std::runtime_error("Table is hosted by another loop.");
+        }
+        throw std::runtime_error("No such table.");
+    }
+    return it->second;
+}
+
+/**
+ * @brief Creates a table with the standard player names "p0".."pN-1".
+ *
+ * @throws std::runtime_error If the table size is out of range.
+ */
+TableHost::Table& TableHost::createTable(std::uint32_t id, std::uint8_t players, std::uint32_t seed,
+                                         std::uint8_t options) {
+    if (players < 2 || players > moves::MAX_TABLE) {
+        throw std::runtime_error("Table size must be between 2 and 16.");
+    }
+    std::vector<std::string> names;
+    for (std::uint8_t i = 0; i < players; ++i) {
+        names.push_back("p" + std::to_string(i));
+    }
+    Table& entry = _tables[id];
+    entry.game = Game::fromRoster(names, seed);
+    entry.options = options;
+    if (options & protocol::TABLE_BLOCK_WINDOWS) {
+        entry.flow = std::make_unique<TurnFlow>(*entry.game);
+    }
+    return entry;
+}
+
+/**
+ * @brief The id the next table of this shard gets: the low 24 bits count up from _next_id and wrap
+ * around, skipping 0 and the ids of tables that are still open.
+ *
+ * @throws std::runtime_error If every id of the shard belongs to an open table.
+ */
+std::uint32_t TableHost::freeId() const {
+    std::uint32_t next = _next_id;
+    for (std::uint32_t tried = 0; tried <= 0xFFFFFF; ++tried, ++next) {
+        std::uint32_t id = (_shard << 24) | (next & 0xFFFFFF);
+        if ((next & 0xFFFFFF) != 0 && _tables.find(id) == _tables.end()) {
+            return id;
+        }
+    }
+    throw std::runtime_error("No free table id on this shard.");
+}
+
+/**
+ * @brief Applies a move, through the table's TurnFlow when it has block windows.
+ */
+void TableHost::play(Table& table, const Move& move) {
+    if (table.flow) {
+        table.flow->begin(move);
+    } else {
+        moves::apply(*table.game, move);
+    }
+}
+
+/**
+ * @brief Plays a client's move and counts it in the metrics, applied or rejected.
+ *
+ * The reason of a rejection is only worked out on the failure path, so an applied
+ * move costs two clock reads and a few uncontended stores.
+ *
+ * @param id Table the move is for.
+ * @param move The move.
+ * @return Table& The table, after the move.
+ * @throws std::runtime_error If the table does not exist or the rules refuse the move.
+ */
+TableHost::Table& TableHost::playCounted(std::uint32_t id, const Move& move) {
+    auto it = _tables.find(id);
+    if (it == _tables.end()) {
+        metrics::recordRejected(move.action, metrics::Refusal::UnknownTable);
+        return find(id); // throws with the right message
+    }
+    Table& entry = it->second;
+    std::uint64_t start = metrics::nowNanos();
+    try {
+        play(entry, move);
+    } catch (const std::exception&) {
+        if (entry.flow && entry.flow->waiting()) {
+            metrics::recordRejected(move.action, metrics::Refusal::BlockPending);
+        } else {
+            moves::Reject reason = moves::rejectReason(*entry.game, move);
+            if (reason == moves::Reject::None) {
+                metrics::recordRejected(move.action, metrics::Refusal::Other);
+            } else {
+                metrics::recordRejected(move.action, reason);
+            }
+        }
+        throw;
+    }
+    metrics::recordApplied(move.action, metrics::nowNanos() - start);
+    return entry;
+}
+
+void TableHost::log(WriteAheadLog::RecordType type, std::uint32_t table, const std::uint8_t* body, size_t size) {
+    if (_log) {
+        _log->append(type, table, body, size);
+    }
+}
+
+/**
+ * @brief Queues a watched table for the next publish; unwatched tables cost nothing.
+ */
+void TableHost::markDirty(std::uint32_t id, Table& table) {
+    if (table.subscribers.empty() || table.dirty) {
+        return;
+    }
+    table.dirty = true;
+    _dirty.push_back(id);
+}
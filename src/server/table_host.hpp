@@ -0,0 +1,73 @@
+#ifndef TABLE_HOST_HPP
+#define TABLE_HOST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "game.hpp"
+#include "engine/state_delta.hpp"
+#include "engine/turn_flow.hpp"
+#include "protocol.hpp"
+#include "wal.hpp"
+
+// A spectator: a connection, identified inside the shard that owns it
+struct Subscriber {
+    std::uint32_t shard;
+    std::uint64_t connection;
+
+    bool operator==(const Subscriber& other) const { return shard == other.shard && connection == other.connection; }
+};
+
+// Owns the tables of one event loop and answers protocol frames for them.
+// A host is only ever touched by the thread running its loop.
+class TableHost {
+public:
+    using Sink = std::function<void(const protocol::SharedFrame&, const std::vector<Subscriber>&)>;
+
+    explicit TableHost(std::uint32_t shard);
+
+    void handle(const std::uint8_t* frame, size_t size, std::vector<std::uint8_t>& out,
+                const Subscriber& from = Subscriber{0, 0});
+    void attachLog(WriteAheadLog* log);
+    size_t recover(WriteAheadLog& log);
+    void checkpoint(WriteAheadLog& log);
+    bool hasUpdates() const;
+    size_t publish(const Sink& sink);
+    size_t tableCount() const;
+    std::uint32_t shard() const;
+
+private:
+    struct Table {
+        std::unique_ptr<Game> game;
+        std::unique_ptr<TurnFlow> flow; // only for tables created with block windows
+        StateDiff diff;
+        std::vector<Subscriber> subscribers;
+        std::uint8_t options = 0;
+        bool dirty = false;
+    };
+    struct Farewell {
+        protocol::SharedFrame frame;
+        std::vector<Subscriber> subscribers;
+    };
+
+    Table& find(std::uint32_t table);
+    std::uint32_t freeId() const;
+    Table& createTable(std::uint32_t id, std::uint8_t players, std::uint32_t seed, std::uint8_t options);
+    void play(Table& table, const Move& move);
+    Table& playCounted(std::uint32_t id, const Move& move);
+    void log(WriteAheadLog::RecordType type, std::uint32_t table, const std::uint8_t* body, size_t size);
+    void markDirty(std::uint32_t id, Table& table);
+
+    std::uint32_t _shard;
+    std::uint32_t _next_id;                // low 24 bits of the next table id to try
+    std::unordered_map<std::uint32_t, Table> _tables;
+    std::vector<std::uint32_t> _dirty;     // watched tables changed since the last publish
+    std::vector<Farewell> _closed;         // TableClosed notices for spectators of closed tables
+    std::vector<std::uint8_t> _records;
+    WriteAheadLog* _log;                   // owned by the event loop, may be null
+};
+
+#endif // TABLE_HOST_HPP
@@ -0,0 +1,96 @@
+#include "table_registry.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/**
+ * @brief Creates one inbox and one wake-up eventfd per shard.
+ *
+ * @param shards Number of shards (one per event loop / core), at most 255.
+ * @param spreadTables Place new tables round robin over all shards instead of on the creating shard.
+ * @param inboxCapacity Slots per inbox, a power of two.
+ * @throws std::runtime_error If an eventfd cannot be created.
+ */
+TableRegistry::TableRegistry(size_t shards, bool spreadTables, size_t inboxCapacity)
+    : _shards(), _spread(spreadTables), _next(0)
+{
+    if (shards == 0 || shards > 255) {
+        throw std::runtime_error("Shard count must be between 1 and 255.");
+    }
+    for (size_t i = 0; i < shards; ++i) {
+        auto shard = std::make_unique<Shard>(inboxCapacity);
+        shard->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (shard->wakeFd < 0) {
+            throw std::runtime_error(std::string("eventfd: ") + std::strerror(errno));
+        }
+        _shards.push_back(std::move(shard));
+    }
+}
+
+TableRegistry::~TableRegistry() {
+    for (auto& shard : _shards) {
+        if (shard->wakeFd >= 0) {
+            close(shard->wakeFd);
+        }
+    }
+}
+
+size_t TableRegistry::shardCount() const {
+    return _shards.size();
+}
+
+/**
+ * @brief Chooses the shard that will own a new table.
+ *
+ * By default a table stays on the shard of the connection that created it,
+ * which keeps the common single-connection case free of handoffs.
+ *
+ * @param localShard Shard of the creating connection.
+ * @return std::uint32_t Owning shard.
+ */
+std::uint32_t TableRegistry::placeTable(std::uint32_t localShard) {
+    if (!_spread) {
+        return localShard;
+    }
+    return _next.fetch_add(1, std::memory_order_relaxed) % static_cast<std::uint32_t>(_shards.size());
+}
+
+/**
+ * @brief Hands an envelope to another shard and wakes it.
+ *
+ * @return false if the target inbox is full; the caller decides how to back off.
+ */
+bool TableRegistry::post(std::uint32_t shard, Envelope&& envelope) {
+    if (!_shards[shard]->inbox.tryPush(std::move(envelope))) {
+        return false;
+    }
+    wake(shard);
+    return true;
+}
+
+/**
+ * @brief Pops the next envelope for a shard; only that shard's thread may call this.
+ */
+bool TableRegistry::poll(std::uint32_t shard, Envelope& envelope) {
+    return _shards[shard]->inbox.tryPop(envelope);
+}
+
+void TableRegistry::wake(std::uint32_t shard) {
+    std::uint64_t one = 1;
+    ssize_t written = write(_shards[shard]->wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+int TableRegistry::wakeFd(std::uint32_t shard) const {
+    return _shards[shard]->wakeFd;
+}
+
+/**
+ * @brief Shard number encoded in the top 8 bits of a table id.
+ */
+std::uint32_t TableRegistry::shardOf(std::uint32_t table) {
+    return table >> 24;
+}
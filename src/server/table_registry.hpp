@@ -0,0 +1,60 @@
+#ifndef TABLE_REGISTRY_HPP
+#define TABLE_REGISTRY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "mpsc_queue.hpp"
+#include "protocol.hpp"
+
+// A request or reply frame handed from one shard to another.
+// Frames are copied inline so the handoff never allocates. A Broadcast carries a
+// shared spectator frame instead, with the target connection ids (u64 each) in bytes.
+struct Envelope {
+    static constexpr size_t CAPACITY = 320;
+    static constexpr size_t MAX_TARGETS = CAPACITY / sizeof(std::uint64_t);
+    enum Kind : std::uint8_t { Request, Reply, Broadcast };
+
+    Kind kind = Request;
+    std::uint32_t origin = 0;       // shard that owns the client connection
+    std::uint64_t connection = 0;   // connection id inside the origin shard
+    std::uint64_t sequence = 0;     // request order on that connection
+    std::uint16_t size = 0;
+    std::uint8_t bytes[CAPACITY];
+    protocol::SharedFrame shared;
+};
+
+// Maps tables to shards and carries frames between shards.
+// Every Game lives in exactly one shard and is only touched by that shard's thread;
+// other shards reach it by posting to the owner's lock-free inbox and waking its eventfd.
+class TableRegistry {
+public:
+    TableRegistry(size_t shards, bool spreadTables, size_t inboxCapacity = 4096);
+    ~TableRegistry();
+    TableRegistry(const TableRegistry&) = delete;
+    TableRegistry& operator=(const TableRegistry&) = delete;
+
+    size_t shardCount() const;
+    std::uint32_t placeTable(std::uint32_t localShard);
+    bool post(std::uint32_t shard, Envelope&& envelope);
+    bool poll(std::uint32_t shard, Envelope& envelope);
+    void wake(std::uint32_t shard);
+    int wakeFd(std::uint32_t shard) const;
+
+    static std::uint32_t shardOf(std::uint32_t table);
+
+private:
+    struct Shard {
+        explicit Shard(size_t capacity) : inbox(capacity), wakeFd(-1) {}
+        MpscQueue<Envelope> inbox;
+        int wakeFd;
+    };
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    bool _spread;
+    std::atomic<std::uint32_t> _next;
+};
+
+#endif // TABLE_REGISTRY_HPP
@@ -0,0 +1,237 @@
+#include "wal.hpp"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t RECORD_HEADER = 8;       // size, crc
+constexpr size_t RECORD_PREFIX = 5;       // type, table
+constexpr size_t MAX_RECORD = 1 << 20;
+
+std::array<std::uint32_t, 256> makeCrcTable() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+std::uint32_t crc32(const std::uint8_t* data, size_t size) {
+    static const std::array<std::uint32_t, 256> table = makeCrcTable();
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+void putU32(std::uint8_t* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+[[noreturn]] void throwErrno(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}
+
+/**
+ * @brief Opens (or creates) a log file for appending.
+ *
+ * @param path Log file; its directory must exist.
+ * @throws std::runtime_error If the file cannot be opened.
+ */
+WriteAheadLog::WriteAheadLog(const std::string& path) : _fd(-1), _path(path), _buffer(), _commits(0) {
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        throwErrno("open " + path);
+    }
+    _buffer.reserve(64 * 1024);
+}
+
+/**
+ * @brief Commits anything still buffered and closes the file.
+ */
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        commit();
+    } catch (const std::exception&) {
+        // Nothing sensible to do while shutting down; the records were never acknowledged
+    }
+    close(_fd);
+}
+
+/**
+ * @brief Reads the whole log from the start and hands every intact record to a visitor.
+ *
+ * A torn or corrupt tail (a crash in the middle of a commit) is cut off, so new records
+ * are appended right after the last good one. Call this once, before any append().
+ *
+ * @param visit Called for every record, in log order; the body is only valid during the call.
+ * @return size_t Number of records replayed.
+ * @throws std::runtime_error If the file cannot be read or truncated.
+ */
+size_t WriteAheadLog::replay(const std::function<void(const Record&)>& visit) {
+    struct stat info{};
+    if (fstat(_fd, &info) < 0) {
+        throwErrno("fstat " + _path);
+    }
+    std::vector<std::uint8_t> data(static_cast<size_t>(info.st_size));
+    size_t got = 0;
+    while (got < data.size()) {
+        ssize_t n = pread(_fd, data.data() + got, data.size() - got, static_cast<off_t>(got));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throwErrno("read " + _path);
+        got += static_cast<size_t>(n);
+    }
+
+    size_t offset = 0;
+    size_t records = 0;
+    while (offset + RECORD_HEADER <= data.size()) {
+        std::uint32_t size = getU32(data.data() + offset);
+        std::uint32_t crc = getU32(data.data() + offset + 4);
+        const std::uint8_t* payload = data.data() + offset + RECORD_HEADER;
+        if (size < RECORD_PREFIX || size > MAX_RECORD || offset + RECORD_HEADER + size > data.size() ||
+            crc32(payload, size) != crc) {
+            break;
+        }
+        Record record{static_cast<RecordType>(payload[0]), getU32(payload + 1),
+                      payload + RECORD_PREFIX, size - RECORD_PREFIX};
+        visit(record);
+        offset += RECORD_HEADER + size;
+        ++records;
+    }
+
+    if (offset != data.size() && ftruncate(_fd, static_cast<off_t>(offset)) < 0) {
+        throwErrno("ftruncate " + _path);
+    }
+    if (lseek(_fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+        throwErrno("lseek " + _path);
+    }
+    return records;
+}
+
+/**
+ * @brief Buffers one record; nothing reaches the disk until commit().
+ */
+void WriteAheadLog::append(RecordType type, std::uint32_t table, const std::uint8_t* body, size_t size) {
+    size_t start = _buffer.size();
+    _buffer.resize(start + RECORD_HEADER + RECORD_PREFIX + size);
+    std::uint8_t* out = _buffer.data() + start;
+    putU32(out, static_cast<std::uint32_t>(RECORD_PREFIX + size));
+    out[RECORD_HEADER] = static_cast<std::uint8_t>(type);
+    putU32(out + RECORD_HEADER + 1, table);
+    if (size > 0) {
+        std::memcpy(out + RECORD_HEADER + RECORD_PREFIX, body, size);
+    }
+    putU32(out + 4, crc32(out + RECORD_HEADER, RECORD_PREFIX + size));
+}
+
+bool WriteAheadLog::pending() const {
+    return !_buffer.empty();
+}
+
+/**
+ * @brief Makes every buffered record durable with one write and one fdatasync.
+ *
+ * @throws std::runtime_error If the write or the sync fails; the records must then
+ *         be treated as lost and must not be acknowledged. The bytes that did reach
+ *         the file are dropped from the buffer, so a later commit does not write them twice.
+ */
+void WriteAheadLog::commit() {
+    if (_buffer.empty()) {
+        return;
+    }
+    size_t written = 0;
+    while (written < _buffer.size()) {
+        ssize_t n = write(_fd, _buffer.data() + written, _buffer.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            int err = errno;
+            _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(written));
+            errno = err;
+            throwErrno("write " + _path);
+        }
+        written += static_cast<size_t>(n);
+    }
+    if (fdatasync(_fd) < 0) {
+        _buffer.clear();
+        throwErrno("fdatasync " + _path);
+    }
+    _buffer.clear();
+    ++_commits;
+}
+
+/**
+ * @brief Replaces the log with the records written by fill, atomically.
+ *
+ * Pending records are committed first. fill appends the new content (normally one
+ * Snapshot record per live table); it is written to a temporary file, synced, and
+ * renamed over the log, so a crash at any point leaves either the old or the new log.
+ *
+ * @param fill Appends the records of the new log.
+ * @throws std::runtime_error If the new log cannot be written; the old one stays in use.
+ */
+void WriteAheadLog::checkpoint(const std::function<void(WriteAheadLog&)>& fill) {
+    commit();
+    std::string temporary = _path + ".tmp";
+    int fd = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throwErrno("open " + temporary);
+    }
+    int old = _fd;
+    _fd = fd;
+    try {
+        fill(*this);
+        commit();
+    } catch (const std::exception&) {
+        _buffer.clear();
+        _fd = old;
+        close(fd);
+        unlink(temporary.c_str());
+        throw;
+    }
+    if (rename(temporary.c_str(), _path.c_str()) < 0) {
+        int err = errno;
+        _fd = old;
+        close(fd);
+        errno = err;
+        throwErrno("rename " + temporary);
+    }
+    close(old);
+
+    // Make the rename itself durable
+    std::string directory = _path.find('/') == std::string::npos ? "." : _path.substr(0, _path.rfind('/'));
+    int dir = open(directory.empty() ? "/" : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+}
+
+std::uint64_t WriteAheadLog::commits() const {
+    return _commits;
+}
+
+const std::string& WriteAheadLog::path() const {
+    return _path;
+}
@@ -0,0 +1,53 @@
+#ifndef WAL_HPP
+#define WAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Append-only write-ahead log of the changes applied to the tables of one shard.
+// Record: [u32 size][u32 crc32][u8 type][u32 table][body], size counting type, table and body.
+// append() only buffers; commit() writes everything buffered since the previous commit with
+// one write and one fdatasync, so one disk flush covers every table touched in a loop pass.
+// checkpoint() replaces the whole log with one snapshot record per live table, which bounds
+// both the file size and the replay time after a crash.
+class WriteAheadLog {
+public:
+    enum class RecordType : std::uint8_t {
+        Create = 1,    // u8 players, u32 seed, u8 options
+        Move = 2,      // u8 action, u8 target
+        Respond = 3,   // u8 block
+        Close = 4,     // empty
+        Snapshot = 5   // u8 options, u16 flow size, TurnFlow::save bytes, Snapshot::write image
+    };
+
+    struct Record {
+        RecordType type;
+        std::uint32_t table;
+        const std::uint8_t* body;
+        size_t size;
+    };
+
+    explicit WriteAheadLog(const std::string& path);
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    size_t replay(const std::function<void(const Record&)>& visit);
+    void append(RecordType type, std::uint32_t table, const std::uint8_t* body, size_t size);
+    bool pending() const;
+    void commit();
+    void checkpoint(const std::function<void(WriteAheadLog&)>& fill);
+    std::uint64_t commits() const;
+    const std::string& path() const;
+
+private:
+    int _fd;
+    std::string _path;
+    std::vector<std::uint8_t> _buffer;
+    std::uint64_t _commits;
+};
+
+#endif // WAL_HPP
@@ -0,0 +1,1522 @@
+#include "doctest.h"
+#include "game.hpp"
+#include "ai/bot.hpp"
+#include "ai/cfr.hpp"
+#include "ai/coin_belief.hpp"
+#include "ai/mcts.hpp"
+#include "ai/role_sweep.hpp"
+#include "ai/search.hpp"
+#include "engine/perft.hpp"
+#include "engine/differential.hpp"
+#include "ai/tablebase.hpp"
+#include "engine/lockstep.hpp"
+#include "engine/move.hpp"
+#include "engine/state_delta.hpp"
+#include "engine/turn_flow.hpp"
+#include "engine/snapshot.hpp"
+#include "roles/player_factory.hpp"
+#include "instrument/alloc_scope.hpp"
+#include "instrument/metrics.hpp"
+#include "instrument/trace.hpp"
+#include "server/protocol.hpp"
+#include "server/table_host.hpp"
+#include "server/table_registry.hpp"
+#include "server/wal.hpp"
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+
+TEST_CASE("Move generation") {
+    Game game(42);
+    game.add_player("Alice");
+    game.add_player("Bob");
+    game.add_player("Charlie");
+    Move legal[moves::MAX_MOVES];
+
+    SUBCASE("Seeded games get the same roles") {
+        Game other(42);
+        other.add_player("Alice");
+        other.add_player("Bob");
+        other.add_player("Charlie");
+        for (size_t i = 0; i < 3; ++i) {
+            CHECK(game.playerAt(i).role() == other.playerAt(i).role());
+            CHECK(game.playerAt(i).get_type() == other.playerAt(i).get_type());
+        }
+    }
+
+    SUBCASE("Must coup with 10 coins") {
+        game.playerAt(0).setCoins(10);
+        size_t count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+        CHECK(count >= 2);
+        for (size_t i = 0; i < count; ++i) {
+            bool coupOrSpy = legal[i].action == Action::Coup ||
+                             (legal[i].action == Action::Ability && game.playerAt(0).role() == Role::Spy);
+            CHECK(coupOrSpy);
+        }
+    }
+
+    SUBCASE("Sanctioned player without coins passes") {
+        game.playerAt(0).setCoins(0);
+        game.playerAt(0).setSanctioned(true);
+        game.playerAt(1).setCoins(0);
+        game.playerAt(2).setCoins(0);
+        if (game.playerAt(0).role() == Role::Spy) {
+            game.playerAt(0).setAction(Action::Ability); // already looked this turn
+        }
+        size_t count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+        REQUIRE(count == 1);
+        CHECK(legal[0].action == Action::None);
+        moves::apply(game, legal[0]);
+        CHECK(game.turn() == "Bob");
+    }
+
+    SUBCASE("Pass is refused when an action exists") {
+        CHECK_THROWS_AS(moves::apply(game, Move{Action::None, Move::NO_TARGET}), std::runtime_error);
+        CHECK_THROWS_AS(moves::apply(game, Move{Action::Arrest, 0}), std::runtime_error); // self
+        CHECK_THROWS_AS(moves::apply(game, Move{Action::Coup, 7}), std::runtime_error);   // out of range
+    }
+
+    SUBCASE("Every generated move is accepted by the engine") {
+        std::mt19937 rng(7);
+        for (int step = 0; step < 300 && game.isGame(); ++step) {
+            size_t count = moves::legalMoves(game, legal, moves::MAX_MOVES);
+            REQUIRE(count > 0);
+            Move move = legal[rng() % count];
+            CHECK(moves::isLegal(game, move));
+            CHECK_NOTHROW(moves::apply(game, move));
+        }
+    }
+}
+
+TEST_CASE("Table host frames") {
+    TableHost host(3);
+    std::vector<std::uint8_t> request;
+    std::vector<std::uint8_t> reply;
+    protocol::Writer writer(request);
+    writer.begin(protocol::Opcode::CreateTable);
+    writer.u8(2);
+    writer.u32(99);
+    writer.end();
+    host.handle(request.data(), request.size(), reply);
+
+    REQUIRE(protocol::frameLength(reply.data(), reply.size()) == reply.size());
+    CHECK(static_cast<protocol::Opcode>(reply[2]) == protocol::Opcode::TableCreated);
+    protocol::Reader reader(reply.data() + 3, reply.size() - 3);
+    std::uint32_t table = reader.u32();
+    CHECK(TableRegistry::shardOf(table) == 3);
+    CHECK(host.tableCount() == 1);
+    CHECK(reader.u8() == protocol::STATUS_ACTIVE);
+    CHECK(reader.u8() == 0);  // current player
+    CHECK(reader.u8() == 2);  // players
+
+    SUBCASE("Illegal move becomes an error frame") {
+        request.clear();
+        reply.clear();
+        writer.begin(protocol::Opcode::Move);
+        writer.u32(table);
+        writer.u8(static_cast<std::uint8_t>(Action::Coup));
+        writer.u8(1);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        CHECK(static_cast<protocol::Opcode>(reply[2]) == protocol::Opcode::Error);
+    }
+
+    SUBCASE("Moves the generator does not list become error frames") {
+        auto send = [&](std::uint8_t action, std::uint8_t target) {
+            request.clear();
+            reply.clear();
+            writer.begin(protocol::Opcode::Move);
+            writer.u32(table);
+            writer.u8(action);
+            writer.u8(target);
+            writer.end();
+            host.handle(request.data(), request.size(), reply);
+            return static_cast<protocol::Opcode>(reply[2]);
+        };
+        // Seed 99 seats two Generals with no coins: a block reaction is not a move of one's own
+        CHECK(send(static_cast<std::uint8_t>(Action::Ability), 1) == protocol::Opcode::Error);
+        CHECK(send(static_cast<std::uint8_t>(Action::Ability), Move::NO_TARGET) == protocol::Opcode::Error);
+        CHECK(send(static_cast<std::uint8_t>(Action::Ability) + 1, Move::NO_TARGET) == protocol::Opcode::Error);
+        CHECK(send(static_cast<std::uint8_t>(Action::Gather), 1) == protocol::Opcode::Error); // stray target
+        CHECK(send(static_cast<std::uint8_t>(Action::Gather), Move::NO_TARGET) == protocol::Opcode::MoveApplied);
+    }
+
+    SUBCASE("Unknown table") {
+        request.clear();
+        reply.clear();
+        writer.begin(protocol::Opcode::GetState);
+        writer.u32(table + 1);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        CHECK(static_cast<protocol::Opcode>(reply[2]) == protocol::Opcode::Error);
+    }
+}
+
+TEST_CASE("Table registry handoff") {
+    TableRegistry registry(2, true, 4);
+    CHECK(registry.shardCount() == 2);
+    CHECK(registry.placeTable(0) != registry.placeTable(0)); // round robin when spreading
+
+    Envelope envelope;
+    envelope.origin = 1;
+    envelope.sequence = 5;
+    envelope.size = 1;
+    envelope.bytes[0] = 0x2A;
+    for (int i = 0; i < 4; ++i) {
+        Envelope copy = envelope;
+        CHECK(registry.post(0, std::move(copy)));
+    }
+    Envelope overflow = envelope;
+    CHECK_FALSE(registry.post(0, std::move(overflow))); // full inbox refuses instead of blocking
+
+    Envelope received;
+    REQUIRE(registry.poll(0, received));
+    CHECK(received.origin == 1);
+    CHECK(received.sequence == 5);
+    CHECK(received.bytes[0] == 0x2A);
+    CHECK_FALSE(registry.poll(1, received));
+
+    TableRegistry local(2, false);
+    CHECK(local.placeTable(1) == 1);
+}
+
+TEST_CASE("State diff") {
+    Game game(5);
+    game.add_player("Alice");
+    game.add_player("Bob");
+    game.add_player("Charlie");
+    StateDiff diff;
+    std::vector<std::uint8_t> records;
+
+    CHECK(diff.diff(game, records) == 3 * 3 + 1 + 1); // every seat joins, then turn and status
+    records.clear();
+    CHECK(diff.diff(game, records) == 0);
+
+    SUBCASE("Moves between observations collapse") {
+        game.playerAt(0).gather(); // Alice +1, turn -> Bob
+        game.playerAt(1).gather(); // Bob +1, turn -> Charlie
+        records.clear();
+        REQUIRE(diff.diff(game, records) == 3);
+        CHECK(records[0] == static_cast<std::uint8_t>(delta::Kind::Coins));
+        CHECK(records[2] == 1);
+        CHECK(records[6] == static_cast<std::uint8_t>(delta::Kind::Turn));
+        CHECK(records[8] == game.playerAt(2).getIndex());
+    }
+
+    SUBCASE("Elimination and restore") {
+        std::string bob = game.playerAt(1).getName();
+        size_t seat = game.playerAt(1).getIndex();
+        game.gameCoup(bob);
+        records.clear();
+        REQUIRE(diff.diff(game, records) >= 1);
+        CHECK(records[0] == static_cast<std::uint8_t>(delta::Kind::Eliminated));
+        CHECK(records[1] == seat);
+
+        game.restorePlayer();
+        records.clear();
+        REQUIRE(diff.diff(game, records) >= 1);
+        CHECK(records[0] == static_cast<std::uint8_t>(delta::Kind::Restored));
+        CHECK(records[1] == seat);
+    }
+}
+
+TEST_CASE("Spectator deltas are encoded once per tick") {
+    TableHost host(0);
+    std::vector<std::uint8_t> request;
+    std::vector<std::uint8_t> reply;
+    protocol::Writer writer(request);
+    writer.begin(protocol::Opcode::CreateTable);
+    writer.u8(3);
+    writer.u32(11);
+    writer.end();
+    host.handle(request.data(), request.size(), reply);
+    protocol::Reader created(reply.data() + 3, reply.size() - 3);
+    std::uint32_t table = created.u32();
+
+    for (std::uint64_t connection = 1; connection <= 3; ++connection) {
+        request.clear();
+        reply.clear();
+        writer.begin(protocol::Opcode::Subscribe);
+        writer.u32(table);
+        writer.end();
+        host.handle(request.data(), request.size(), reply, Subscriber{0, connection});
+        CHECK(static_cast<protocol::Opcode>(reply[2]) == protocol::Opcode::Subscribed);
+    }
+    CHECK_FALSE(host.hasUpdates());
+
+    for (int i = 0; i < 3; ++i) {
+        request.clear();
+        reply.clear();
+        writer.begin(protocol::Opcode::Move);
+        writer.u32(table);
+        writer.u8(static_cast<std::uint8_t>(Action::Gather));
+        writer.u8(Move::NO_TARGET);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        REQUIRE(static_cast<protocol::Opcode>(reply[2]) == protocol::Opcode::MoveApplied);
+    }
+    REQUIRE(host.hasUpdates());
+
+    size_t calls = 0;
+    size_t receivers = 0;
+    protocol::SharedFrame sent;
+    host.publish([&](const protocol::SharedFrame& frame, const std::vector<Subscriber>& subscribers) {
+        ++calls;
+        receivers += subscribers.size();
+        sent = frame;
+    });
+    CHECK(calls == 1);
+    CHECK(receivers == 3);
+    REQUIRE(sent);
+    CHECK(static_cast<protocol::Opcode>((*sent)[2]) == protocol::Opcode::Delta);
+    CHECK((*sent)[7] == 3); // one coin record per seat; the turn came back around
+    CHECK_FALSE(host.hasUpdates());
+}
+
+TEST_CASE("Turn flow block windows") {
+    // Find a seeded table where the first player is not a Governor and someone else is
+    unsigned int seed = 0;
+    for (unsigned int s = 1; s < 1000 && seed == 0; ++s) {
+        Game probe(s);
+        probe.add_player("A");
+        probe.add_player("B");
+        probe.add_player("C");
+        bool governorElsewhere = probe.playerAt(1).role() == Role::Governor || probe.playerAt(2).role() == Role::Governor;
+        if (probe.playerAt(0).role() != Role::Governor && governorElsewhere) {
+            seed = s;
+        }
+    }
+    REQUIRE(seed != 0);
+    Game game(seed);
+    game.add_player("A");
+    game.add_player("B");
+    game.add_player("C");
+    TurnFlow flow(game);
+
+    flow.begin(Move{Action::Tax, Move::NO_TARGET});
+    REQUIRE(flow.waiting());
+    CHECK(flow.blockingRole() == Role::Governor);
+    CHECK(flow.responder().role() == Role::Governor);
+    CHECK(&flow.actor() == &game.playerAt(0));
+    CHECK(game.turn() == "B"); // the turn moved on; the window does not hold the table
+    CHECK_THROWS_AS(flow.begin(Move{Action::Gather, Move::NO_TARGET}), std::runtime_error);
+
+    SUBCASE("Block") {
+        const Player* governor = &flow.responder();
+        flow.respond(true);
+        CHECK(flow.state() == TurnFlow::State::Done);
+        CHECK(flow.blocker() == governor);
+        CHECK(game.playerAt(0).getCoins() == 0);
+        CHECK_THROWS_AS(flow.respond(true), std::runtime_error);
+    }
+
+    SUBCASE("Allow") {
+        while (flow.waiting()) {
+            flow.respond(false);
+        }
+        CHECK_FALSE(flow.blocked());
+        CHECK(game.playerAt(0).getCoins() == 2);
+        flow.begin(Move{Action::Gather, Move::NO_TARGET});
+        CHECK(flow.state() == TurnFlow::State::Done);
+        CHECK(flow.blockingRole() == Role::Player);
+    }
+}
+
+TEST_CASE("Write-ahead log recovery") {
+    std::string path = "/tmp/coup_wal_test_" + std::to_string(std::random_device{}()) + ".wal";
+    std::remove(path.c_str());
+    std::vector<std::uint8_t> request;
+    std::vector<std::uint8_t> reply;
+    protocol::Writer writer(request);
+    std::uint32_t table = 0;
+    std::vector<std::uint8_t> before;
+    {
+        WriteAheadLog log(path);
+        TableHost host(0);
+        host.attachLog(&log);
+        writer.begin(protocol::Opcode::CreateTable);
+        writer.u8(3);
+        writer.u32(21);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        protocol::Reader created(reply.data() + 3, reply.size() - 3);
+        table = created.u32();
+        for (int i = 0; i < 4; ++i) {
+            request.clear();
+            writer.begin(protocol::Opcode::Move);
+            writer.u32(table);
+            writer.u8(static_cast<std::uint8_t>(Action::Gather));
+            writer.u8(Move::NO_TARGET);
+            writer.end();
+            host.handle(request.data(), request.size(), reply);
+        }
+        CHECK(log.pending());
+        log.commit();
+        CHECK_FALSE(log.pending());
+        CHECK(log.commits() == 1);
+
+        request.clear();
+        reply.clear();
+        writer.begin(protocol::Opcode::GetState);
+        writer.u32(table);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        before = reply;
+    }
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn.write("\x09\x00\x00", 3); // a commit cut short by a crash
+    }
+
+    WriteAheadLog log(path);
+    TableHost host(0);
+    CHECK(host.recover(log) == 5);
+    CHECK(host.tableCount() == 1);
+    reply.clear();
+    host.handle(request.data(), request.size(), reply);
+    CHECK(reply == before);
+
+    SUBCASE("New tables do not reuse recovered ids") {
+        request.clear();
+        reply.clear();
+        writer.begin(protocol::Opcode::CreateTable);
+        writer.u8(2);
+        writer.u32(1);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        protocol::Reader created(reply.data() + 3, reply.size() - 3);
+        CHECK(created.u32() == table + 1);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Table ids wrap around past open tables") {
+    std::string path = "/tmp/coup_ids_test_" + std::to_string(std::random_device{}()) + ".wal";
+    std::remove(path.c_str());
+    {
+        WriteAheadLog log(path);
+        const std::uint8_t body[] = {2, 1, 0, 0, 0, 0};
+        log.append(WriteAheadLog::RecordType::Create, 1, body, sizeof(body));
+        log.append(WriteAheadLog::RecordType::Create, 0xFFFFFF, body, sizeof(body));
+        log.commit();
+    }
+    WriteAheadLog log(path);
+    TableHost host(0);
+    CHECK(host.recover(log) == 2);
+
+    std::vector<std::uint8_t> request;
+    std::vector<std::uint8_t> reply;
+    protocol::Writer writer(request);
+    writer.begin(protocol::Opcode::CreateTable);
+    writer.u8(2);
+    writer.u32(1);
+    writer.end();
+    host.handle(request.data(), request.size(), reply);
+    protocol::Reader created(reply.data() + 3, reply.size() - 3);
+    CHECK(created.u32() == 2); // past the last id, 0 is skipped and table 1 is still open
+    CHECK(host.tableCount() == 3);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Game snapshots") {
+    Game game(77);
+    game.add_player("Alice");
+    game.add_player("Bob");
+    game.add_player("Charlie");
+    game.playerAt(0).setCoins(9);
+    game.playerAt(0).coup(game.playerAt(2));
+    game.playerAt(1).setSanctioned(true);
+    game.setBribe(true);
+
+    std::vector<std::uint8_t> image;
+    size_t written = Snapshot::write(game, image);
+    REQUIRE(written == image.size());
+    CHECK(image[2] == Snapshot::VERSION);
+
+    SUBCASE("Round trip into a fresh game") {
+        Game copy(1);
+        Snapshot::read(copy, image.data(), image.size());
+        std::vector<std::uint8_t> again;
+        Snapshot::write(copy, again);
+        CHECK(again == image);
+        CHECK(copy.players() == game.players());
+        CHECK(copy.getOutList().size() == 1);
+        CHECK(copy.getOutList()[0]->role() == game.getOutList()[0]->role());
+        CHECK(copy.turn() == game.turn());
+        CHECK(copy.getBribe());
+        CHECK(copy.playerAt(1).isSanctioned());
+    }
+
+    SUBCASE("Restoring into the same roster reuses the players") {
+        Player* alice = &game.playerAt(0);
+        Player* charlie = game.getOutList()[0].get();
+        game.restorePlayer();
+        game.playerAt(0).setCoins(5);
+        game.setBribe(false);
+        Snapshot::read(game, image.data(), image.size());
+        CHECK(&game.playerAt(0) == alice);
+        CHECK(game.getOutList()[0].get() == charlie);
+        CHECK(game.playerCount() == 2);
+        CHECK(game.playerAt(0).getCoins() == 2);
+        CHECK(game.getBribe());
+    }
+
+    SUBCASE("Bad images leave the game alone") {
+        std::vector<std::uint8_t> bad = image;
+        bad[2] = Snapshot::VERSION + 1;
+        CHECK_THROWS_AS(Snapshot::read(game, bad.data(), bad.size()), std::runtime_error);
+        CHECK_THROWS_AS(Snapshot::read(game, image.data(), image.size() - 1), std::runtime_error);
+        CHECK(game.playerCount() == 2);
+    }
+
+    SUBCASE("A player added after a coup can share a seat") {
+        Game table(3);
+        table.add_player("a");
+        table.add_player("b");
+        table.add_player("c");
+        table.gameCoup("b");
+        table.add_player("d");
+        REQUIRE(table.playerAt(1).getIndex() == table.playerAt(2).getIndex());
+        table.playerAt(2).setCoins(4);
+        std::vector<std::uint8_t> shared;
+        Snapshot::write(table, shared);
+
+        Game copy(1);
+        Snapshot::read(copy, shared.data(), shared.size());
+        CHECK(copy.players() == table.players());
+        CHECK(copy.playerAt(2).getCoins() == 4);
+        Player* c = &table.playerAt(1);
+        Snapshot::read(table, shared.data(), shared.size());
+        CHECK(&table.playerAt(1) == c);
+        CHECK(table.players() == std::vector<std::string>{"a", "c", "d"});
+        std::vector<std::uint8_t> again;
+        Snapshot::write(table, again);
+        CHECK(again == shared);
+    }
+
+    SUBCASE("Positions built field by field") {
+        SnapshotState state;
+        state.turn = 3;
+        SnapshotEntry entries[3];
+        entries[0].role = Role::Baron;
+        entries[0].coins = 5;
+        entries[0].sanctioned = true;
+        entries[0].name = "Dana";
+        entries[1].role = Role::Spy;
+        entries[1].seat = 2;
+        entries[1].canArrest = false;
+        entries[1].lastAction = Action::Arrest;
+        entries[1].name = "Erin";
+        entries[2].role = Role::Judge;
+        entries[2].seat = 1;
+        entries[2].name = "Frank";
+        std::vector<std::uint8_t> built;
+        size_t size = Snapshot::build(state, entries, 2, 1, built);
+        REQUIRE(size == built.size());
+        Snapshot::read(game, built.data(), built.size());
+        CHECK(game.players() == std::vector<std::string>{"Dana", "Erin"});
+        CHECK(game.turn() == "Erin");
+        CHECK(game.playerAt(0).getCoins() == 5);
+        CHECK(game.playerAt(0).isSanctioned());
+        CHECK(game.playerAt(1).getIndex() == 2);
+        CHECK_FALSE(game.playerAt(1).getCanArrest());
+        CHECK(game.playerAt(1).getLastAction() == Action::Arrest);
+        CHECK(game.getOutList()[0]->role() == Role::Judge);
+        std::vector<std::uint8_t> written;
+        Snapshot::write(game, written);
+        CHECK(written == built);
+    }
+}
+
+TEST_CASE("Seat table") {
+    Game game(5);
+    game.add_player("Alice");
+    game.add_player("Bob");
+    game.add_player("Charlie");
+    std::shared_ptr<SeatTable> seats = game.seatTable();
+    Player& alice = game.playerAt(0);
+    Player& bob = game.playerAt(1);
+
+    SUBCASE("Players read and write their own slot") {
+        bob.setCoins(6);
+        bob.setArrest(true);
+        CHECK(seats->coins[bob.getSlot()] == 6);
+        CHECK(seats->arrested[bob.getSlot()] == 1);
+        CHECK(seats->role[bob.getSlot()] == bob.role());
+        CHECK(seats->coins[alice.getSlot()] == 0);
+        CHECK(Game(game).seatTable() != seats);
+    }
+
+    SUBCASE("Eliminated players leave the scans") {
+        alice.setCoins(7);
+        alice.coup(game.playerAt(2));
+        size_t charlie = game.getOutList()[0]->getSlot();
+        CHECK(seats->active[charlie] == 0);
+        seats->arrested[charlie] = 1;
+        // Bob is sanctioned and broke, Alice is arrested: only an arrest of Charlie would be left
+        bob.setSanctioned(true);
+        alice.setArrest(true);
+        CHECK_FALSE(game.canAction());
+        game.resetArrest();
+        CHECK(seats->arrested[charlie] == 1);
+        CHECK(game.canAction());
+        game.restorePlayer();
+        CHECK(seats->active[charlie] == 1);
+    }
+
+    SUBCASE("Slots of destroyed players are reused") {
+        size_t slots = seats->size();
+        size_t slot = PlayerFactory::createPlayer(game, "Spy", "Dana", 3)->getSlot();
+        CHECK(seats->size() == slots + 1);
+        CHECK(PlayerFactory::createPlayer(game, "Baron", "Erin", 3)->getSlot() == slot);
+        CHECK(seats->size() == slots + 1);
+    }
+
+    SUBCASE("Names are interned once") {
+        CHECK(alice.getNameId() == seats->names.find("Alice"));
+        CHECK(seats->names.find("Dana") == NameTable::NONE);
+        CHECK(seats->names.intern("Bob") == bob.getNameId());
+        CHECK_THROWS_AS(game.add_player("Bob"), std::runtime_error);
+        for (int i = 0; i < 100; ++i) {
+            game.add_player("Seat" + std::to_string(i)); // grows the hash past its first size
+        }
+        CHECK(game.playerAt(50).getName() == "Seat47");
+        CHECK(seats->names.find("Seat47") == game.playerAt(50).getNameId());
+        CHECK(game.playersForSelection("Seat47").size() == game.playerCount() - 1);
+        game.gameCoup("Seat47");
+        CHECK_NOTHROW(game.add_player("Seat47")); // only seated names are taken
+    }
+
+    SUBCASE("Copies are independent") {
+        bob.setCoins(4);
+        alice.setArrest(true);
+        Game copy(game);
+        copy.gameCoup("Bob");
+        copy.playerAt(0).setCoins(8);
+        CHECK_THROWS_AS(game.add_player("Bob"), std::runtime_error);
+        CHECK(game.playerCount() == 3);
+        CHECK(seats->active[bob.getSlot()] == 1);
+        CHECK(alice.getCoins() == 0);
+        CHECK(copy.getOutList()[0]->getCoins() == 4);
+        CHECK(copy.playerAt(0).isArrested());
+
+        copy.resetArrest();
+        CHECK(alice.isArrested()); // the copy's scans only see the copy's table
+        copy = game;
+        std::vector<std::uint8_t> a, b;
+        Snapshot::write(game, a);
+        Snapshot::write(copy, b);
+        CHECK(a == b);
+        CHECK(&copy.playerAt(1) != &bob);
+    }
+}
+
+TEST_CASE("Roster tables") {
+    std::vector<std::string> names = {"Alice", "Bob", "Charlie", "Dana", "Erin", "Frank"};
+
+    SUBCASE("Same game as seat-by-seat add_player") {
+        for (unsigned int seed = 1; seed <= 20; ++seed) {
+            Game added(seed);
+            for (const std::string& name : names) {
+                added.add_player(name);
+            }
+            Game roster(names, seed);
+            REQUIRE(roster.playerCount() == names.size());
+            std::vector<std::uint8_t> a, b;
+            Snapshot::write(added, a);
+            Snapshot::write(roster, b);
+            CHECK(a == b);
+            added.add_player("Late");
+            roster.add_player("Late");
+            CHECK(added.playerAt(6).role() == roster.playerAt(6).role()); // the generators agree afterwards
+        }
+    }
+
+    SUBCASE("Given roles, played to the end") {
+        std::vector<Role> roles = {Role::Spy, Role::Merchant, Role::Judge, Role::Governor, Role::General, Role::Baron};
+        std::unique_ptr<Game> game = Game::fromRoster(names, roles);
+        for (size_t i = 0; i < roles.size(); ++i) {
+            CHECK(game->playerAt(i).role() == roles[i]);
+            CHECK(game->playerAt(i).getIndex() == i);
+        }
+        std::vector<std::shared_ptr<Player>> kept = game->getPlayers();
+        game->add_player("Late"); // outside the roster's block, on the block's seat table
+        std::shared_ptr<Player> late = game->getPlayers().back();
+        Bot bot(BotKind::Couper);
+        while (game->isGame()) {
+            moves::apply(*game, bot.choose(*game));
+        }
+        CHECK(game->getOutList().size() == roles.size());
+        game.reset();
+        CHECK(kept[5]->getName() == "Frank"); // players outlive the game's own references
+        kept.clear();
+        CHECK(late->getName() == "Late"); // and keep the block holding the seat table alive
+    }
+
+    SUBCASE("Bad rosters") {
+        CHECK_THROWS_AS(Game(std::vector<std::string>{"A", "B", "A"}, 1), std::runtime_error);
+        CHECK_THROWS_AS(Game(names, std::vector<Role>{Role::Spy}), std::runtime_error);
+        CHECK_THROWS_AS(Game(std::vector<std::string>{"A"}, std::vector<Role>{static_cast<Role>(9)}), std::runtime_error);
+    }
+}
+
+TEST_CASE("Checkpointed recovery keeps a pending block window") {
+    std::string path = "/tmp/coup_ckpt_test_" + std::to_string(std::random_device{}()) + ".wal";
+    std::remove(path.c_str());
+    std::vector<std::uint8_t> request;
+    std::vector<std::uint8_t> reply;
+    protocol::Writer writer(request);
+    std::vector<std::uint8_t> before;
+    std::uint32_t table = 0;
+    {
+        WriteAheadLog log(path);
+        TableHost host(0);
+        host.attachLog(&log);
+        // Tax until some table stops in a block window
+        for (std::uint32_t seed = 1; seed < 200 && before.empty(); ++seed) {
+            request.clear();
+            reply.clear();
+            writer.begin(protocol::Opcode::CreateTable);
+            writer.u8(4);
+            writer.u32(seed);
+            writer.u8(protocol::TABLE_BLOCK_WINDOWS);
+            writer.end();
+            host.handle(request.data(), request.size(), reply);
+            protocol::Reader created(reply.data() + 3, reply.size() - 3);
+            table = created.u32();
+            request.clear();
+            reply.clear();
+            writer.begin(protocol::Opcode::Move);
+            writer.u32(table);
+            writer.u8(static_cast<std::uint8_t>(Action::Tax));
+            writer.u8(Move::NO_TARGET);
+            writer.end();
+            host.handle(request.data(), request.size(), reply);
+            if (protocol::frameLength(reply.data(), reply.size()) < reply.size()) {
+                before = reply; // MoveApplied followed by BlockWindow
+            }
+        }
+        REQUIRE_FALSE(before.empty());
+        log.commit();
+        host.checkpoint(log);
+    }
+
+    WriteAheadLog log(path);
+    TableHost host(0);
+    host.recover(log);
+    request.clear();
+    reply.clear();
+    writer.begin(protocol::Opcode::GetState);
+    writer.u32(table);
+    writer.end();
+    host.handle(request.data(), request.size(), reply);
+    size_t first = protocol::frameLength(reply.data(), reply.size());
+    REQUIRE(first < reply.size());
+    CHECK(static_cast<protocol::Opcode>(reply[first + 2]) == protocol::Opcode::BlockWindow);
+    CHECK(std::equal(reply.begin() + 3, reply.end(), before.begin() + 3)); // same state and window
+
+    request.clear();
+    reply.clear();
+    writer.begin(protocol::Opcode::Respond);
+    writer.u32(table);
+    writer.u8(1);
+    writer.end();
+    host.handle(request.data(), request.size(), reply);
+    CHECK(static_cast<protocol::Opcode>(reply[2]) == protocol::Opcode::State);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Allocation scopes") {
+    // The test binary keeps the default operator new, so allocations are reported by hand
+    static instrument::ScopeSite outerSite("test::outer");
+    static instrument::ScopeSite innerSite("test::inner");
+    instrument::resetAllocationCounters();
+    auto stats = [](const char* name) {
+        instrument::ScopeStats found{name, 0, 0, 0, 0};
+        instrument::forEachScope([&](const instrument::ScopeStats& s) {
+            if (std::string(s.name) == name) found = s;
+        });
+        return found;
+    };
+
+    {
+        instrument::AllocScope outer(outerSite);
+        instrument::noteAllocation(16);
+        for (int i = 0; i < 2; ++i) {
+            instrument::AllocScope inner(innerSite);
+            instrument::noteAllocation(8);
+            instrument::AllocScope again(innerSite); // recursion is counted once in total
+            instrument::noteAllocation(8);
+        }
+    }
+    instrument::noteAllocation(32); // outside every scope
+
+    instrument::ScopeStats outer = stats("test::outer");
+    instrument::ScopeStats inner = stats("test::inner");
+    CHECK(outer.calls == 1);
+    CHECK(outer.self == 1);
+    CHECK(outer.selfBytes == 16);
+    CHECK(outer.total == 5);
+    CHECK(inner.calls == 4);
+    CHECK(inner.self == 4);
+    CHECK(inner.total == 4);
+
+    instrument::pauseScopes(true);
+    {
+        instrument::AllocScope paused(outerSite);
+        instrument::noteAllocation(16);
+    }
+    instrument::pauseScopes(false);
+    CHECK(stats("test::outer").calls == 1);
+    CHECK(stats("test::outer").self == 1);
+    CHECK_FALSE(instrument::trackingEnabled()); // markers in the engine are compiled out here
+}
+
+TEST_CASE("Trace rings") {
+    // Spans work without COUP_TRACING; only the COUP_TRACE_SCOPE markers are compiled out
+    std::thread worker([] {
+        trace::setThreadName("test worker");
+        for (size_t i = 0; i < trace::RING_CAPACITY + 10; ++i) {
+            trace::Span span("test::lapped");
+        }
+    });
+    worker.join();
+    {
+        trace::Span span("test::\"quoted\"");
+    }
+
+    std::ostringstream out;
+    size_t events = trace::writeChromeTrace(out);
+    std::string json = out.str();
+    CHECK(events >= trace::RING_CAPACITY + 1);
+    CHECK(json.find("\"name\": \"test worker\"") != std::string::npos);
+    CHECK(json.find("test::\\\"quoted\\\"") != std::string::npos);
+    // The worker's ring kept only its newest RING_CAPACITY events
+    size_t lapped = 0;
+    for (size_t at = json.find("test::lapped"); at != std::string::npos; at = json.find("test::lapped", at + 1)) {
+        ++lapped;
+    }
+    CHECK(lapped == trace::RING_CAPACITY);
+    CHECK(json.find("\"ph\": \"X\"") != std::string::npos);
+}
+
+TEST_CASE("Reject reasons") {
+    Game game(5);
+    game.add_player("Alice");
+    game.add_player("Bob");
+    Player& alice = game.playerAt(0);
+
+    CHECK(moves::rejectReason(game, Move{Action::Gather, Move::NO_TARGET}) == moves::Reject::None);
+    CHECK(moves::rejectReason(game, Move{Action::Coup, 1}) == moves::Reject::NotEnoughCoins);
+    CHECK(moves::rejectReason(game, Move{Action::Arrest, 0}) == moves::Reject::InvalidTarget);
+    CHECK(moves::rejectReason(game, Move{Action::Arrest, 1}) == moves::Reject::CannotArrest); // Bob is broke
+    CHECK(moves::rejectReason(game, Move{Action::None, Move::NO_TARGET}) == moves::Reject::MustAct);
+    CHECK(moves::rejectReason(game, Move{static_cast<Action>(42), Move::NO_TARGET}) == moves::Reject::UnknownAction);
+    alice.setSanctioned(true);
+    CHECK(moves::rejectReason(game, Move{Action::Tax, Move::NO_TARGET}) == moves::Reject::Sanctioned);
+    alice.setCoins(10);
+    CHECK(moves::rejectReason(game, Move{Action::Bribe, Move::NO_TARGET}) == moves::Reject::MustCoup);
+    game.gameCoup("Bob");
+    CHECK(moves::rejectReason(game, Move{Action::Gather, Move::NO_TARGET}) == moves::Reject::GameOver);
+    CHECK(std::string(moves::rejectName(moves::Reject::NotEnoughCoins)) == "not_enough_coins");
+
+    SUBCASE("Role reactions and passive abilities are not moves") {
+        Game table({"merchant", "governor"}, {Role::Merchant, Role::Governor});
+        table.playerAt(0).setCoins(5);
+        table.playerAt(1).setCoins(5);
+        Move income{Action::Ability, Move::NO_TARGET};
+        CHECK(moves::rejectReason(table, income) == moves::Reject::AbilityUnavailable);
+        CHECK_THROWS_AS(moves::apply(table, income), std::runtime_error);
+        moves::apply(table, Move{Action::Gather, Move::NO_TARGET});
+        CHECK_THROWS_AS(moves::apply(table, Move{Action::Ability, 0}), std::runtime_error); // Governor's block
+        CHECK(table.playerAt(0).getCoins() == 6);
+        CHECK(table.playerAt(1).getCoins() == 5);
+    }
+}
+
+TEST_CASE("Metrics histograms and counters") {
+    SUBCASE("Buckets stay within 1/32 of the value") {
+        for (std::uint64_t v : {0ull, 1ull, 63ull, 64ull, 65ull, 1000ull, 123456ull, 987654321ull}) {
+            size_t bucket = metrics::Histogram::bucketOf(v);
+            std::uint64_t high = metrics::Histogram::bucketHigh(bucket);
+            CHECK(high >= v);
+            CHECK(static_cast<double>(high - v) <= static_cast<double>(v) / 32.0);
+            if (bucket > 0) {
+                CHECK(metrics::Histogram::bucketHigh(bucket - 1) < v);
+            }
+        }
+        CHECK(metrics::Histogram::bucketOf(~0ull) == metrics::Histogram::BUCKETS - 1);
+    }
+
+    SUBCASE("Percentiles") {
+        auto h = std::make_unique<metrics::Histogram>();
+        for (std::uint64_t v = 1; v <= 1000; ++v) {
+            h->record(v * 100);
+        }
+        CHECK(h->count() == 1000);
+        CHECK(h->max() == 100000);
+        CHECK(h->percentile(0.5) >= 50000);
+        CHECK(h->percentile(0.5) <= 50000 + 50000 / 32);
+        CHECK(h->percentile(1.0) == 100000);
+    }
+
+    SUBCASE("Server moves are counted per action and reason, across threads") {
+        auto before = std::make_unique<metrics::Scrape>();
+        metrics::scrape(*before);
+
+        TableHost host(0);
+        std::vector<std::uint8_t> request;
+        std::vector<std::uint8_t> reply;
+        protocol::Writer writer(request);
+        writer.begin(protocol::Opcode::CreateTable);
+        writer.u8(2);
+        writer.u32(9);
+        writer.end();
+        host.handle(request.data(), request.size(), reply);
+        protocol::Reader created(reply.data() + 3, reply.size() - 3);
+        std::uint32_t table = created.u32();
+        auto move = [&](std::uint32_t id, Action action, std::uint8_t target) {
+            request.clear();
+            reply.clear();
+            writer.begin(protocol::Opcode::Move);
+            writer.u32(id);
+            writer.u8(static_cast<std::uint8_t>(action));
+            writer.u8(target);
+            writer.end();
+            host.handle(request.data(), request.size(), reply);
+        };
+        move(table, Action::Gather, Move::NO_TARGET);
+        move(table, Action::Coup, 0);           // 0 coins
+        move(table + 1, Action::Gather, Move::NO_TARGET);
+        std::thread other([] { metrics::recordApplied(Action::Gather, 500); });
+        other.join();
+
+        auto after = std::make_unique<metrics::Scrape>();
+        metrics::scrape(*after);
+        size_t gather = static_cast<size_t>(Action::Gather);
+        size_t coup = static_cast<size_t>(Action::Coup);
+        CHECK(after->applied[gather] - before->applied[gather] == 2);
+        CHECK(after->latency[gather].count() - before->latency[gather].count() == 2);
+        CHECK(after->rejected[coup][static_cast<size_t>(moves::Reject::NotEnoughCoins)] -
+                  before->rejected[coup][static_cast<size_t>(moves::Reject::NotEnoughCoins)] == 1);
+        CHECK(after->rejected[gather][static_cast<size_t>(metrics::Refusal::UnknownTable)] -
+                  before->rejected[gather][static_cast<size_t>(metrics::Refusal::UnknownTable)] == 1);
+
+        std::string text = metrics::renderText();
+        CHECK(text.find("coup_moves_applied_total{action=\"gather\"}") != std::string::npos);
+        CHECK(text.find("coup_moves_rejected_total{action=\"coup\",reason=\"not_enough_coins\"}") != std::string::npos);
+        CHECK(text.find("coup_move_latency_ns{action=\"gather\",quantile=\"0.99\"}") != std::string::npos);
+    }
+}
+
+TEST_CASE("Bots") {
+    SUBCASE("Seats") {
+        BotKind kind = BotKind::Random;
+        CHECK(Bot::parseSeat("bot:couper", kind));
+        CHECK(kind == BotKind::Couper);
+        CHECK(Bot::parseSeat("bot:spy", kind));
+        CHECK(kind == BotKind::SpyArrester);
+        CHECK_FALSE(Bot::parseSeat("bot:", kind));
+        CHECK_FALSE(Bot::parseSeat("bot:greedy2", kind));
+        CHECK_FALSE(Bot::parseSeat("Alice", kind));
+        for (size_t k = 0; k < static_cast<size_t>(BotKind::Count); ++k) {
+            CHECK(Bot::parseSeat(std::string("bot:") + Bot::kindName(static_cast<BotKind>(k)), kind));
+            CHECK(kind == static_cast<BotKind>(k));
+        }
+    }
+
+    SUBCASE("Couper coups the richest opponent, the tax bot keeps collecting") {
+        Game game(3);
+        game.add_player("Alice");
+        game.add_player("Bob");
+        game.add_player("Carol");
+        game.playerAt(0).setCoins(7);
+        game.playerAt(1).setCoins(2);
+        game.playerAt(2).setCoins(5);
+        CHECK(Bot(BotKind::Couper).choose(game) == Move{Action::Coup, 2});
+        CHECK(Bot(BotKind::TaxMaximizer).choose(game).action != Action::Coup);
+        game.playerAt(0).setCoins(10);
+        CHECK(Bot(BotKind::TaxMaximizer).choose(game).action == Action::Coup);
+    }
+
+    SUBCASE("Every policy plays legal moves to the end of the game") {
+        for (size_t k = 0; k < static_cast<size_t>(BotKind::Count); ++k) {
+            for (unsigned int seed = 1; seed <= 20; ++seed) {
+                Game game(seed);
+                for (const char* name : {"a", "b", "c", "d"}) {
+                    game.add_player(name);
+                }
+                TurnFlow flow(game);
+                Bot bot(static_cast<BotKind>(k), seed);
+                size_t played = 0;
+                while (game.isGame() && played < 1000) {
+                    Move move = bot.choose(game);
+                    REQUIRE(moves::isLegal(game, move));
+                    flow.begin(move);
+                    while (flow.waiting()) {
+                        flow.respond(bot.block(flow));
+                    }
+                    ++played;
+                }
+                CHECK(played > 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("CFR solver") {
+    CfrOptions options;
+    options.players = 2;
+    options.depth = 3;
+    options.tableBits = 14;
+    CfrSolver solver(options);
+    solver.run(60, 2);
+    CHECK(solver.iterations() == 60);
+    CHECK(solver.table().size() > 0);
+    CHECK(solver.table().dropped() == 0);
+
+    Game game(1);
+    game.add_player("p0");
+    game.add_player("p1");
+    Move legal[moves::MAX_MOVES];
+    double probabilities[moves::MAX_MOVES];
+    size_t count = solver.averageStrategy(game, legal, probabilities);
+    REQUIRE(count > 1);
+    double total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        CHECK(moves::isLegal(game, legal[i]));
+        total += probabilities[i];
+    }
+    CHECK(total == doctest::Approx(1.0));
+
+    const std::string path = "cfr_test.bin";
+    solver.save(path);
+    CfrSolver resumed(options);
+    resumed.load(path);
+    CHECK(resumed.iterations() == 60);
+    CHECK(resumed.table().size() == solver.table().size());
+    double reloaded[moves::MAX_MOVES];
+    CHECK(resumed.averageStrategy(game, legal, reloaded) == count);
+    for (size_t i = 0; i < count; ++i) {
+        CHECK(reloaded[i] == doctest::Approx(probabilities[i]));
+    }
+
+    CfrOptions other = options;
+    other.players = 3;
+    CfrSolver mismatched(other);
+    CHECK_THROWS_AS(mismatched.load(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Endgame tablebase") {
+    Tablebase table;
+    table.generate(2, {{Role::Spy, Role::Baron}, {Role::Governor, Role::Merchant}});
+    CHECK(table.solved(Role::Spy, Role::Baron));
+    CHECK_FALSE(table.solved(Role::Baron, Role::Spy));
+
+    // The transition function matches the engine on random positions of the solved pairs
+    std::mt19937 rng(3);
+    size_t base = Tablebase::pairIndex(Role::Spy, Role::Baron) * Tablebase::PAIR_SIZE;
+    for (int sample = 0; sample < 200; ++sample) {
+        size_t index = base + rng() % Tablebase::PAIR_SIZE;
+        EndgamePosition position = Tablebase::position(index);
+        if (!Tablebase::canonical(position)) {
+            continue;
+        }
+        CHECK(Tablebase::index(position) == index);
+        Game game(1);
+        position.toGame(game);
+        EndgamePosition read;
+        REQUIRE(EndgamePosition::fromGame(game, read));
+        CHECK(read == position);
+        Move engine[moves::MAX_MOVES];
+        Move own[moves::MAX_MOVES];
+        size_t count = moves::legalMoves(game, engine, moves::MAX_MOVES);
+        REQUIRE(count == position.legalMoves(own));
+        for (size_t i = 0; i < count; ++i) {
+            CHECK(engine[i] == own[i]);
+            Game copy(1);
+            position.toGame(copy);
+            moves::apply(copy, engine[i]);
+            EndgamePosition expected;
+            bool running = position.play(engine[i], expected);
+            CHECK(running == copy.isGame());
+            if (running) {
+                REQUIRE(EndgamePosition::fromGame(copy, read));
+                CHECK(read == expected);
+            }
+        }
+    }
+
+    // A Spy with 7 coins coups at once; the table says so and the bot follows it
+    EndgamePosition position;
+    position.seats[0].role = Role::Spy;
+    position.seats[0].coins = 7;
+    position.seats[1].role = Role::Baron;
+    position.seats[1].coins = 2;
+    CHECK(table.probe(position) == 1);
+    Game game(1);
+    position.toGame(game);
+    Bot bot(BotKind::TaxMaximizer);
+    CHECK(bot.choose(game).action != Action::Coup);
+    bot.setTablebase(&table);
+    CHECK(bot.choose(game) == Move{Action::Coup, 1});
+
+    // Following bestMove() from a won position wins in exactly the promised number of plies
+    position.seats[0].coins = 3;
+    std::uint8_t value = table.probe(position);
+    REQUIRE(value > Tablebase::DRAW);
+    REQUIRE(value < Tablebase::LOSS);
+    position.toGame(game);
+    size_t plies = 0;
+    while (game.isGame()) {
+        Move move;
+        REQUIRE(table.bestMove(game, move));
+        moves::apply(game, move);
+        ++plies;
+    }
+    CHECK(plies == value);
+    CHECK(game.playerAt(0).getName() == "p0");
+
+    const std::string path = "tablebase_test.bin";
+    table.save(path);
+    Tablebase mapped;
+    mapped.open(path);
+    CHECK(mapped.solved(Role::Governor, Role::Merchant));
+    CHECK(mapped.sweeps() == table.sweeps());
+    for (int sample = 0; sample < 1000; ++sample) {
+        EndgamePosition probe = Tablebase::position(base + rng() % Tablebase::PAIR_SIZE);
+        CHECK(mapped.probe(probe) == table.probe(probe));
+    }
+    std::ofstream(path, std::ios::binary) << "not a table";
+    CHECK_THROWS_AS(mapped.open(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Lockstep batch matches the scalar engine") {
+    std::vector<LockstepBatch::Kernel> kernels{LockstepBatch::Kernel::Generic};
+    if (LockstepBatch::bestKernel() == LockstepBatch::Kernel::Avx2) {
+        kernels.push_back(LockstepBatch::Kernel::Avx2);
+    }
+    for (LockstepBatch::Kernel kernel : kernels) {
+        for (bool randomMoves : {false, true}) {
+            CAPTURE(LockstepBatch::kernelName(kernel));
+            CAPTURE(randomMoves);
+            LockstepBatch batch(kernel);
+            std::vector<std::unique_ptr<Game>> games;
+            std::vector<Bot> bots;
+            for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+                games.push_back(std::make_unique<Game>(static_cast<unsigned int>(lane + 1)));
+                for (size_t p = 0; p < 2 + lane % 5; ++p) {
+                    games.back()->add_player("p" + std::to_string(p));
+                }
+                batch.load(lane, *games.back());
+                bots.emplace_back(BotKind::Random, static_cast<unsigned int>(lane + 7));
+            }
+
+            // deal() gives a lane the table a fresh Game with the same seed gets
+            LockstepBatch dealt(kernel);
+            for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+                dealt.deal(lane, static_cast<unsigned int>(lane + 1), games[lane]->playerCount());
+                CHECK(dealt.running(lane));
+                for (size_t i = 0; i < games[lane]->playerCount(); ++i) {
+                    CHECK(dealt.seat(lane, i).role == games[lane]->playerAt(i).role());
+                    CHECK(dealt.seat(lane, i).canArrest);
+                }
+            }
+
+            Move moves[LockstepBatch::LANES];
+            for (int ply = 0; ply < 400; ++ply) {
+                batch.choose(moves);
+                for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+                    Game& game = *games[lane];
+                    REQUIRE(batch.running(lane) == game.isGame());
+                    if (!game.isGame()) {
+                        continue;
+                    }
+                    if (randomMoves) {
+                        moves[lane] = bots[lane].choose(game);
+                    }
+                    REQUIRE(moves::isLegal(game, moves[lane]));
+                    moves::apply(game, moves[lane]);
+                }
+                batch.apply(moves);
+                for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+                    const Game& game = *games[lane];
+                    REQUIRE(batch.players(lane) == game.playerCount());
+                    CHECK(batch.turn(lane) == game.getTurn());
+                    CHECK(batch.bribe(lane) == game.getBribe());
+                    CHECK(batch.current(lane) == static_cast<size_t>(game.currentPlayerIndex()));
+                    for (size_t i = 0; i < game.playerCount(); ++i) {
+                        LockstepBatch::Seat seat = batch.seat(lane, i);
+                        const Player& player = game.playerAt(i);
+                        CHECK(seat.id == player.getIndex());
+                        CHECK(seat.role == player.role());
+                        CHECK(seat.coins == player.getCoins());
+                        CHECK(seat.sanctioned == player.isSanctioned());
+                        CHECK(seat.arrested == player.isArrested());
+                        CHECK(seat.canArrest == player.getCanArrest());
+                        CHECK(seat.lastAction == player.getLastAction());
+                    }
+                }
+            }
+            size_t finished = 0;
+            for (size_t lane = 0; lane < LockstepBatch::LANES; ++lane) {
+                if (!games[lane]->isGame()) {
+                    ++finished;
+                    CHECK(batch.winner(lane) == games[lane]->playerAt(0).getIndex());
+                }
+            }
+            CHECK(finished > 0);
+        }
+    }
+}
+
+TEST_CASE("Role sweep") {
+    // C(3 + 5, 5) multisets of three roles, 6^2 seatings of two
+    std::vector<std::vector<Role>> multisets = RoleSweep::assignments(3, false);
+    CHECK(multisets.size() == 56);
+    CHECK(RoleSweep::assignments(2, true).size() == 36);
+    for (size_t i = 0; i < multisets.size(); ++i) {
+        CHECK(std::is_sorted(multisets[i].begin(), multisets[i].end()));
+        if (i > 0) {
+            CHECK(multisets[i - 1] < multisets[i]);
+        }
+    }
+
+    SweepOptions options;
+    options.players = 3;
+    options.games = 4;
+    RoleSweep single(options);
+    single.run(1);
+    RoleSweep threaded(options);
+    threaded.run(2);
+    REQUIRE(single.rows().size() == threaded.rows().size());
+    for (size_t i = 0; i < single.rows().size(); ++i) {
+        const SweepRow& row = single.rows()[i];
+        std::uint32_t played = row.draws;
+        for (std::uint32_t wins : row.wins) {
+            played += wins;
+        }
+        CHECK(played == options.games);
+        CHECK(row.wins == threaded.rows()[i].wins);
+        CHECK(row.draws == threaded.rows()[i].draws);
+    }
+
+    options.players = 7;
+    options.seatings = true;
+    CHECK_THROWS_AS(RoleSweep{options}, std::runtime_error);
+    options.players = 1;
+    options.seatings = false;
+    CHECK_THROWS_AS(RoleSweep{options}, std::runtime_error);
+}
+
+TEST_CASE("Perft") {
+    // Golden counts: a change to move generation or the rules that alters them must be deliberate
+    PerftOptions options;
+    options.roles = {Role::Spy, Role::Baron};
+    options.depth = 8;
+    options.splitDepth = 0;
+    PerftResult serial = Perft(options).run(1);
+    CHECK(serial.nodes == std::vector<std::uint64_t>{1, 3, 8, 28, 88, 324, 1203, 4939, 21358});
+    CHECK(serial.finished[7] == 0);
+    CHECK(serial.finished[8] == 97);
+
+    options.roles = {Role::Governor, Role::Judge, Role::Merchant};
+    options.depth = 6;
+    CHECK(Perft(options).run(1).nodes == std::vector<std::uint64_t>{1, 2, 6, 22, 90, 327, 1085});
+
+    // Splitting and threads do not change the counts; divide adds up to the full depth
+    options.roles = {Role::Spy, Role::Baron};
+    options.depth = 8;
+    for (size_t split : {1u, 3u, 8u}) {
+        options.splitDepth = split;
+        PerftResult threaded = Perft(options).run(3);
+        CHECK(threaded.nodes == serial.nodes);
+        CHECK(threaded.finished == serial.finished);
+        REQUIRE(threaded.divide.size() == 3);
+        std::uint64_t leaves = 0;
+        for (const auto& entry : threaded.divide) {
+            leaves += entry.second;
+        }
+        CHECK(leaves == serial.nodes[8]);
+    }
+    CHECK(serial.divide[2].first == Move{Action::Ability, 1});
+
+    // Rolled roles come from the seed exactly as Game(names, seed) deals them
+    PerftOptions rolled;
+    rolled.players = 4;
+    rolled.seed = 9;
+    rolled.depth = 3;
+    Perft fromSeed(rolled);
+    Game game(std::vector<std::string>{"p0", "p1", "p2", "p3"}, 9);
+    for (size_t i = 0; i < 4; ++i) {
+        CHECK(fromSeed.roles()[i] == game.playerAt(i).role());
+    }
+    Move legal[moves::MAX_MOVES];
+    CHECK(fromSeed.run(1).nodes[1] == moves::legalMoves(game, legal, moves::MAX_MOVES));
+
+    rolled.players = 1;
+    CHECK_THROWS_AS(Perft{rolled}, std::runtime_error);
+    rolled.players = 2;
+    rolled.depth = Perft::MAX_DEPTH + 1;
+    CHECK_THROWS_AS(Perft{rolled}, std::runtime_error);
+}
+
+TEST_CASE("Differential check") {
+    DifferentialCheck check;
+
+    // Two Spies with 7 coins, seat 1 first; its legal moves are gather, tax, bribe, then arrest,
+    // sanction, coup and look at seat 0, so 5 picks the coup that ends the game
+    const std::uint8_t coup[] = {0, 42, 42, 1, 5, 0, 0};
+    REQUIRE(check.run(coup, sizeof(coup)));
+    CHECK(check.moves() == 1);
+
+    // Random inputs agree move for move on every engine
+    std::mt19937 rng(11);
+    std::vector<std::uint8_t> input;
+    for (int i = 0; i < 300; ++i) {
+        input.resize(1 + rng() % 200);
+        for (std::uint8_t& byte : input) {
+            byte = static_cast<std::uint8_t>(rng());
+        }
+        INFO(check.error());
+        CHECK(check.run(input.data(), input.size()));
+    }
+    CHECK(check.moves() > 1000);
+    CHECK(check.error().empty());
+}
+
+TEST_CASE("Alpha-beta search") {
+    // Proven results agree with the tablebase: wins and losses within the horizon are found,
+    // and nothing is proven in a drawn position
+    Tablebase table;
+    table.generate(1, {{Role::Spy, Role::Baron}});
+    std::mt19937 rng(5);
+    size_t base = Tablebase::pairIndex(Role::Spy, Role::Baron) * Tablebase::PAIR_SIZE;
+    for (SearchMode mode : {SearchMode::Paranoid, SearchMode::MaxN}) {
+        SearchOptions options;
+        options.mode = mode;
+        options.maxDepth = 6;
+        options.nodeBudget = 1u << 30;
+        Searcher searcher(options);
+        for (int checked = 0; checked < 60;) {
+            EndgamePosition position = Tablebase::position(base + rng() % Tablebase::PAIR_SIZE);
+            if (!Tablebase::canonical(position) || position.seats[0].coins < 0 || position.seats[1].coins < 0) {
+                continue;
+            }
+            ++checked;
+            Game game(1);
+            position.toGame(game);
+            std::uint8_t value = table.probe(position);
+            SearchResult result = searcher.search(game);
+            CAPTURE(int(value));
+            CHECK(moves::isLegal(game, result.best));
+            if (value != Tablebase::DRAW && value < Tablebase::LOSS && value <= 6) {
+                CHECK(result.value == 1.0);
+            } else if (value > Tablebase::LOSS && value - Tablebase::LOSS <= 6) {
+                CHECK(result.value == 0.0);
+            } else if (value == Tablebase::DRAW) {
+                CHECK(result.value > 0.0);
+                CHECK(result.value < 1.0);
+            }
+            if (result.value == 1.0) {
+                CHECK((value != Tablebase::DRAW && value < Tablebase::LOSS));
+            }
+        }
+    }
+
+    // A Spy with 7 coins coups at once
+    EndgamePosition position;
+    position.seats[0].role = Role::Spy;
+    position.seats[0].coins = 7;
+    position.seats[1].role = Role::Baron;
+    position.seats[1].coins = 2;
+    Game game(1);
+    position.toGame(game);
+    Searcher searcher;
+    SearchResult won = searcher.search(game);
+    CHECK(won.best == Move{Action::Coup, 1});
+    CHECK(won.value == 1.0);
+    CHECK(won.depth == 1);
+
+    // The node budget ends the deepening; the table makes a repeated search cheaper
+    std::vector<std::string> names{"p0", "p1", "p2", "p3"};
+    Game table4(names, 3);
+    std::vector<std::uint8_t> before;
+    std::vector<std::uint8_t> after;
+    Snapshot::write(table4, before);
+    SearchOptions limited;
+    limited.nodeBudget = 5000;
+    Searcher budgeted(limited);
+    SearchResult first = budgeted.search(table4);
+    CHECK(first.nodes <= limited.nodeBudget + 1);
+    CHECK(first.depth >= 2);
+    CHECK(first.depth < limited.maxDepth);
+    CHECK(first.iterations.size() == first.depth);
+    CHECK(first.branchingFactor() > 1.0);
+    CHECK(moves::isLegal(table4, first.best));
+    SearchResult second = budgeted.search(table4);
+    CHECK(second.depth >= first.depth);
+    CHECK(second.iterations[first.depth - 1].nodes < first.iterations[first.depth - 1].nodes);
+    Snapshot::write(table4, after);
+    CHECK(before == after);
+
+    limited.maxDepth = Searcher::MAX_PLIES + 1;
+    CHECK_THROWS_AS(Searcher{limited}, std::runtime_error);
+}
+
+TEST_CASE("Tree-parallel MCTS") {
+    // A Spy with 7 coins coups at once, with one thread or four sharing the tree
+    EndgamePosition position;
+    position.seats[0].role = Role::Spy;
+    position.seats[0].coins = 7;
+    position.seats[1].role = Role::Baron;
+    position.seats[1].coins = 2;
+    Game game(1);
+    position.toGame(game);
+    for (size_t threads : {1, 4}) {
+        MctsOptions options;
+        options.playouts = 2000;
+        options.threads = threads;
+        Mcts mcts(options);
+        MctsResult result = mcts.search(game);
+        CHECK(result.best == Move{Action::Coup, 1});
+        CHECK(result.value == doctest::Approx(1.0));
+        CHECK(result.playouts == 2000);
+        CHECK_FALSE(result.poolFull);
+    }
+
+    // Every playout goes through one root move once the root is expanded; virtual losses are all
+    // taken back at the end
+    std::vector<std::string> names{"p0", "p1", "p2", "p3"};
+    Game table(names, 3);
+    std::vector<std::uint8_t> before;
+    std::vector<std::uint8_t> after;
+    Snapshot::write(table, before);
+    MctsOptions options;
+    options.playouts = 3000;
+    options.threads = 4;
+    Mcts mcts(options);
+    MctsResult result = mcts.search(table);
+    Move legal[moves::MAX_MOVES];
+    REQUIRE(result.visits.size() == moves::legalMoves(table, legal, moves::MAX_MOVES));
+    std::uint64_t visits = 0;
+    for (size_t i = 0; i < result.visits.size(); ++i) {
+        CHECK(result.visits[i].first == legal[i]);
+        CHECK(result.visits[i].second > 0);
+        visits += result.visits[i].second;
+    }
+    CHECK(visits <= options.playouts);
+    CHECK(visits + options.threads >= options.playouts);
+    CHECK(result.nodes > result.visits.size());
+    CHECK(moves::isLegal(table, result.best));
+    Snapshot::write(table, after);
+    CHECK(before == after);
+
+    // A pool too small for the tree stops growing and still answers
+    options.poolNodes = 64;
+    Mcts small(options);
+    MctsResult bounded = small.search(table);
+    CHECK(bounded.poolFull);
+    CHECK(bounded.nodes <= 64);
+    CHECK(moves::isLegal(table, bounded.best));
+
+    options.poolNodes = 1;
+    CHECK_THROWS_AS(Mcts{options}, std::runtime_error);
+    options.poolNodes = 1024;
+    options.playouts = 0;
+    CHECK_THROWS_AS(Mcts{options}, std::runtime_error);
+}
+
+TEST_CASE("Coin belief") {
+    // Watched from the deal, every seat's coins follow from the public moves alone
+    size_t wrong = 0;
+    for (unsigned int seed = 1; seed <= 20; ++seed) {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < 2 + seed % 5; ++i) {
+            names.push_back("p" + std::to_string(i));
+        }
+        Game game(names, seed);
+        CoinBelief belief;
+        belief.reset(game);
+        Bot bot(BotKind::Random, seed);
+        for (int ply = 0; ply < 400 && game.isGame(); ++ply) {
+            belief.play(game, bot.choose(game));
+            for (size_t i = 0; i < game.playerCount(); ++i) {
+                const Player& player = game.playerAt(i);
+                wrong += belief.probability(player.getIndex(), player.getCoins()) == 1.0 ? 0 : 1;
+            }
+        }
+    }
+    CHECK(wrong == 0);
+
+    // From a uniform guess, the truth is never ruled out and the beliefs sharpen
+    size_t ruledOut = 0;
+    double before = 0;
+    double after = 0;
+    size_t seats = 0;
+    for (unsigned int seed = 1; seed <= 20; ++seed) {
+        std::vector<std::string> names{"p0", "p1", "p2", "p3"};
+        Game game(names, seed);
+        std::mt19937 rng(seed);
+        CoinBelief belief;
+        for (size_t i = 0; i < game.playerCount(); ++i) {
+            game.playerAt(i).setCoins(int(rng() % 10));
+            belief.assume(game.playerAt(i).getIndex(), 0, 12);
+            before += belief.probability(game.playerAt(i).getIndex(), game.playerAt(i).getCoins());
+        }
+        Bot bot(BotKind::Greedy, seed);
+        for (int ply = 0; ply < 40 && game.isGame(); ++ply) {
+            belief.play(game, bot.choose(game));
+            for (size_t i = 0; i < game.playerCount(); ++i) {
+                const Player& player = game.playerAt(i);
+                ruledOut += belief.probability(player.getIndex(), player.getCoins()) > 0 ? 0 : 1;
+            }
+        }
+        for (size_t i = 0; i < game.playerCount(); ++i) {
+            after += belief.probability(game.playerAt(i).getIndex(), game.playerAt(i).getCoins());
+            ++seats;
+        }
+    }
+    CHECK(ruledOut == 0);
+    CHECK(after / double(seats) > 2 * before / 80);
+
+    // A tax moves 0..9 of 0..12 up by two; a Merchant's turn moves only 3 and up by one
+    Game table({"spy", "merchant"}, {Role::Spy, Role::Merchant});
+    CoinBelief belief;
+    belief.assume(0, 0, 12);
+    belief.assume(1, 0, 12);
+    belief.play(table, Move{Action::Tax, Move::NO_TARGET});
+    CHECK(belief.probability(0, 1) == 0.0);
+    CHECK(belief.probability(0, 2) == doctest::Approx(0.1));
+    CHECK(belief.probability(0, 11) == doctest::Approx(0.1));
+    CHECK(belief.probability(0, 12) == 0.0);
+    CHECK(belief.mean(0) == doctest::Approx(6.5));
+    CHECK(belief.probability(1, 2) == doctest::Approx(1.0 / 13));
+    CHECK(belief.probability(1, 3) == 0.0);
+    CHECK(belief.probability(1, 13) == doctest::Approx(1.0 / 13));
+    const float* bins = belief.histogram(1);
+    CHECK(std::accumulate(bins, bins + CoinBelief::BINS, 0.0) == doctest::Approx(1.0));
+
+    // A refused move leaves the beliefs alone; a sample only draws what the belief allows
+    CHECK_THROWS(belief.play(table, Move{Action::Coup, 0}));
+    CHECK(belief.probability(0, 2) == doctest::Approx(0.1));
+    std::mt19937 rng(1);
+    belief.reveal(1, table.playerAt(1).getCoins());
+    for (int draw = 0; draw < 100; ++draw) {
+        belief.determinize(table, 1, rng);
+        CHECK(belief.probability(0, table.playerAt(0).getCoins()) > 0);
+        CHECK(belief.probability(1, table.playerAt(1).getCoins()) == 1.0);
+    }
+    CHECK_THROWS_AS(belief.assume(0, 5, 4), std::runtime_error);
+}
@@ -0,0 +1,116 @@
+// Offline MCCFR solver: runs external-sampling iterations on every core for hours if asked,
+// checkpointing the regret table so an interrupted run can be resumed with --resume.
+#include "ai/cfr.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    CfrOptions solver;
+    std::uint64_t iterations = 100000; // total, including those of a resumed checkpoint
+    double seconds = 0;                // stop after this long even if iterations remain; 0: no limit
+    size_t threads = 0;                // 0: one per core
+    std::string checkpoint;            // file written every checkpointSeconds and at the end
+    double checkpointSeconds = 300;
+    bool resume = false;
+};
+
+void usage() {
+    std::cerr << "Usage: coup_cfr [--players N] [--depth PLIES] [--table-bits B] [--seed N] [--iterations N]\n"
+                 "                [--seconds S] [--threads N] [--checkpoint FILE] [--checkpoint-interval SEC]\n"
+                 "                [--resume]" << std::endl;
+}
+
+void report(const CfrSolver& solver, double seconds, std::uint64_t done) {
+    const RegretTable& table = solver.table();
+    std::printf("%12llu iterations  %10.0f it/s  %10zu entries  %5.1f%% full  %llu dropped\n",
+                static_cast<unsigned long long>(solver.iterations()), seconds > 0 ? double(done) / seconds : 0.0,
+                table.size(), 100.0 * double(table.size()) / double(table.capacity()),
+                static_cast<unsigned long long>(table.dropped()));
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--players" && hasValue) opt.solver.players = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--depth" && hasValue) opt.solver.depth = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--table-bits" && hasValue) opt.solver.tableBits = static_cast<unsigned int>(std::atol(argv[++i]));
+        else if (arg == "--seed" && hasValue) opt.solver.seed = static_cast<unsigned int>(std::atol(argv[++i]));
+        else if (arg == "--iterations" && hasValue) opt.iterations = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seconds" && hasValue) opt.seconds = std::atof(argv[++i]);
+        else if (arg == "--threads" && hasValue) opt.threads = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--checkpoint" && hasValue) opt.checkpoint = argv[++i];
+        else if (arg == "--checkpoint-interval" && hasValue) opt.checkpointSeconds = std::atof(argv[++i]);
+        else if (arg == "--resume") opt.resume = true;
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (opt.resume && opt.checkpoint.empty()) {
+        usage();
+        return 1;
+    }
+    size_t threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        CfrSolver solver(opt.solver);
+        if (opt.resume && std::ifstream(opt.checkpoint)) {
+            solver.load(opt.checkpoint);
+            std::cout << "coup_cfr: resumed " << solver.iterations() << " iterations from " << opt.checkpoint
+                      << std::endl;
+        }
+        std::cout << "coup_cfr: " << opt.solver.players << " players, depth " << opt.solver.depth << ", "
+                  << threads << " threads, " << solver.table().capacity() << " table entries" << std::endl;
+
+        // Work in batches of about a second so the time limit and checkpoints stay on schedule
+        std::uint64_t batch = 64 * threads;
+        std::uint64_t startIterations = solver.iterations();
+        Clock::time_point start = Clock::now();
+        Clock::time_point lastCheckpoint = start;
+        while (solver.iterations() < opt.iterations) {
+            Clock::time_point before = Clock::now();
+            solver.run(std::min(batch, opt.iterations - solver.iterations()), threads);
+            double took = std::chrono::duration<double>(Clock::now() - before).count();
+            if (took < 0.5) {
+                batch *= 2;
+            } else if (took > 2 && batch > threads) {
+                batch /= 2;
+            }
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            bool timeUp = opt.seconds > 0 && elapsed >= opt.seconds;
+            if (!opt.checkpoint.empty() &&
+                std::chrono::duration<double>(Clock::now() - lastCheckpoint).count() >= opt.checkpointSeconds) {
+                solver.save(opt.checkpoint);
+                lastCheckpoint = Clock::now();
+                report(solver, elapsed, solver.iterations() - startIterations);
+            }
+            if (timeUp) {
+                break;
+            }
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!opt.checkpoint.empty()) {
+            solver.save(opt.checkpoint);
+        }
+        report(solver, elapsed, solver.iterations() - startIterations);
+    } catch (const std::exception& e) {
+        std::cerr << "coup_cfr: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Differential fuzzer (src/engine/differential.hpp): replays byte strings as games on the reference
+// Game and the alternate engines and stops at the first disagreement.
+//
+// Built with -DCOUP_LIBFUZZER and -fsanitize=fuzzer (make coup_fuzz_libfuzzer) it is a libFuzzer
+// target and takes libFuzzer's options. Otherwise it has its own main that feeds random inputs:
+//
+//   coup_fuzz [--iterations N] [--seconds S] [--seed N] [--threads N] [--max-len N] [FILE...]
+//
+// Files are replayed once each (a crash file from either build reproduces a failure). Each thread
+// draws its own inputs from seed + thread; a failing one is saved to crash-<seed>-<iteration>.bin.
+#include "engine/differential.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef COUP_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, size_t size) {
+    static DifferentialCheck check;
+    if (!check.run(data, size)) {
+        std::fprintf(stderr, "coup_fuzz: %s\n", check.error().c_str());
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void usage() {
+    std::cerr << "Usage: coup_fuzz [--iterations N] [--seconds S] [--seed N] [--threads N] [--max-len N] [FILE...]"
+              << std::endl;
+}
+
+bool replay(DifferentialCheck& check, const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "coup_fuzz: cannot read " << path << std::endl;
+        return false;
+    }
+    std::vector<std::uint8_t> input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!check.run(input.data(), input.size())) {
+        std::cerr << "coup_fuzz: " << path << ": " << check.error() << std::endl;
+        return false;
+    }
+    std::cout << path << ": ok (" << input.size() << " bytes)" << std::endl;
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::uint64_t iterations = 0;
+    double seconds = 0;
+    unsigned int seed = 1;
+    size_t threads = 0;
+    size_t maxLen = 256;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--iterations" && hasValue) iterations = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seconds" && hasValue) seconds = std::atof(argv[++i]);
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned int>(std::atol(argv[++i]));
+        else if (arg == "--threads" && hasValue) threads = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--max-len" && hasValue) maxLen = static_cast<size_t>(std::atol(argv[++i]));
+        else if (!arg.empty() && arg[0] != '-') files.push_back(arg);
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!files.empty()) {
+        DifferentialCheck check;
+        bool ok = true;
+        for (const std::string& path : files) {
+            ok = replay(check, path) && ok;
+        }
+        return ok ? 0 : 1;
+    }
+    if (iterations == 0 && seconds <= 0) {
+        seconds = 10;
+    }
+    threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    maxLen = std::max<size_t>(maxLen, 1);
+
+    std::atomic<std::uint64_t> next(0);
+    std::atomic<std::uint64_t> checked(0);
+    std::atomic<std::uint64_t> moves(0);
+    std::atomic<bool> stop(false);
+    std::atomic<bool> failed(false);
+    Clock::time_point start = Clock::now();
+    auto work = [&](size_t thread) {
+        // Random lengths favour short inputs: most games are decided within a few hundred moves
+        DifferentialCheck check;
+        std::mt19937_64 rng(seed + thread);
+        std::vector<std::uint8_t> input;
+        std::uint64_t local = 0;
+        for (; !stop.load(std::memory_order_relaxed); ++local) {
+            std::uint64_t iteration = next.fetch_add(1, std::memory_order_relaxed);
+            if (iterations && iteration >= iterations) {
+                break;
+            }
+            if ((local & 1023) == 0 && seconds > 0 &&
+                std::chrono::duration<double>(Clock::now() - start).count() >= seconds) {
+                break;
+            }
+            input.resize(1 + rng() % (rng() % maxLen + 1));
+            for (std::uint8_t& byte : input) {
+                byte = static_cast<std::uint8_t>(rng());
+            }
+            if (!check.run(input.data(), input.size())) {
+                if (!failed.exchange(true)) {
+                    std::string path = "crash-" + std::to_string(seed) + "-" + std::to_string(iteration) + ".bin";
+                    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(input.data()),
+                                                                 static_cast<std::streamsize>(input.size()));
+                    std::cerr << "coup_fuzz: iteration " << iteration << ": " << check.error()
+                              << " (input saved to " << path << ")" << std::endl;
+                }
+                stop = true;
+            }
+        }
+        checked += local;
+        moves += check.moves();
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (failed) {
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::uint64_t inputs = checked.load();
+    std::printf("coup_fuzz: %llu inputs, %llu moves on %zu threads in %.2f s (%.0f inputs/min, %.0f moves/s), "
+                "no disagreement\n",
+                static_cast<unsigned long long>(inputs), static_cast<unsigned long long>(moves.load()), threads,
+                elapsed, inputs * 60.0 / elapsed, moves.load() / elapsed);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,227 @@
+// Load generator for coup_server: every connection plays many tables in lockstep,
+// mirroring each table locally (same seed, same moves) so it only sends legal moves.
+#include "server/client.hpp"
+#include "server/protocol.hpp"
+#include "engine/move.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using protocol::Opcode;
+
+struct Options {
+    std::string unixPath;
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 7777;
+    size_t connections = 4;
+    size_t tables = 64;         // tables per connection, one pipelined move each per round
+    size_t players = 4;
+    size_t moves = 200000;      // moves per connection
+    size_t maxGameMoves = 500;  // recycle tables that run too long
+    unsigned int seed = 1;
+};
+
+struct Table {
+    std::uint32_t id = 0;
+    std::unique_ptr<Game> mirror;
+    size_t moves = 0;
+};
+
+struct Result {
+    std::vector<std::uint32_t> latencies; // nanoseconds
+    size_t moves = 0;
+    size_t errors = 0;
+    size_t games = 0;
+};
+
+void usage() {
+    std::cerr << "Usage: coup_loadgen [--unix PATH | --host ADDR --port N] [--connections N] [--tables N]\n"
+                 "                    [--players N] [--moves N] [--seed N]" << std::endl;
+}
+
+Opcode opcodeOf(const std::vector<std::uint8_t>& frame) {
+    return static_cast<Opcode>(frame[protocol::HEADER_SIZE]);
+}
+
+std::uint32_t tableOf(const std::vector<std::uint8_t>& frame) {
+    protocol::Reader reader(frame.data() + protocol::HEADER_SIZE + 1, frame.size() - protocol::HEADER_SIZE - 1);
+    return reader.u32();
+}
+
+void createTable(Client& client, Table& table, const Options& opt, std::mt19937& rng, Result& result) {
+    unsigned int seed = rng();
+    std::vector<std::uint8_t> frame;
+    protocol::Writer writer(frame);
+    writer.begin(Opcode::CreateTable);
+    writer.u8(static_cast<std::uint8_t>(opt.players));
+    writer.u32(seed);
+    writer.end();
+    client.send(frame);
+    client.receive(frame);
+    if (opcodeOf(frame) != Opcode::TableCreated) {
+        throw std::runtime_error("Server refused to create a table.");
+    }
+    table.id = tableOf(frame);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < opt.players; ++i) {
+        names.push_back("p" + std::to_string(i));
+    }
+    table.mirror = Game::fromRoster(names, seed);
+    table.moves = 0;
+    result.games++;
+}
+
+void closeTable(Client& client, Table& table) {
+    std::vector<std::uint8_t> frame;
+    protocol::Writer writer(frame);
+    writer.begin(Opcode::CloseTable);
+    writer.u32(table.id);
+    writer.end();
+    client.send(frame);
+    client.receive(frame);
+}
+
+void runConnection(const Options& opt, size_t index, Result& result) {
+    Client client;
+    if (opt.unixPath.empty()) {
+        client.connectTcp(opt.host, opt.port);
+    } else {
+        client.connectUnix(opt.unixPath);
+    }
+    std::mt19937 rng(opt.seed * 7919u + static_cast<unsigned int>(index));
+    std::vector<Table> tables(opt.tables);
+    for (auto& table : tables) {
+        createTable(client, table, opt, rng, result);
+    }
+    result.latencies.reserve(opt.moves);
+
+    std::vector<Move> pending(tables.size());
+    std::vector<bool> recycle(tables.size());
+    std::vector<std::uint8_t> batch;
+    std::vector<std::uint8_t> reply;
+    Move legal[moves::MAX_MOVES];
+
+    while (result.moves < opt.moves) {
+        batch.clear();
+        protocol::Writer writer(batch);
+        for (size_t i = 0; i < tables.size(); ++i) {
+            size_t count = moves::legalMoves(*tables[i].mirror, legal, moves::MAX_MOVES);
+            pending[i] = legal[rng() % count];
+            writer.begin(Opcode::Move);
+            writer.u32(tables[i].id);
+            writer.u8(static_cast<std::uint8_t>(pending[i].action));
+            writer.u8(pending[i].target);
+            writer.end();
+        }
+        Clock::time_point sent = Clock::now();
+        client.send(batch);
+        for (size_t i = 0; i < tables.size(); ++i) {
+            client.receive(reply);
+            Clock::time_point got = Clock::now();
+            result.latencies.push_back(static_cast<std::uint32_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(got - sent).count()));
+            result.moves++;
+            Table& table = tables[i];
+            if (opcodeOf(reply) == Opcode::MoveApplied) {
+                moves::apply(*table.mirror, pending[i]);
+            } else {
+                result.errors++;
+            }
+            table.moves++;
+            recycle[i] = !table.mirror->isGame() || table.moves >= opt.maxGameMoves ||
+                         opcodeOf(reply) != Opcode::MoveApplied;
+        }
+        // Only once every pipelined reply has been read
+        for (size_t i = 0; i < tables.size(); ++i) {
+            if (recycle[i]) {
+                closeTable(client, tables[i]);
+                createTable(client, tables[i], opt, rng, result);
+            }
+        }
+    }
+    for (auto& table : tables) {
+        closeTable(client, table);
+    }
+}
+
+double percentile(const std::vector<std::uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index] / 1000.0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--unix" && hasValue) opt.unixPath = argv[++i];
+        else if (arg == "--host" && hasValue) opt.host = argv[++i];
+        else if (arg == "--port" && hasValue) opt.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        else if (arg == "--connections" && hasValue) opt.connections = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--tables" && hasValue) opt.tables = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--players" && hasValue) opt.players = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--moves" && hasValue) opt.moves = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--seed" && hasValue) opt.seed = static_cast<unsigned int>(std::atol(argv[++i]));
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (opt.connections == 0 || opt.tables == 0 || opt.players < 2 || opt.players > moves::MAX_TABLE) {
+        usage();
+        return 1;
+    }
+
+    std::vector<Result> results(opt.connections);
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed(false);
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < opt.connections; ++i) {
+        threads.emplace_back([&, i]() {
+            try {
+                runConnection(opt, i, results[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "connection " << i << ": " << e.what() << std::endl;
+                failed = true;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::uint32_t> all;
+    size_t totalMoves = 0, errors = 0, games = 0;
+    for (const auto& r : results) {
+        all.insert(all.end(), r.latencies.begin(), r.latencies.end());
+        totalMoves += r.moves;
+        errors += r.errors;
+        games += r.games;
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << "connections " << opt.connections << ", tables " << opt.connections * opt.tables
+              << ", players " << opt.players << "\n"
+              << "moves       " << totalMoves << " in " << seconds << " s\n"
+              << "moves/sec   " << static_cast<double>(totalMoves) / seconds << "\n"
+              << "games       " << games << "\n"
+              << "errors      " << errors << "\n"
+              << "latency us  p50 " << percentile(all, 0.50) << "  p99 " << percentile(all, 0.99)
+              << "  p99.9 " << percentile(all, 0.999) << "  max " << percentile(all, 1.0) << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+#include "server/server.hpp"
+#include "instrument/metrics.hpp"
+#include "instrument/trace.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <pthread.h>
+#include <string>
+
+namespace {
+
+void usage() {
+    std::cerr << "Usage: coup_server [--unix PATH | --host ADDR --port N] [--loops N] [--no-pin] [--spread]\n"
+                 "                   [--tick MS] [--wal DIR] [--checkpoint SEC] [--trace FILE]\n"
+                 "                   [--metrics FILE] [--metrics-interval SEC]" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    ServerConfig config;
+    std::string tracePath;
+    std::string metricsPath;
+    unsigned int metricsSeconds = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--unix" && hasValue) {
+            config.unixPath = argv[++i];
+        } else if (arg == "--host" && hasValue) {
+            config.host = argv[++i];
+        } else if (arg == "--port" && hasValue) {
+            config.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--loops" && hasValue) {
+            config.loops = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--no-pin") {
+            config.pinThreads = false;
+        } else if (arg == "--tick" && hasValue) {
+            config.tickMillis = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (arg == "--wal" && hasValue) {
+            config.walDir = argv[++i];
+        } else if (arg == "--checkpoint" && hasValue) {
+            config.checkpointSeconds = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (arg == "--metrics" && hasValue) {
+            metricsPath = argv[++i];
+        } else if (arg == "--metrics-interval" && hasValue) {
+            metricsSeconds = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--spread") {
+            config.spreadTables = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!tracePath.empty() && !trace::enabled()) {
+        std::cerr << "coup_server: built without tracing (make TRACING=1), --trace ignored" << std::endl;
+    }
+
+    // Block the stop signals before any loop thread exists, then wait for them here
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        CoupServer server(config);
+        server.start();
+        std::cout << "coup_server: " << server.loopCount() << " loops on "
+                  << (config.unixPath.empty() ? config.host + ":" + std::to_string(config.port) : config.unixPath)
+                  << std::endl;
+        if (metricsPath.empty()) {
+            int received = 0;
+            sigwait(&signals, &received);
+        } else {
+            // Scrape the loops' metric shards into the file until a stop signal arrives
+            timespec interval{static_cast<time_t>(metricsSeconds), 0};
+            while (sigtimedwait(&signals, nullptr, &interval) < 0) {
+                metrics::writeText(metricsPath);
+            }
+        }
+        std::cout << "coup_server: shutting down" << std::endl;
+        server.stop();
+        server.wait();
+        if (!metricsPath.empty()) {
+            metrics::writeText(metricsPath);
+        }
+        if (!tracePath.empty() && trace::enabled()) {
+            size_t events = trace::writeChromeTrace(tracePath);
+            std::cout << "coup_server: " << events << " trace events written to " << tracePath << std::endl;
+        }
+        if (server.failed()) {
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
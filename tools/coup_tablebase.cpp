@@ -0,0 +1,227 @@
+// Two-player endgame tablebase: generates the table (src/ai/tablebase.hpp) and checks a saved one.
+//
+//   coup_tablebase generate FILE [--threads N] [--pair ROLE:ROLE]...
+//   coup_tablebase verify FILE [--sample N] [--seed N]
+//
+// verify re-derives every stored value from its successors' values (the table must be a fixpoint
+// of the rules) and replays sampled positions through the real engine, comparing legal moves and
+// resulting positions with the tablebase's own transition function.
+#include "ai/tablebase.hpp"
+#include "game.hpp"
+#include "engine/move.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const ROLE_NAMES[] = {"Spy", "Merchant", "Judge", "Governor", "General", "Baron"};
+
+void usage() {
+    std::cerr << "Usage: coup_tablebase generate FILE [--threads N] [--pair ROLE:ROLE]...\n"
+                 "       coup_tablebase verify FILE [--sample N] [--seed N]" << std::endl;
+}
+
+bool parseRole(const std::string& text, Role& role) {
+    for (size_t i = 0; i < Tablebase::ROLES; ++i) {
+        if (text == ROLE_NAMES[i]) {
+            role = static_cast<Role>(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The value a position must have given its successors' stored values
+std::uint8_t derive(const Tablebase& table, const EndgamePosition& position) {
+    Move legal[moves::MAX_MOVES];
+    size_t count = position.legalMoves(legal);
+    int fastestWin = 0;
+    int slowestLoss = 0;
+    bool allLost = true;
+    for (size_t i = 0; i < count; ++i) {
+        EndgamePosition next;
+        if (!position.play(legal[i], next)) {
+            fastestWin = 1;
+            continue;
+        }
+        std::uint8_t value = table.probe(next);
+        if (next.current != position.current) {
+            value = Tablebase::flip(value);
+        }
+        if (value == Tablebase::DRAW) {
+            allLost = false;
+        } else if (value < Tablebase::LOSS) {
+            if (fastestWin == 0 || value + 1 < fastestWin) {
+                fastestWin = value + 1;
+            }
+        } else {
+            slowestLoss = std::max(slowestLoss, value - Tablebase::LOSS + 1);
+        }
+    }
+    if (fastestWin) {
+        return static_cast<std::uint8_t>(fastestWin);
+    }
+    return allLost ? static_cast<std::uint8_t>(Tablebase::LOSS + slowestLoss) : Tablebase::DRAW;
+}
+
+// Plays every legal move of the position through moves::apply() and compares
+bool matchesEngine(const EndgamePosition& position, std::string& error) {
+    Game game(1);
+    position.toGame(game);
+    Move engine[moves::MAX_MOVES];
+    Move own[moves::MAX_MOVES];
+    size_t count = moves::legalMoves(game, engine, moves::MAX_MOVES);
+    if (count != position.legalMoves(own) || !std::equal(engine, engine + count, own)) {
+        error = "legal moves differ";
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Game copy(1);
+        position.toGame(copy);
+        moves::apply(copy, engine[i]);
+        EndgamePosition expected;
+        bool running = position.play(engine[i], expected);
+        EndgamePosition actual;
+        if (running != copy.isGame() || (running && (!EndgamePosition::fromGame(copy, actual) || !(actual == expected)))) {
+            error = "move " + std::to_string(i) + " leads elsewhere";
+            return false;
+        }
+    }
+    return true;
+}
+
+int generate(const std::string& path, size_t threads, const std::vector<std::pair<Role, Role>>& pairs) {
+    Tablebase table;
+    Clock::time_point start = Clock::now();
+    table.generate(threads, pairs);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t solvedPairs = pairs.empty() ? Tablebase::PAIRS : pairs.size();
+    double positions = double(solvedPairs) * double(Tablebase::PAIR_SIZE);
+    table.save(path);
+
+    size_t wins = 0, losses = 0, draws = 0;
+    for (size_t first = 1; first <= Tablebase::ROLES; ++first) {
+        for (size_t second = 1; second <= Tablebase::ROLES; ++second) {
+            if (!table.solved(static_cast<Role>(first), static_cast<Role>(second))) {
+                continue;
+            }
+            size_t base = Tablebase::pairIndex(static_cast<Role>(first), static_cast<Role>(second)) * Tablebase::PAIR_SIZE;
+            for (size_t i = 0; i < Tablebase::PAIR_SIZE; ++i) {
+                EndgamePosition position = Tablebase::position(base + i);
+                if (!Tablebase::canonical(position)) {
+                    continue;
+                }
+                std::uint8_t value = table.probe(position);
+                if (value == Tablebase::DRAW) ++draws;
+                else if (value < Tablebase::LOSS) ++wins;
+                else ++losses;
+            }
+        }
+    }
+    std::printf("coup_tablebase: %zu pairs, %.0f positions in %.2f s (%.0f positions/s), %zu sweeps\n", solvedPairs,
+                positions, seconds, positions / seconds, table.sweeps());
+    std::printf("coup_tablebase: %zu wins, %zu losses, %zu draws for the player to move\n", wins, losses, draws);
+    return 0;
+}
+
+int verify(const std::string& path, size_t samples, unsigned int seed) {
+    Tablebase table;
+    table.open(path);
+    size_t checked = 0;
+    size_t bad = 0;
+    std::vector<size_t> canonical;
+    for (size_t pair = 0; pair < Tablebase::PAIRS; ++pair) {
+        Role first = static_cast<Role>(pair / Tablebase::ROLES + 1);
+        Role second = static_cast<Role>(pair % Tablebase::ROLES + 1);
+        if (!table.solved(first, second)) {
+            continue;
+        }
+        for (size_t i = pair * Tablebase::PAIR_SIZE; i < (pair + 1) * Tablebase::PAIR_SIZE; ++i) {
+            EndgamePosition position = Tablebase::position(i);
+            if (!Tablebase::canonical(position)) {
+                continue;
+            }
+            canonical.push_back(i);
+            ++checked;
+            if (derive(table, position) != table.probe(position) && bad++ < 10) {
+                std::cerr << "coup_tablebase: index " << i << " stores " << int(table.probe(position))
+                          << ", its successors give " << int(derive(table, position)) << std::endl;
+            }
+        }
+    }
+    std::printf("coup_tablebase: %zu positions re-derived, %zu inconsistent\n", checked, bad);
+
+    std::mt19937 rng(seed);
+    size_t mismatches = 0;
+    samples = canonical.empty() ? 0 : samples;
+    for (size_t s = 0; s < samples; ++s) {
+        size_t i = canonical[rng() % canonical.size()];
+        std::string error;
+        if (!matchesEngine(Tablebase::position(i), error) && mismatches++ < 10) {
+            std::cerr << "coup_tablebase: index " << i << ": " << error << std::endl;
+        }
+    }
+    std::printf("coup_tablebase: %zu sampled positions replayed through the engine, %zu mismatches\n", samples,
+                mismatches);
+    return bad == 0 && mismatches == 0 ? 0 : 1;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+    std::string path = argv[2];
+    size_t threads = 0;
+    size_t samples = 100000;
+    unsigned int seed = 1;
+    std::vector<std::pair<Role, Role>> pairs;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) threads = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--sample" && hasValue) samples = static_cast<size_t>(std::atol(argv[++i]));
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned int>(std::atol(argv[++i]));
+        else if (arg == "--pair" && hasValue) {
+            std::string pair = argv[++i];
+            size_t colon = pair.find(':');
+            Role first, second;
+            if (colon == std::string::npos || !parseRole(pair.substr(0, colon), first) ||
+                !parseRole(pair.substr(colon + 1), second)) {
+                usage();
+                return 1;
+            }
+            pairs.emplace_back(first, second);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        if (command == "generate") {
+            return generate(path, threads, pairs);
+        }
+        if (command == "verify") {
+            return verify(path, samples, seed);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "coup_tablebase: " << e.what() << std::endl;
+        return 1;
+    }
+    usage();
+    return 1;
+}